@@ -7,181 +7,77 @@
 # https://doc.qt.io/qt-5/licensing.html or https://doc.qt.io/qt-6/licensing.html
 QT += charts core gui widgets
 
-# CONFIG += c++17
-CONFIG += c++20
-CONFIG += no_keywords
-CONFIG -= qtquickcompiler
-
-DEFINES += QT_DEPRECATED_WARNINGS
-DEFINES += QT_NO_NARROWING_CONVERSIONS_IN_CONNECT
-
-DEFINES += QT_NO_DEBUG_OUTPUT
-# DEFINES += QT_NO_INFO_OUTPUT
-# DEFINES += QT_NO_WARNING_OUTPUT
-# DEFINES += QT_FATAL_WARNINGS
-# DEFINES += QT_FATAL_CRITICALS
-
-########################################################################################################################
-# Compiler Options
-##################
-
-DEFINES += _CRT_SECURE_NO_WARNINGS
-
-QMAKE_CXXFLAGS += \
-    /std:c++20 \
-    /permissive- \
-    /volatile:iso \
-    /EHsc \
-    /Zc:__cplusplus \
-    /Zc:preprocessor
-
-QMAKE_CXXFLAGS_RELEASE += \
-    /O2
-
-QMAKE_CXXFLAGS_DEBUG += \
-    /Od \
-    /Zi
+include( common.pri )
 
 ########################################################################################################################
 # Source Files
 ##############
 
-INCLUDEPATH += $$PWD/src
-
 SOURCES += \
+    src/BandMath.cxx \
+    src/BatchQueue.cxx \
+    src/ChunkedCube.cxx \
+    src/ClassMap.cxx \
+    src/ClassifyStage.cxx \
+    src/CubeRecorder.cxx \
+    src/Demosaic.cxx \
+    src/EndmemberLibrary.cxx \
+    src/EnviCube.cxx \
+    src/FrameCodec.cxx \
+    src/FrameItem.cxx \
+    src/FramePool.cxx \
+    src/FrameStatistics.cxx \
+    src/LibraryClassifier.cxx \
     src/Main.cxx \
-    src/MainWindow.cxx
+    src/MainWindow.cxx \
+    src/PreTriggerRing.cxx \
+    src/Preview.cxx \
+    src/ProbeSet.cxx \
+    src/RawRecorder.cxx \
+    src/RecordTelemetry.cxx \
+    src/SpectralClassifier.cxx \
+    src/SpectralHistory.cxx \
+    src/StreamCapture.cxx \
+    src/SweepFeed.cxx \
+    src/ThreadPool.cxx \
+    src/ToneMap.cxx
 
 HEADERS += \
-    src/MainWindow.hxx
+    src/BandMath.hxx \
+    src/BatchQueue.hxx \
+    src/ChunkedCube.hxx \
+    src/ClassMap.hxx \
+    src/ClassifyStage.hxx \
+    src/CubeRecorder.hxx \
+    src/CubeStage.hxx \
+    src/Demosaic.hxx \
+    src/DisplayPacer.hxx \
+    src/EndmemberLibrary.hxx \
+    src/EnviCube.hxx \
+    src/FrameCodec.hxx \
+    src/FrameItem.hxx \
+    src/FramePool.hxx \
+    src/FrameStatistics.hxx \
+    src/LibraryClassifier.hxx \
+    src/MainWindow.hxx \
+    src/PreTriggerRing.hxx \
+    src/Preview.hxx \
+    src/ProbeSet.hxx \
+    src/RawRecorder.hxx \
+    src/RecordTelemetry.hxx \
+    src/Simd.hxx \
+    src/SpectralClassifier.hxx \
+    src/SpectralHistory.hxx \
+    src/SpectralMeasure.hxx \
+    src/StreamCapture.hxx \
+    src/SweepFeed.hxx \
+    src/ThreadPool.hxx \
+    src/ToneMap.hxx \
+    src/TripleBuffer.hxx
 
 FORMS += \
     src/MainWindow.ui
 
-########################################################################################################################
-# Misc
-#############
-
-win32: USER = $$(USERNAME)
-unix:  USER = $$(USER)
-
-########################################################################################################################
-# Hinalea API
-#############
-
-HINALEA_API = "C:/Users/$$USER/Documents/Hinalea-API/HinaleaAPI"
-
-!exists( $$HINALEA_API ) {
-    error( HINALEA_API ( $$HINALEA_API ) does not exist. You need to change the path to where you installed Hinalea API. )
-}
-
-INCLUDEPATH += $$HINALEA_API/include
-
-LIBS += -L$$HINALEA_API/lib
-
-if ( true ) {
-    # This is for client use.
-    LIBS += -lHinaleaAPI_msvc_x64
-} else {
-    WARNING = "This conditional branch is for internal use. We do not ship debug build of Hinalea API with the SDK to clients."
-    !build_pass:message( $$WARNING )
-    !build_pass:warning( $$WARNING )
-    CONFIG( release, debug | release ) { LIBS += -lHinaleaAPI_msvc_x64  }
-    CONFIG( debug  , debug | release ) { LIBS += -lHinaleaAPI_msvc_x64d }
-    DEFINES += HINALEA_INTERNAL
-}
-
-########################################################################################################################
-# Intel OneAPI: Math Kernel Library and OpenMP
-##############################################
-
-if ( true ) {
-    # If the Intel OneAPI SDK is installed:
-    ONEAPI = "C:/Program Files (x86)/Intel/oneAPI"
-    INTEL_COMPILER = $$ONEAPI/compiler/latest
-    MKL = $$ONEAPI/mkl/latest
-
-    !exists( $$ONEAPI ) {
-        error( ONEAPI ( $$ONEAPI ) does not exist. You need to change the path to where you installed Intel OneAPI SDK. )
-    }
-
-    QMAKE_LFLAGS += /nodefaultlib:vcomp
-    DEFINES += MKL_ILP64
-    INCLUDEPATH += $$ONEAPI/compiler/latest/windows/compiler/include
-    INCLUDEPATH += $$MKL/include
-
-    exists( $$MKL/redist ) {
-        # 2023-
-        LIBS += -L$$MKL/redist/intel64
-        LIBS += -L$$MKL/lib/intel64
-        LIBS += -L$$INTEL_COMPILER/windows/redist/intel64_win/compiler
-        LIBS += -L$$INTEL_COMPILER/windows/compiler/lib/intel64_win
-    } else {
-        # 2024+
-        LIBS += -L$$MKL/bin
-        LIBS += -L$$MKL/lib
-        LIBS += -L$$INTEL_COMPILER/bin
-        LIBS += -L$$INTEL_COMPILER/lib
-    }
-
-    LIBS += -llibiomp5md
-    LIBS += -lmkl_rt
-} else {
-    # Make sure the following DLL dependencies are located in the Hinalea-API-Cxx-Example/bin/ folder:
-    # libiomp5md.dll
-    # mkl_avx2.2.dll
-    # mkl_core.2.dll
-    # mkl_def.2.dll
-    # mkl_intel_thread.2.dll
-    # mkl_rt.2.dll
-    # mkl_vml_avx512.2.dll
-    # mkl_vml_def.2.dll
-}
-
-########################################################################################################################
-# Cuda
-######
-
-if ( true ) {
-    # If the CUDA SDK is installed:
-    # CUDA_DIR = $$clean_path( $$(CUDA_PATH) )
-    # CUDA_DIR = $$clean_path( $$(CUDA_PATH_V11_7) )
-    CUDA_DIR = $$clean_path( $$(CUDA_PATH_V12_4) )
-
-    !exists( $$CUDA_DIR ) {
-        error( CUDA_DIR ( $$CUDA_DIR ) does not exist. You need to change the path to where you installed CUDA SDK. )
-    }
-
-    INCLUDEPATH += $$CUDA_DIR/include
-
-    LIBS += -L$$CUDA_DIR/bin
-    LIBS += -L$$CUDA_DIR/lib/x64
-    LIBS += -lcuda
-    LIBS += -lcudart
-    LIBS += -lcublas
-    LIBS += -lcublasLt
-    LIBS += -lcusolver
-    LIBS += -lnppicc
-
-    CUDA_DIR_PARTS = $$split( CUDA_DIR, / )
-    CUDA_VERSION = $$last( CUDA_DIR_PARTS )
-    CUDA_VERSION_PARTS = $$split( CUDA_VERSION, . )
-    CUDA_VERSION_MAJOR = $$first( CUDA_VERSION_PARTS )
-
-    # CUDA 12 has added some extra dependencies
-    equals( CUDA_VERSION_MAJOR, v12 ) {
-        LIBS += -lcusparse
-    }
-
-} else {
-    # Make sure the following DLL dependencies are located in the Hinalea-API-Cxx-Example/bin/ folder:
-    # cublas64_12.dll
-    # cublasLt64_12.dll
-    # cudart64_12.dll
-    # cusolver64_12.dll
-    # nppicc64_12.dll
-}
-
 ########################################################################################################################
 # Deployment
 ############
@@ -0,0 +1,77 @@
+#include "Bench.hxx"
+
+#include <cmath>
+#include <random>
+
+namespace {
+
+inline auto constexpr bumps = 3;
+
+} /* namespace anonymous */
+
+auto Bench::syntheticSpectra(
+    HINALEA_IN ::hinalea::Int const observations,
+    HINALEA_IN ::hinalea::Int const bands
+    ) -> ::std::vector< ::hinalea::f32 >
+{
+    auto engine = ::std::mt19937{ 42 };
+    auto uniform = ::std::uniform_real_distribution< double >{ 0.0, 1.0 };
+    auto spectra = ::std::vector< ::hinalea::f32 >( static_cast< ::std::size_t >( observations * bands ) );
+
+    for ( auto o = ::hinalea::Int{ 0 }; o < observations; ++o )
+    {
+        double centers[ ::bumps ];
+        double widths[ ::bumps ];
+        double heights[ ::bumps ];
+
+        for ( auto k = 0; k < ::bumps; ++k )
+        {
+            centers[ k ] = uniform( engine ) * static_cast< double >( bands );
+            widths[ k ] = ( 0.05 + 0.2 * uniform( engine ) ) * static_cast< double >( bands );
+            heights[ k ] = 0.2 + uniform( engine );
+        }
+
+        for ( auto b = ::hinalea::Int{ 0 }; b < bands; ++b )
+        {
+            auto value = 0.05;
+
+            for ( auto k = 0; k < ::bumps; ++k )
+            {
+                auto const d = ( static_cast< double >( b ) - centers[ k ] ) / widths[ k ];
+                value += heights[ k ] * ::std::exp( -0.5 * d * d );
+            }
+
+            spectra[ static_cast< ::std::size_t >( o * bands + b ) ] = static_cast< ::hinalea::f32 >( value );
+        }
+    }
+
+    return spectra;
+}
+
+auto Bench::syntheticCube(
+    HINALEA_IN ::std::vector< ::hinalea::f32 > const & spectra,
+    HINALEA_IN ::hinalea::Int const                    bands,
+    HINALEA_IN ::hinalea::Int const                    area
+    ) -> ::std::vector< ::hinalea::f32 >
+{
+    auto const observations = static_cast< ::hinalea::Int >( spectra.size( ) ) / bands;
+
+    auto engine = ::std::mt19937{ 7 };
+    auto pick = ::std::uniform_int_distribution< ::hinalea::Int >{ 0, observations - 1 };
+    auto scale = ::std::uniform_real_distribution< float >{ 0.5f, 1.5f };
+    auto noise = ::std::normal_distribution< float >{ 1.0f, 0.02f };
+    auto cube = ::std::vector< ::hinalea::f32 >( static_cast< ::std::size_t >( bands * area ) );
+
+    for ( auto p = ::hinalea::Int{ 0 }; p < area; ++p )
+    {
+        auto const * const spectrum = spectra.data( ) + pick( engine ) * bands;
+        auto const gain = scale( engine );
+
+        for ( auto b = ::hinalea::Int{ 0 }; b < bands; ++b )
+        {
+            cube[ static_cast< ::std::size_t >( b * area + p ) ] = spectrum[ b ] * gain * noise( engine );
+        }
+    }
+
+    return cube;
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <Hinalea.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+/* Benchmarks of the in-project kernels, run from the command line by `Main.cxx`, no camera needed unless noted.
+ *
+ * Every benchmark prints one table to standard output, with the median of several timed runs after an untimed warm up
+ * run. Build it in release: `bench.pro` shares the compiler options of the application through `common.pri`.
+ */
+class Bench
+{
+public:
+    using Arguments = ::std::vector< ::std::string >;
+
+    /* GUI thread time of replacing the spectra series of the chart, with and without the repaint it causes. Needs a
+     * display, or `QT_QPA_PLATFORM=offscreen`. Arguments: [bands] [series] [opengl|raster].
+     */
+    static
+    auto chartUpdate(
+        HINALEA_IN Arguments const & arguments
+        ) -> void;
+
+    /* `ChunkedCube` in the chunk shapes of the application, written from an ENVI cube: write time and size ratio, and
+     * the time and share of the file of reading the middle band and the centre spectrum, against `EnviCube` reading them
+     * from the source. Writes below `directory`, the temporary one by default. Arguments: <cube> [directory].
+     */
+    static
+    auto chunkedCube(
+        HINALEA_IN Arguments const & arguments
+        ) -> void;
+
+    /* `FrameEncoder` ratio and encode and decode MB/s, in total and per core, of every predictor and stripe height, on
+     * frames of a raw or compressed stream recording spread over its sweep. Arguments: <recording> [frames].
+     */
+    static
+    auto frameCodec(
+        HINALEA_IN Arguments const & arguments
+        ) -> void;
+
+    /* Frame statistics kernel against `hinalea::image_statistics`, on synthetic frames of every bit depth.
+     * Arguments: [width] [height].
+     */
+    static
+    auto frameStatistics(
+        HINALEA_IN Arguments const & arguments
+        ) -> void;
+
+    /* `LibraryClassifier` throughput at 1, 10, 100 and 1000 endmembers, with `SpectralClassifier` up to 255.
+     * Arguments: [width] [height] [bands].
+     */
+    static
+    auto libraryClassifier(
+        HINALEA_IN Arguments const & arguments
+        ) -> void;
+
+    /* `ProbeSet` reduction of 16 probes of 31 x 31 pixels, at 100, 200 and 300 bands, and its share of a cube period.
+     * Arguments: [width] [height] [cubes per second].
+     */
+    static
+    auto probeStatistics(
+        HINALEA_IN Arguments const & arguments
+        ) -> void;
+
+    /* PNG per frame, as `Acquisition::record` writes, against `RawRecorder` raw and compressed, at every bit depth.
+     * Prints frames/s, MB/s of frame data and the size ratio. Writes below `directory`, the temporary one by default.
+     * Arguments: [width] [height] [frames] [directory].
+     */
+    static
+    auto recordFormats(
+        HINALEA_IN Arguments const & arguments
+        ) -> void;
+
+    /* `SpectralClassifier` against `hinalea::SpectralMetric`, spectral angle on synthetic cubes of 100 to 300 bands.
+     * Arguments: [width] [height] [endmembers].
+     */
+    static
+    auto spectralClassifier(
+        HINALEA_IN Arguments const & arguments
+        ) -> void;
+
+    /* `observations x bands` smooth positive spectra, row major, each a sum of a few wide bumps. */
+    [[ nodiscard ]]
+    static
+    auto syntheticSpectra(
+        HINALEA_IN ::hinalea::Int observations,
+        HINALEA_IN ::hinalea::Int bands
+        ) -> ::std::vector< ::hinalea::f32 >;
+
+    /* BSQ cube of `area` pixels, each a randomly scaled spectrum of `spectra` with 2% noise. */
+    [[ nodiscard ]]
+    static
+    auto syntheticCube(
+        HINALEA_IN ::std::vector< ::hinalea::f32 > const & spectra,
+        HINALEA_IN ::hinalea::Int                          bands,
+        HINALEA_IN ::hinalea::Int                          area
+        ) -> ::std::vector< ::hinalea::f32 >;
+
+    /* Integer argument `index`, or `fallback` if there are fewer arguments. */
+    [[ nodiscard ]]
+    static
+    auto integer(
+        HINALEA_IN Arguments const & arguments,
+        HINALEA_IN ::std::size_t     index,
+        HINALEA_IN ::hinalea::Int    fallback
+        ) -> ::hinalea::Int
+    {
+        return ( index < arguments.size( ) ) ? ::std::stoll( arguments[ index ] ) : fallback;
+    }
+
+    /* Median of `repeats` timed calls of `function`, in milliseconds, after one untimed call. */
+    template <
+        typename Function
+        >
+    [[ nodiscard ]]
+    static
+    auto medianMilliseconds(
+        HINALEA_IN    int        repeats,
+        HINALEA_INOUT Function && function
+        ) -> double
+    {
+        using Milliseconds = ::std::chrono::duration< double, ::std::milli >;
+
+        function( );
+
+        auto times = ::std::vector< double >( static_cast< ::std::size_t >( ::std::max( repeats, 1 ) ) );
+
+        for ( auto & time : times )
+        {
+            auto const start = ::std::chrono::steady_clock::now( );
+            function( );
+            time = Milliseconds{ ::std::chrono::steady_clock::now( ) - start }.count( );
+        }
+
+        auto const middle = times.begin( ) + static_cast< ::std::ptrdiff_t >( times.size( ) / 2 );
+        ::std::nth_element( times.begin( ), middle, times.end( ) );
+        return *middle;
+    }
+};
@@ -0,0 +1,119 @@
+#include "Bench.hxx"
+
+#include <QApplication>
+#include <QChart>
+#include <QChartView>
+#include <QLineSeries>
+#include <QPointF>
+#include <QVector>
+
+#include <array>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string_view>
+
+/* QtCharts version 5 uses QtCharts namespace whereas QtCharts version 6 uses the default Qt namespace */
+#if QT_VERSION < QT_VERSION_CHECK( 6, 0, 0 )
+QT_CHARTS_USE_NAMESPACE
+#endif /* QT_VERSION_CHECK */
+
+namespace {
+
+inline auto constexpr rounds = 100;
+
+} /* namespace anonymous */
+
+auto Bench::chartUpdate(
+    HINALEA_IN Arguments const & arguments
+    ) -> void
+{
+    using Milliseconds = ::std::chrono::duration< double, ::std::milli >;
+
+    auto const bands = static_cast< int >( Bench::integer( arguments, 0, 300 ) );
+    auto const seriesCount = static_cast< int >( Bench::integer( arguments, 1, 4 ) );
+    auto const useOpenGL = ( arguments.size( ) < 3 ) or ( ::std::string_view{ arguments[ 2 ] } != "raster" );
+
+    auto argc = 1;
+    char name[ ] = "Hinalea-API-Cxx-Bench";
+    char * argv[ ] = { name, nullptr };
+    auto application = QApplication{ argc, argv };
+
+    /* Set up like `MainWindow::initChartView`. */
+    auto * const chart = new QChart{ };
+    auto series = QVector< QLineSeries * >{ };
+
+    for ( auto i = 0; i < seriesCount; ++i )
+    {
+        auto * const line = new QLineSeries{ };
+        line->setUseOpenGL( useOpenGL );
+        chart->addSeries( line );
+        series.append( line );
+    }
+
+    chart->legend( )->hide( );
+    chart->createDefaultAxes( );
+
+    auto view = QChartView{ chart };
+    view.resize( 800, 400 );
+    view.show( );
+    QApplication::processEvents( );
+
+    /* Two sets of spectra, alternated so every replace changes every point. */
+    auto points = ::std::array< QVector< QVector< QPointF > >, 2 >{ };
+
+    for ( auto set = 0; set < 2; ++set )
+    {
+        for ( auto i = 0; i < seriesCount; ++i )
+        {
+            auto spectrum = QVector< QPointF >{ };
+            spectrum.reserve( bands );
+
+            for ( auto band = 0; band < bands; ++band )
+            {
+                spectrum.append( QPointF( 400.0 + band, 0.5 + 0.4 * ::std::sin( 0.05 * band + i + set ) ) );
+            }
+
+            points[ static_cast< ::std::size_t >( set ) ].append( spectrum );
+        }
+    }
+
+    ::std::cout
+        << "Chart update of " << seriesCount << " series of " << bands << " bands in an 800 x 400 view, "
+        << ( useOpenGL ? "OpenGL" : "raster" ) << " series, " << ::rounds << " updates\n"
+        << "repaint  mean ms  max ms\n"
+        << ::std::fixed << ::std::setprecision( 3 );
+
+    /* Without the repaint is the cost of `MainWindow::onUpdateSeries`, the repaint follows later in the event loop. */
+    for ( auto const repaint : { false, true } )
+    {
+        auto total = Milliseconds{ };
+        auto worst = Milliseconds{ };
+
+        for ( auto round = 0; round < ::rounds; ++round )
+        {
+            auto const & spectra = points[ static_cast< ::std::size_t >( round % 2 ) ];
+            auto const start = ::std::chrono::steady_clock::now( );
+
+            for ( auto i = 0; i < seriesCount; ++i )
+            {
+                series[ i ]->replace( spectra[ i ] );
+            }
+
+            if ( repaint )
+            {
+                view.repaint( );
+            }
+
+            auto const elapsed = Milliseconds{ ::std::chrono::steady_clock::now( ) - start };
+            total += elapsed;
+            worst = ::std::max( worst, elapsed );
+            QApplication::processEvents( );
+        }
+
+        ::std::cout
+            << ::std::setw( 7 ) << ( repaint ? "yes" : "no" )
+            << ::std::setw( 9 ) << ( total.count( ) / ::rounds )
+            << ::std::setw( 8 ) << worst.count( ) << '\n';
+    }
+}
@@ -0,0 +1,108 @@
+#include "Bench.hxx"
+
+#include "ChunkedCube.hxx"
+#include "EnviCube.hxx"
+
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+inline auto constexpr repeats = 3;
+
+/* Chunk shapes of `MainWindow`: one band per chunk for browsing bands, band blocks of small tiles for spectra. */
+inline ChunkedCube::Options constexpr chunk_shapes[ ] = {
+    ChunkedCube::Options{ 1, 256, ChunkedCube::Compression::Deflate, 1 },
+    ChunkedCube::Options{ 16, 64, ChunkedCube::Compression::Deflate, 1 },
+    };
+
+} /* namespace anonymous */
+
+auto Bench::chunkedCube(
+    HINALEA_IN Arguments const & arguments
+    ) -> void
+{
+    if ( arguments.empty( ) )
+    {
+        throw ::std::runtime_error{ "chunked-cube needs the path of an ENVI cube." };
+    }
+
+    auto const source = EnviCube::open( arguments[ 0 ] );
+    auto const dir = ( ( arguments.size( ) > 1 ) ? ::hinalea::fs::path{ arguments[ 1 ] } : ::hinalea::fs::temp_directory_path( ) )
+                   / "hinalea-chunked-cube";
+    auto const path = dir / "cube.hcc";
+
+    ::hinalea::fs::remove_all( dir );
+    ::hinalea::fs::create_directories( dir );
+
+    auto const band = source.bands( ) / 2;
+    auto const x = source.samples( ) / 2;
+    auto const y = source.lines( ) / 2;
+
+    auto region = PreviewRegion{ };
+    region.width = source.samples( );
+    region.height = source.lines( );
+
+    auto window = CubeWindow{ };
+    window.width = source.samples( );
+    window.height = source.lines( );
+
+    auto pixel = CubeWindow{ };
+    pixel.x = x;
+    pixel.y = y;
+    pixel.width = 1;
+    pixel.height = 1;
+
+    auto plane = ::std::vector< ::hinalea::f32 >( static_cast< ::std::size_t >( source.samples( ) * source.lines( ) ) );
+    auto spectrum = ::std::vector< ::hinalea::f32 >( static_cast< ::std::size_t >( source.bands( ) ) );
+
+    ::std::cout
+        << "Chunked cube of " << source.describe( ) << ", middle band and centre spectrum, median of " << ::repeats << " runs\n"
+        << "layout          write ms  ratio   band ms  of file  spectrum ms  of file\n"
+        << ::std::fixed << ::std::setprecision( 3 );
+
+    auto const sourceBandTime = Bench::medianMilliseconds( ::repeats, [ & ]{ source.readBand( band, region, plane.data( ), region.width ); } );
+    auto const sourceSpectrumTime = Bench::medianMilliseconds( ::repeats, [ & ]{ source.readSpectrum( x, y, spectrum.data( ) ); } );
+
+    /* NOTE: Mapped, so repeated reads come from the page cache like the chunked ones below. */
+    ::std::cout
+        << ::std::left << ::std::setw( 14 ) << "envi" << ::std::right
+        << ::std::setw( 10 ) << "-"
+        << ::std::setw( 7 ) << "-"
+        << ::std::setw( 10 ) << sourceBandTime
+        << ::std::setw( 9 ) << "-"
+        << ::std::setw( 13 ) << sourceSpectrumTime
+        << ::std::setw( 9 ) << "-" << '\n';
+
+    for ( auto const & options : ::chunk_shapes )
+    {
+        auto statistics = ChunkedCube::WriteStatistics{ };
+        auto const writeTime = Bench::medianMilliseconds( ::repeats, [ & ]{ statistics = ChunkedCube::write( path, source, options ); } );
+
+        /* NOTE: Straight through `ChunkedCube::read`, every read decodes its chunks again as the viewer's first read does. */
+        auto const cube = ChunkedCube::open( path );
+        auto bandBytes = ::std::uint64_t{ 0 };
+        auto spectrumBytes = ::std::uint64_t{ 0 };
+        auto const bandTime = Bench::medianMilliseconds( ::repeats, [ & ]{ bandBytes = cube.read( band, 1, window, plane.data( ) ); } );
+        auto const spectrumTime = Bench::medianMilliseconds( ::repeats, [ & ]{ spectrumBytes = cube.read( 0, cube.bands( ), pixel, spectrum.data( ) ); } );
+
+        auto const fileBytes = static_cast< double >( statistics.bytes );
+        auto const name = ::std::to_string( options.bandsPerChunk ) + " x " + ::std::to_string( options.tileSize );
+
+        ::std::cout
+            << ::std::left << ::std::setw( 14 ) << name << ::std::right
+            << ::std::setw( 10 ) << writeTime
+            << ::std::setw( 7 ) << static_cast< double >( statistics.rawBytes ) / fileBytes
+            << ::std::setw( 10 ) << bandTime
+            << ::std::setw( 9 ) << static_cast< double >( bandBytes ) / fileBytes
+            << ::std::setw( 13 ) << spectrumTime
+            << ::std::setw( 9 ) << static_cast< double >( spectrumBytes ) / fileBytes << '\n';
+    }
+
+    /* NOTE: Only the directory made for the benchmark, the chunked cube is as large as the source. */
+    ::hinalea::fs::remove_all( dir );
+}
@@ -0,0 +1,111 @@
+#include "Bench.hxx"
+
+#include "FrameCodec.hxx"
+#include "RawRecorder.hxx"
+#include "ThreadPool.hxx"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+inline auto constexpr repeats = 5;
+
+inline FramePredictor constexpr predictors[ ] = { FramePredictor::Left, FramePredictor::Paeth };
+inline ::hinalea::Int constexpr stripe_rows[ ] = { 8, 32, 128 };
+
+} /* namespace anonymous */
+
+auto Bench::frameCodec(
+    HINALEA_IN Arguments const & arguments
+    ) -> void
+{
+    if ( arguments.empty( ) )
+    {
+        throw ::std::runtime_error{ "frame-codec needs the path of a raw or compressed stream recording." };
+    }
+
+    auto recording = RawRecording::open( arguments[ 0 ] );
+    auto const format = recording.format( );
+    auto const count = ::std::min( Bench::integer( arguments, 1, 20 ), recording.frames( ) );
+    auto const rowBytes = format.width * RawRecorder::bytesPerPixel( format.bitDepth );
+    auto const frameBytes = static_cast< ::std::size_t >( rowBytes * format.height );
+
+    /* NOTE: Frames are spread over the sweep, the bands differ in brightness and so in how well they compress. */
+    auto frames = ::std::vector< ::std::vector< ::std::byte > >( static_cast< ::std::size_t >( count ) );
+
+    for ( auto i = ::hinalea::Int{ 0 }; i < count; ++i )
+    {
+        auto & frame = frames[ static_cast< ::std::size_t >( i ) ];
+        frame.resize( frameBytes );
+        recording.read( i * recording.frames( ) / count, frame.data( ) );
+    }
+
+    auto const cores = static_cast< double >( ThreadPool::global( ).concurrency( ) );
+    auto const rawBytes = static_cast< double >( frameBytes ) * static_cast< double >( count );
+
+    ::std::cout
+        << "Frame codec on " << count << " of " << recording.frames( ) << " frames of " << format.width << " x " << format.height
+        << " at " << format.bitDepth << " bit, " << ThreadPool::global( ).concurrency( ) << " threads, median of " << ::repeats << " runs\n"
+        << "predictor  stripe rows  ratio  encode MB/s  per core  decode MB/s  per core\n"
+        << ::std::fixed << ::std::setprecision( 2 );
+
+    auto decoded = ::std::vector< ::std::byte >( frameBytes );
+
+    for ( auto const predictor : ::predictors )
+    {
+        for ( auto const stripeRows : ::stripe_rows )
+        {
+            auto encoder = FrameEncoder{ FrameCodecSettings{ predictor, stripeRows } };
+            auto const view = [ & ]( ::std::size_t const i ){ return FrameView{ frames[ i ].data( ), format.width, format.height, rowBytes, format.bitDepth }; };
+
+            auto const encodeTime = Bench::medianMilliseconds(
+                ::repeats,
+                [ & ]
+                {
+                    for ( auto i = ::std::size_t{ 0 }; i < frames.size( ); ++i )
+                    {
+                        static_cast< void >( encoder.encode( view( i ) ) );
+                    }
+                }
+                );
+
+            /* NOTE: Kept encoded outside the timing, one encoder per frame would hold a worst case buffer each. */
+            auto encoded = ::std::vector< ::std::vector< ::std::byte > >( frames.size( ) );
+            auto encodedBytes = 0.0;
+
+            for ( auto i = ::std::size_t{ 0 }; i < frames.size( ); ++i )
+            {
+                auto const size = encoder.encode( view( i ) );
+                encoded[ i ].assign( encoder.data( ), encoder.data( ) + size );
+                encodedBytes += static_cast< double >( size );
+            }
+
+            auto const decodeTime = Bench::medianMilliseconds(
+                ::repeats,
+                [ & ]
+                {
+                    for ( auto const & frame : encoded )
+                    {
+                        ::decodeFrame( frame.data( ), frame.size( ), format.width, format.height, format.bitDepth, decoded.data( ), rowBytes );
+                    }
+                }
+                );
+
+            auto const encodeRate = rawBytes / encodeTime / 1e3;
+            auto const decodeRate = rawBytes / decodeTime / 1e3;
+
+            ::std::cout
+                << ::std::left << ::std::setw( 9 ) << ( ( predictor == FramePredictor::Paeth ) ? "paeth" : "left" ) << ::std::right
+                << ::std::setw( 13 ) << stripeRows
+                << ::std::setw( 7 ) << rawBytes / encodedBytes
+                << ::std::setw( 13 ) << encodeRate
+                << ::std::setw( 10 ) << encodeRate / cores
+                << ::std::setw( 13 ) << decodeRate
+                << ::std::setw( 10 ) << decodeRate / cores << '\n';
+        }
+    }
+}
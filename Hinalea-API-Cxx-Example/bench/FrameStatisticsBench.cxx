@@ -0,0 +1,103 @@
+#include "Bench.hxx"
+
+#include "FrameStatistics.hxx"
+#include "ThreadPool.hxx"
+
+#include <QImage>
+
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+
+/* Bits per sample of the cameras, the ones above 8 stored in 16 bits. */
+inline ::hinalea::Int constexpr bit_depths[ ] = { 8, 10, 12, 16 };
+
+/* Brightest pixels excluded from the maximum, like hot pixels in `MainWindow::ignoreCount`. */
+inline auto constexpr ignore_count = ::hinalea::Int{ 16 };
+
+inline auto constexpr repeats = 21;
+
+/* Noise around mid grey with a few saturated pixels, so the saturation count and the ignored pixels are exercised. */
+[[ nodiscard ]]
+auto syntheticFrame(
+    HINALEA_IN ::hinalea::Int const width,
+    HINALEA_IN ::hinalea::Int const height,
+    HINALEA_IN ::hinalea::Int const bitDepth
+    ) -> ::std::vector< ::std::byte >
+{
+    auto const bytesPerSample = ( bitDepth > 8 ) ? 2 : 1;
+    auto const maxValue = ( ::hinalea::Int{ 1 } << bitDepth ) - 1;
+    auto const pixels = static_cast< ::std::size_t >( width * height );
+
+    auto engine = ::std::mt19937{ 1234 };
+    auto noise = ::std::normal_distribution< double >{ maxValue / 2.0, maxValue / 8.0 };
+    auto frame = ::std::vector< ::std::byte >( pixels * bytesPerSample );
+
+    for ( auto i = ::std::size_t{ 0 }; i < pixels; ++i )
+    {
+        auto const value = ( i % 4099 == 0 ) ? maxValue : ::std::clamp( static_cast< ::hinalea::Int >( noise( engine ) ), ::hinalea::Int{ 0 }, maxValue );
+
+        if ( bytesPerSample == 2 )
+        {
+            reinterpret_cast< ::std::uint16_t * >( frame.data( ) )[ i ] = static_cast< ::std::uint16_t >( value );
+        }
+        else
+        {
+            frame[ i ] = static_cast< ::std::byte >( value );
+        }
+    }
+
+    return frame;
+}
+
+} /* namespace anonymous */
+
+auto Bench::frameStatistics(
+    HINALEA_IN Arguments const & arguments
+    ) -> void
+{
+    auto const width = Bench::integer( arguments, 0, 2048 );
+    auto const height = Bench::integer( arguments, 1, 2048 );
+
+    ::std::cout
+        << "Frame statistics of a " << width << " x " << height << " frame, threshold at the maximum sample, "
+        << ::ignore_count << " brightest ignored, " << ThreadPool::global( ).concurrency( ) << " threads, median of "
+        << ::repeats << " runs\n"
+        << "bits  kernel ms  hinalea::image_statistics ms  speedup  match\n"
+        << ::std::fixed << ::std::setprecision( 3 );
+
+    auto kernel = FrameStatisticsKernel{ };
+
+    for ( auto const bitDepth : ::bit_depths )
+    {
+        auto const frame = ::syntheticFrame( width, height, bitDepth );
+        auto const linePitch = width * ( ( bitDepth > 8 ) ? 2 : 1 );
+        auto const threshold = ( ::hinalea::Int{ 1 } << bitDepth ) - 1;
+        auto const view = FrameView{ frame.data( ), width, height, linePitch, bitDepth };
+        auto const image = QImage{
+            reinterpret_cast< uchar const * >( frame.data( ) ),
+            static_cast< int >( width ),
+            static_cast< int >( height ),
+            static_cast< qsizetype >( linePitch ),
+            ( bitDepth > 8 ) ? QImage::Format_Grayscale16 : QImage::Format_Grayscale8,
+            };
+
+        auto const kernelTime = Bench::medianMilliseconds( ::repeats, [ & ]{ kernel.compute( view, threshold, ::ignore_count ); } );
+        auto const sdkTime = Bench::medianMilliseconds( ::repeats, [ & ]{ static_cast< void >( ::hinalea::image_statistics( image, threshold, ::ignore_count ) ); } );
+
+        auto const & statistics = kernel.result( );
+        auto const [ min, max, saturation ] = ::hinalea::image_statistics( image, threshold, ::ignore_count );
+        auto const match = ( min == statistics.min ) and ( max == statistics.max ) and ( saturation == statistics.saturation );
+
+        ::std::cout
+            << ::std::setw( 4 ) << bitDepth
+            << ::std::setw( 11 ) << kernelTime
+            << ::std::setw( 30 ) << sdkTime
+            << ::std::setw( 9 ) << ( sdkTime / kernelTime )
+            << "  " << ( match ? "yes" : "NO" ) << '\n';
+    }
+}
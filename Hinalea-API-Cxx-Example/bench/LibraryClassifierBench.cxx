@@ -0,0 +1,77 @@
+#include "Bench.hxx"
+
+#include "EndmemberLibrary.hxx"
+#include "LibraryClassifier.hxx"
+#include "SpectralClassifier.hxx"
+#include "ThreadPool.hxx"
+
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+
+inline ::hinalea::Int constexpr library_sizes[ ] = { 1, 10, 100, 1000 };
+
+/* Spectra the cube is made of, the first ones of every library. */
+inline auto constexpr cube_spectra = ::hinalea::Int{ 16 };
+
+inline auto constexpr threshold = 0.2;
+
+inline auto constexpr repeats = 7;
+
+} /* namespace anonymous */
+
+auto Bench::libraryClassifier(
+    HINALEA_IN Arguments const & arguments
+    ) -> void
+{
+    auto const width = Bench::integer( arguments, 0, 512 );
+    auto const height = Bench::integer( arguments, 1, 512 );
+    auto const bands = Bench::integer( arguments, 2, 200 );
+    auto const area = width * height;
+
+    auto const cube = Bench::syntheticCube( Bench::syntheticSpectra( ::cube_spectra, bands ), bands, area );
+
+    ::std::cout
+        << "Spectral angle of a " << width << " x " << height << " x " << bands << " cube against a library, threshold "
+        << ::threshold << " rad, " << ThreadPool::global( ).concurrency( ) << " threads, median of " << ::repeats << " runs\n"
+        << "endmembers  LibraryClassifier ms  Mpixel/s  SpectralClassifier ms  Mpixel/s\n"
+        << ::std::fixed << ::std::setprecision( 3 );
+
+    for ( auto const observations : ::library_sizes )
+    {
+        auto const spectra = Bench::syntheticSpectra( observations, bands );
+        auto classes = ::std::vector< ::std::uint8_t >( static_cast< ::std::size_t >( observations ) );
+
+        for ( auto e = ::hinalea::Int{ 0 }; e < observations; ++e )
+        {
+            classes[ static_cast< ::std::size_t >( e ) ] = static_cast< ::std::uint8_t >( e % EndmemberLibrary::maxClasses );
+        }
+
+        auto library = LibraryClassifier{ };
+        library.fit( SpectralMeasure::SpectralAngle, spectra.data( ), observations, bands, classes.data( ) );
+
+        auto const libraryTime = Bench::medianMilliseconds( ::repeats, [ & ]{ library.classify( cube.data( ), area, ::threshold ); } );
+
+        ::std::cout
+            << ::std::setw( 10 ) << observations
+            << ::std::setw( 22 ) << libraryTime
+            << ::std::setw( 10 ) << ( static_cast< double >( area ) / 1000.0 / libraryTime );
+
+        /* Labels are 8-bit, so the per endmember classifier stops at 255 endmembers. */
+        if ( observations <= EndmemberLibrary::maxClasses )
+        {
+            auto tiled = SpectralClassifier{ };
+            tiled.fit( SpectralMeasure::SpectralAngle, spectra.data( ), observations, bands );
+
+            auto const tiledTime = Bench::medianMilliseconds( ::repeats, [ & ]{ tiled.classify( cube.data( ), area, ::threshold ); } );
+
+            ::std::cout
+                << ::std::setw( 23 ) << tiledTime
+                << ::std::setw( 10 ) << ( static_cast< double >( area ) / 1000.0 / tiledTime );
+        }
+
+        ::std::cout << '\n';
+    }
+}
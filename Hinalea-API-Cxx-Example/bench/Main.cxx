@@ -0,0 +1,70 @@
+#include "Bench.hxx"
+
+#include <iostream>
+#include <string_view>
+#include <utility>
+
+#include <cstdlib>
+
+namespace {
+
+using Benchmark = auto ( * )( Bench::Arguments const & ) -> void;
+
+inline ::std::pair< ::std::string_view, Benchmark > constexpr benchmarks[ ] = {
+    { "chart-update"       , &Bench::chartUpdate        },
+    { "chunked-cube"       , &Bench::chunkedCube        },
+    { "frame-codec"        , &Bench::frameCodec         },
+    { "frame-statistics"   , &Bench::frameStatistics    },
+    { "library-classifier" , &Bench::libraryClassifier  },
+    { "probe-statistics"   , &Bench::probeStatistics    },
+    { "record-formats"     , &Bench::recordFormats      },
+    { "spectral-classifier", &Bench::spectralClassifier },
+    };
+
+auto printUsage(
+    ) -> void
+{
+    ::std::cerr << "Usage: Hinalea-API-Cxx-Bench <benchmark> [arguments...]\nBenchmarks:";
+
+    for ( auto const & [ name, benchmark ] : ::benchmarks )
+    {
+        ::std::cerr << ' ' << name;
+    }
+
+    ::std::cerr << '\n';
+}
+
+} /* namespace anonymous */
+
+auto main(
+    HINALEA_IN int     argc,
+    HINALEA_IN char ** argv
+    ) -> int
+try
+{
+    if ( argc < 2 )
+    {
+        ::printUsage( );
+        return EXIT_FAILURE;
+    }
+
+    auto const name = ::std::string_view{ argv[ 1 ] };
+    auto const arguments = Bench::Arguments( argv + 2, argv + argc );
+
+    for ( auto const & [ benchmarkName, benchmark ] : ::benchmarks )
+    {
+        if ( benchmarkName == name )
+        {
+            benchmark( arguments );
+            return EXIT_SUCCESS;
+        }
+    }
+
+    ::printUsage( );
+    return EXIT_FAILURE;
+}
+catch( ::std::exception const & exc )
+{
+    ::std::cerr << exc.what( ) << '\n';
+    return EXIT_FAILURE;
+}
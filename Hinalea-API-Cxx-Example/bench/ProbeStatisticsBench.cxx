@@ -0,0 +1,76 @@
+#include "Bench.hxx"
+
+#include "ProbeSet.hxx"
+
+#include <QRect>
+#include <QRegion>
+
+#include <iomanip>
+#include <iostream>
+
+namespace {
+
+inline ::hinalea::Int constexpr band_counts[ ] = { 100, 200, 300 };
+
+/* 16 probes of 31 x 31 pixels. */
+inline auto constexpr probe_grid = 4;
+inline auto constexpr probe_size = 31;
+
+inline auto constexpr repeats = 51;
+
+} /* namespace anonymous */
+
+auto Bench::probeStatistics(
+    HINALEA_IN Arguments const & arguments
+    ) -> void
+{
+    auto const width = Bench::integer( arguments, 0, 1024 );
+    auto const height = Bench::integer( arguments, 1, 1024 );
+    auto const cubeRate = Bench::integer( arguments, 2, 10 );
+    auto const area = width * height;
+
+    /* Probes spread evenly over the cube, so every one reads rows of its own. */
+    auto probes = ::std::vector< ::std::vector< PixelSpan > >{ };
+
+    for ( auto row = 0; row < ::probe_grid; ++row )
+    {
+        for ( auto column = 0; column < ::probe_grid; ++column )
+        {
+            auto const x = static_cast< int >( ( 2 * column + 1 ) * width / ( 2 * ::probe_grid ) ) - ::probe_size / 2;
+            auto const y = static_cast< int >( ( 2 * row + 1 ) * height / ( 2 * ::probe_grid ) ) - ::probe_size / 2;
+            probes.push_back( ::probeSpans( QRegion{ QRect{ x, y, ::probe_size, ::probe_size } }, width, height ) );
+        }
+    }
+
+    ::std::cout
+        << "Probe statistics of " << probes.size( ) << " probes of " << ::probe_size << " x " << ::probe_size << " pixels over a "
+        << width << " x " << height << " cube, single threaded like `MainWindow::classifyCallback`, median of " << ::repeats
+        << " runs\n"
+        << "bands  reduce and means ms  share of the period at " << cubeRate << " cubes/s\n"
+        << ::std::fixed << ::std::setprecision( 3 );
+
+    auto probeSet = ProbeSet{ };
+    probeSet.setProbes( probes, area );
+
+    auto means = ::std::vector< ::hinalea::f32 >{ };
+    auto probeCount = ::hinalea::Int{ };
+    auto bandCount = ::hinalea::Int{ };
+
+    for ( auto const bands : ::band_counts )
+    {
+        auto const cube = Bench::syntheticCube( Bench::syntheticSpectra( 4, bands ), bands, area );
+
+        auto const time = Bench::medianMilliseconds(
+            ::repeats,
+            [ & ]
+            {
+                static_cast< void >( probeSet.reduce( cube.data( ), bands, area ) and probeSet.means( means, probeCount, bandCount ) );
+            }
+            );
+
+        ::std::cout
+            << ::std::setw( 5 ) << bands
+            << ::std::setw( 21 ) << time
+            << ::std::setw( 40 ) << ( time * static_cast< double >( cubeRate ) / 10.0 ) << " %\n";
+    }
+}
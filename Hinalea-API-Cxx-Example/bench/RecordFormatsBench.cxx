@@ -0,0 +1,189 @@
+#include "Bench.hxx"
+
+#include "RawRecorder.hxx"
+
+#include <QImage>
+#include <QString>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+/* Bits per sample of the cameras, the ones above 8 stored in 16 bits. */
+inline ::hinalea::Int constexpr bit_depths[ ] = { 8, 10, 12, 16 };
+
+inline auto constexpr repeats = 3;
+
+/* Smooth scene with about 1% noise, closer to what the camera sees than pure noise, which no lossless format can
+ * compress. Every frame has its own noise, so they are not all the same image.
+ */
+[[ nodiscard ]]
+auto sceneFrames(
+    HINALEA_IN ::hinalea::Int const width,
+    HINALEA_IN ::hinalea::Int const height,
+    HINALEA_IN ::hinalea::Int const bitDepth,
+    HINALEA_IN ::hinalea::Int const count
+    ) -> ::std::vector< ::std::vector< ::std::byte > >
+{
+    auto const bytesPerPixel = RawRecorder::bytesPerPixel( bitDepth );
+    auto const maxValue = static_cast< double >( ( ::hinalea::Int{ 1 } << bitDepth ) - 1 );
+
+    auto engine = ::std::mt19937{ 1234 };
+    auto noise = ::std::normal_distribution< double >{ 0.0, maxValue / 100.0 };
+    auto frames = ::std::vector< ::std::vector< ::std::byte > >( static_cast< ::std::size_t >( count ) );
+
+    for ( auto & frame : frames )
+    {
+        frame.resize( static_cast< ::std::size_t >( width * height * bytesPerPixel ) );
+
+        for ( auto y = ::hinalea::Int{ 0 }; y < height; ++y )
+        {
+            for ( auto x = ::hinalea::Int{ 0 }; x < width; ++x )
+            {
+                auto const u = static_cast< double >( x ) / static_cast< double >( width );
+                auto const v = static_cast< double >( y ) / static_cast< double >( height );
+                auto const scene = 0.5 + 0.25 * ::std::sin( 6.0 * u ) * ::std::cos( 4.0 * v );
+                auto const value = static_cast< ::std::uint16_t >( ::std::clamp( scene * maxValue + noise( engine ), 0.0, maxValue ) );
+                auto const i = static_cast< ::std::size_t >( y * width + x );
+
+                if ( bytesPerPixel == 2 )
+                {
+                    reinterpret_cast< ::std::uint16_t * >( frame.data( ) )[ i ] = value;
+                }
+                else
+                {
+                    frame[ i ] = static_cast< ::std::byte >( value );
+                }
+            }
+        }
+    }
+
+    return frames;
+}
+
+/* One PNG per frame written by `QImage::save` on the recording thread, like `Acquisition::record`. Returns the bytes
+ * written.
+ */
+auto writePng(
+    HINALEA_IN ::hinalea::fs::path const &                            dir,
+    HINALEA_IN ::std::vector< ::std::vector< ::std::byte > > const & frames,
+    HINALEA_IN RawRecorder::Format const &                            format
+    ) -> ::std::uint64_t
+{
+    auto const linePitch = format.width * RawRecorder::bytesPerPixel( format.bitDepth );
+    auto const imageFormat = ( format.bitDepth > 8 ) ? QImage::Format_Grayscale16 : QImage::Format_Grayscale8;
+    auto bytes = ::std::uint64_t{ 0 };
+
+    for ( auto i = ::std::size_t{ 0 }; i < frames.size( ); ++i )
+    {
+        auto const image = QImage{
+            reinterpret_cast< uchar const * >( frames[ i ].data( ) ),
+            static_cast< int >( format.width ),
+            static_cast< int >( format.height ),
+            static_cast< qsizetype >( linePitch ),
+            imageFormat,
+            };
+        auto const path = dir / ( ::std::to_string( i ) + ".png" );
+
+        if ( not image.save( QString::fromStdU16String( path.generic_u16string( ) ), "PNG" ) )
+        {
+            throw ::std::runtime_error{ "Failed to write " + path.string( ) };
+        }
+
+        bytes += static_cast< ::std::uint64_t >( ::hinalea::fs::file_size( path ) );
+    }
+
+    return bytes;
+}
+
+/* Pushes every frame into a `RawRecorder`, as fast as it takes them, and closes it. Returns its statistics. */
+auto writeRaw(
+    HINALEA_IN     ::hinalea::fs::path const &                            base,
+    HINALEA_IN     ::std::vector< ::std::vector< ::std::byte > > const & frames,
+    HINALEA_IN     RawRecorder::Format const &                            format,
+    HINALEA_IN_OPT ::std::optional< FrameCodecSettings > const &         codec
+    ) -> RawRecorder::Statistics
+{
+    auto const linePitch = format.width * RawRecorder::bytesPerPixel( format.bitDepth );
+
+    auto recorder = RawRecorder{ };
+    recorder.open( base, format, static_cast< ::hinalea::Int >( frames.size( ) ), codec );
+
+    for ( auto i = ::std::size_t{ 0 }; i < frames.size( ); ++i )
+    {
+        recorder.push(
+            FrameView{ frames[ i ].data( ), format.width, format.height, linePitch, format.bitDepth },
+            static_cast< ::hinalea::Int >( i ),
+            static_cast< ::std::int64_t >( i ),
+            static_cast< ::std::uint64_t >( i )
+            );
+    }
+
+    return recorder.close( );
+}
+
+} /* namespace anonymous */
+
+auto Bench::recordFormats(
+    HINALEA_IN Arguments const & arguments
+    ) -> void
+{
+    auto const width = Bench::integer( arguments, 0, 1024 );
+    auto const height = Bench::integer( arguments, 1, 1024 );
+    auto const count = Bench::integer( arguments, 2, 50 );
+    auto const dir = ( ( arguments.size( ) > 3 ) ? ::hinalea::fs::path{ arguments[ 3 ] } : ::hinalea::fs::temp_directory_path( ) )
+                   / "hinalea-record-formats";
+
+    ::std::cout
+        << "Recording " << count << " frames of " << width << " x " << height << " to " << dir.string( )
+        << ", median of " << ::repeats << " runs\n"
+        << "bits  format      frames/s      MB/s  ratio\n"
+        << ::std::fixed << ::std::setprecision( 2 );
+
+    for ( auto const bitDepth : ::bit_depths )
+    {
+        auto const format = RawRecorder::Format{ width, height, bitDepth };
+        auto const frames = ::sceneFrames( width, height, bitDepth, count );
+        auto const rawBytes = static_cast< double >( frames.size( ) * frames.front( ).size( ) );
+
+        auto const print = [ & ]( char const * const name, double const milliseconds, ::std::uint64_t const bytes )
+        {
+            auto const seconds = milliseconds / 1e3;
+            ::std::cout
+                << ::std::setw( 4 ) << bitDepth << "  " << ::std::left << ::std::setw( 10 ) << name << ::std::right
+                << ::std::setw( 10 ) << static_cast< double >( count ) / seconds
+                << ::std::setw( 10 ) << rawBytes / seconds / 1e6
+                << ::std::setw( 7 ) << rawBytes / static_cast< double >( ::std::max( bytes, ::std::uint64_t{ 1 } ) ) << '\n';
+        };
+
+        auto const pngDir = dir / ( "png" + ::std::to_string( bitDepth ) );
+        ::hinalea::fs::remove_all( pngDir );
+        ::hinalea::fs::create_directories( pngDir );
+
+        auto pngBytes = ::std::uint64_t{ 0 };
+        auto const pngTime = Bench::medianMilliseconds( ::repeats, [ & ]{ pngBytes = ::writePng( pngDir, frames, format ); } );
+        print( "png", pngTime, pngBytes );
+
+        auto statistics = RawRecorder::Statistics{ };
+        auto const rawBase = dir / ( "raw" + ::std::to_string( bitDepth ) );
+        auto const rawTime = Bench::medianMilliseconds( ::repeats, [ & ]{ statistics = ::writeRaw( rawBase, frames, format, ::std::nullopt ); } );
+        print( "raw", rawTime, statistics.bytes );
+
+        auto const compressedBase = dir / ( "compressed" + ::std::to_string( bitDepth ) );
+        auto const codec = ::std::optional< FrameCodecSettings >{ FrameCodecSettings{ } };
+        auto const compressedTime = Bench::medianMilliseconds( ::repeats, [ & ]{ statistics = ::writeRaw( compressedBase, frames, format, codec ); } );
+        print( "compressed", compressedTime, statistics.bytes );
+    }
+
+    /* NOTE: Only the directory made for the benchmark, the files are as large as the recordings. */
+    ::hinalea::fs::remove_all( dir );
+}
@@ -0,0 +1,90 @@
+#include "Bench.hxx"
+
+#include "SpectralClassifier.hxx"
+#include "ThreadPool.hxx"
+
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+
+namespace {
+
+inline ::hinalea::Int constexpr band_counts[ ] = { 100, 150, 200, 250, 300 };
+
+inline auto constexpr threshold = 0.2;
+
+inline auto constexpr repeats = 11;
+
+} /* namespace anonymous */
+
+auto Bench::spectralClassifier(
+    HINALEA_IN Arguments const & arguments
+    ) -> void
+{
+    auto const width = Bench::integer( arguments, 0, 512 );
+    auto const height = Bench::integer( arguments, 1, 512 );
+    auto const observations = Bench::integer( arguments, 2, 4 );
+    auto const area = width * height;
+
+    ::std::cout
+        << "Spectral angle of a " << width << " x " << height << " cube against " << observations << " endmembers, threshold "
+        << ::threshold << " rad, " << ThreadPool::global( ).concurrency( ) << " threads, median of " << ::repeats << " runs\n"
+        << "bands  SpectralClassifier ms  Mpixel/s  hinalea::SpectralMetric ms  speedup  mismatched labels\n"
+        << ::std::fixed << ::std::setprecision( 3 );
+
+    auto metric = ::hinalea::SpectralMetric< ::hinalea::f32 >{ ::hinalea::SpectralMetricType::SpectralAngle };
+    auto classifier = SpectralClassifier{ };
+
+    {
+        auto const [ lower, upper ] = metric.threshold_limits( );
+        classifier.setThresholdLimits( SpectralMeasure::SpectralAngle, lower, upper );
+    }
+
+    for ( auto const bands : ::band_counts )
+    {
+        auto const endmembers = Bench::syntheticSpectra( observations, bands );
+        auto const cube = Bench::syntheticCube( endmembers, bands, area );
+
+        /* Fit and classify, like `MainWindow::classifyJob` does for every cube. */
+        auto const classifierTime = Bench::medianMilliseconds(
+            ::repeats,
+            [ & ]
+            {
+                classifier.fit( SpectralMeasure::SpectralAngle, endmembers.data( ), observations, bands );
+                classifier.classify( cube.data( ), area, ::threshold );
+            }
+            );
+
+        auto const metricTime = Bench::medianMilliseconds(
+            ::repeats,
+            [ & ]
+            {
+                auto const X = ::hinalea::Matrix{ ::hinalea::non_null{ cube.data( ) }, bands, area, true };
+                auto const Y = ::hinalea::Matrix{ ::hinalea::non_null{ endmembers.data( ) }, observations, bands, false };
+                metric.fit( X, Y );
+                metric.classify( ::threshold );
+            }
+            );
+
+        auto const & labels = classifier.classes( );
+        auto const * const metricLabels = reinterpret_cast< ::std::uint8_t const * >( metric.classes( ).data( ) );
+        auto const mismatches = ::std::inner_product(
+            labels.begin( ),
+            labels.end( ),
+            metricLabels,
+            ::std::size_t{ 0 },
+            ::std::plus< >{ },
+            ::std::not_equal_to< >{ }
+            );
+
+        ::std::cout
+            << ::std::setw( 5 ) << bands
+            << ::std::setw( 23 ) << classifierTime
+            << ::std::setw( 10 ) << ( static_cast< double >( area ) / 1000.0 / classifierTime )
+            << ::std::setw( 28 ) << metricTime
+            << ::std::setw( 9 ) << ( metricTime / classifierTime )
+            << ::std::setw( 19 ) << mismatches << '\n';
+    }
+}
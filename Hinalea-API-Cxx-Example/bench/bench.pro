@@ -0,0 +1,54 @@
+########################################################################################################################
+# Qt Options
+############
+
+# NOTE:
+# QtCharts (GPL3) is only needed by the chart-update benchmark, like the application it has a different license than
+# base Qt (LGPL3).
+QT += charts core gui widgets
+
+CONFIG += console
+CONFIG -= app_bundle
+
+include( ../common.pri )
+
+########################################################################################################################
+# Source Files
+##############
+
+SOURCES += \
+    Bench.cxx \
+    ChartUpdateBench.cxx \
+    ChunkedCubeBench.cxx \
+    FrameCodecBench.cxx \
+    FrameStatisticsBench.cxx \
+    LibraryClassifierBench.cxx \
+    Main.cxx \
+    ProbeStatisticsBench.cxx \
+    RecordFormatsBench.cxx \
+    SpectralClassifierBench.cxx \
+    ../src/ChunkedCube.cxx \
+    ../src/EnviCube.cxx \
+    ../src/FrameCodec.cxx \
+    ../src/FrameStatistics.cxx \
+    ../src/LibraryClassifier.cxx \
+    ../src/ProbeSet.cxx \
+    ../src/RawRecorder.cxx \
+    ../src/RecordTelemetry.cxx \
+    ../src/SpectralClassifier.cxx \
+    ../src/ThreadPool.cxx
+
+HEADERS += \
+    Bench.hxx
+
+########################################################################################################################
+# Deployment
+############
+
+TARGET = Hinalea-API-Cxx-Bench
+TARGET = $$join( TARGET,,,_qt )
+TARGET = $$join( TARGET,,,$$QT_MAJOR_VERSION )
+CONFIG( debug, debug | release ) { TARGET = $$join( TARGET,,,d ) }
+DESTDIR = $$PWD/../bin
+target.path = $$DESTDIR
+INSTALLS += target
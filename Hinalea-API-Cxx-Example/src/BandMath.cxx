@@ -0,0 +1,838 @@
+#include "BandMath.hxx"
+
+#include "Simd.hxx"
+#include "ThreadPool.hxx"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+
+namespace {
+
+auto constexpr infinity = ::std::numeric_limits< ::hinalea::f32 >::infinity( );
+
+[[ nodiscard ]]
+auto isLetter(
+    HINALEA_IN char const c
+    ) noexcept -> bool
+{
+    return ( ( 'a' <= c ) and ( c <= 'z' ) ) or ( ( 'A' <= c ) and ( c <= 'Z' ) );
+}
+
+[[ nodiscard ]]
+auto isDigit(
+    HINALEA_IN char const c
+    ) noexcept -> bool
+{
+    return ( '0' <= c ) and ( c <= '9' );
+}
+
+} /* namespace anonymous */
+
+/* Recursive descent emitting the postfix program and its register depth, over
+ * `expression := term { ( '+' | '-' ) term }`, `term := unary { ( '*' | '/' ) unary }`, `unary := '-' unary | primary`
+ * and `primary := number | R<nm> | B<index> | function '(' expression [ ',' expression ] ')' | '(' expression ')'`.
+ */
+class BandExpression::Parser
+{
+public:
+    explicit
+    Parser(
+        HINALEA_IN ::std::string_view const source
+        )
+        : text{ source }
+    {
+    }
+
+    auto run(
+        HINALEA_OUT BandExpression & expression
+        ) -> void
+    {
+        this->target = &expression;
+        this->parseExpression( );
+        this->skipSpaces( );
+
+        if ( this->position != this->text.size( ) )
+        {
+            this->fail( "Unexpected character" );
+        }
+
+        if ( this->target->program.empty( ) )
+        {
+            this->fail( "Empty expression" );
+        }
+    }
+
+private:
+    ::std::string_view text;
+    ::std::size_t position{ 0 };
+    ::hinalea::Int stack{ 0 };
+    BandExpression * target{ nullptr };
+
+    [[ noreturn ]]
+    auto fail(
+        HINALEA_IN char const * const what
+        ) const -> void
+    {
+        throw ::std::invalid_argument{ ::std::string{ what } + " at column " + ::std::to_string( this->position + 1 ) + "." };
+    }
+
+    auto skipSpaces(
+        ) -> void
+    {
+        while ( ( this->position < this->text.size( ) ) and ( ( this->text[ this->position ] == ' ' ) or ( this->text[ this->position ] == '\t' ) ) )
+        {
+            ++this->position;
+        }
+    }
+
+    [[ nodiscard ]]
+    auto accept(
+        HINALEA_IN char const c
+        ) -> bool
+    {
+        this->skipSpaces( );
+
+        if ( ( this->position < this->text.size( ) ) and ( this->text[ this->position ] == c ) )
+        {
+            ++this->position;
+            return true;
+        }
+
+        return false;
+    }
+
+    auto expect(
+        HINALEA_IN char const c
+        ) -> void
+    {
+        if ( not this->accept( c ) )
+        {
+            this->fail( ( c == ')' ) ? "Expected ')'" : "Expected ','" );
+        }
+    }
+
+    /* Pushes `instruction`, which pops `operands` and pushes one result. */
+    auto emit(
+        HINALEA_IN Instruction const   instruction,
+        HINALEA_IN ::hinalea::Int const operands
+        ) -> void
+    {
+        this->target->program.push_back( instruction );
+        this->stack += 1 - operands;
+        this->target->depth = ::std::max( this->target->depth, this->stack );
+    }
+
+    [[ nodiscard ]]
+    auto number(
+        ) -> double
+    {
+        auto value = 0.0;
+        auto const * const begin = this->text.data( ) + this->position;
+        auto const [ end, error ] = ::std::from_chars( begin, this->text.data( ) + this->text.size( ), value );
+
+        if ( error != ::std::errc{ } )
+        {
+            this->fail( "Expected a number" );
+        }
+
+        this->position += static_cast< ::std::size_t >( end - begin );
+        return value;
+    }
+
+    auto parseExpression(
+        ) -> void
+    {
+        this->parseTerm( );
+
+        while ( true )
+        {
+            if ( this->accept( '+' ) )
+            {
+                this->parseTerm( );
+                this->emit( Instruction{ Op::Add }, 2 );
+            }
+            else if ( this->accept( '-' ) )
+            {
+                this->parseTerm( );
+                this->emit( Instruction{ Op::Subtract }, 2 );
+            }
+            else
+            {
+                return;
+            }
+        }
+    }
+
+    auto parseTerm(
+        ) -> void
+    {
+        this->parseUnary( );
+
+        while ( true )
+        {
+            if ( this->accept( '*' ) )
+            {
+                this->parseUnary( );
+                this->emit( Instruction{ Op::Multiply }, 2 );
+            }
+            else if ( this->accept( '/' ) )
+            {
+                this->parseUnary( );
+                this->emit( Instruction{ Op::Divide }, 2 );
+            }
+            else
+            {
+                return;
+            }
+        }
+    }
+
+    auto parseUnary(
+        ) -> void
+    {
+        if ( this->accept( '-' ) )
+        {
+            this->parseUnary( );
+            this->emit( Instruction{ Op::Negate }, 1 );
+        }
+        else
+        {
+            this->parsePrimary( );
+        }
+    }
+
+    auto parsePrimary(
+        ) -> void
+    {
+        if ( this->accept( '(' ) )
+        {
+            this->parseExpression( );
+            this->expect( ')' );
+            return;
+        }
+
+        this->skipSpaces( );
+
+        if ( this->position == this->text.size( ) )
+        {
+            this->fail( "Unexpected end of expression" );
+        }
+
+        if ( auto const c = this->text[ this->position ];
+             ::isDigit( c ) or ( c == '.' ) )
+        {
+            auto instruction = Instruction{ Op::Constant };
+            instruction.constant = static_cast< ::hinalea::f32 >( this->number( ) );
+            this->emit( instruction, 0 );
+            return;
+        }
+
+        auto const begin = this->position;
+
+        while ( ( this->position < this->text.size( ) ) and ::isLetter( this->text[ this->position ] ) )
+        {
+            ++this->position;
+        }
+
+        auto const name = this->text.substr( begin, this->position - begin );
+
+        if ( ( name == "R" ) or ( name == "r" ) or ( name == "B" ) or ( name == "b" ) )
+        {
+            auto const value = this->number( );
+            auto instruction = Instruction{ Op::Band };
+
+            if ( ( name == "R" ) or ( name == "r" ) )
+            {
+                instruction.wavelength = value;
+            }
+            else if ( ( value < 0 ) or ( value != ::std::floor( value ) ) )
+            {
+                this->fail( "Band index must be a non negative integer" );
+            }
+            else
+            {
+                instruction.wavelength = -1;
+                instruction.requested = static_cast< ::hinalea::Int >( value );
+            }
+
+            this->emit( instruction, 0 );
+            return;
+        }
+
+        auto const function =
+            [ & ]( Op const op, ::hinalea::Int const arguments )
+            {
+                this->expect( '(' );
+                this->parseExpression( );
+
+                for ( auto i = ::hinalea::Int{ 1 }; i < arguments; ++i )
+                {
+                    this->expect( ',' );
+                    this->parseExpression( );
+                }
+
+                this->expect( ')' );
+                this->emit( Instruction{ op }, arguments );
+            };
+
+        if ( name == "abs" )
+        {
+            function( Op::Absolute, 1 );
+        }
+        else if ( name == "sqrt" )
+        {
+            function( Op::SquareRoot, 1 );
+        }
+        else if ( name == "min" )
+        {
+            function( Op::Minimum, 2 );
+        }
+        else if ( name == "max" )
+        {
+            function( Op::Maximum, 2 );
+        }
+        else
+        {
+            this->position = begin;
+            this->fail( name.empty( ) ? "Unexpected character" : "Unknown name" );
+        }
+    }
+};
+
+
+namespace {
+
+/* Element wise kernels, unary kernels ignore `b`. */
+struct Add
+{
+    static
+    auto scalar(
+        HINALEA_IN ::hinalea::f32 const a,
+        HINALEA_IN ::hinalea::f32 const b
+        ) noexcept -> ::hinalea::f32
+    {
+        return a + b;
+    }
+
+    SIMD_TARGET_AVX2
+    static
+    auto vector(
+        HINALEA_IN __m256 const a,
+        HINALEA_IN __m256 const b
+        ) noexcept -> __m256
+    {
+        return _mm256_add_ps( a, b );
+    }
+};
+
+struct Subtract
+{
+    static
+    auto scalar(
+        HINALEA_IN ::hinalea::f32 const a,
+        HINALEA_IN ::hinalea::f32 const b
+        ) noexcept -> ::hinalea::f32
+    {
+        return a - b;
+    }
+
+    SIMD_TARGET_AVX2
+    static
+    auto vector(
+        HINALEA_IN __m256 const a,
+        HINALEA_IN __m256 const b
+        ) noexcept -> __m256
+    {
+        return _mm256_sub_ps( a, b );
+    }
+};
+
+struct Multiply
+{
+    static
+    auto scalar(
+        HINALEA_IN ::hinalea::f32 const a,
+        HINALEA_IN ::hinalea::f32 const b
+        ) noexcept -> ::hinalea::f32
+    {
+        return a * b;
+    }
+
+    SIMD_TARGET_AVX2
+    static
+    auto vector(
+        HINALEA_IN __m256 const a,
+        HINALEA_IN __m256 const b
+        ) noexcept -> __m256
+    {
+        return _mm256_mul_ps( a, b );
+    }
+};
+
+struct Divide
+{
+    static
+    auto scalar(
+        HINALEA_IN ::hinalea::f32 const a,
+        HINALEA_IN ::hinalea::f32 const b
+        ) noexcept -> ::hinalea::f32
+    {
+        return a / b;
+    }
+
+    SIMD_TARGET_AVX2
+    static
+    auto vector(
+        HINALEA_IN __m256 const a,
+        HINALEA_IN __m256 const b
+        ) noexcept -> __m256
+    {
+        return _mm256_div_ps( a, b );
+    }
+};
+
+/* NOTE: Both variants return `b` when either operand is NaN, like `minps` and `maxps`. */
+struct Minimum
+{
+    static
+    auto scalar(
+        HINALEA_IN ::hinalea::f32 const a,
+        HINALEA_IN ::hinalea::f32 const b
+        ) noexcept -> ::hinalea::f32
+    {
+        return ( a < b ) ? a : b;
+    }
+
+    SIMD_TARGET_AVX2
+    static
+    auto vector(
+        HINALEA_IN __m256 const a,
+        HINALEA_IN __m256 const b
+        ) noexcept -> __m256
+    {
+        return _mm256_min_ps( a, b );
+    }
+};
+
+struct Maximum
+{
+    static
+    auto scalar(
+        HINALEA_IN ::hinalea::f32 const a,
+        HINALEA_IN ::hinalea::f32 const b
+        ) noexcept -> ::hinalea::f32
+    {
+        return ( a > b ) ? a : b;
+    }
+
+    SIMD_TARGET_AVX2
+    static
+    auto vector(
+        HINALEA_IN __m256 const a,
+        HINALEA_IN __m256 const b
+        ) noexcept -> __m256
+    {
+        return _mm256_max_ps( a, b );
+    }
+};
+
+struct Negate
+{
+    static
+    auto scalar(
+        HINALEA_IN ::hinalea::f32 const a,
+        HINALEA_IN ::hinalea::f32
+        ) noexcept -> ::hinalea::f32
+    {
+        return -a;
+    }
+
+    SIMD_TARGET_AVX2
+    static
+    auto vector(
+        HINALEA_IN __m256 const a,
+        HINALEA_IN __m256
+        ) noexcept -> __m256
+    {
+        return _mm256_xor_ps( a, _mm256_set1_ps( -0.0f ) );
+    }
+};
+
+struct Absolute
+{
+    static
+    auto scalar(
+        HINALEA_IN ::hinalea::f32 const a,
+        HINALEA_IN ::hinalea::f32
+        ) noexcept -> ::hinalea::f32
+    {
+        return ::std::abs( a );
+    }
+
+    SIMD_TARGET_AVX2
+    static
+    auto vector(
+        HINALEA_IN __m256 const a,
+        HINALEA_IN __m256
+        ) noexcept -> __m256
+    {
+        return _mm256_andnot_ps( _mm256_set1_ps( -0.0f ), a );
+    }
+};
+
+struct SquareRoot
+{
+    static
+    auto scalar(
+        HINALEA_IN ::hinalea::f32 const a,
+        HINALEA_IN ::hinalea::f32
+        ) noexcept -> ::hinalea::f32
+    {
+        return ::std::sqrt( a );
+    }
+
+    SIMD_TARGET_AVX2
+    static
+    auto vector(
+        HINALEA_IN __m256 const a,
+        HINALEA_IN __m256
+        ) noexcept -> __m256
+    {
+        return _mm256_sqrt_ps( a );
+    }
+};
+
+template <
+    typename Kernel
+    >
+auto applyScalar(
+    HINALEA_IN  ::hinalea::f32 const * const a,
+    HINALEA_IN  ::hinalea::f32 const * const b,
+    HINALEA_OUT ::hinalea::f32 *       const out,
+    HINALEA_IN  ::hinalea::Int         const begin,
+    HINALEA_IN  ::hinalea::Int         const count
+    ) -> void
+{
+    for ( auto i = begin; i < count; ++i )
+    {
+        out[ i ] = Kernel::scalar( a[ i ], b[ i ] );
+    }
+}
+
+template <
+    typename Kernel
+    >
+SIMD_TARGET_AVX2
+auto applyAvx2(
+    HINALEA_IN  ::hinalea::f32 const * const a,
+    HINALEA_IN  ::hinalea::f32 const * const b,
+    HINALEA_OUT ::hinalea::f32 *       const out,
+    HINALEA_IN  ::hinalea::Int         const count
+    ) -> void
+{
+    auto constexpr lanes = ::hinalea::Int{ 8 };
+    auto i = ::hinalea::Int{ 0 };
+
+    for ( ; i + lanes <= count; i += lanes )
+    {
+        _mm256_storeu_ps( out + i, Kernel::vector( _mm256_loadu_ps( a + i ), _mm256_loadu_ps( b + i ) ) );
+    }
+
+    ::applyScalar< Kernel >( a, b, out, i, count );
+}
+
+/* `a` and `b` may alias `out`. */
+template <
+    typename Kernel
+    >
+auto apply(
+    HINALEA_IN  bool                   const avx2,
+    HINALEA_IN  ::hinalea::f32 const * const a,
+    HINALEA_IN  ::hinalea::f32 const * const b,
+    HINALEA_OUT ::hinalea::f32 *       const out,
+    HINALEA_IN  ::hinalea::Int         const count
+    ) -> void
+{
+    if ( avx2 )
+    {
+        ::applyAvx2< Kernel >( a, b, out, count );
+    }
+    else
+    {
+        ::applyScalar< Kernel >( a, b, out, 0, count );
+    }
+}
+
+/* Copies `values` into `out` and widens `minimum` and `maximum` by its finite values. */
+auto storeScalar(
+    HINALEA_IN    ::hinalea::f32 const * const values,
+    HINALEA_OUT   ::hinalea::f32 *       const out,
+    HINALEA_IN    ::hinalea::Int         const begin,
+    HINALEA_IN    ::hinalea::Int         const count,
+    HINALEA_INOUT ::hinalea::f32 &             minimum,
+    HINALEA_INOUT ::hinalea::f32 &             maximum
+    ) -> void
+{
+    for ( auto i = begin; i < count; ++i )
+    {
+        auto const value = values[ i ];
+        out[ i ] = value;
+
+        if ( ::std::isfinite( value ) )
+        {
+            minimum = ::std::min( minimum, value );
+            maximum = ::std::max( maximum, value );
+        }
+    }
+}
+
+SIMD_TARGET_AVX2
+auto storeAvx2(
+    HINALEA_IN    ::hinalea::f32 const * const values,
+    HINALEA_OUT   ::hinalea::f32 *       const out,
+    HINALEA_IN    ::hinalea::Int         const count,
+    HINALEA_INOUT ::hinalea::f32 &             minimum,
+    HINALEA_INOUT ::hinalea::f32 &             maximum
+    ) -> void
+{
+    auto constexpr lanes = ::hinalea::Int{ 8 };
+    auto const positiveInfinity = _mm256_set1_ps( ::infinity );
+    auto const negativeInfinity = _mm256_set1_ps( -::infinity );
+    auto const sign = _mm256_set1_ps( -0.0f );
+    auto vmin = positiveInfinity;
+    auto vmax = negativeInfinity;
+    auto i = ::hinalea::Int{ 0 };
+
+    for ( ; i + lanes <= count; i += lanes )
+    {
+        auto const v = _mm256_loadu_ps( values + i );
+        auto const finite = _mm256_cmp_ps( _mm256_andnot_ps( sign, v ), positiveInfinity, _CMP_LT_OQ );
+        _mm256_storeu_ps( out + i, v );
+        vmin = _mm256_min_ps( vmin, _mm256_blendv_ps( positiveInfinity, v, finite ) );
+        vmax = _mm256_max_ps( vmax, _mm256_blendv_ps( negativeInfinity, v, finite ) );
+    }
+
+    alignas( 32 ) ::hinalea::f32 mins[ lanes ];
+    alignas( 32 ) ::hinalea::f32 maxs[ lanes ];
+    _mm256_store_ps( mins, vmin );
+    _mm256_store_ps( maxs, vmax );
+    minimum = ::std::min( minimum, *::std::min_element( mins, mins + lanes ) );
+    maximum = ::std::max( maximum, *::std::max_element( maxs, maxs + lanes ) );
+
+    ::storeScalar( values, out, i, count, minimum, maximum );
+}
+
+/* Wavelength with up to 6 significant digits, eg. "800" or "670.1". */
+[[ nodiscard ]]
+auto formatNumber(
+    HINALEA_IN double const value
+    ) -> ::std::string
+{
+    char buffer[ 32 ];
+    auto const [ end, error ] = ::std::to_chars( buffer, buffer + sizeof( buffer ), value, ::std::chars_format::general, 6 );
+    HINALEA_ASSERT( error == ::std::errc{ } );
+    return ::std::string( buffer, end );
+}
+
+} /* namespace anonymous */
+
+auto BandExpression::parse(
+    HINALEA_IN ::std::string_view const text
+    ) -> BandExpression
+{
+    auto expression = BandExpression{ };
+    Parser{ text }.run( expression );
+    return expression;
+}
+
+auto BandExpression::bind(
+    HINALEA_IN ::std::vector< double > const & wavelengths
+    ) const -> BandExpression
+{
+    auto bound = *this;
+    bound.bandCount = static_cast< ::hinalea::Int >( wavelengths.size( ) );
+    bound.bandWavelengths = wavelengths;
+
+    for ( auto & instruction : bound.program )
+    {
+        if ( instruction.op != Op::Band )
+        {
+            continue;
+        }
+
+        if ( instruction.wavelength < 0 )
+        {
+            if ( instruction.requested >= bound.bandCount )
+            {
+                throw ::std::invalid_argument{
+                    "Band B" + ::std::to_string( instruction.requested ) + " is out of range, the cubes have "
+                    + ::std::to_string( bound.bandCount ) + " bands."
+                    };
+            }
+
+            instruction.band = instruction.requested;
+        }
+        else
+        {
+            if ( wavelengths.empty( ) )
+            {
+                throw ::std::invalid_argument{ "Wavelength references need the band wavelengths of the camera." };
+            }
+
+            auto const nearest = ::std::min_element(
+                wavelengths.begin( ),
+                wavelengths.end( ),
+                [ & ]( double const a, double const b ){ return ::std::abs( a - instruction.wavelength ) < ::std::abs( b - instruction.wavelength ); }
+                );
+            instruction.band = static_cast< ::hinalea::Int >( nearest - wavelengths.begin( ) );
+        }
+    }
+
+    return bound;
+}
+
+auto BandExpression::bands(
+    ) const noexcept -> ::hinalea::Int
+{
+    return this->bandCount;
+}
+
+auto BandExpression::describe(
+    ) const -> ::std::string
+{
+    auto references = ::std::vector< ::std::string >{ };
+
+    for ( auto const & instruction : this->program )
+    {
+        if ( ( instruction.op != Op::Band ) or ( instruction.band < 0 ) )
+        {
+            continue;
+        }
+
+        auto const index = static_cast< ::std::size_t >( instruction.band );
+        auto const resolved = "B" + ::std::to_string( instruction.band ) + " (" + ::formatNumber( this->bandWavelengths[ index ] ) + " nm)";
+        auto reference = ( instruction.wavelength < 0 )
+            ? resolved
+            : "R" + ::formatNumber( instruction.wavelength ) + " = " + resolved;
+
+        if ( ::std::find( references.begin( ), references.end( ), reference ) == references.end( ) )
+        {
+            references.push_back( ::std::move( reference ) );
+        }
+    }
+
+    auto text = ::std::string{ };
+
+    for ( auto const & reference : references )
+    {
+        text += ( text.empty( ) ? "" : ", " ) + reference;
+    }
+
+    return text;
+}
+
+auto BandExpression::evaluate(
+    HINALEA_IN  ::hinalea::f32 const * const cube,
+    HINALEA_IN  ::hinalea::Int         const area,
+    HINALEA_OUT ::hinalea::f32 *       const out
+    ) const -> ::std::pair< ::hinalea::f32, ::hinalea::f32 >
+{
+    HINALEA_ASSERT( not this->program.empty( ) );
+    HINALEA_ASSERT( this->bandCount > 0 );
+
+    auto const avx2 = simd::level( ) == simd::Level::Avx2;
+    auto const blocks = static_cast< ::std::size_t >( ( area + blockSize - 1 ) / blockSize );
+    auto const registerCount = static_cast< ::std::size_t >( this->depth );
+    auto mutex = ::std::mutex{ };
+    auto minimum = ::infinity;
+    auto maximum = -::infinity;
+
+    ThreadPool::global( ).parallelFor(
+        blocks,
+        8,
+        [ & ]( ::std::size_t const begin, ::std::size_t const end )
+        {
+            /* NOTE: Operands point either into the cube planes or into the block registers. */
+            thread_local auto registers = ::std::vector< ::hinalea::f32 >{ };
+            thread_local auto operands = ::std::vector< ::hinalea::f32 const * >{ };
+            registers.resize( registerCount * static_cast< ::std::size_t >( blockSize ) );
+            operands.resize( registerCount );
+
+            auto localMinimum = ::infinity;
+            auto localMaximum = -::infinity;
+
+            for ( auto block = begin; block < end; ++block )
+            {
+                auto const first = static_cast< ::hinalea::Int >( block ) * blockSize;
+                auto const count = ::std::min( blockSize, area - first );
+                auto top = ::std::size_t{ 0 };
+
+                for ( auto const & instruction : this->program )
+                {
+                    if ( instruction.op == Op::Band )
+                    {
+                        operands[ top++ ] = cube + instruction.band * area + first;
+                        continue;
+                    }
+
+                    if ( instruction.op == Op::Constant )
+                    {
+                        auto * const result = registers.data( ) + top * static_cast< ::std::size_t >( blockSize );
+                        ::std::fill_n( result, count, instruction.constant );
+                        operands[ top++ ] = result;
+                        continue;
+                    }
+
+                    auto const unary = ( instruction.op == Op::Negate ) or ( instruction.op == Op::Absolute ) or ( instruction.op == Op::SquareRoot );
+                    auto const target = top - ( unary ? 1 : 2 );
+                    auto * const result = registers.data( ) + target * static_cast< ::std::size_t >( blockSize );
+                    auto const * const a = operands[ target ];
+                    auto const * const b = unary ? a : operands[ target + 1 ];
+
+                    switch ( instruction.op )
+                    {
+                    case Op::Add:        ::apply< ::Add >( avx2, a, b, result, count ); break;
+                    case Op::Subtract:   ::apply< ::Subtract >( avx2, a, b, result, count ); break;
+                    case Op::Multiply:   ::apply< ::Multiply >( avx2, a, b, result, count ); break;
+                    case Op::Divide:     ::apply< ::Divide >( avx2, a, b, result, count ); break;
+                    case Op::Minimum:    ::apply< ::Minimum >( avx2, a, b, result, count ); break;
+                    case Op::Maximum:    ::apply< ::Maximum >( avx2, a, b, result, count ); break;
+                    case Op::Negate:     ::apply< ::Negate >( avx2, a, b, result, count ); break;
+                    case Op::Absolute:   ::apply< ::Absolute >( avx2, a, b, result, count ); break;
+                    case Op::SquareRoot: ::apply< ::SquareRoot >( avx2, a, b, result, count ); break;
+                    case Op::Band:
+                    case Op::Constant:   break;
+                    }
+
+                    operands[ target ] = result;
+                    top = target + 1;
+                }
+
+                if ( avx2 )
+                {
+                    ::storeAvx2( operands[ 0 ], out + first, count, localMinimum, localMaximum );
+                }
+                else
+                {
+                    ::storeScalar( operands[ 0 ], out + first, 0, count, localMinimum, localMaximum );
+                }
+            }
+
+            auto const lock = ::std::scoped_lock{ mutex };
+            minimum = ::std::min( minimum, localMinimum );
+            maximum = ::std::max( maximum, localMaximum );
+        }
+        );
+
+    if ( minimum > maximum )
+    {
+        auto constexpr nan = ::std::numeric_limits< ::hinalea::f32 >::quiet_NaN( );
+        return { nan, nan };
+    }
+
+    return { minimum, maximum };
+}
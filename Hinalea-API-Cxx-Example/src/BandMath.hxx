@@ -0,0 +1,76 @@
+#pragma once
+
+#include <Hinalea.h>
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/* Per-pixel band arithmetic over BSQ float cubes, eg. `(R800 - R670) / (R800 + R670)`.
+ *
+ * Expressions use `+ - * /`, parentheses, numbers and the functions `abs`, `sqrt`, `min` and `max`. `R<nm>` is the
+ * band closest to a wavelength in nanometers and `B<index>` is a band by its index.
+ *
+ * The expression is compiled into a postfix program once. Evaluation runs the whole program over blocks of pixels,
+ * with band operands pointing straight into the cube planes and intermediate results in block sized registers that
+ * stay in L1, so each referenced band is read from memory exactly once and nothing else is. The arithmetic runs on
+ * AVX2 (scalar fallback), and blocks are spread across `ThreadPool::global( )`.
+ */
+class BandExpression
+{
+public:
+    /* Pixels per block, a multiple of the SIMD width. */
+    static auto constexpr blockSize = ::hinalea::Int{ 512 };
+
+    /* Throws `std::invalid_argument` with the offending column on syntax errors. */
+    [[ nodiscard ]]
+    static
+    auto parse(
+        HINALEA_IN ::std::string_view text
+        ) -> BandExpression;
+
+    /* Resolves the band references against the band wavelengths of the cubes to evaluate. Throws
+     * `std::invalid_argument` if a band index is out of range, or there are no wavelengths for `R` references.
+     */
+    [[ nodiscard ]]
+    auto bind(
+        HINALEA_IN ::std::vector< double > const & wavelengths
+        ) const -> BandExpression;
+
+    /* Band count the expression was bound to, 0 before `bind`. */
+    [[ nodiscard ]]
+    auto bands(
+        ) const noexcept -> ::hinalea::Int;
+
+    /* Referenced bands and their resolved indices, eg. "R800 = B57 (801.3 nm)", one per distinct reference. */
+    [[ nodiscard ]]
+    auto describe(
+        ) const -> ::std::string;
+
+    /* Writes one value per pixel into `out`, returns the minimum and maximum of the finite values, or NaNs if none. */
+    auto evaluate(
+        HINALEA_IN  ::hinalea::f32 const * cube,
+        HINALEA_IN  ::hinalea::Int         area,
+        HINALEA_OUT ::hinalea::f32 *       out
+        ) const -> ::std::pair< ::hinalea::f32, ::hinalea::f32 >;
+
+private:
+    enum class Op { Band, Constant, Add, Subtract, Multiply, Divide, Negate, Minimum, Maximum, Absolute, SquareRoot };
+
+    struct Instruction
+    {
+        Op op{ Op::Constant };
+        ::hinalea::f32 constant{ 0 };
+        ::hinalea::Int band{ -1 };      /* Resolved band of `Op::Band`. */
+        double wavelength{ 0 };         /* Requested wavelength of `Op::Band`, or negative for `B<index>`. */
+        ::hinalea::Int requested{ -1 }; /* Requested index of `B<index>`. */
+    };
+
+    class Parser;
+
+    ::std::vector< Instruction > program{ };
+    ::hinalea::Int depth{ 0 }; /* Registers needed by the program. */
+    ::hinalea::Int bandCount{ 0 };
+    ::std::vector< double > bandWavelengths{ };
+};
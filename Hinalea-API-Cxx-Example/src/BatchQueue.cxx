@@ -0,0 +1,235 @@
+#include "BatchQueue.hxx"
+
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+
+BatchQueue::~BatchQueue(
+    )
+{
+    this->cancelAll( );
+    this->wait( );
+}
+
+auto BatchQueue::start(
+    HINALEA_IN ::std::vector< Job > jobs,
+    HINALEA_IN Limits const &       newLimits,
+    HINALEA_IN Work                 newWork
+    ) -> void
+{
+    HINALEA_ASSERT( newWork != nullptr );
+
+    if ( this->isBusy( ) )
+    {
+        throw ::std::logic_error{ "The previous batch is still running." };
+    }
+
+    this->wait( );
+
+    this->batch = ::std::move( jobs );
+    this->limits = newLimits;
+    this->limits.jobs = ::std::clamp< ::std::size_t >( newLimits.jobs, 1, ::std::max< ::std::size_t >( this->batch.size( ), 1 ) );
+    this->work = ::std::move( newWork );
+
+    {
+        auto const lock = ::std::scoped_lock{ this->mutex };
+        this->entries.assign( this->batch.size( ), Entry{ } );
+        this->next = 0;
+        this->running = 0;
+        this->memoryInUse = 0;
+        this->started = Clock::now( );
+        this->finished = this->started;
+    }
+
+    for ( auto worker = ::std::size_t{ 0 }; worker < this->limits.jobs; ++worker )
+    {
+        this->workers.emplace_back( &BatchQueue::run, this, worker );
+    }
+}
+
+auto BatchQueue::cancel(
+    HINALEA_IN ::std::size_t const index
+    ) -> bool
+{
+    {
+        auto const lock = ::std::scoped_lock{ this->mutex };
+
+        if ( ( index >= this->entries.size( ) ) or ( this->entries[ index ].status.state != State::Queued ) )
+        {
+            return false;
+        }
+
+        this->entries[ index ].status.state = State::Cancelled;
+    }
+
+    /* NOTE: A worker waiting for the budget may be waiting for this job. */
+    this->changed.notify_all( );
+    return true;
+}
+
+auto BatchQueue::cancelAll(
+    ) -> void
+{
+    {
+        auto const lock = ::std::scoped_lock{ this->mutex };
+
+        for ( auto & entry : this->entries )
+        {
+            if ( entry.status.state == State::Queued )
+            {
+                entry.status.state = State::Cancelled;
+            }
+        }
+    }
+
+    this->changed.notify_all( );
+}
+
+auto BatchQueue::wait(
+    ) -> void
+{
+    for ( auto & worker : this->workers )
+    {
+        if ( worker.joinable( ) )
+        {
+            worker.join( );
+        }
+    }
+
+    this->workers.clear( );
+}
+
+auto BatchQueue::isBusy(
+    ) const -> bool
+{
+    auto const lock = ::std::scoped_lock{ this->mutex };
+    return ::std::any_of( this->entries.begin( ), this->entries.end( ), []( Entry const & entry ){
+        return ( entry.status.state == State::Queued ) or ( entry.status.state == State::Running );
+        } );
+}
+
+auto BatchQueue::jobs(
+    ) const noexcept -> ::std::vector< Job > const &
+{
+    return this->batch;
+}
+
+auto BatchQueue::status(
+    ) const -> ::std::vector< JobStatus >
+{
+    auto const lock = ::std::scoped_lock{ this->mutex };
+    auto const now = Clock::now( );
+    auto status = ::std::vector< JobStatus >{ };
+    status.reserve( this->entries.size( ) );
+
+    for ( auto const & entry : this->entries )
+    {
+        status.push_back( entry.status );
+
+        if ( entry.status.state == State::Running )
+        {
+            status.back( ).elapsed = now - entry.started;
+        }
+    }
+
+    return status;
+}
+
+auto BatchQueue::statistics(
+    ) const -> Statistics
+{
+    auto const lock = ::std::scoped_lock{ this->mutex };
+    auto statistics = Statistics{ };
+
+    for ( auto index = ::std::size_t{ 0 }; index < this->entries.size( ); ++index )
+    {
+        switch ( this->entries[ index ].status.state )
+        {
+        case State::Queued:    ++statistics.queued;    break;
+        case State::Running:   ++statistics.running;   break;
+        case State::Failed:    ++statistics.failed;    break;
+        case State::Cancelled: ++statistics.cancelled; break;
+        case State::Done:
+            ++statistics.done;
+            statistics.inputBytesDone += this->batch[ index ].inputBytes;
+            break;
+        }
+    }
+
+    statistics.memoryInUse = this->memoryInUse;
+    statistics.elapsed = ( ( statistics.queued + statistics.running ) > 0 ? Clock::now( ) : this->finished ) - this->started;
+    return statistics;
+}
+
+auto BatchQueue::run(
+    HINALEA_IN ::std::size_t const worker
+    ) -> void
+{
+    while ( true )
+    {
+        auto index = ::std::size_t{ };
+
+        {
+            auto lock = ::std::unique_lock{ this->mutex };
+
+            /* Strictly in order: the next queued job starts once it fits, or nothing else is running. */
+            auto const admissible = [ this ]{
+                while ( ( this->next < this->entries.size( ) ) and ( this->entries[ this->next ].status.state != State::Queued ) )
+                {
+                    ++this->next;
+                }
+
+                return ( this->next == this->entries.size( ) ) or ( this->running == 0 ) or
+                       ( this->memoryInUse + this->batch[ this->next ].memoryBytes <= this->limits.memoryBytes );
+                };
+
+            this->changed.wait( lock, admissible );
+
+            if ( this->next == this->entries.size( ) )
+            {
+                return;
+            }
+
+            index = this->next++;
+            ++this->running;
+            this->memoryInUse += this->batch[ index ].memoryBytes;
+            this->entries[ index ].status.state = State::Running;
+            this->entries[ index ].started = Clock::now( );
+        }
+
+        auto state = State::Done;
+        auto error = ::std::string{ };
+
+        try
+        {
+            this->work( worker, this->batch[ index ], [ this, index ]( int const percent ){
+                auto const lock = ::std::scoped_lock{ this->mutex };
+                this->entries[ index ].status.percent = ::std::clamp( percent, 0, 100 );
+                } );
+        }
+        catch ( ::std::exception const & exception )
+        {
+            state = State::Failed;
+            error = exception.what( );
+        }
+        catch ( ... )
+        {
+            state = State::Failed;
+            error = "Unknown error.";
+        }
+
+        {
+            auto const lock = ::std::scoped_lock{ this->mutex };
+            auto & entry = this->entries[ index ];
+            entry.status.state = state;
+            entry.status.error = ::std::move( error );
+            entry.status.percent = ( state == State::Done ) ? 100 : entry.status.percent;
+            entry.status.elapsed = Clock::now( ) - entry.started;
+            --this->running;
+            this->memoryInUse -= this->batch[ index ].memoryBytes;
+            this->finished = Clock::now( );
+        }
+
+        this->changed.notify_all( );
+    }
+}
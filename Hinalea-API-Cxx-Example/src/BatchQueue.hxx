@@ -0,0 +1,149 @@
+#pragma once
+
+#include <Hinalea.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* Runs a batch of processing jobs, eg. one per raw capture, on a few worker threads.
+ *
+ * Jobs start in the order given. At most `Limits::jobs` run at once, and a job only starts while the memory estimates
+ * of the running jobs and its own fit in `Limits::memoryBytes`; a job larger than the whole budget runs alone. Waiting
+ * for the budget holds back the jobs after it too, so a large capture is not starved by the small ones behind it.
+ *
+ * A queued job can be cancelled; a running job cannot, the work function is left to finish.
+ */
+class BatchQueue
+{
+public:
+    enum class State { Queued, Running, Done, Failed, Cancelled };
+
+    struct Job
+    {
+        ::hinalea::fs::path input{ };
+        ::hinalea::fs::path output{ };
+        ::std::uint64_t inputBytes{ };  /* For the throughput. */
+        ::std::uint64_t memoryBytes{ }; /* Estimated peak while running. */
+    };
+
+    struct JobStatus
+    {
+        State state{ State::Queued };
+        int percent{ 0 };
+        ::std::string error{ };              /* Of a failed job. */
+        ::std::chrono::nanoseconds elapsed{ }; /* Running, so far, or finished. */
+    };
+
+    struct Limits
+    {
+        ::std::size_t jobs{ 1 };
+        ::std::uint64_t memoryBytes{ };
+    };
+
+    struct Statistics
+    {
+        ::std::size_t queued{ };
+        ::std::size_t running{ };
+        ::std::size_t done{ };
+        ::std::size_t failed{ };
+        ::std::size_t cancelled{ };
+        ::std::uint64_t inputBytesDone{ };  /* Of the jobs done. */
+        ::std::uint64_t memoryInUse{ };     /* Estimates of the running jobs. */
+        ::std::chrono::nanoseconds elapsed{ }; /* Since `start`, until the last job finished. */
+    };
+
+    /* Reports the percentage of the running job, from its worker thread. */
+    using Progress = ::std::function< void ( int percent ) >;
+
+    /* Runs `job` on worker `worker`, below `Limits::jobs`, so per worker resources can be indexed by it. A job fails by
+     * throwing.
+     */
+    using Work = ::std::function< void ( ::std::size_t worker, Job const & job, Progress const & progress ) >;
+
+    BatchQueue(
+        ) = default;
+
+    /* Cancels the queued jobs and waits for the running ones. */
+    ~BatchQueue(
+        );
+
+    BatchQueue(
+        BatchQueue const &
+        ) = delete;
+
+    auto operator=(
+        BatchQueue const &
+        ) -> BatchQueue & = delete;
+
+    /* Starts working through `jobs`. Waits for the workers of the previous batch, which must have finished. */
+    auto start(
+        HINALEA_IN ::std::vector< Job > jobs,
+        HINALEA_IN Limits const &       limits,
+        HINALEA_IN Work                 work
+        ) -> void;
+
+    /* Cancels job `index` if it is still queued. */
+    auto cancel(
+        HINALEA_IN ::std::size_t index
+        ) -> bool;
+
+    /* Cancels every queued job. */
+    auto cancelAll(
+        ) -> void;
+
+    /* Waits for the workers, ie. until every job is finished or cancelled. */
+    auto wait(
+        ) -> void;
+
+    /* Whether jobs are queued or running. */
+    [[ nodiscard ]]
+    auto isBusy(
+        ) const -> bool;
+
+    /* Jobs of the current batch, fixed from `start` on. */
+    [[ nodiscard ]]
+    auto jobs(
+        ) const noexcept -> ::std::vector< Job > const &;
+
+    [[ nodiscard ]]
+    auto status(
+        ) const -> ::std::vector< JobStatus >;
+
+    [[ nodiscard ]]
+    auto statistics(
+        ) const -> Statistics;
+
+private:
+    using Clock = ::std::chrono::steady_clock;
+
+    struct Entry
+    {
+        JobStatus status{ };
+        Clock::time_point started{ };
+    };
+
+    auto run(
+        HINALEA_IN ::std::size_t worker
+        ) -> void;
+
+    ::std::vector< Job > batch{ };
+    Limits limits{ };
+    Work work{ };
+    ::std::vector< ::std::thread > workers{ };
+
+    mutable ::std::mutex mutex{ };
+    ::std::condition_variable changed{ };
+    ::std::vector< Entry > entries{ };
+    ::std::size_t next{ 0 }; /* Jobs before `next` are started or cancelled. */
+    ::std::size_t running{ 0 };
+    ::std::uint64_t memoryInUse{ 0 };
+    Clock::time_point started{ };
+    Clock::time_point finished{ }; /* Of the last job to finish. */
+};
@@ -0,0 +1,498 @@
+#include "ChunkedCube.hxx"
+
+#include "ThreadPool.hxx"
+
+#include <QByteArray>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+static_assert( ::std::endian::native == ::std::endian::little, "Chunked cubes are written in native byte order." );
+
+namespace {
+
+auto constexpr fileMagic = "HNLCHCB1";
+auto constexpr fileVersion = ::std::uint32_t{ 1 };
+auto constexpr fileHeaderFields = ::std::size_t{ 64 };
+auto constexpr chunkEntryBytes = ::std::size_t{ 16 };
+auto constexpr dataAlignment = ::std::size_t{ 4096 };
+
+/* Bands and pixels of one chunk. */
+struct ChunkShape
+{
+    ::hinalea::Int band{ };
+    ::hinalea::Int bands{ };
+    ::hinalea::Int x{ };
+    ::hinalea::Int y{ };
+    ::hinalea::Int width{ };
+    ::hinalea::Int height{ };
+
+    [[ nodiscard ]]
+    auto samples(
+        ) const noexcept -> ::std::size_t
+    {
+        return static_cast< ::std::size_t >( this->bands * this->width * this->height );
+    }
+};
+
+[[ nodiscard ]]
+constexpr
+auto roundUp(
+    HINALEA_IN ::std::size_t const bytes
+    ) noexcept -> ::std::size_t
+{
+    return ( bytes + dataAlignment - 1 ) / dataAlignment * dataAlignment;
+}
+
+template <
+    typename T
+    >
+auto store(
+    HINALEA_OUT ::std::vector< char > & buffer,
+    HINALEA_IN  ::std::size_t           offset,
+    HINALEA_IN  T const &               value
+    ) -> void
+{
+    ::std::memcpy( buffer.data( ) + offset, &value, sizeof( T ) );
+}
+
+template <
+    typename T
+    >
+[[ nodiscard ]]
+auto load(
+    HINALEA_IN ::std::vector< char > const & buffer,
+    HINALEA_IN ::std::size_t                 offset
+    ) -> T
+{
+    auto value = T{ };
+    ::std::memcpy( &value, buffer.data( ) + offset, sizeof( T ) );
+    return value;
+}
+
+[[ nodiscard ]]
+auto chunkShape(
+    HINALEA_IN ::hinalea::Int         const width,
+    HINALEA_IN ::hinalea::Int         const height,
+    HINALEA_IN ::hinalea::Int         const bands,
+    HINALEA_IN ChunkedCube::Options const &  options,
+    HINALEA_IN ::hinalea::Int         const block,
+    HINALEA_IN ::hinalea::Int         const tileX,
+    HINALEA_IN ::hinalea::Int         const tileY
+    ) noexcept -> ChunkShape
+{
+    auto shape = ChunkShape{ };
+    shape.band = block * options.bandsPerChunk;
+    shape.bands = ::std::min( options.bandsPerChunk, bands - shape.band );
+    shape.x = tileX * options.tileSize;
+    shape.y = tileY * options.tileSize;
+    shape.width = ::std::min( options.tileSize, width - shape.x );
+    shape.height = ::std::min( options.tileSize, height - shape.y );
+    return shape;
+}
+
+/* Gathers a chunk from its band planes, `planeWidth` samples per line, and encodes it. */
+[[ nodiscard ]]
+auto encodeChunk(
+    HINALEA_IN ChunkShape const &                 shape,
+    HINALEA_IN ::hinalea::f32 const *       const planes,
+    HINALEA_IN ::hinalea::Int               const planeWidth,
+    HINALEA_IN ::hinalea::Int               const planeHeight,
+    HINALEA_IN ChunkedCube::Options const &       options
+    ) -> QByteArray
+{
+    auto raw = ::std::vector< ::hinalea::f32 >( shape.samples( ) );
+    auto * target = raw.data( );
+
+    for ( auto b = ::hinalea::Int{ 0 }; b < shape.bands; ++b )
+    {
+        auto const * const plane = planes + b * planeWidth * planeHeight;
+
+        for ( auto y = shape.y; y < shape.y + shape.height; ++y )
+        {
+            target = ::std::copy_n( plane + y * planeWidth + shape.x, shape.width, target );
+        }
+    }
+
+    auto const rawBytes = raw.size( ) * sizeof( ::hinalea::f32 );
+
+    if ( options.compression == ChunkedCube::Compression::Deflate )
+    {
+        /* NOTE: Byte planes put the sign and exponent bytes, which barely change within a tile, next to each other. */
+        auto shuffled = ::std::vector< char >( rawBytes );
+        auto const * const bytes = reinterpret_cast< char const * >( raw.data( ) );
+
+        for ( auto i = ::std::size_t{ 0 }; i < raw.size( ); ++i )
+        {
+            for ( auto k = ::std::size_t{ 0 }; k < sizeof( ::hinalea::f32 ); ++k )
+            {
+                shuffled[ k * raw.size( ) + i ] = bytes[ i * sizeof( ::hinalea::f32 ) + k ];
+            }
+        }
+
+        auto packed = ::qCompress( reinterpret_cast< uchar const * >( shuffled.data( ) ), static_cast< int >( rawBytes ), options.level );
+
+        if ( static_cast< ::std::size_t >( packed.size( ) ) < rawBytes )
+        {
+            return packed;
+        }
+    }
+
+    return QByteArray{ reinterpret_cast< char const * >( raw.data( ) ), static_cast< int >( rawBytes ) };
+}
+
+/* Decodes a stored chunk into `shape.samples( )` samples. */
+auto decodeChunk(
+    HINALEA_IN  ChunkShape const &     shape,
+    HINALEA_IN  QByteArray const &     stored,
+    HINALEA_OUT ::hinalea::f32 * const out
+    ) -> void
+{
+    auto const samples = shape.samples( );
+    auto const rawBytes = samples * sizeof( ::hinalea::f32 );
+
+    if ( static_cast< ::std::size_t >( stored.size( ) ) == rawBytes )
+    {
+        ::std::memcpy( out, stored.constData( ), rawBytes );
+        return;
+    }
+
+    auto const shuffled = ::qUncompress( stored );
+
+    if ( static_cast< ::std::size_t >( shuffled.size( ) ) != rawBytes )
+    {
+        throw ::std::runtime_error{ "Corrupt chunk in chunked cube." };
+    }
+
+    auto * const bytes = reinterpret_cast< char * >( out );
+
+    for ( auto i = ::std::size_t{ 0 }; i < samples; ++i )
+    {
+        for ( auto k = ::std::size_t{ 0 }; k < sizeof( ::hinalea::f32 ); ++k )
+        {
+            bytes[ i * sizeof( ::hinalea::f32 ) + k ] = shuffled[ static_cast< int >( k * samples + i ) ];
+        }
+    }
+}
+
+} /* namespace anonymous */
+
+auto ChunkedCube::write(
+    HINALEA_IN ::hinalea::fs::path const &     path,
+    HINALEA_IN ::hinalea::Int            const width,
+    HINALEA_IN ::hinalea::Int            const height,
+    HINALEA_IN ::hinalea::Int            const bands,
+    HINALEA_IN ::std::vector< double > const & wavelengths,
+    HINALEA_IN BandSource const &              source,
+    HINALEA_IN Options const &                 options
+    ) -> WriteStatistics
+{
+    if ( ( width < 1 ) or ( height < 1 ) or ( bands < 1 ) or ( options.bandsPerChunk < 1 ) or ( options.tileSize < 1 ) )
+    {
+        throw ::std::invalid_argument{ "Invalid chunked cube shape." };
+    }
+
+    auto const started = ::std::chrono::steady_clock::now( );
+    auto const tilesAcross = ( width + options.tileSize - 1 ) / options.tileSize;
+    auto const tilesDown = ( height + options.tileSize - 1 ) / options.tileSize;
+    auto const tiles = tilesAcross * tilesDown;
+    auto const blocks = ( bands + options.bandsPerChunk - 1 ) / options.bandsPerChunk;
+    auto const chunkCount = static_cast< ::std::size_t >( blocks * tiles );
+    auto const savedWavelengths = ( static_cast< ::hinalea::Int >( wavelengths.size( ) ) == bands ) ? wavelengths : ::std::vector< double >{ };
+
+    auto header = ::std::vector< char >( ::fileHeaderFields + sizeof( double ) * savedWavelengths.size( ) );
+    ::std::memcpy( header.data( ), ::fileMagic, 8 );
+    ::store( header, 8, ::fileVersion );
+    ::store( header, 12, static_cast< ::std::uint32_t >( options.compression ) );
+    ::store( header, 16, static_cast< ::std::int64_t >( bands ) );
+    ::store( header, 24, static_cast< ::std::int64_t >( width ) );
+    ::store( header, 32, static_cast< ::std::int64_t >( height ) );
+    ::store( header, 40, static_cast< ::std::int64_t >( options.bandsPerChunk ) );
+    ::store( header, 48, static_cast< ::std::int64_t >( options.tileSize ) );
+    ::store( header, 56, static_cast< ::std::uint64_t >( savedWavelengths.size( ) ) );
+    ::std::memcpy( header.data( ) + ::fileHeaderFields, savedWavelengths.data( ), sizeof( double ) * savedWavelengths.size( ) );
+
+    auto index = ::std::vector< char >( ::chunkEntryBytes * chunkCount );
+
+    ::hinalea::fs::create_directories( path.parent_path( ) );
+    auto file = ::std::ofstream{ path, ::std::ios::binary | ::std::ios::trunc };
+    file.write( header.data( ), static_cast< ::std::streamsize >( header.size( ) ) );
+    file.write( index.data( ), static_cast< ::std::streamsize >( index.size( ) ) );
+
+    auto offset = ::roundUp( header.size( ) + index.size( ) );
+    file.seekp( static_cast< ::std::streamoff >( offset ) );
+
+    auto statistics = WriteStatistics{ };
+    auto planes = ::std::vector< ::hinalea::f32 >( static_cast< ::std::size_t >( ::std::min( options.bandsPerChunk, bands ) * width * height ) );
+    auto encoded = ::std::vector< QByteArray >( static_cast< ::std::size_t >( tiles ) );
+
+    for ( auto block = ::hinalea::Int{ 0 }; block < blocks; ++block )
+    {
+        auto const first = block * options.bandsPerChunk;
+        auto const count = ::std::min( options.bandsPerChunk, bands - first );
+
+        for ( auto b = ::hinalea::Int{ 0 }; b < count; ++b )
+        {
+            source( first + b, planes.data( ) + b * width * height );
+        }
+
+        ThreadPool::global( ).parallelFor(
+            static_cast< ::std::size_t >( tiles ),
+            1,
+            [ & ]( ::std::size_t const begin, ::std::size_t const end )
+            {
+                for ( auto tile = begin; tile < end; ++tile )
+                {
+                    auto const tileIndex = static_cast< ::hinalea::Int >( tile );
+                    auto const shape = ::chunkShape( width, height, bands, options, block, tileIndex % tilesAcross, tileIndex / tilesAcross );
+                    encoded[ tile ] = ::encodeChunk( shape, planes.data( ), width, height, options );
+                }
+            }
+            );
+
+        for ( auto tile = ::std::size_t{ 0 }; tile < encoded.size( ); ++tile )
+        {
+            auto const chunk = static_cast< ::std::size_t >( block ) * encoded.size( ) + tile;
+            auto const size = static_cast< ::std::size_t >( encoded[ tile ].size( ) );
+            file.write( encoded[ tile ].constData( ), static_cast< ::std::streamsize >( size ) );
+
+            ::store( index, ::chunkEntryBytes * chunk, static_cast< ::std::uint64_t >( offset ) );
+            ::store( index, ::chunkEntryBytes * chunk + 8, static_cast< ::std::uint64_t >( size ) );
+            offset += size;
+        }
+
+        if ( not file )
+        {
+            throw ::std::runtime_error{ "Failed to write chunked cube: " + path.string( ) };
+        }
+    }
+
+    file.seekp( static_cast< ::std::streamoff >( header.size( ) ) );
+    file.write( index.data( ), static_cast< ::std::streamsize >( index.size( ) ) );
+    file.close( );
+
+    if ( not file )
+    {
+        throw ::std::runtime_error{ "Failed to write chunked cube: " + path.string( ) };
+    }
+
+    statistics.chunks = chunkCount;
+    statistics.rawBytes = static_cast< ::std::uint64_t >( bands * width * height ) * sizeof( ::hinalea::f32 );
+    statistics.bytes = offset;
+    statistics.elapsed = ::std::chrono::steady_clock::now( ) - started;
+    return statistics;
+}
+
+auto ChunkedCube::write(
+    HINALEA_IN ::hinalea::fs::path const & path,
+    HINALEA_IN EnviCube const &            cube,
+    HINALEA_IN Options const &             options
+    ) -> WriteStatistics
+{
+    auto region = PreviewRegion{ };
+    region.width = cube.samples( );
+    region.height = cube.lines( );
+
+    return ChunkedCube::write(
+        path,
+        cube.samples( ),
+        cube.lines( ),
+        cube.bands( ),
+        cube.wavelengths( ),
+        [ & ]( ::hinalea::Int const band, ::hinalea::f32 * const plane )
+        {
+            cube.readBand( band, region, plane, region.width );
+        },
+        options
+        );
+}
+
+auto ChunkedCube::open(
+    HINALEA_IN ::hinalea::fs::path const & path
+    ) -> ChunkedCube
+{
+    auto file = ::std::ifstream{ path, ::std::ios::binary };
+    auto header = ::std::vector< char >( ::fileHeaderFields );
+    file.read( header.data( ), static_cast< ::std::streamsize >( header.size( ) ) );
+
+    if ( ( not file ) or ( ::std::memcmp( header.data( ), ::fileMagic, 8 ) != 0 ) or ( ::load< ::std::uint32_t >( header, 8 ) != ::fileVersion ) )
+    {
+        throw ::std::runtime_error{ "Not a chunked cube: " + path.string( ) };
+    }
+
+    auto cube = ChunkedCube{ };
+    cube.path = path;
+    cube.settings.compression = static_cast< Compression >( ::load< ::std::uint32_t >( header, 12 ) );
+    cube.bandCount = static_cast< ::hinalea::Int >( ::load< ::std::int64_t >( header, 16 ) );
+    cube.width = static_cast< ::hinalea::Int >( ::load< ::std::int64_t >( header, 24 ) );
+    cube.height = static_cast< ::hinalea::Int >( ::load< ::std::int64_t >( header, 32 ) );
+    cube.settings.bandsPerChunk = static_cast< ::hinalea::Int >( ::load< ::std::int64_t >( header, 40 ) );
+    cube.settings.tileSize = static_cast< ::hinalea::Int >( ::load< ::std::int64_t >( header, 48 ) );
+
+    if ( ( cube.bandCount < 1 ) or ( cube.width < 1 ) or ( cube.height < 1 ) or ( cube.settings.bandsPerChunk < 1 ) or ( cube.settings.tileSize < 1 ) )
+    {
+        throw ::std::runtime_error{ "Corrupt chunked cube header: " + path.string( ) };
+    }
+
+    cube.bandWavelengths.resize( static_cast< ::std::size_t >( ::load< ::std::uint64_t >( header, 56 ) ) );
+    file.read( reinterpret_cast< char * >( cube.bandWavelengths.data( ) ), static_cast< ::std::streamsize >( sizeof( double ) * cube.bandWavelengths.size( ) ) );
+
+    auto const blocks = ( cube.bandCount + cube.settings.bandsPerChunk - 1 ) / cube.settings.bandsPerChunk;
+    auto index = ::std::vector< char >( ::chunkEntryBytes * static_cast< ::std::size_t >( blocks * cube.tilesAcross( ) * cube.tilesDown( ) ) );
+    file.read( index.data( ), static_cast< ::std::streamsize >( index.size( ) ) );
+
+    if ( not file )
+    {
+        throw ::std::runtime_error{ "Corrupt chunked cube header: " + path.string( ) };
+    }
+
+    auto const size = static_cast< ::std::uint64_t >( ::hinalea::fs::file_size( path ) );
+    cube.chunks.resize( index.size( ) / ::chunkEntryBytes );
+
+    for ( auto i = ::std::size_t{ 0 }; i < cube.chunks.size( ); ++i )
+    {
+        auto & chunk = cube.chunks[ i ];
+        chunk.offset = ::load< ::std::uint64_t >( index, ::chunkEntryBytes * i );
+        chunk.size = ::load< ::std::uint64_t >( index, ::chunkEntryBytes * i + 8 );
+
+        if ( ( chunk.offset == 0 ) or ( chunk.offset + chunk.size > size ) )
+        {
+            throw ::std::runtime_error{ "Incomplete chunked cube: " + path.string( ) };
+        }
+    }
+
+    return cube;
+}
+
+auto ChunkedCube::samples(
+    ) const noexcept -> ::hinalea::Int
+{
+    return this->width;
+}
+
+auto ChunkedCube::lines(
+    ) const noexcept -> ::hinalea::Int
+{
+    return this->height;
+}
+
+auto ChunkedCube::bands(
+    ) const noexcept -> ::hinalea::Int
+{
+    return this->bandCount;
+}
+
+auto ChunkedCube::options(
+    ) const noexcept -> Options const &
+{
+    return this->settings;
+}
+
+auto ChunkedCube::wavelengths(
+    ) const noexcept -> ::std::vector< double > const &
+{
+    return this->bandWavelengths;
+}
+
+auto ChunkedCube::read(
+    HINALEA_IN  ::hinalea::Int   const firstBand,
+    HINALEA_IN  ::hinalea::Int   const bandCount,
+    HINALEA_IN  CubeWindow const &     window,
+    HINALEA_OUT ::hinalea::f32 * const out
+    ) const -> ::std::uint64_t
+{
+    if ( ( firstBand < 0 ) or ( bandCount < 1 ) or ( firstBand + bandCount > this->bandCount ) or
+         ( window.x < 0 ) or ( window.y < 0 ) or ( window.width < 1 ) or ( window.height < 1 ) or
+         ( window.x + window.width > this->width ) or ( window.y + window.height > this->height ) )
+    {
+        throw ::std::out_of_range{ "Read outside of chunked cube: " + this->path.string( ) };
+    }
+
+    auto const tileSize = this->settings.tileSize;
+    auto const tilesAcross = this->tilesAcross( );
+    auto const tilesPerBlock = tilesAcross * this->tilesDown( );
+    auto shapes = ::std::vector< ChunkShape >{ };
+    auto numbers = ::std::vector< ::std::size_t >{ };
+
+    for ( auto block = firstBand / this->settings.bandsPerChunk; block <= ( firstBand + bandCount - 1 ) / this->settings.bandsPerChunk; ++block )
+    {
+        for ( auto tileY = window.y / tileSize; tileY <= ( window.y + window.height - 1 ) / tileSize; ++tileY )
+        {
+            for ( auto tileX = window.x / tileSize; tileX <= ( window.x + window.width - 1 ) / tileSize; ++tileX )
+            {
+                shapes.push_back( ::chunkShape( this->width, this->height, this->bandCount, this->settings, block, tileX, tileY ) );
+                numbers.push_back( static_cast< ::std::size_t >( block * tilesPerBlock + tileY * tilesAcross + tileX ) );
+            }
+        }
+    }
+
+    /* NOTE: Chunks are read in file order, which is the order they were listed in, and decoded in parallel. */
+    auto stored = ::std::vector< QByteArray >( shapes.size( ) );
+    auto bytes = ::std::uint64_t{ 0 };
+    auto file = ::std::ifstream{ this->path, ::std::ios::binary };
+
+    for ( auto i = ::std::size_t{ 0 }; i < shapes.size( ); ++i )
+    {
+        auto const & chunk = this->chunks[ numbers[ i ] ];
+        stored[ i ].resize( static_cast< int >( chunk.size ) );
+        file.seekg( static_cast< ::std::streamoff >( chunk.offset ) );
+        file.read( stored[ i ].data( ), static_cast< ::std::streamsize >( chunk.size ) );
+        bytes += chunk.size;
+    }
+
+    if ( not file )
+    {
+        throw ::std::runtime_error{ "Failed to read chunked cube: " + this->path.string( ) };
+    }
+
+    ThreadPool::global( ).parallelFor(
+        shapes.size( ),
+        1,
+        [ & ]( ::std::size_t const begin, ::std::size_t const end )
+        {
+            auto samples = ::std::vector< ::hinalea::f32 >{ };
+
+            for ( auto i = begin; i < end; ++i )
+            {
+                auto const & shape = shapes[ i ];
+                samples.resize( shape.samples( ) );
+                ::decodeChunk( shape, stored[ i ], samples.data( ) );
+
+                auto const band0 = ::std::max( shape.band, firstBand );
+                auto const band1 = ::std::min( shape.band + shape.bands, firstBand + bandCount );
+                auto const x0 = ::std::max( shape.x, window.x );
+                auto const x1 = ::std::min( shape.x + shape.width, window.x + window.width );
+                auto const y0 = ::std::max( shape.y, window.y );
+                auto const y1 = ::std::min( shape.y + shape.height, window.y + window.height );
+
+                for ( auto band = band0; band < band1; ++band )
+                {
+                    for ( auto y = y0; y < y1; ++y )
+                    {
+                        auto const * const source = samples.data( ) + ( ( band - shape.band ) * shape.height + ( y - shape.y ) ) * shape.width + ( x0 - shape.x );
+                        auto * const target = out + ( ( band - firstBand ) * window.height + ( y - window.y ) ) * window.width + ( x0 - window.x );
+                        ::std::copy( source, source + ( x1 - x0 ), target );
+                    }
+                }
+            }
+        }
+        );
+
+    return bytes;
+}
+
+auto ChunkedCube::tilesAcross(
+    ) const noexcept -> ::hinalea::Int
+{
+    return ( this->width + this->settings.tileSize - 1 ) / this->settings.tileSize;
+}
+
+auto ChunkedCube::tilesDown(
+    ) const noexcept -> ::hinalea::Int
+{
+    return ( this->height + this->settings.tileSize - 1 ) / this->settings.tileSize;
+}
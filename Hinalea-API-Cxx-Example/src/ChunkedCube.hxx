@@ -0,0 +1,140 @@
+#pragma once
+
+#include "EnviCube.hxx"
+
+#include <Hinalea.h>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/* Spatial window of a cube, in pixels. */
+struct CubeWindow
+{
+    ::hinalea::Int x{ };
+    ::hinalea::Int y{ };
+    ::hinalea::Int width{ };
+    ::hinalea::Int height{ };
+};
+
+/* Band tiled cube, `.hcc`, for cubes that are read a few bands or one region at a time.
+ *
+ * The cube is cut into chunks of `bandsPerChunk` bands by `tileSize` square pixels, edge chunks are smaller. A chunk
+ * is its bands one after another, each a tile of f32 samples row by row, and is stored either as is or byte shuffled
+ * and deflated, whichever is smaller. An index of every chunk's offset and size follows the file header, so a read
+ * seeks to and decodes only the chunks that overlap the requested bands and window; with one band per chunk, one band
+ * of a 300 band cube reads 1/300 of the file. Chunks are encoded and decoded in parallel on `ThreadPool::global( )`.
+ *
+ * All integers are little endian. The header is "HNLCHCB1", u32 version 1, u32 compression, i64 bands, width, height,
+ * bands per chunk and tile size, u64 wavelength count, f64 wavelengths in nanometers, then per chunk a u64 offset and
+ * u64 stored size; a stored size equal to the raw size is an uncompressed chunk. Chunks are numbered band block first,
+ * then tile rows, then tiles. The index is written last, a cut short file has an empty index and does not open.
+ */
+class ChunkedCube
+{
+public:
+    enum class Compression : ::std::uint32_t { None, Deflate };
+
+    struct Options
+    {
+        ::hinalea::Int bandsPerChunk{ 1 };
+        ::hinalea::Int tileSize{ 256 };
+        Compression compression{ Compression::Deflate };
+        int level{ 1 }; /* zlib level, 1 is several times faster than the default for a few percent of size. */
+    };
+
+    struct WriteStatistics
+    {
+        ::std::uint64_t chunks{ };
+        ::std::uint64_t rawBytes{ };
+        ::std::uint64_t bytes{ }; /* Of the file. */
+        ::std::chrono::nanoseconds elapsed{ };
+    };
+
+    /* Fills `plane` with band `band`, `width * height` samples. Called once per band, in order. */
+    using BandSource = ::std::function< void ( ::hinalea::Int band, ::hinalea::f32 * plane ) >;
+
+    /* Writes a cube of `bands` bands to `path`, holding one block of `bandsPerChunk` planes at a time. Throws on I/O
+     * errors.
+     */
+    static
+    auto write(
+        HINALEA_IN ::hinalea::fs::path const &     path,
+        HINALEA_IN ::hinalea::Int                  width,
+        HINALEA_IN ::hinalea::Int                  height,
+        HINALEA_IN ::hinalea::Int                  bands,
+        HINALEA_IN ::std::vector< double > const & wavelengths,
+        HINALEA_IN BandSource const &              source,
+        HINALEA_IN Options const &                 options
+        ) -> WriteStatistics;
+
+    /* Writes every band of `cube`. */
+    static
+    auto write(
+        HINALEA_IN ::hinalea::fs::path const & path,
+        HINALEA_IN EnviCube const &            cube,
+        HINALEA_IN Options const &             options
+        ) -> WriteStatistics;
+
+    /* Reads the header and index. Throws `std::runtime_error` if `path` is not a complete chunked cube. */
+    [[ nodiscard ]]
+    static
+    auto open(
+        HINALEA_IN ::hinalea::fs::path const & path
+        ) -> ChunkedCube;
+
+    [[ nodiscard ]]
+    auto samples(
+        ) const noexcept -> ::hinalea::Int;
+
+    [[ nodiscard ]]
+    auto lines(
+        ) const noexcept -> ::hinalea::Int;
+
+    [[ nodiscard ]]
+    auto bands(
+        ) const noexcept -> ::hinalea::Int;
+
+    [[ nodiscard ]]
+    auto options(
+        ) const noexcept -> Options const &;
+
+    /* Band wavelengths in nanometers, empty if the cube has none. */
+    [[ nodiscard ]]
+    auto wavelengths(
+        ) const noexcept -> ::std::vector< double > const &;
+
+    /* Reads bands `firstBand` to `firstBand + bandCount` of `window` into `out`, BSQ, `window.width * window.height`
+     * samples per band. Returns the number of bytes read from the file. Throws on I/O errors and corrupt chunks.
+     */
+    auto read(
+        HINALEA_IN  ::hinalea::Int     firstBand,
+        HINALEA_IN  ::hinalea::Int     bandCount,
+        HINALEA_IN  CubeWindow const & window,
+        HINALEA_OUT ::hinalea::f32 *   out
+        ) const -> ::std::uint64_t;
+
+private:
+    struct Chunk
+    {
+        ::std::uint64_t offset{ };
+        ::std::uint64_t size{ };
+    };
+
+    [[ nodiscard ]]
+    auto tilesAcross(
+        ) const noexcept -> ::hinalea::Int;
+
+    [[ nodiscard ]]
+    auto tilesDown(
+        ) const noexcept -> ::hinalea::Int;
+
+    ::hinalea::fs::path path{ };
+    ::hinalea::Int width{ 0 };
+    ::hinalea::Int height{ 0 };
+    ::hinalea::Int bandCount{ 0 };
+    Options settings{ };
+    ::std::vector< double > bandWavelengths{ };
+    ::std::vector< Chunk > chunks{ };
+};
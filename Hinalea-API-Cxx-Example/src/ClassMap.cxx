@@ -0,0 +1,132 @@
+#include "ClassMap.hxx"
+
+#include <algorithm>
+#include <cstring>
+
+auto ClassMap::reset(
+    HINALEA_IN ::hinalea::Int const newWidth,
+    HINALEA_IN ::hinalea::Int const newHeight
+    ) -> void
+{
+    auto const lock = ::std::scoped_lock{ this->mutex };
+
+    this->width  = newWidth;
+    this->height = newHeight;
+    this->tilesX = ( newWidth  + tileSize - 1 ) / tileSize;
+    this->tilesY = ( newHeight + tileSize - 1 ) / tileSize;
+
+    auto const labels = static_cast< ::std::size_t >( newWidth * newHeight );
+    auto const tiles  = static_cast< ::std::size_t >( this->tilesX * this->tilesY );
+
+    for ( auto & map : this->maps )
+    {
+        map.assign( labels, 0 );
+    }
+
+    for ( auto & map : this->confidenceMaps )
+    {
+        map.assign( labels, 255 );
+    }
+
+    this->fullConfidence.assign( static_cast< ::std::size_t >( newWidth ), 255 );
+
+    this->front = 0;
+    this->changed.assign( tiles, 0 );
+    this->pending.assign( tiles, 1 );
+    this->stats = Statistics{ };
+
+    /* Make the consumer pick up the all dirty, all zero map. */
+    this->currentGeneration.store( 1, ::std::memory_order_release );
+    this->consumedGeneration = 0;
+}
+
+auto ClassMap::publish(
+    HINALEA_IN     ::std::uint8_t const * const labels,
+    HINALEA_IN_OPT ::std::uint8_t const * const confidence
+    ) -> void
+{
+    if ( this->pending.empty( ) )
+    {
+        return;
+    }
+
+    auto const back = 1 - this->front;
+    auto const * const previous = this->maps[ this->front ].data( );
+    auto * const next = this->maps[ back ].data( );
+    auto const * const previousConfidence = this->confidenceMaps[ this->front ].data( );
+    auto * const nextConfidence = this->confidenceMaps[ back ].data( );
+    auto const rowBytes = static_cast< ::std::size_t >( this->width );
+
+    ::std::fill( this->changed.begin( ), this->changed.end( ), ::std::uint8_t{ 0 } );
+
+    for ( auto y = ::hinalea::Int{ 0 }; y < this->height; ++y )
+    {
+        auto const offset = static_cast< ::std::size_t >( y * this->width );
+        auto * const tiles = this->changed.data( ) + ( y / tileSize ) * this->tilesX;
+        auto const * const confidenceRow = ( confidence != nullptr ) ? confidence + offset : this->fullConfidence.data( );
+
+        /* Compare whole rows first, most rows of a static scene are unchanged. */
+        if ( ( ::std::memcmp( labels + offset, previous + offset, rowBytes ) != 0 )
+             or ( ::std::memcmp( confidenceRow, previousConfidence + offset, rowBytes ) != 0 ) )
+        {
+            for ( auto tx = ::hinalea::Int{ 0 }; tx < this->tilesX; ++tx )
+            {
+                auto const x = tx * tileSize;
+                auto const span = static_cast< ::std::size_t >( ::std::min( tileSize, this->width - x ) );
+                tiles[ tx ] |= ( ::std::memcmp( labels + offset + x, previous + offset + x, span ) != 0 )
+                            or ( ::std::memcmp( confidenceRow + x, previousConfidence + offset + x, span ) != 0 );
+            }
+        }
+
+        ::std::memcpy( next + offset, labels + offset, rowBytes );
+        ::std::memcpy( nextConfidence + offset, confidenceRow, rowBytes );
+    }
+
+    auto const lock = ::std::scoped_lock{ this->mutex };
+    this->front = back;
+
+    for ( auto tile = ::std::size_t{ 0 }; tile < this->pending.size( ); ++tile )
+    {
+        this->pending[ tile ] |= this->changed[ tile ];
+    }
+
+    ++this->stats.published;
+    this->currentGeneration.fetch_add( 1, ::std::memory_order_release );
+}
+
+auto ClassMap::invalidate(
+    ) -> void
+{
+    auto const lock = ::std::scoped_lock{ this->mutex };
+    ::std::fill( this->pending.begin( ), this->pending.end( ), ::std::uint8_t{ 1 } );
+    this->currentGeneration.fetch_add( 1, ::std::memory_order_release );
+}
+
+auto ClassMap::generation(
+    ) const noexcept -> ::std::uint64_t
+{
+    return this->currentGeneration.load( ::std::memory_order_acquire );
+}
+
+auto ClassMap::statistics(
+    ) const -> Statistics
+{
+    auto const lock = ::std::scoped_lock{ this->mutex };
+    return this->stats;
+}
+
+auto ClassMap::tileRect(
+    HINALEA_IN ::hinalea::Int const tx,
+    HINALEA_IN ::hinalea::Int const ty
+    ) const noexcept -> QRect
+{
+    auto const x = tx * tileSize;
+    auto const y = ty * tileSize;
+
+    return QRect{
+        static_cast< int >( x ),
+        static_cast< int >( y ),
+        static_cast< int >( ::std::min( tileSize, this->width  - x ) ),
+        static_cast< int >( ::std::min( tileSize, this->height - y ) ),
+        };
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <Hinalea.h>
+
+#include <QRect>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/* Double buffered class label and confidence map shared between the classify thread and the GUI thread.
+ *
+ * The producer copies each new map into the back buffer while comparing it tile by tile against the last published
+ * map, then swaps it to the front under a short lock and bumps the generation. Changed tiles accumulate until the
+ * consumer collects them, so a consumer that skips generations still sees every region that changed. A static scene
+ * publishes no dirty tiles, and the consumer returns without touching any pixels.
+ */
+class ClassMap
+{
+public:
+    static auto constexpr tileSize = ::hinalea::Int{ 64 };
+
+    struct Statistics
+    {
+        ::std::uint64_t published{ };
+        ::std::uint64_t consumed{ };
+        ::std::uint64_t dirtyTiles{ }; /* Tiles handed to the consumer. */
+        ::std::uint64_t totalTiles{ }; /* Tiles the consumer would have handled without dirty tracking. */
+    };
+
+    /* Only call while neither the producer nor the consumer are running. Every tile starts out dirty. */
+    auto reset(
+        HINALEA_IN ::hinalea::Int width,
+        HINALEA_IN ::hinalea::Int height
+        ) -> void;
+
+    /* Producer side: `labels` and `confidence` hold `width * height` packed values. A null `confidence` is full. */
+    auto publish(
+        HINALEA_IN     ::std::uint8_t const * labels,
+        HINALEA_IN_OPT ::std::uint8_t const * confidence = nullptr
+        ) -> void;
+
+    /* Marks every tile dirty, eg. once the colors the consumer maps labels to have changed. */
+    auto invalidate(
+        ) -> void;
+
+    [[ nodiscard ]]
+    auto generation(
+        ) const noexcept -> ::std::uint64_t;
+
+    /* Consumer side: calls `visit( QRect tile, std::uint8_t const * labels, std::uint8_t const * confidence,
+     * hinalea::Int linePitch )` for every tile changed since the previous call, with `labels` and `confidence` pointing
+     * at the top left value of the tile.
+     * Returns false without locking if nothing was published since the previous call.
+     */
+    template <
+        typename Visitor
+        >
+    auto consume(
+        HINALEA_IN Visitor && visit
+        ) -> bool
+    {
+        if ( this->generation( ) == this->consumedGeneration )
+        {
+            return false;
+        }
+
+        auto const lock = ::std::scoped_lock{ this->mutex };
+        auto const * const labels = this->maps[ this->front ].data( );
+        auto const * const confidence = this->confidenceMaps[ this->front ].data( );
+
+        for ( auto ty = ::hinalea::Int{ 0 }; ty < this->tilesY; ++ty )
+        {
+            for ( auto tx = ::hinalea::Int{ 0 }; tx < this->tilesX; ++tx )
+            {
+                auto & dirty = this->pending[ static_cast< ::std::size_t >( ty * this->tilesX + tx ) ];
+
+                if ( dirty )
+                {
+                    auto const tile = this->tileRect( tx, ty );
+                    auto const offset = tile.y( ) * this->width + tile.x( );
+                    visit( tile, labels + offset, confidence + offset, this->width );
+                    dirty = 0;
+                    ++this->stats.dirtyTiles;
+                }
+            }
+        }
+
+        this->consumedGeneration = this->generation( );
+        this->stats.totalTiles += static_cast< ::std::uint64_t >( this->pending.size( ) );
+        ++this->stats.consumed;
+        return true;
+    }
+
+    [[ nodiscard ]]
+    auto statistics(
+        ) const -> Statistics;
+
+private:
+    [[ nodiscard ]]
+    auto tileRect(
+        HINALEA_IN ::hinalea::Int tx,
+        HINALEA_IN ::hinalea::Int ty
+        ) const noexcept -> QRect;
+
+    ::hinalea::Int width{ };
+    ::hinalea::Int height{ };
+    ::hinalea::Int tilesX{ };
+    ::hinalea::Int tilesY{ };
+
+    /* Only the producer writes the maps; the front map is only read by the consumer under the lock. */
+    ::std::vector< ::std::uint8_t > maps[ 2 ]{ };
+    ::std::vector< ::std::uint8_t > confidenceMaps[ 2 ]{ };
+    ::std::size_t front{ 0 };
+
+    /* Producer scratch, tiles that changed in the map being published, and a full confidence row. */
+    ::std::vector< ::std::uint8_t > changed{ };
+    ::std::vector< ::std::uint8_t > fullConfidence{ };
+
+    mutable ::std::mutex mutex{ };
+    ::std::vector< ::std::uint8_t > pending{ };
+    Statistics stats{ };
+    ::std::atomic< ::std::uint64_t > currentGeneration{ 0 };
+
+    /* Only used by the consumer. */
+    ::std::uint64_t consumedGeneration{ 0 };
+};
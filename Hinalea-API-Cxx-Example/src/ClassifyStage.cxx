@@ -0,0 +1,25 @@
+#include "ClassifyStage.hxx"
+
+auto ClassifyStage::submit(
+    HINALEA_IN ::hinalea::f32 const * const cube,
+    HINALEA_IN ::hinalea::Int         const bands,
+    HINALEA_IN ::hinalea::Int         const area,
+    HINALEA_IN ::hinalea::f32 const * const endmembers,
+    HINALEA_IN ::hinalea::Int         const observations,
+    HINALEA_IN SpectralMeasure        const measure,
+    HINALEA_IN double                 const threshold
+    ) -> bool
+{
+    return this->CubeStage::submit(
+        cube,
+        bands,
+        area,
+        [ & ]( ClassifyInputs & inputs )
+        {
+            inputs.endmembers.assign( endmembers, endmembers + observations * bands );
+            inputs.observations = observations;
+            inputs.measure = measure;
+            inputs.threshold = threshold;
+        }
+        );
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "CubeStage.hxx"
+#include "SpectralMeasure.hxx"
+
+#include <Hinalea.h>
+
+#include <vector>
+
+/* What classifies a cube, copied with it from the realtime callback. */
+struct ClassifyInputs
+{
+    ::std::vector< ::hinalea::f32 > endmembers{ }; /* `observations * bands` samples. */
+    ::hinalea::Int observations{ };
+    SpectralMeasure measure{ };
+    double threshold{ };
+};
+
+/* Classification pipeline stage fed from the realtime thread, see `CubeStage`. */
+class ClassifyStage
+    : public CubeStage< ClassifyInputs >
+{
+public:
+    using CubeStage::CubeStage;
+
+    /* Producer side, copies the cube and endmembers. Returns false if the stage is not running. */
+    auto submit(
+        HINALEA_IN ::hinalea::f32 const * cube,
+        HINALEA_IN ::hinalea::Int         bands,
+        HINALEA_IN ::hinalea::Int         area,
+        HINALEA_IN ::hinalea::f32 const * endmembers,
+        HINALEA_IN ::hinalea::Int         observations,
+        HINALEA_IN SpectralMeasure        measure,
+        HINALEA_IN double                 threshold
+        ) -> bool;
+};
@@ -0,0 +1,575 @@
+#include "CubeRecorder.hxx"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+static_assert( ::std::endian::native == ::std::endian::little, "Cube series files are written in native byte order." );
+
+namespace {
+
+auto constexpr fileMagic = "HNLCUBS1";
+auto constexpr chunkMagic = "HNLCHUNK";
+auto constexpr fileVersion = ::std::uint32_t{ 1 };
+auto constexpr fileHeaderFields = ::std::size_t{ 48 };
+auto constexpr chunkHeaderFields = ::std::size_t{ 16 };
+auto constexpr entryBytes = ::std::size_t{ 16 };
+auto constexpr headerAlignment = ::std::size_t{ 4096 };
+
+[[ nodiscard ]]
+constexpr
+auto roundUp(
+    HINALEA_IN ::std::size_t const bytes
+    ) noexcept -> ::std::size_t
+{
+    return ( bytes + headerAlignment - 1 ) / headerAlignment * headerAlignment;
+}
+
+[[ nodiscard ]]
+constexpr
+auto chunkHeaderBytes(
+    HINALEA_IN ::std::size_t const cubesPerChunk
+    ) noexcept -> ::std::size_t
+{
+    return ::roundUp( chunkHeaderFields + entryBytes * cubesPerChunk );
+}
+
+template <
+    typename T
+    >
+auto store(
+    HINALEA_OUT ::std::vector< char > & buffer,
+    HINALEA_IN  ::std::size_t           offset,
+    HINALEA_IN  T const &               value
+    ) -> void
+{
+    ::std::memcpy( buffer.data( ) + offset, &value, sizeof( T ) );
+}
+
+template <
+    typename T
+    >
+[[ nodiscard ]]
+auto load(
+    HINALEA_IN ::std::vector< char > const & buffer,
+    HINALEA_IN ::std::size_t                 offset
+    ) -> T
+{
+    auto value = T{ };
+    ::std::memcpy( &value, buffer.data( ) + offset, sizeof( T ) );
+    return value;
+}
+
+} /* namespace anonymous */
+
+CubeRecorder::~CubeRecorder(
+    )
+{
+    if ( this->writer.joinable( ) )
+    {
+        try
+        {
+            this->close( );
+        }
+        catch ( ... )
+        {
+            /* NOTE: Errors were already reported by `push`, or the recording is being abandoned. */
+        }
+    }
+}
+
+auto CubeRecorder::open(
+    HINALEA_IN ::hinalea::fs::path const & base,
+    HINALEA_IN Options                     options
+    ) -> void
+{
+    HINALEA_ASSERT( not this->writer.joinable( ) );
+    HINALEA_ASSERT( ( options.width > 0 ) and ( options.height > 0 ) );
+
+    this->filePath = base;
+    this->filePath += ".hcs";
+    ::hinalea::fs::create_directories( base.parent_path( ) );
+
+    /* NOTE: Unbuffered, so every cube goes to the OS as one write straight from its buffer. */
+    this->file = ::std::ofstream{ };
+    this->file.rdbuf( )->pubsetbuf( nullptr, 0 );
+    this->file.open( this->filePath, ::std::ios::binary | ::std::ios::trunc );
+
+    if ( not this->file )
+    {
+        throw ::std::runtime_error{ "Failed to create cube recording: " + this->filePath.string( ) };
+    }
+
+    this->settings = ::std::move( options );
+    this->settings.every = ::std::max< ::hinalea::Int >( this->settings.every, 1 );
+    this->settings.cubesPerChunk = ::std::max< ::hinalea::Int >( this->settings.cubesPerChunk, 1 );
+
+    this->queue.clear( );
+    this->freeSlots.clear( );
+    this->slots.clear( );
+    this->bands = 0;
+    this->cubeBytes = 0;
+    this->maxSlots = 0;
+    this->copying = 0;
+    this->error = nullptr;
+    this->stats = Statistics{ };
+    this->closing = false;
+    this->chunk.clear( );
+    this->chunk.reserve( static_cast< ::std::size_t >( this->settings.cubesPerChunk ) );
+    this->chunkOffset = -1;
+    this->headerWritten = false;
+    this->opened = Clock::now( );
+
+    if ( this->settings.bands > 0 )
+    {
+        this->setBands( this->settings.bands );
+
+        auto first = ::std::make_unique< Slot >( );
+        first->data = ::std::make_unique_for_overwrite< ::hinalea::f32[ ] >( this->cubeBytes / sizeof( ::hinalea::f32 ) );
+        this->freeSlots.push_back( first.get( ) );
+        this->slots.push_back( ::std::move( first ) );
+        this->stats.buffers = this->slots.size( );
+    }
+
+    this->writer = ::std::thread{ &CubeRecorder::run, this };
+}
+
+auto CubeRecorder::setBands(
+    HINALEA_IN ::hinalea::Int const cubeBands
+    ) -> void
+{
+    this->bands = cubeBands;
+    this->cubeBytes = static_cast< ::std::size_t >( cubeBands * this->settings.width * this->settings.height ) * sizeof( ::hinalea::f32 );
+    this->maxSlots = ::std::max< ::std::size_t >( this->settings.queueBytes / ::std::max< ::std::size_t >( this->cubeBytes, 1 ), 2 );
+}
+
+auto CubeRecorder::push(
+    HINALEA_IN ::hinalea::f32 const * const cube,
+    HINALEA_IN ::hinalea::Int         const cubeBands,
+    HINALEA_IN ::hinalea::Int         const area,
+    HINALEA_IN ::std::int64_t         const timestamp
+    ) -> bool
+{
+    auto const start = Clock::now( );
+    auto * slot = static_cast< Slot * >( nullptr );
+    auto sequence = ::std::uint64_t{ };
+
+    {
+        auto lock = ::std::unique_lock{ this->mutex };
+
+        auto const reject = [ & ]( ::std::uint64_t & counter )
+        {
+            ++counter;
+            this->stats.pushTime += Clock::now( ) - start;
+            return false;
+        };
+
+        if ( this->error )
+        {
+            ::std::rethrow_exception( this->error );
+        }
+
+        if ( this->closing or not this->writer.joinable( ) )
+        {
+            return false;
+        }
+
+        sequence = this->stats.offered++;
+
+        if ( sequence % static_cast< ::std::uint64_t >( this->settings.every ) != 0 )
+        {
+            return reject( this->stats.skipped );
+        }
+
+        if ( this->bands == 0 )
+        {
+            this->setBands( cubeBands );
+        }
+
+        /* NOTE: The realtime mode or binning changed under the recording, a file only holds one cube shape. */
+        if ( ( cubeBands != this->bands ) or ( area != this->settings.width * this->settings.height ) )
+        {
+            return reject( this->stats.dropped );
+        }
+
+        if ( this->freeSlots.empty( ) and ( this->slots.size( ) < this->maxSlots ) )
+        {
+            auto next = ::std::make_unique< Slot >( );
+            next->data = ::std::make_unique_for_overwrite< ::hinalea::f32[ ] >( this->cubeBytes / sizeof( ::hinalea::f32 ) );
+            this->freeSlots.push_back( next.get( ) );
+            this->slots.push_back( ::std::move( next ) );
+            this->stats.buffers = this->slots.size( );
+        }
+
+        if ( this->freeSlots.empty( ) )
+        {
+            if ( this->settings.overflow == Overflow::Drop )
+            {
+                return reject( this->stats.dropped );
+            }
+
+            ++this->stats.stalls;
+            this->released.wait( lock, [ this ]{ return ( not this->freeSlots.empty( ) ) or this->error or this->closing; } );
+
+            if ( this->error )
+            {
+                ::std::rethrow_exception( this->error );
+            }
+
+            if ( this->freeSlots.empty( ) )
+            {
+                return reject( this->stats.dropped );
+            }
+        }
+
+        slot = this->freeSlots.back( );
+        this->freeSlots.pop_back( );
+        ++this->copying;
+    }
+
+    ::std::memcpy( slot->data.get( ), cube, this->cubeBytes );
+    slot->timestamp = timestamp;
+    slot->sequence = sequence;
+
+    {
+        auto const lock = ::std::scoped_lock{ this->mutex };
+        this->queue.push_back( slot );
+        --this->copying;
+        this->stats.maxQueued = ::std::max( this->stats.maxQueued, this->queue.size( ) );
+        this->stats.pushTime += Clock::now( ) - start;
+    }
+
+    this->queued.notify_one( );
+    return true;
+}
+
+auto CubeRecorder::close(
+    ) -> Statistics
+{
+    if ( not this->writer.joinable( ) )
+    {
+        return this->statistics( );
+    }
+
+    {
+        auto const lock = ::std::scoped_lock{ this->mutex };
+        this->closing = true;
+    }
+
+    this->queued.notify_one( );
+    this->released.notify_all( );
+    this->writer.join( );
+    this->file.close( );
+
+    if ( this->error )
+    {
+        ::std::rethrow_exception( this->error );
+    }
+
+    return this->statistics( );
+}
+
+auto CubeRecorder::statistics(
+    ) const -> Statistics
+{
+    auto const lock = ::std::scoped_lock{ this->mutex };
+    return this->stats;
+}
+
+auto CubeRecorder::path(
+    ) const -> ::hinalea::fs::path const &
+{
+    return this->filePath;
+}
+
+auto CubeRecorder::run(
+    ) -> void
+{
+    while ( true )
+    {
+        auto * slot = static_cast< Slot * >( nullptr );
+
+        {
+            auto lock = ::std::unique_lock{ this->mutex };
+            this->queued.wait(
+                lock,
+                [ this ]{ return ( this->closing and ( this->copying == 0 ) ) or ( not this->queue.empty( ) ); }
+                );
+
+            if ( this->queue.empty( ) )
+            {
+                break;
+            }
+
+            slot = this->queue.front( );
+            this->queue.pop_front( );
+        }
+
+        auto failure = ::std::exception_ptr{ };
+
+        try
+        {
+            this->write( *slot );
+        }
+        catch ( ... )
+        {
+            failure = ::std::current_exception( );
+        }
+
+        {
+            auto const lock = ::std::scoped_lock{ this->mutex };
+            this->freeSlots.push_back( slot );
+
+            if ( failure )
+            {
+                this->error = failure;
+                this->freeSlots.insert( this->freeSlots.end( ), this->queue.begin( ), this->queue.end( ) );
+                this->queue.clear( );
+            }
+            else
+            {
+                ++this->stats.recorded;
+                this->stats.bytes += this->cubeBytes;
+                this->stats.elapsed = ::std::chrono::duration_cast< ::std::chrono::nanoseconds >( Clock::now( ) - this->opened );
+            }
+        }
+
+        this->released.notify_all( );
+
+        if ( failure )
+        {
+            return;
+        }
+    }
+
+    try
+    {
+        if ( not this->chunk.empty( ) )
+        {
+            this->writeChunkTable( );
+        }
+    }
+    catch ( ... )
+    {
+        auto const lock = ::std::scoped_lock{ this->mutex };
+        this->error = ::std::current_exception( );
+    }
+}
+
+auto CubeRecorder::write(
+    HINALEA_IN Slot const & slot
+    ) -> void
+{
+    if ( not this->headerWritten )
+    {
+        this->writeFileHeader( );
+        this->headerWritten = true;
+    }
+
+    /* NOTE: The chunk table is reserved up front and filled in once the chunk is complete. */
+    if ( this->chunk.empty( ) )
+    {
+        auto const reserved = ::std::vector< char >( ::chunkHeaderBytes( static_cast< ::std::size_t >( this->settings.cubesPerChunk ) ) );
+        this->chunkOffset = static_cast< ::std::streamoff >( this->file.tellp( ) );
+        this->file.write( reserved.data( ), static_cast< ::std::streamsize >( reserved.size( ) ) );
+    }
+
+    this->file.write( reinterpret_cast< char const * >( slot.data.get( ) ), static_cast< ::std::streamsize >( this->cubeBytes ) );
+
+    if ( not this->file )
+    {
+        throw ::std::runtime_error{ "Failed to write cube recording: " + this->filePath.string( ) };
+    }
+
+    this->chunk.push_back( Entry{ slot.timestamp, slot.sequence } );
+
+    if ( this->chunk.size( ) == static_cast< ::std::size_t >( this->settings.cubesPerChunk ) )
+    {
+        this->writeChunkTable( );
+    }
+}
+
+auto CubeRecorder::writeFileHeader(
+    ) -> void
+{
+    auto const & wavelengths = this->settings.wavelengths;
+    auto const count = ( wavelengths.size( ) == static_cast< ::std::size_t >( this->bands ) ) ? wavelengths.size( ) : ::std::size_t{ 0 };
+    auto header = ::std::vector< char >( ::roundUp( ::fileHeaderFields + sizeof( double ) * count ) );
+
+    ::std::memcpy( header.data( ), ::fileMagic, 8 );
+    ::store( header, 8, ::fileVersion );
+    ::store( header, 12, static_cast< ::std::uint32_t >( this->settings.cubesPerChunk ) );
+    ::store( header, 16, static_cast< ::std::int64_t >( this->bands ) );
+    ::store( header, 24, static_cast< ::std::int64_t >( this->settings.width ) );
+    ::store( header, 32, static_cast< ::std::int64_t >( this->settings.height ) );
+    ::store( header, 40, static_cast< ::std::uint64_t >( count ) );
+
+    for ( auto i = ::std::size_t{ 0 }; i < count; ++i )
+    {
+        ::store( header, ::fileHeaderFields + sizeof( double ) * i, wavelengths[ i ] );
+    }
+
+    this->file.write( header.data( ), static_cast< ::std::streamsize >( header.size( ) ) );
+
+    if ( not this->file )
+    {
+        throw ::std::runtime_error{ "Failed to write cube recording header: " + this->filePath.string( ) };
+    }
+}
+
+auto CubeRecorder::writeChunkTable(
+    ) -> void
+{
+    auto table = ::std::vector< char >( ::chunkHeaderFields + ::entryBytes * this->chunk.size( ) );
+    ::std::memcpy( table.data( ), ::chunkMagic, 8 );
+    ::store( table, 8, static_cast< ::std::uint32_t >( this->settings.cubesPerChunk ) );
+    ::store( table, 12, static_cast< ::std::uint32_t >( this->chunk.size( ) ) );
+
+    for ( auto i = ::std::size_t{ 0 }; i < this->chunk.size( ); ++i )
+    {
+        ::store( table, ::chunkHeaderFields + ::entryBytes * i, this->chunk[ i ].timestamp );
+        ::store( table, ::chunkHeaderFields + ::entryBytes * i + 8, this->chunk[ i ].sequence );
+    }
+
+    auto const end = this->file.tellp( );
+    this->file.seekp( this->chunkOffset );
+    this->file.write( table.data( ), static_cast< ::std::streamsize >( table.size( ) ) );
+    this->file.seekp( end );
+
+    if ( not this->file )
+    {
+        throw ::std::runtime_error{ "Failed to write cube recording chunk: " + this->filePath.string( ) };
+    }
+
+    this->chunk.clear( );
+
+    auto const lock = ::std::scoped_lock{ this->mutex };
+    ++this->stats.chunks;
+}
+
+auto CubeSeries::open(
+    HINALEA_IN ::hinalea::fs::path const & path
+    ) -> CubeSeries
+{
+    auto series = CubeSeries{ };
+    series.file.open( path, ::std::ios::binary );
+
+    auto header = ::std::vector< char >( ::fileHeaderFields );
+    series.file.read( header.data( ), static_cast< ::std::streamsize >( header.size( ) ) );
+
+    if ( ( not series.file ) or ( ::std::memcmp( header.data( ), ::fileMagic, 8 ) != 0 ) or ( ::load< ::std::uint32_t >( header, 8 ) != ::fileVersion ) )
+    {
+        throw ::std::runtime_error{ "Not a cube recording: " + path.string( ) };
+    }
+
+    auto const cubesPerChunk = static_cast< ::std::size_t >( ::load< ::std::uint32_t >( header, 12 ) );
+    series.bandCount = static_cast< ::hinalea::Int >( ::load< ::std::int64_t >( header, 16 ) );
+    series.cubeWidth = static_cast< ::hinalea::Int >( ::load< ::std::int64_t >( header, 24 ) );
+    series.cubeHeight = static_cast< ::hinalea::Int >( ::load< ::std::int64_t >( header, 32 ) );
+    series.bandWavelengths.resize( static_cast< ::std::size_t >( ::load< ::std::uint64_t >( header, 40 ) ) );
+    series.file.read( reinterpret_cast< char * >( series.bandWavelengths.data( ) ), static_cast< ::std::streamsize >( series.bandWavelengths.size( ) * sizeof( double ) ) );
+
+    if ( ( not series.file ) or ( cubesPerChunk == 0 ) or ( series.bandCount < 1 ) or ( series.cubeWidth < 1 ) or ( series.cubeHeight < 1 ) )
+    {
+        throw ::std::runtime_error{ "Corrupt cube recording header: " + path.string( ) };
+    }
+
+    auto const size = static_cast< ::std::streamoff >( ::hinalea::fs::file_size( path ) );
+    auto const cubeBytes = static_cast< ::std::streamoff >( series.bandCount * series.cubeWidth * series.cubeHeight ) * static_cast< ::std::streamoff >( sizeof( ::hinalea::f32 ) );
+    auto const tableBytes = static_cast< ::std::streamoff >( ::chunkHeaderBytes( cubesPerChunk ) );
+    auto offset = static_cast< ::std::streamoff >( ::roundUp( ::fileHeaderFields + sizeof( double ) * series.bandWavelengths.size( ) ) );
+    auto table = ::std::vector< char >( ::chunkHeaderFields + ::entryBytes * cubesPerChunk );
+
+    /* NOTE: A chunk whose table was never filled in, or whose cubes are cut short, ends the readable recording. */
+    while ( offset + tableBytes <= size )
+    {
+        series.file.seekg( offset );
+        series.file.read( table.data( ), static_cast< ::std::streamsize >( table.size( ) ) );
+
+        auto const count = static_cast< ::std::size_t >( ::load< ::std::uint32_t >( table, 12 ) );
+
+        if ( ( not series.file ) or ( ::std::memcmp( table.data( ), ::chunkMagic, 8 ) != 0 ) or ( count == 0 ) or ( count > cubesPerChunk ) or
+             ( offset + tableBytes + cubeBytes * static_cast< ::std::streamoff >( count ) > size ) )
+        {
+            break;
+        }
+
+        for ( auto i = ::std::size_t{ 0 }; i < count; ++i )
+        {
+            series.entries.push_back( Entry{
+                ::load< ::std::int64_t >( table, ::chunkHeaderFields + ::entryBytes * i ),
+                ::load< ::std::uint64_t >( table, ::chunkHeaderFields + ::entryBytes * i + 8 ),
+                offset + tableBytes + cubeBytes * static_cast< ::std::streamoff >( i ),
+                } );
+        }
+
+        offset += tableBytes + cubeBytes * static_cast< ::std::streamoff >( count );
+    }
+
+    series.file.clear( );
+    return series;
+}
+
+auto CubeSeries::cubes(
+    ) const noexcept -> ::hinalea::Int
+{
+    return static_cast< ::hinalea::Int >( this->entries.size( ) );
+}
+
+auto CubeSeries::bands(
+    ) const noexcept -> ::hinalea::Int
+{
+    return this->bandCount;
+}
+
+auto CubeSeries::width(
+    ) const noexcept -> ::hinalea::Int
+{
+    return this->cubeWidth;
+}
+
+auto CubeSeries::height(
+    ) const noexcept -> ::hinalea::Int
+{
+    return this->cubeHeight;
+}
+
+auto CubeSeries::wavelengths(
+    ) const noexcept -> ::std::vector< double > const &
+{
+    return this->bandWavelengths;
+}
+
+auto CubeSeries::timestamp(
+    HINALEA_IN ::hinalea::Int const cube
+    ) const -> ::std::int64_t
+{
+    return this->entries.at( static_cast< ::std::size_t >( cube ) ).timestamp;
+}
+
+auto CubeSeries::sequence(
+    HINALEA_IN ::hinalea::Int const cube
+    ) const -> ::std::uint64_t
+{
+    return this->entries.at( static_cast< ::std::size_t >( cube ) ).sequence;
+}
+
+auto CubeSeries::read(
+    HINALEA_IN  ::hinalea::Int   const cube,
+    HINALEA_OUT ::hinalea::f32 * const out
+    ) -> void
+{
+    auto const & entry = this->entries.at( static_cast< ::std::size_t >( cube ) );
+    auto const samples = this->bandCount * this->cubeWidth * this->cubeHeight;
+
+    this->file.seekg( entry.offset );
+    this->file.read( reinterpret_cast< char * >( out ), static_cast< ::std::streamsize >( samples ) * static_cast< ::std::streamsize >( sizeof( ::hinalea::f32 ) ) );
+
+    if ( not this->file )
+    {
+        this->file.clear( );
+        throw ::std::runtime_error{ "Failed to read cube " + ::std::to_string( cube ) + " of cube recording." };
+    }
+}
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <Hinalea.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* Appends realtime cubes to one chunked time series file, `<base>.hcs`.
+ *
+ * The file starts with the cube shape and band wavelengths, followed by chunks of up to `cubesPerChunk` BSQ float
+ * cubes. Each chunk starts with a table of the capture timestamps and realtime sequence numbers of its cubes, which is
+ * rewritten once the chunk is complete, so a recording that was cut short is readable up to its last complete chunk.
+ * See `CubeSeries` for the layout.
+ *
+ * `push` runs on the realtime thread and only copies the cube into a buffer for the writer thread, which writes each
+ * cube with one unbuffered write. Buffers are allocated on demand up to a byte budget and then recycled. Once every
+ * buffer waits for the disk, the cube is either dropped and counted, or `push` blocks until a buffer is free.
+ */
+class CubeRecorder
+{
+public:
+    using Clock = ::std::chrono::steady_clock;
+
+    enum class Overflow { Drop, Block };
+
+    struct Options
+    {
+        ::hinalea::Int width{ };
+        ::hinalea::Int height{ };
+        ::hinalea::Int bands{ 0 };              /* If known, `open` allocates the first buffer instead of the first push. */
+        ::std::vector< double > wavelengths{ }; /* Only written if they match the band count of the cubes. */
+        ::hinalea::Int every{ 1 };              /* Records every Nth pushed cube. */
+        ::hinalea::Int cubesPerChunk{ 16 };
+        ::std::size_t queueBytes{ ::std::size_t{ 512 } << 20 };
+        Overflow overflow{ Overflow::Drop };
+    };
+
+    struct Statistics
+    {
+        ::std::uint64_t offered{ };  /* Cubes pushed. */
+        ::std::uint64_t skipped{ };  /* Cubes between every Nth. */
+        ::std::uint64_t dropped{ };  /* No free buffer with `Overflow::Drop`. */
+        ::std::uint64_t stalls{ };   /* Pushes that waited for a free buffer with `Overflow::Block`. */
+        ::std::uint64_t recorded{ };
+        ::std::uint64_t chunks{ };
+        ::std::uint64_t bytes{ };
+        ::std::size_t buffers{ };
+        ::std::size_t maxQueued{ };
+        ::std::chrono::nanoseconds pushTime{ }; /* Spent in `push` by the producer, including stalls. */
+        ::std::chrono::nanoseconds elapsed{ };  /* From `open` to the last completed write. */
+    };
+
+    CubeRecorder(
+        ) = default;
+
+    ~CubeRecorder(
+        );
+
+    CubeRecorder(
+        CubeRecorder const &
+        ) = delete;
+
+    auto operator=(
+        CubeRecorder const &
+        ) -> CubeRecorder & = delete;
+
+    /* Creates `<base>.hcs`, the band count is taken from the options or else the first cube. Throws on I/O errors. */
+    auto open(
+        HINALEA_IN ::hinalea::fs::path const & base,
+        HINALEA_IN Options                     options
+        ) -> void;
+
+    /* `cube` is BSQ, `bands` planes of `area` samples. Returns whether the cube was queued; false once closing, for
+     * skipped and dropped cubes and for cubes of another shape than the first. Rethrows a failed write.
+     */
+    auto push(
+        HINALEA_IN ::hinalea::f32 const * cube,
+        HINALEA_IN ::hinalea::Int         bands,
+        HINALEA_IN ::hinalea::Int         area,
+        HINALEA_IN ::std::int64_t         timestamp
+        ) -> bool;
+
+    /* Writes the queued cubes and completes the last chunk. Safe to call while another thread pushes. */
+    auto close(
+        ) -> Statistics;
+
+    [[ nodiscard ]]
+    auto statistics(
+        ) const -> Statistics;
+
+    [[ nodiscard ]]
+    auto path(
+        ) const -> ::hinalea::fs::path const &;
+
+private:
+    struct Slot
+    {
+        ::std::unique_ptr< ::hinalea::f32[ ] > data{ };
+        ::std::int64_t timestamp{ };
+        ::std::uint64_t sequence{ };
+    };
+
+    struct Entry
+    {
+        ::std::int64_t timestamp{ };
+        ::std::uint64_t sequence{ };
+    };
+
+    auto run(
+        ) -> void;
+
+    auto write(
+        HINALEA_IN Slot const & slot
+        ) -> void;
+
+    auto writeFileHeader(
+        ) -> void;
+
+    auto writeChunkTable(
+        ) -> void;
+
+    /* Sizes the buffers for cubes of `cubeBands` bands. */
+    auto setBands(
+        HINALEA_IN ::hinalea::Int cubeBands
+        ) -> void;
+
+    ::hinalea::fs::path filePath{ };
+    Options settings{ };
+    ::std::ofstream file{ };
+    ::std::thread writer{ };
+    Clock::time_point opened{ };
+
+    mutable ::std::mutex mutex{ };
+    ::std::condition_variable queued{ };
+    ::std::condition_variable released{ };
+    ::std::deque< Slot * > queue{ };
+    ::std::vector< Slot * > freeSlots{ };
+    ::std::vector< ::std::unique_ptr< Slot > > slots{ };
+    ::hinalea::Int bands{ 0 }; /* Set by the first push. */
+    ::std::size_t cubeBytes{ 0 };
+    ::std::size_t maxSlots{ 0 };
+    ::hinalea::Int copying{ 0 }; /* Pushes between taking a buffer and queueing it. */
+    ::std::exception_ptr error{ };
+    Statistics stats{ };
+    bool closing{ false };
+
+    /* Only used by the writer thread until it is joined. */
+    ::std::vector< Entry > chunk{ };
+    ::std::streamoff chunkOffset{ -1 };
+    bool headerWritten{ false };
+};
+
+/* Reads back a recording of `CubeRecorder`. All integers are little endian.
+ *
+ * The file header is 4096 bytes, or more in multiples of 4096 bytes to fit the wavelengths: "HNLCUBS1", u32 version 1,
+ * u32 cubes per chunk, i64 bands, width and height, u64 wavelength count, then f64 wavelengths in nanometers.
+ *
+ * Each chunk header is `16 + 16 * cubes per chunk` bytes rounded up to 4096: "HNLCHUNK", u32 cubes per chunk, u32 cube
+ * count, then per cube an i64 capture timestamp in nanoseconds since the Unix epoch and the u64 realtime sequence
+ * number, which counts every cube the realtime thread delivered so gaps show skipped and dropped cubes. The cubes
+ * follow the chunk header, `bands * width * height` f32 samples each, BSQ.
+ */
+class CubeSeries
+{
+public:
+    [[ nodiscard ]]
+    static
+    auto open(
+        HINALEA_IN ::hinalea::fs::path const & path
+        ) -> CubeSeries;
+
+    [[ nodiscard ]]
+    auto cubes(
+        ) const noexcept -> ::hinalea::Int;
+
+    [[ nodiscard ]]
+    auto bands(
+        ) const noexcept -> ::hinalea::Int;
+
+    [[ nodiscard ]]
+    auto width(
+        ) const noexcept -> ::hinalea::Int;
+
+    [[ nodiscard ]]
+    auto height(
+        ) const noexcept -> ::hinalea::Int;
+
+    [[ nodiscard ]]
+    auto wavelengths(
+        ) const noexcept -> ::std::vector< double > const &;
+
+    [[ nodiscard ]]
+    auto timestamp(
+        HINALEA_IN ::hinalea::Int cube
+        ) const -> ::std::int64_t;
+
+    [[ nodiscard ]]
+    auto sequence(
+        HINALEA_IN ::hinalea::Int cube
+        ) const -> ::std::uint64_t;
+
+    /* Copies one cube into `out`, `bands * width * height` samples. */
+    auto read(
+        HINALEA_IN  ::hinalea::Int   cube,
+        HINALEA_OUT ::hinalea::f32 * out
+        ) -> void;
+
+private:
+    struct Entry
+    {
+        ::std::int64_t timestamp{ };
+        ::std::uint64_t sequence{ };
+        ::std::streamoff offset{ };
+    };
+
+    ::hinalea::Int bandCount{ };
+    ::hinalea::Int cubeWidth{ };
+    ::hinalea::Int cubeHeight{ };
+    ::std::vector< double > bandWavelengths{ };
+    ::std::vector< Entry > entries{ };
+    ::std::ifstream file{ };
+};
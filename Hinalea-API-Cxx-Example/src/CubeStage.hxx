@@ -0,0 +1,281 @@
+#pragma once
+
+#include <Hinalea.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <variant>
+#include <vector>
+
+/* Pipeline stage fed with cubes from the realtime thread.
+ *
+ * The realtime callback only copies the cube, and whatever `Inputs` go with it, into a recycled job and returns; it
+ * never waits on the work. Jobs go through a bounded queue and, once it is full, the oldest queued cube is dropped in
+ * favour of the newest. Workers run the process function outside of any lock. With more than one worker, jobs may
+ * finish out of order, use `Job::sequence` to discard stale results.
+ */
+template <
+    typename Inputs = ::std::monostate
+    >
+class CubeStage
+{
+public:
+    using Clock = ::std::chrono::steady_clock;
+
+    struct Job
+        : Inputs
+    {
+        ::std::vector< ::hinalea::f32 > cube{ }; /* BSQ, `bands * area` samples. */
+        ::hinalea::Int bands{ };
+        ::hinalea::Int area{ };
+        ::std::uint64_t sequence{ };
+        Clock::time_point queued{ };
+    };
+
+    struct Statistics
+    {
+        ::std::uint64_t submitted{ };
+        ::std::uint64_t completed{ };
+        ::std::uint64_t dropped{ };
+        ::std::uint64_t failed{ };
+        ::std::size_t depth{ };
+        ::std::chrono::nanoseconds latency{ }; /* Moving average from submit to completion. */
+    };
+
+    using Process = ::std::function< void ( Job const & job ) >;
+
+    explicit
+    CubeStage(
+        HINALEA_IN ::std::size_t const newCapacity = 2
+        )
+        : capacity{ ::std::max< ::std::size_t >( newCapacity, 1 ) }
+    {
+    }
+
+    ~CubeStage(
+        )
+    {
+        this->stop( );
+    }
+
+    CubeStage(
+        CubeStage const &
+        ) = delete;
+
+    auto operator=(
+        CubeStage const &
+        ) -> CubeStage & = delete;
+
+    auto start(
+        HINALEA_IN ::std::size_t const workerCount,
+        HINALEA_IN Process             newProcess
+        ) -> void
+    {
+        this->stop( );
+
+        {
+            auto const lock = ::std::scoped_lock{ this->mutex };
+            this->process = ::std::move( newProcess );
+            this->stats = Statistics{ };
+            this->running = true;
+        }
+
+        for ( auto i = ::std::size_t{ 0 }; i < ::std::max< ::std::size_t >( workerCount, 1 ); ++i )
+        {
+            this->workers.emplace_back( &CubeStage::run, this );
+        }
+    }
+
+    /* Drops every queued job and waits for the running ones to finish. */
+    auto stop(
+        ) -> void
+    {
+        {
+            auto const lock = ::std::scoped_lock{ this->mutex };
+            this->running = false;
+
+            while ( not this->queue.empty( ) )
+            {
+                this->freeJobs.push_back( ::std::move( this->queue.front( ) ) );
+                this->queue.pop_front( );
+            }
+
+            this->stats.depth = 0;
+        }
+
+        this->wake.notify_all( );
+
+        for ( auto & worker : this->workers )
+        {
+            if ( worker.joinable( ) )
+            {
+                worker.join( );
+            }
+        }
+
+        this->workers.clear( );
+    }
+
+    /* Producer side, copies the cube and calls `fill( inputs )` to copy the rest. Returns false if the stage is not
+     * running. Both run outside the lock, into a recycled job that keeps its capacity.
+     */
+    template <
+        typename Fill
+        >
+    auto submit(
+        HINALEA_IN ::hinalea::f32 const * const cube,
+        HINALEA_IN ::hinalea::Int         const bands,
+        HINALEA_IN ::hinalea::Int         const area,
+        HINALEA_IN Fill &&                      fill
+        ) -> bool
+    {
+        auto job = ::std::unique_ptr< Job >{ };
+
+        {
+            auto const lock = ::std::scoped_lock{ this->mutex };
+
+            if ( not this->running )
+            {
+                return false;
+            }
+
+            if ( not this->freeJobs.empty( ) )
+            {
+                job = ::std::move( this->freeJobs.back( ) );
+                this->freeJobs.pop_back( );
+            }
+        }
+
+        if ( not job )
+        {
+            job = ::std::make_unique< Job >( );
+        }
+
+        /* Copy outside the lock, the realtime thread owns the cube only for the duration of its callback.
+         * Recycled jobs keep their capacity, so steady state submits do not allocate.
+         */
+        job->cube.assign( cube, cube + bands * area );
+        job->bands = bands;
+        job->area = area;
+        fill( static_cast< Inputs & >( *job ) );
+        job->queued = Clock::now( );
+
+        {
+            auto const lock = ::std::scoped_lock{ this->mutex };
+
+            if ( not this->running )
+            {
+                this->freeJobs.push_back( ::std::move( job ) );
+                return false;
+            }
+
+            if ( this->queue.size( ) >= this->capacity )
+            {
+                /* Drop oldest: the newest cube is always the most relevant one to show. */
+                this->freeJobs.push_back( ::std::move( this->queue.front( ) ) );
+                this->queue.pop_front( );
+                ++this->stats.dropped;
+            }
+
+            job->sequence = ++this->sequence;
+            this->queue.push_back( ::std::move( job ) );
+            ++this->stats.submitted;
+            this->stats.depth = this->queue.size( );
+        }
+
+        this->wake.notify_one( );
+        return true;
+    }
+
+    /* Producer side of stages whose jobs are the cube only. */
+    auto submit(
+        HINALEA_IN ::hinalea::f32 const * const cube,
+        HINALEA_IN ::hinalea::Int         const bands,
+        HINALEA_IN ::hinalea::Int         const area
+        ) -> bool
+    {
+        return this->submit( cube, bands, area, [ ]( Inputs & ){ } );
+    }
+
+    [[ nodiscard ]]
+    auto statistics(
+        ) const -> Statistics
+    {
+        auto const lock = ::std::scoped_lock{ this->mutex };
+        return this->stats;
+    }
+
+private:
+    auto run(
+        ) -> void
+    {
+        while ( true )
+        {
+            auto job = ::std::unique_ptr< Job >{ };
+
+            {
+                auto lock = ::std::unique_lock{ this->mutex };
+                this->wake.wait( lock, [ this ]{ return ( not this->running ) or ( not this->queue.empty( ) ); } );
+
+                if ( not this->running )
+                {
+                    return;
+                }
+
+                job = ::std::move( this->queue.front( ) );
+                this->queue.pop_front( );
+                this->stats.depth = this->queue.size( );
+            }
+
+            auto ok = true;
+
+            try
+            {
+                this->process( *job );
+            }
+            catch ( ::std::exception const & exc )
+            {
+                ::std::cerr << exc.what( ) << '\n';
+                ok = false;
+            }
+
+            auto const latency = ::std::chrono::duration_cast< ::std::chrono::nanoseconds >( Clock::now( ) - job->queued );
+
+            {
+                auto const lock = ::std::scoped_lock{ this->mutex };
+
+                if ( ok )
+                {
+                    ++this->stats.completed;
+                    this->stats.latency += ( latency - this->stats.latency ) / 8;
+                }
+                else
+                {
+                    ++this->stats.failed;
+                }
+
+                this->freeJobs.push_back( ::std::move( job ) );
+            }
+        }
+    }
+
+    ::std::size_t capacity;
+    Process process{ };
+    ::std::vector< ::std::thread > workers{ };
+
+    mutable ::std::mutex mutex{ };
+    ::std::condition_variable wake{ };
+    ::std::deque< ::std::unique_ptr< Job > > queue{ };
+    ::std::vector< ::std::unique_ptr< Job > > freeJobs{ };
+    ::std::uint64_t sequence{ 0 };
+    Statistics stats{ };
+    bool running{ false };
+};
@@ -0,0 +1,429 @@
+#include "Demosaic.hxx"
+
+#include "Simd.hxx"
+#include "ThreadPool.hxx"
+
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+/* Neighbour averages of one row, computed once and shared by every CFA site. */
+struct RowTerms
+{
+    ::std::uint16_t * horizontal; /* ( left + right ) / 2 */
+    ::std::uint16_t * vertical;   /* ( up + down ) / 2 */
+    ::std::uint16_t * diagonal;   /* average of the four diagonal neighbours */
+    ::std::uint16_t * green;      /* green estimate at red and blue sites */
+};
+
+[[ nodiscard ]]
+constexpr
+auto average(
+    HINALEA_IN ::std::uint32_t const a,
+    HINALEA_IN ::std::uint32_t const b
+    ) noexcept -> ::std::uint16_t
+{
+    /* Same rounding as _mm256_avg_epu16. */
+    return static_cast< ::std::uint16_t >( ( a + b + 1 ) >> 1 );
+}
+
+[[ nodiscard ]]
+constexpr
+auto absDiff(
+    HINALEA_IN ::std::uint16_t const a,
+    HINALEA_IN ::std::uint16_t const b
+    ) noexcept -> ::std::uint16_t
+{
+    return ( a > b ) ? ( a - b ) : ( b - a );
+}
+
+/* `up`, `mid` and `down` are padded by one sample on both sides, ie. index 0 is column -1. */
+template <
+    bool EdgeAware
+    >
+auto rowTermsScalar(
+    HINALEA_IN ::std::uint16_t const * const up,
+    HINALEA_IN ::std::uint16_t const * const mid,
+    HINALEA_IN ::std::uint16_t const * const down,
+    HINALEA_IN ::hinalea::Int          const begin,
+    HINALEA_IN ::hinalea::Int          const width,
+    HINALEA_IN RowTerms                const & terms
+    ) -> void
+{
+    for ( auto x = begin; x < width; ++x )
+    {
+        auto const h = ::average( mid[ x ], mid[ x + 2 ] );
+        auto const v = ::average( up[ x + 1 ], down[ x + 1 ] );
+        terms.horizontal[ x ] = h;
+        terms.vertical  [ x ] = v;
+        terms.diagonal  [ x ] = ::average( ::average( up[ x ], up[ x + 2 ] ), ::average( down[ x ], down[ x + 2 ] ) );
+
+        if constexpr ( EdgeAware )
+        {
+            auto const gh = ::absDiff( mid[ x ], mid[ x + 2 ] );
+            auto const gv = ::absDiff( up[ x + 1 ], down[ x + 1 ] );
+            terms.green[ x ] = ( gh < gv ) ? h : ( gv < gh ) ? v : ::average( h, v );
+        }
+        else
+        {
+            terms.green[ x ] = ::average( h, v );
+        }
+    }
+}
+
+template <
+    bool EdgeAware
+    >
+SIMD_TARGET_AVX2
+auto rowTermsAvx2(
+    HINALEA_IN ::std::uint16_t const * const up,
+    HINALEA_IN ::std::uint16_t const * const mid,
+    HINALEA_IN ::std::uint16_t const * const down,
+    HINALEA_IN ::hinalea::Int          const width,
+    HINALEA_IN RowTerms                const & terms
+    ) -> void
+{
+    /* NOTE: No lambdas in here since GCC and Clang do not propagate the target attribute into them. */
+    using V = __m256i;
+    auto constexpr lanes = ::hinalea::Int{ 16 };
+    auto x = ::hinalea::Int{ 0 };
+
+    for ( ; x + lanes <= width; x += lanes )
+    {
+        auto const l  = _mm256_loadu_si256( reinterpret_cast< V const * >( mid  + x     ) );
+        auto const r  = _mm256_loadu_si256( reinterpret_cast< V const * >( mid  + x + 2 ) );
+        auto const u  = _mm256_loadu_si256( reinterpret_cast< V const * >( up   + x + 1 ) );
+        auto const d  = _mm256_loadu_si256( reinterpret_cast< V const * >( down + x + 1 ) );
+        auto const ul = _mm256_loadu_si256( reinterpret_cast< V const * >( up   + x     ) );
+        auto const ur = _mm256_loadu_si256( reinterpret_cast< V const * >( up   + x + 2 ) );
+        auto const dl = _mm256_loadu_si256( reinterpret_cast< V const * >( down + x     ) );
+        auto const dr = _mm256_loadu_si256( reinterpret_cast< V const * >( down + x + 2 ) );
+
+        auto const h = _mm256_avg_epu16( l, r );
+        auto const v = _mm256_avg_epu16( u, d );
+        auto const diagonal = _mm256_avg_epu16( _mm256_avg_epu16( ul, ur ), _mm256_avg_epu16( dl, dr ) );
+        auto const cross = _mm256_avg_epu16( h, v );
+        auto green = cross;
+
+        if constexpr ( EdgeAware )
+        {
+            auto const gh = _mm256_or_si256( _mm256_subs_epu16( l, r ), _mm256_subs_epu16( r, l ) );
+            auto const gv = _mm256_or_si256( _mm256_subs_epu16( u, d ), _mm256_subs_epu16( d, u ) );
+            auto const least = _mm256_min_epu16( gh, gv );
+            auto const equal = _mm256_cmpeq_epi16( gh, gv );
+            /* gh < gv <=> min( gh, gv ) == gh and gh != gv */
+            auto const useH = _mm256_andnot_si256( equal, _mm256_cmpeq_epi16( least, gh ) );
+            auto const useV = _mm256_andnot_si256( equal, _mm256_cmpeq_epi16( least, gv ) );
+            green = _mm256_blendv_epi8( green, h, useH );
+            green = _mm256_blendv_epi8( green, v, useV );
+        }
+
+        _mm256_storeu_si256( reinterpret_cast< V * >( terms.horizontal + x ), h );
+        _mm256_storeu_si256( reinterpret_cast< V * >( terms.vertical   + x ), v );
+        _mm256_storeu_si256( reinterpret_cast< V * >( terms.diagonal   + x ), diagonal );
+        _mm256_storeu_si256( reinterpret_cast< V * >( terms.green      + x ), green );
+    }
+
+    ::rowTermsScalar< EdgeAware >( up, mid, down, x, width, terms );
+}
+
+template <
+    int Shift
+    >
+[[ nodiscard ]]
+constexpr
+auto toDisplay(
+    HINALEA_IN ::std::uint16_t const value
+    ) noexcept -> ::std::uint8_t
+{
+    /* Clamp in case the sensor sets bits above its nominal bit depth. */
+    return static_cast< ::std::uint8_t >( ::std::min( value >> Shift, 0xFF ) );
+}
+
+struct Phase
+{
+    int x;
+    int y;
+};
+
+[[ nodiscard ]]
+constexpr
+auto redPhase(
+    HINALEA_IN CfaPattern const pattern
+    ) noexcept -> Phase
+{
+    switch ( pattern )
+    {
+        case CfaPattern::Rggb: { return { 0, 0 }; }
+        case CfaPattern::Grbg: { return { 1, 0 }; }
+        case CfaPattern::Gbrg: { return { 0, 1 }; }
+        case CfaPattern::Bggr: { return { 1, 1 }; }
+    }
+
+    return { 0, 0 };
+}
+
+template <
+    typename T
+    >
+auto loadRow(
+    HINALEA_IN  T const * const       row,
+    HINALEA_IN  ::hinalea::Int const  width,
+    HINALEA_OUT ::std::uint16_t *     padded
+    ) -> void
+{
+    /* Mirror one sample on each side so the kernels never need bounds checks. */
+    for ( auto x = ::hinalea::Int{ 0 }; x < width; ++x )
+    {
+        padded[ x + 1 ] = static_cast< ::std::uint16_t >( row[ x ] );
+    }
+
+    padded[ 0 ]         = padded[ ( width > 1 ) ? 2 : 1 ];
+    padded[ width + 1 ] = padded[ ( width > 1 ) ? ( width - 1 ) : width ];
+}
+
+template <
+    CfaPattern Pattern,
+    int        BitDepth,
+    bool       EdgeAware
+    >
+auto demosaicBand(
+    HINALEA_IN FrameView      const & raw,
+    HINALEA_IN DemosaicOutput const & output,
+    HINALEA_IN simd::Level    const   level,
+    HINALEA_IN ::std::size_t  const   begin,
+    HINALEA_IN ::std::size_t  const   end
+    ) -> void
+{
+    using T = ::std::conditional_t< ( BitDepth <= 8 ), ::std::uint8_t, ::std::uint16_t >;
+
+    auto constexpr phase = ::redPhase( Pattern );
+    auto constexpr shift = ( BitDepth > 8 ) ? ( BitDepth - 8 ) : 0;
+    auto constexpr alpha = static_cast< ::std::uint16_t >( ( 1 << BitDepth ) - 1 );
+
+    auto const width  = raw.width;
+    auto const height = static_cast< ::std::size_t >( raw.height );
+    auto const padded = static_cast< ::std::size_t >( width + 2 );
+
+    /* 3 rolling input rows plus the 4 term rows, reused across frames. */
+    thread_local auto scratch = ::std::vector< ::std::uint16_t >{ };
+    scratch.resize( padded * 3 + static_cast< ::std::size_t >( width ) * 4 + 16 );
+
+    ::std::uint16_t * rows[ 3 ] = { scratch.data( ), scratch.data( ) + padded, scratch.data( ) + padded * 2 };
+    auto * const termsBase = scratch.data( ) + padded * 3;
+    auto const terms = RowTerms{
+        termsBase,
+        termsBase + width,
+        termsBase + width * 2,
+        termsBase + width * 3,
+        };
+
+    auto const * const bytes = static_cast< ::std::byte const * >( raw.data );
+    auto const rowAt =
+        [ & ]( ::std::size_t const y )
+        {
+            /* Mirror at the top and bottom edges, same as for columns. */
+            auto const mirrored = ( height == 1 ) ? 0
+                : ( y == static_cast< ::std::size_t >( -1 ) ) ? 1
+                : ( y == height ) ? ( height - 2 )
+                : y;
+            return reinterpret_cast< T const * >( bytes + mirrored * raw.linePitch );
+        };
+
+    ::loadRow( rowAt( begin - 1 ), width, rows[ 0 ] );
+    ::loadRow( rowAt( begin     ), width, rows[ 1 ] );
+
+    for ( auto y = begin; y < end; ++y )
+    {
+        ::loadRow( rowAt( y + 1 ), width, rows[ 2 ] );
+
+        if ( level == simd::Level::Avx2 )
+        {
+            ::rowTermsAvx2< EdgeAware >( rows[ 0 ], rows[ 1 ], rows[ 2 ], width, terms );
+        }
+        else
+        {
+            ::rowTermsScalar< EdgeAware >( rows[ 0 ], rows[ 1 ], rows[ 2 ], 0, width, terms );
+        }
+
+        auto * const display = output.display + y * output.displayLinePitch;
+        auto * const analysis = output.analysis
+            ? reinterpret_cast< ::std::uint16_t * >( reinterpret_cast< ::std::byte * >( output.analysis ) + y * output.analysisLinePitch )
+            : nullptr;
+        auto const * const center = rows[ 1 ] + 1;
+        auto const * const toneMap = output.toneMap;
+        auto const redRow = ( ( static_cast< int >( y ) ^ phase.y ) & 1 ) == 0;
+
+        for ( auto x = ::hinalea::Int{ 0 }; x < width; ++x )
+        {
+            auto const redColumn = ( ( static_cast< int >( x ) ^ phase.x ) & 1 ) == 0;
+            ::std::uint16_t r, g, b;
+
+            if ( redRow and redColumn )         /* Red site */
+            {
+                r = center[ x ];
+                g = terms.green[ x ];
+                b = terms.diagonal[ x ];
+            }
+            else if ( not redRow and not redColumn ) /* Blue site */
+            {
+                r = terms.diagonal[ x ];
+                g = terms.green[ x ];
+                b = center[ x ];
+            }
+            else if ( redRow )                  /* Green site on a red row */
+            {
+                r = terms.horizontal[ x ];
+                g = center[ x ];
+                b = terms.vertical[ x ];
+            }
+            else                                /* Green site on a blue row */
+            {
+                r = terms.vertical[ x ];
+                g = center[ x ];
+                b = terms.horizontal[ x ];
+            }
+
+            if ( toneMap )
+            {
+                display[ x * 4 + 0 ] = toneMap[ ::std::min( r, alpha ) ];
+                display[ x * 4 + 1 ] = toneMap[ ::std::min( g, alpha ) ];
+                display[ x * 4 + 2 ] = toneMap[ ::std::min( b, alpha ) ];
+            }
+            else
+            {
+                display[ x * 4 + 0 ] = ::toDisplay< shift >( r );
+                display[ x * 4 + 1 ] = ::toDisplay< shift >( g );
+                display[ x * 4 + 2 ] = ::toDisplay< shift >( b );
+            }
+
+            display[ x * 4 + 3 ] = 0xFF;
+
+            if ( analysis )
+            {
+                analysis[ x * 4 + 0 ] = r;
+                analysis[ x * 4 + 1 ] = g;
+                analysis[ x * 4 + 2 ] = b;
+                analysis[ x * 4 + 3 ] = alpha;
+            }
+        }
+
+        ::std::rotate( rows, rows + 1, rows + 3 );
+    }
+}
+
+template <
+    CfaPattern Pattern,
+    int        BitDepth
+    >
+auto demosaicFrame(
+    HINALEA_IN FrameView      const & raw,
+    HINALEA_IN DemosaicMethod const   method,
+    HINALEA_IN DemosaicOutput const & output
+    ) -> void
+{
+    auto const level = simd::level( );
+    auto const height = static_cast< ::std::size_t >( raw.height );
+    auto const bands = ThreadPool::global( ).concurrency( ) * 2;
+    auto const grain = ::std::max< ::std::size_t >( ( height + bands - 1 ) / bands, 8 );
+
+    ThreadPool::global( ).parallelFor(
+        height,
+        grain,
+        [ & ]( ::std::size_t const begin, ::std::size_t const end )
+        {
+            if ( method == DemosaicMethod::EdgeAware )
+            {
+                ::demosaicBand< Pattern, BitDepth, true >( raw, output, level, begin, end );
+            }
+            else
+            {
+                ::demosaicBand< Pattern, BitDepth, false >( raw, output, level, begin, end );
+            }
+        }
+        );
+}
+
+template <
+    CfaPattern Pattern
+    >
+auto demosaicPattern(
+    HINALEA_IN FrameView      const & raw,
+    HINALEA_IN DemosaicMethod const   method,
+    HINALEA_IN DemosaicOutput const & output
+    ) -> void
+{
+    switch ( raw.bitDepth )
+    {
+        case 8:  { ::demosaicFrame< Pattern,  8 >( raw, method, output ); break; }
+        case 10: { ::demosaicFrame< Pattern, 10 >( raw, method, output ); break; }
+        case 12: { ::demosaicFrame< Pattern, 12 >( raw, method, output ); break; }
+        case 14: { ::demosaicFrame< Pattern, 14 >( raw, method, output ); break; }
+        case 16: { ::demosaicFrame< Pattern, 16 >( raw, method, output ); break; }
+        default:
+        {
+            throw ::std::invalid_argument{ "Demosaic only supports 8, 10, 12, 14 and 16 bit frames." };
+        }
+    }
+}
+
+} /* namespace anonymous */
+
+auto flipCfaPattern(
+    HINALEA_IN CfaPattern     const pattern,
+    HINALEA_IN bool           const horizontal,
+    HINALEA_IN bool           const vertical,
+    HINALEA_IN ::hinalea::Int const width,
+    HINALEA_IN ::hinalea::Int const height
+    ) noexcept -> CfaPattern
+{
+    auto phase = ::redPhase( pattern );
+
+    /* Flipping an even sized axis moves the red sample to the other column or row of the quad. */
+    if ( horizontal and ::hinalea::is_even( width ) )
+    {
+        phase.x ^= 1;
+    }
+
+    if ( vertical and ::hinalea::is_even( height ) )
+    {
+        phase.y ^= 1;
+    }
+
+    switch ( ( phase.y << 1 ) | phase.x )
+    {
+        case 0:  { return CfaPattern::Rggb; }
+        case 1:  { return CfaPattern::Grbg; }
+        case 2:  { return CfaPattern::Gbrg; }
+        default: { return CfaPattern::Bggr; }
+    }
+}
+
+auto demosaic(
+    HINALEA_IN FrameView      const & raw,
+    HINALEA_IN CfaPattern     const   pattern,
+    HINALEA_IN DemosaicMethod const   method,
+    HINALEA_IN DemosaicOutput const & output
+    ) -> void
+{
+    if ( not output.display )
+    {
+        throw ::std::invalid_argument{ "Demosaic requires a display output." };
+    }
+
+    if ( ( raw.width < 2 ) or ( raw.height < 2 ) )
+    {
+        throw ::std::invalid_argument{ "Demosaic requires at least a 2x2 frame." };
+    }
+
+    switch ( pattern )
+    {
+        case CfaPattern::Rggb: { ::demosaicPattern< CfaPattern::Rggb >( raw, method, output ); break; }
+        case CfaPattern::Grbg: { ::demosaicPattern< CfaPattern::Grbg >( raw, method, output ); break; }
+        case CfaPattern::Gbrg: { ::demosaicPattern< CfaPattern::Gbrg >( raw, method, output ); break; }
+        case CfaPattern::Bggr: { ::demosaicPattern< CfaPattern::Bggr >( raw, method, output ); break; }
+    }
+}
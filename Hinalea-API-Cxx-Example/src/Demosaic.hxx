@@ -0,0 +1,53 @@
+#pragma once
+
+#include "FrameStatistics.hxx"
+
+#include <Hinalea.h>
+
+#include <cstdint>
+
+/* Position of the red sample in the top left 2x2 quad of the color filter array. */
+enum class CfaPattern { Rggb, Grbg, Gbrg, Bggr };
+
+enum class DemosaicMethod
+{
+    Bilinear,  /* Average of the nearest same color neighbours. */
+    EdgeAware, /* Green is interpolated along the direction of the smaller gradient. */
+};
+
+struct DemosaicOutput
+{
+    /* Display ready 8-bit RGBA, required. */
+    ::std::uint8_t * display{ nullptr };
+    ::hinalea::Int   displayLinePitch{ };
+
+    /* Full precision 16-bit RGBA for analysis, optional. Samples keep the sensor bit depth. */
+    ::std::uint16_t * analysis{ nullptr };
+    ::hinalea::Int    analysisLinePitch{ };
+
+    /* Optional tone mapping table indexed by raw intensity, used for the display output instead of a plain shift. */
+    ::std::uint8_t const * toneMap{ nullptr };
+};
+
+/* Pattern seen after the camera applied the given flips to a sensor with `pattern`. */
+[[ nodiscard ]]
+auto flipCfaPattern(
+    HINALEA_IN CfaPattern     pattern,
+    HINALEA_IN bool           horizontal,
+    HINALEA_IN bool           vertical,
+    HINALEA_IN ::hinalea::Int width,
+    HINALEA_IN ::hinalea::Int height
+    ) noexcept -> CfaPattern;
+
+/* Converts a raw color filter array frame into RGBA.
+ *
+ * Kernels are specialized at compile time for every CFA pattern and for 8, 10, 12, 14 and 16 bit frames. Each row
+ * computes its neighbour averages and gradients with AVX2 (scalar fallback), and row bands are spread across
+ * `ThreadPool::global( )`. Both outputs are written in the same pass.
+ */
+auto demosaic(
+    HINALEA_IN FrameView const &      raw,
+    HINALEA_IN CfaPattern             pattern,
+    HINALEA_IN DemosaicMethod         method,
+    HINALEA_IN DemosaicOutput const & output
+    ) -> void;
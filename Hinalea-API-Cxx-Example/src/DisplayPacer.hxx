@@ -0,0 +1,82 @@
+#pragma once
+
+#include <Hinalea.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+/* Paces a loop to one pass per period, however long the pass itself takes.
+ *
+ * Each deadline is the previous one plus the period, so short passes do not make the rate drift. A pass that overruns
+ * its deadline is followed at once and the schedule restarts from now, so a stall is not made up for with a burst.
+ */
+class DisplayPacer
+{
+public:
+    using Clock = ::std::chrono::steady_clock;
+
+    struct Periods
+    {
+        ::std::chrono::milliseconds timerInterval{ }; /* Of the GUI display timer, the refresh period rounded up. */
+        ::hinalea::MicrosecondsI    displayPeriod{ }; /* Between two frames fetched by the display thread. */
+        ::hinalea::MicrosecondsI    fetchPeriod{ };   /* Between two fetches while every frame is needed. */
+    };
+
+    /* Shortest fetch period, so very short exposures do not turn fetching into spinning. */
+    static auto constexpr minFetchPeriod = ::hinalea::MicrosecondsI{ 100 };
+
+    /* Periods of the display path for a camera `exposure` and a GUI `refreshRate` in repaints per second.
+     *
+     * The GUI repaints at the refresh target regardless of the exposure, always showing the newest frame. The display
+     * thread never fetches frames faster than the camera produces them nor faster than they can be shown, so a 1 msec
+     * exposure does not ask for 1000 repaints per second and a 500 msec exposure keeps the GUI responsive.
+     *
+     * Consumers that need every frame, eg. a raw sweep, have the display thread fetch twice per exposure instead and
+     * render only at the display period. Frames never come faster than one per exposure, so none is missed.
+     */
+    [[ nodiscard ]]
+    static
+    auto periods(
+        HINALEA_IN ::hinalea::MicrosecondsI const exposure,
+        HINALEA_IN int const                      refreshRate
+        ) -> Periods
+    {
+        HINALEA_ASSERT( refreshRate > 0 );
+
+        auto const refresh = ::std::chrono::duration_cast< ::hinalea::MicrosecondsI >( ::std::chrono::seconds{ 1 } ) / refreshRate;
+        return Periods{
+            ::std::chrono::ceil< ::std::chrono::milliseconds >( refresh ),
+            ::std::max( exposure, refresh ),
+            ::std::max( exposure / 2, minFetchPeriod ),
+            };
+    }
+
+    /* Restarts the schedule from now. */
+    auto restart(
+        ) noexcept -> void
+    {
+        this->next = Clock::now( );
+    }
+
+    /* Sleeps until `period` after the previous deadline, or returns at once if that has passed. */
+    auto wait(
+        HINALEA_IN Clock::duration const period
+        ) -> void
+    {
+        this->next += period;
+
+        if ( auto const now = Clock::now( );
+             this->next < now )
+        {
+            this->next = now;
+        }
+        else
+        {
+            ::std::this_thread::sleep_until( this->next );
+        }
+    }
+
+private:
+    Clock::time_point next{ Clock::now( ) };
+};
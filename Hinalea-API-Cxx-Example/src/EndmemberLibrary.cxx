@@ -0,0 +1,248 @@
+#include "EndmemberLibrary.hxx"
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+
+namespace {
+
+[[ nodiscard ]]
+auto trim(
+    HINALEA_IN ::std::string_view text
+    ) -> ::std::string_view
+{
+    auto const isSpace = [ ]( char const c ){ return ( c == ' ' ) or ( c == '\t' ) or ( c == '\r' ); };
+
+    while ( ( not text.empty( ) ) and isSpace( text.front( ) ) )
+    {
+        text.remove_prefix( 1 );
+    }
+
+    while ( ( not text.empty( ) ) and isSpace( text.back( ) ) )
+    {
+        text.remove_suffix( 1 );
+    }
+
+    return text;
+}
+
+[[ nodiscard ]]
+auto split(
+    HINALEA_IN ::std::string_view const line
+    ) -> ::std::vector< ::std::string_view >
+{
+    auto fields = ::std::vector< ::std::string_view >{ };
+    auto begin = ::std::size_t{ 0 };
+
+    while ( true )
+    {
+        auto const end = line.find( ',', begin );
+        fields.push_back( ::trim( line.substr( begin, end - begin ) ) );
+
+        if ( end == ::std::string_view::npos )
+        {
+            return fields;
+        }
+
+        begin = end + 1;
+    }
+}
+
+/* `std::from_chars` ignores the C locale, which Qt sets from the environment. */
+[[ nodiscard ]]
+auto parseSample(
+    HINALEA_IN  ::std::string_view const field,
+    HINALEA_OUT ::hinalea::f32 &         value
+    ) -> bool
+{
+    auto const * const end = field.data( ) + field.size( );
+    auto const [ ptr, error ] = ::std::from_chars( field.data( ), end, value );
+    return ( error == ::std::errc{ } ) and ( ptr == end ) and ( not field.empty( ) );
+}
+
+[[ nodiscard ]]
+auto parseColor(
+    HINALEA_IN ::std::string_view const field
+    ) -> ::std::optional< ::std::uint32_t >
+{
+    auto rgb = ::std::uint32_t{ 0 };
+
+    if ( ( field.size( ) != 7 ) or ( field.front( ) != '#' ) )
+    {
+        return ::std::nullopt;
+    }
+
+    auto const * const end = field.data( ) + field.size( );
+
+    if ( auto const [ ptr, error ] = ::std::from_chars( field.data( ) + 1, end, rgb, 16 );
+         ( error != ::std::errc{ } ) or ( ptr != end ) )
+    {
+        return ::std::nullopt;
+    }
+
+    return 0xff000000u | rgb;
+}
+
+[[ nodiscard ]]
+auto isHeader(
+    HINALEA_IN ::std::string_view const name
+    ) -> bool
+{
+    auto constexpr header = ::std::string_view{ "wavelength" };
+
+    return ::std::equal(
+        name.begin( ),
+        name.end( ),
+        header.begin( ),
+        header.end( ),
+        [ ]( char const a, char const b ){ return ( ( 'A' <= a ) and ( a <= 'Z' ) ? char( a - 'A' + 'a' ) : a ) == b; }
+        );
+}
+
+} /* namespace anonymous */
+
+auto EndmemberLibrary::load(
+    HINALEA_IN ::hinalea::fs::path const & path
+    ) -> EndmemberLibrary
+{
+    auto file = ::std::ifstream{ path };
+
+    if ( not file )
+    {
+        throw ::std::runtime_error{ "Failed to open endmember library: " + path.string( ) };
+    }
+
+    auto library = EndmemberLibrary{ };
+    auto line = ::std::string{ };
+    auto lineNumber = 0;
+
+    auto const fail =
+        [ & ]( char const * const what )
+        {
+            throw ::std::runtime_error{
+                path.string( ) + ":" + ::std::to_string( lineNumber ) + ": " + what
+                };
+        };
+
+    while ( ::std::getline( file, line ) )
+    {
+        ++lineNumber;
+
+        auto const text = ::trim( line );
+
+        if ( text.empty( ) or ( text.front( ) == '#' ) )
+        {
+            continue;
+        }
+
+        auto const fields = ::split( text );
+        auto const name = fields.front( );
+
+        if ( ::isHeader( name ) )
+        {
+            continue;
+        }
+
+        if ( name.empty( ) )
+        {
+            fail( "Spectrum has no class name." );
+        }
+
+        auto first = ::std::size_t{ 1 };
+        auto const color = ( fields.size( ) > 1 ) ? ::parseColor( fields[ 1 ] ) : ::std::nullopt;
+
+        if ( color.has_value( ) )
+        {
+            ++first;
+        }
+
+        auto const bands = static_cast< ::hinalea::Int >( fields.size( ) - first );
+
+        if ( bands < 1 )
+        {
+            fail( "Spectrum has no samples." );
+        }
+
+        if ( library.bandCount == 0 )
+        {
+            library.bandCount = bands;
+        }
+        else if ( bands != library.bandCount )
+        {
+            fail( "Spectrum band count differs from the previous spectra." );
+        }
+
+        for ( auto i = first; i < fields.size( ); ++i )
+        {
+            auto value = ::hinalea::f32{ };
+
+            if ( not ::parseSample( fields[ i ], value ) )
+            {
+                fail( "Sample is not a number." );
+            }
+
+            library.values.push_back( value );
+        }
+
+        auto entry = ::std::find_if(
+            library.classList.begin( ),
+            library.classList.end( ),
+            [ & ]( Class const & c ){ return c.name == name; }
+            );
+
+        if ( entry == library.classList.end( ) )
+        {
+            if ( static_cast< ::hinalea::Int >( library.classList.size( ) ) == maxClasses )
+            {
+                fail( "Libraries are limited to 255 classes." );
+            }
+
+            entry = library.classList.insert( library.classList.end( ), Class{ ::std::string{ name }, color } );
+        }
+        else if ( not entry->color.has_value( ) )
+        {
+            entry->color = color;
+        }
+
+        library.classIndices.push_back( static_cast< ::std::uint8_t >( entry - library.classList.begin( ) ) );
+    }
+
+    if ( library.classIndices.empty( ) )
+    {
+        throw ::std::runtime_error{ "Endmember library has no spectra: " + path.string( ) };
+    }
+
+    return library;
+}
+
+auto EndmemberLibrary::bands(
+    ) const noexcept -> ::hinalea::Int
+{
+    return this->bandCount;
+}
+
+auto EndmemberLibrary::observations(
+    ) const noexcept -> ::hinalea::Int
+{
+    return static_cast< ::hinalea::Int >( this->classIndices.size( ) );
+}
+
+auto EndmemberLibrary::spectra(
+    ) const noexcept -> ::hinalea::f32 const *
+{
+    return this->values.data( );
+}
+
+auto EndmemberLibrary::spectrumClasses(
+    ) const noexcept -> ::std::uint8_t const *
+{
+    return this->classIndices.data( );
+}
+
+auto EndmemberLibrary::classes(
+    ) const noexcept -> ::std::vector< Class > const &
+{
+    return this->classList;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <Hinalea.h>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+/* Reference spectra to classify against, in place of the spectra picked from the image.
+ *
+ * Libraries are comma separated text files with one spectrum per line:
+ *
+ *     # Lines starting with '#' and empty lines are skipped.
+ *     wavelength, 450.0, 455.0, ...   <- Optional, ignored.
+ *     grass, #2e8b57, 0.041, 0.043, ...
+ *     grass, 0.038, 0.040, ...
+ *     asphalt, 0.101, 0.102, ...
+ *
+ * Spectra sharing a name form one class, so a class can hold as many spectra as needed while labels stay 8-bit.
+ * The optional `#rrggbb` field sets the overlay color of the class, the first one given wins.
+ */
+class EndmemberLibrary
+{
+public:
+    /* Labels are 8-bit and 0 means unclassified. */
+    static auto constexpr maxClasses = ::hinalea::Int{ 255 };
+
+    struct Class
+    {
+        ::std::string name{ };
+        ::std::optional< ::std::uint32_t > color{ ::std::nullopt }; /* 0xffrrggbb, same layout as `QRgb`. */
+    };
+
+    /* Throws `std::runtime_error` with the offending line on malformed files. */
+    [[ nodiscard ]]
+    static
+    auto load(
+        HINALEA_IN ::hinalea::fs::path const & path
+        ) -> EndmemberLibrary;
+
+    [[ nodiscard ]]
+    auto bands(
+        ) const noexcept -> ::hinalea::Int;
+
+    [[ nodiscard ]]
+    auto observations(
+        ) const noexcept -> ::hinalea::Int;
+
+    /* `observations x bands`, row major. */
+    [[ nodiscard ]]
+    auto spectra(
+        ) const noexcept -> ::hinalea::f32 const *;
+
+    /* Class index of every spectrum. */
+    [[ nodiscard ]]
+    auto spectrumClasses(
+        ) const noexcept -> ::std::uint8_t const *;
+
+    [[ nodiscard ]]
+    auto classes(
+        ) const noexcept -> ::std::vector< Class > const &;
+
+private:
+    ::hinalea::Int bandCount{ 0 };
+    ::std::vector< ::hinalea::f32 > values{ };
+    ::std::vector< ::std::uint8_t > classIndices{ };
+    ::std::vector< Class > classList{ };
+};
@@ -0,0 +1,1050 @@
+#include "EnviCube.hxx"
+#include "ChunkedCube.hxx"
+#include "RawRecorder.hxx"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else /* ^^^ Windows | POSIX vvv */
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif /* _WIN32 */
+
+/* Read only mapping of a whole file, unmapped on destruction. */
+struct EnviCube::Mapping
+{
+    ::std::byte const * data{ nullptr };
+    ::std::size_t size{ 0 };
+
+    #ifdef _WIN32
+    HANDLE file{ INVALID_HANDLE_VALUE };
+    HANDLE section{ nullptr };
+    #endif
+
+    explicit
+    Mapping(
+        HINALEA_IN ::hinalea::fs::path const & path
+        )
+    {
+        #ifdef _WIN32
+        this->file = ::CreateFileW( path.c_str( ), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+
+        if ( auto size = LARGE_INTEGER{ };
+             ( this->file == INVALID_HANDLE_VALUE ) or not ::GetFileSizeEx( this->file, &size ) )
+        {
+            this->release( );
+            throw ::std::runtime_error{ "Failed to open cube data: " + path.string( ) };
+        }
+        else
+        {
+            this->size = static_cast< ::std::size_t >( size.QuadPart );
+        }
+
+        if ( this->size > 0 )
+        {
+            this->section = ::CreateFileMappingW( this->file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+            auto * const view = ( this->section != nullptr ) ? ::MapViewOfFile( this->section, FILE_MAP_READ, 0, 0, 0 ) : nullptr;
+
+            if ( view == nullptr )
+            {
+                this->release( );
+                throw ::std::runtime_error{ "Failed to map cube data: " + path.string( ) };
+            }
+
+            this->data = static_cast< ::std::byte const * >( view );
+        }
+        #else /* ^^^ Windows | POSIX vvv */
+        auto const descriptor = ::open( path.c_str( ), O_RDONLY );
+        struct stat status{ };
+
+        if ( ( descriptor < 0 ) or ( ::fstat( descriptor, &status ) != 0 ) )
+        {
+            if ( descriptor >= 0 )
+            {
+                ::close( descriptor );
+            }
+
+            throw ::std::runtime_error{ "Failed to open cube data: " + path.string( ) };
+        }
+
+        this->size = static_cast< ::std::size_t >( status.st_size );
+
+        if ( this->size > 0 )
+        {
+            auto * const view = ::mmap( nullptr, this->size, PROT_READ, MAP_SHARED, descriptor, 0 );
+
+            if ( view == MAP_FAILED )
+            {
+                ::close( descriptor );
+                throw ::std::runtime_error{ "Failed to map cube data: " + path.string( ) };
+            }
+
+            this->data = static_cast< ::std::byte const * >( view );
+        }
+
+        /* NOTE: The mapping keeps its own reference to the file. */
+        ::close( descriptor );
+        #endif /* _WIN32 */
+    }
+
+    ~Mapping(
+        )
+    {
+        this->release( );
+    }
+
+    Mapping(
+        Mapping const &
+        ) = delete;
+
+    auto operator=(
+        Mapping const &
+        ) -> Mapping & = delete;
+
+    auto release(
+        ) noexcept -> void
+    {
+        #ifdef _WIN32
+        if ( this->data != nullptr )
+        {
+            ::UnmapViewOfFile( this->data );
+        }
+
+        if ( this->section != nullptr )
+        {
+            ::CloseHandle( this->section );
+        }
+
+        if ( this->file != INVALID_HANDLE_VALUE )
+        {
+            ::CloseHandle( this->file );
+        }
+
+        this->section = nullptr;
+        this->file = INVALID_HANDLE_VALUE;
+        #else /* ^^^ Windows | POSIX vvv */
+        if ( this->data != nullptr )
+        {
+            ::munmap( const_cast< ::std::byte * >( this->data ), this->size );
+        }
+        #endif /* _WIN32 */
+
+        this->data = nullptr;
+    }
+};
+
+namespace {
+
+[[ nodiscard ]]
+auto lowered(
+    HINALEA_IN ::std::string text
+    ) -> ::std::string
+{
+    ::std::transform(
+        text.begin( ),
+        text.end( ),
+        text.begin( ),
+        [ ]( unsigned char const c ){ return static_cast< char >( ::std::tolower( c ) ); }
+        );
+    return text;
+}
+
+[[ nodiscard ]]
+auto trimmed(
+    HINALEA_IN ::std::string_view text
+    ) -> ::std::string
+{
+    auto const first = text.find_first_not_of( " \t\r\n" );
+
+    if ( first == ::std::string_view::npos )
+    {
+        return { };
+    }
+
+    auto const last = text.find_last_not_of( " \t\r\n" );
+    return ::std::string{ text.substr( first, last - first + 1 ) };
+}
+
+/* Keys are lower case, brace values keep their braces and are joined across lines. */
+[[ nodiscard ]]
+auto parseHeader(
+    HINALEA_IN ::hinalea::fs::path const & path
+    ) -> ::std::map< ::std::string, ::std::string >
+{
+    auto file = ::std::ifstream{ path };
+    auto line = ::std::string{ };
+
+    if ( ( not ::std::getline( file, line ) ) or ( ::trimmed( line ) != "ENVI" ) )
+    {
+        throw ::std::runtime_error{ "Not an ENVI header: " + path.string( ) };
+    }
+
+    auto fields = ::std::map< ::std::string, ::std::string >{ };
+
+    while ( ::std::getline( file, line ) )
+    {
+        auto const equals = line.find( '=' );
+
+        if ( equals == ::std::string::npos )
+        {
+            continue;
+        }
+
+        auto value = ::trimmed( ::std::string_view{ line }.substr( equals + 1 ) );
+
+        if ( ( not value.empty( ) ) and ( value.front( ) == '{' ) )
+        {
+            for ( auto next = ::std::string{ }; ( value.find( '}' ) == ::std::string::npos ) and ::std::getline( file, next ); )
+            {
+                value += ' ';
+                value += ::trimmed( next );
+            }
+        }
+
+        fields[ ::lowered( ::trimmed( ::std::string_view{ line }.substr( 0, equals ) ) ) ] = ::std::move( value );
+    }
+
+    return fields;
+}
+
+[[ nodiscard ]]
+auto parseInteger(
+    HINALEA_IN ::std::map< ::std::string, ::std::string > const & fields,
+    HINALEA_IN ::std::string const &                             key,
+    HINALEA_IN ::hinalea::Int                                    fallback = -1
+    ) -> ::hinalea::Int
+{
+    auto const found = fields.find( key );
+
+    if ( found == fields.end( ) )
+    {
+        return fallback;
+    }
+
+    auto value = ::hinalea::Int{ -1 };
+    auto stream = ::std::istringstream{ found->second };
+    stream.imbue( ::std::locale::classic( ) );
+    stream >> value;
+    return stream ? value : -1;
+}
+
+[[ nodiscard ]]
+auto parseList(
+    HINALEA_IN ::std::string const & value
+    ) -> ::std::vector< double >
+{
+    auto text = value;
+    ::std::replace_if( text.begin( ), text.end( ), [ ]( char const c ){ return ( c == '{' ) or ( c == '}' ) or ( c == ',' ); }, ' ' );
+
+    auto stream = ::std::istringstream{ text };
+    stream.imbue( ::std::locale::classic( ) );
+    auto values = ::std::vector< double >{ };
+
+    for ( auto number = 0.0; stream >> number; )
+    {
+        values.push_back( number );
+    }
+
+    return values;
+}
+
+/* ENVI data file next to `header`: the header name without `.hdr`, or with one of the usual data extensions. */
+[[ nodiscard ]]
+auto findData(
+    HINALEA_IN ::hinalea::fs::path const & header
+    ) -> ::hinalea::fs::path
+{
+    auto base = header;
+    base.replace_extension( );
+
+    if ( ::hinalea::fs::is_regular_file( base ) )
+    {
+        return base;
+    }
+
+    for ( auto const * const extension : { ".raw", ".img", ".dat", ".bsq", ".bil", ".bip", ".RAW", ".IMG", ".DAT" } )
+    {
+        auto candidate = base;
+        candidate += extension;
+
+        if ( ::hinalea::fs::is_regular_file( candidate ) )
+        {
+            return candidate;
+        }
+    }
+
+    throw ::std::runtime_error{ "No data file found for ENVI header: " + header.string( ) };
+}
+
+/* Header of the data file `data`: `data.hdr`, or the data name with its extension replaced by `.hdr`. */
+[[ nodiscard ]]
+auto findHeader(
+    HINALEA_IN ::hinalea::fs::path const & data
+    ) -> ::hinalea::fs::path
+{
+    auto appended = data;
+    appended += ".hdr";
+
+    if ( ::hinalea::fs::is_regular_file( appended ) )
+    {
+        return appended;
+    }
+
+    for ( auto const * const extension : { ".hdr", ".HDR" } )
+    {
+        auto replaced = data;
+        replaced.replace_extension( extension );
+
+        if ( ::hinalea::fs::is_regular_file( replaced ) )
+        {
+            return replaced;
+        }
+    }
+
+    throw ::std::runtime_error{ "No ENVI header found for: " + data.string( ) };
+}
+
+template <
+    typename T
+    >
+[[ nodiscard ]]
+auto byteSwapped(
+    HINALEA_IN T const value
+    ) noexcept -> T
+{
+    auto bytes = ::std::bit_cast< ::std::array< ::std::byte, sizeof( T ) > >( value );
+    ::std::reverse( bytes.begin( ), bytes.end( ) );
+    return ::std::bit_cast< T >( bytes );
+}
+
+template <
+    typename T,
+    bool     Swap
+    >
+auto convertSamples(
+    HINALEA_IN  ::std::byte const * const source,
+    HINALEA_IN  ::hinalea::Int      const stride,
+    HINALEA_IN  ::hinalea::Int      const count,
+    HINALEA_OUT ::hinalea::f32 *    const out
+    ) noexcept -> void
+{
+    auto const step = static_cast< ::std::size_t >( stride ) * sizeof( T );
+
+    for ( auto i = ::hinalea::Int{ 0 }; i < count; ++i )
+    {
+        auto value = T{ };
+        ::std::memcpy( &value, source + static_cast< ::std::size_t >( i ) * step, sizeof( T ) );
+
+        if constexpr ( Swap )
+        {
+            value = ::byteSwapped( value );
+        }
+
+        out[ i ] = static_cast< ::hinalea::f32 >( value );
+    }
+}
+
+template <
+    typename T
+    >
+auto convertSamples(
+    HINALEA_IN  bool                const swap,
+    HINALEA_IN  ::std::byte const * const source,
+    HINALEA_IN  ::hinalea::Int      const stride,
+    HINALEA_IN  ::hinalea::Int      const count,
+    HINALEA_OUT ::hinalea::f32 *    const out
+    ) noexcept -> void
+{
+    if ( swap )
+    {
+        ::convertSamples< T, true >( source, stride, count, out );
+    }
+    else
+    {
+        ::convertSamples< T, false >( source, stride, count, out );
+    }
+}
+
+[[ nodiscard ]]
+auto dataTypeBytes(
+    HINALEA_IN int const dataType
+    ) noexcept -> ::hinalea::Int
+{
+    switch ( dataType )
+    {
+        case 1:  return 1; /* uint8 */
+        case 2:  return 2; /* int16 */
+        case 3:  return 4; /* int32 */
+        case 4:  return 4; /* float32 */
+        case 5:  return 8; /* float64 */
+        case 12: return 2; /* uint16 */
+        case 13: return 4; /* uint32 */
+        default: return 0;
+    }
+}
+
+[[ nodiscard ]]
+auto dataTypeName(
+    HINALEA_IN int const dataType
+    ) -> char const *
+{
+    switch ( dataType )
+    {
+        case 1:  return "uint8";
+        case 2:  return "int16";
+        case 3:  return "int32";
+        case 4:  return "float32";
+        case 5:  return "float64";
+        case 12: return "uint16";
+        case 13: return "uint32";
+        default: return "unknown";
+    }
+}
+
+/* Decoded frames a compressed stream keeps, eg. the band on screen and the ones next to it. */
+inline auto constexpr cached_frames = ::std::size_t{ 4 };
+
+/* Bytes of decoded chunks a chunked cube keeps, a few bands of a large cube or every band block under a spectrum. */
+inline auto constexpr cached_chunk_bytes = ::std::size_t{ 64 } << 20;
+
+/* Indices of the `count` samples taken every `step` from `origin` that fall in `[ begin, end )`. */
+[[ nodiscard ]]
+auto sampledRange(
+    HINALEA_IN ::hinalea::Int const origin,
+    HINALEA_IN ::hinalea::Int const step,
+    HINALEA_IN ::hinalea::Int const count,
+    HINALEA_IN ::hinalea::Int const begin,
+    HINALEA_IN ::hinalea::Int const end
+    ) noexcept -> ::std::pair< ::hinalea::Int, ::hinalea::Int >
+{
+    auto const first = ( ::std::max( begin - origin, ::hinalea::Int{ 0 } ) + step - 1 ) / step;
+    auto const last = ::std::min( ( ::std::max( end - origin, ::hinalea::Int{ 0 } ) + step - 1 ) / step, count );
+    return { first, ::std::max( first, last ) };
+}
+
+} /* namespace anonymous */
+
+/* Frames of a compressed `RawRecorder` stream, decoded from the mapped `.hfc` file on demand. */
+struct EnviCube::Stream
+{
+    RawRecorder::Format format{ };
+    ::std::vector< ::std::uint64_t > offsets{ }; /* Of the frames in the `.hfc` file, and the end of the last one. */
+
+    ::std::mutex mutex{ };
+    ::std::deque< ::std::pair< ::hinalea::Int, ::std::vector< ::std::byte > > > frames{ }; /* Most recently read first. */
+    ::std::vector< ::std::byte > line{ };
+
+    [[ nodiscard ]]
+    auto rowBytes(
+        ) const noexcept -> ::hinalea::Int
+    {
+        return this->format.width * RawRecorder::bytesPerPixel( this->format.bitDepth );
+    }
+
+    /* Frame `index`, decoded unless it is one of the last read. Valid until the next call, call with `mutex` held. */
+    [[ nodiscard ]]
+    auto frame(
+        HINALEA_IN Mapping const &      encoded,
+        HINALEA_IN ::hinalea::Int const index
+        ) -> ::std::byte const *
+    {
+        if ( auto const found = ::std::find_if( this->frames.begin( ), this->frames.end( ), [ & ]( auto const & entry ){ return entry.first == index; } );
+             found != this->frames.end( ) )
+        {
+            ::std::rotate( this->frames.begin( ), found, found + 1 );
+            return this->frames.front( ).second.data( );
+        }
+
+        /* NOTE: The least recently read frame gives up its buffer, so browsing the bands does not allocate. */
+        auto samples = ::std::vector< ::std::byte >{ };
+
+        if ( this->frames.size( ) >= ::cached_frames )
+        {
+            samples = ::std::move( this->frames.back( ).second );
+            this->frames.pop_back( );
+        }
+
+        samples.resize( static_cast< ::std::size_t >( this->rowBytes( ) * this->format.height ) );
+        ::decodeFrame( this->encoded( encoded, index ), this->encodedBytes( index ), this->format.width, this->format.height, this->format.bitDepth, samples.data( ), this->rowBytes( ) );
+        this->frames.emplace_front( index, ::std::move( samples ) );
+        return this->frames.front( ).second.data( );
+    }
+
+    /* Row `y` of frame `index`; only its stripe is decoded unless the frame is kept. Valid as `frame`. */
+    [[ nodiscard ]]
+    auto row(
+        HINALEA_IN Mapping const &      encoded,
+        HINALEA_IN ::hinalea::Int const index,
+        HINALEA_IN ::hinalea::Int const y
+        ) -> ::std::byte const *
+    {
+        if ( auto const found = ::std::find_if( this->frames.begin( ), this->frames.end( ), [ & ]( auto const & entry ){ return entry.first == index; } );
+             found != this->frames.end( ) )
+        {
+            return found->second.data( ) + y * this->rowBytes( );
+        }
+
+        this->line.resize( static_cast< ::std::size_t >( this->rowBytes( ) ) );
+        ::decodeFrameRows( this->encoded( encoded, index ), this->encodedBytes( index ), this->format.width, this->format.height, this->format.bitDepth, y, 1, this->line.data( ), this->rowBytes( ) );
+        return this->line.data( );
+    }
+
+private:
+    [[ nodiscard ]]
+    auto encoded(
+        HINALEA_IN Mapping const &      mapping,
+        HINALEA_IN ::hinalea::Int const index
+        ) const noexcept -> ::std::byte const *
+    {
+        return mapping.data + this->offsets[ static_cast< ::std::size_t >( index ) ];
+    }
+
+    [[ nodiscard ]]
+    auto encodedBytes(
+        HINALEA_IN ::hinalea::Int const index
+        ) const noexcept -> ::std::size_t
+    {
+        auto const i = static_cast< ::std::size_t >( index );
+        return static_cast< ::std::size_t >( this->offsets[ i + 1 ] - this->offsets[ i ] );
+    }
+};
+
+/* Chunks of a chunked cube, read through `ChunkedCube::read` one at a time and kept until `cached_chunk_bytes` is
+ * exceeded.
+ */
+struct EnviCube::Chunked
+{
+    /* One band of a decoded chunk, `window.width * window.height` samples. */
+    struct Tile
+    {
+        ::hinalea::f32 const * samples{ nullptr };
+        CubeWindow window{ };
+    };
+
+    ChunkedCube cube{ };
+
+    ::std::mutex mutex{ };
+    ::std::deque< ::std::pair< ::hinalea::Int, ::std::vector< ::hinalea::f32 > > > chunks{ }; /* Most recently read first. */
+    ::std::size_t bytes{ 0 };
+
+    [[ nodiscard ]]
+    auto tileSize(
+        ) const noexcept -> ::hinalea::Int
+    {
+        return this->cube.options( ).tileSize;
+    }
+
+    /* Band `band` of the tile `tileX, tileY`, read unless its chunk is kept. Valid until the next call, call with `mutex`
+     * held.
+     */
+    [[ nodiscard ]]
+    auto tile(
+        HINALEA_IN ::hinalea::Int const band,
+        HINALEA_IN ::hinalea::Int const tileX,
+        HINALEA_IN ::hinalea::Int const tileY
+        ) -> Tile
+    {
+        auto const bandsPerChunk = this->cube.options( ).bandsPerChunk;
+        auto const tileSize = this->tileSize( );
+        auto const tilesAcross = ( this->cube.samples( ) + tileSize - 1 ) / tileSize;
+        auto const tilesDown = ( this->cube.lines( ) + tileSize - 1 ) / tileSize;
+
+        auto const firstBand = band / bandsPerChunk * bandsPerChunk;
+        auto const bandCount = ::std::min( bandsPerChunk, this->cube.bands( ) - firstBand );
+
+        auto tile = Tile{ };
+        tile.window.x = tileX * tileSize;
+        tile.window.y = tileY * tileSize;
+        tile.window.width = ::std::min( tileSize, this->cube.samples( ) - tile.window.x );
+        tile.window.height = ::std::min( tileSize, this->cube.lines( ) - tile.window.y );
+
+        auto const area = tile.window.width * tile.window.height;
+        auto const number = ( band / bandsPerChunk * tilesDown + tileY ) * tilesAcross + tileX;
+
+        if ( auto const found = ::std::find_if( this->chunks.begin( ), this->chunks.end( ), [ & ]( auto const & entry ){ return entry.first == number; } );
+             found != this->chunks.end( ) )
+        {
+            ::std::rotate( this->chunks.begin( ), found, found + 1 );
+            tile.samples = this->chunks.front( ).second.data( ) + ( band - firstBand ) * area;
+            return tile;
+        }
+
+        auto const chunkBytes = static_cast< ::std::size_t >( bandCount * area ) * sizeof( ::hinalea::f32 );
+
+        /* NOTE: The last evicted chunk gives up its buffer, most chunks of a cube have the same shape. */
+        auto samples = ::std::vector< ::hinalea::f32 >{ };
+
+        while ( ( not this->chunks.empty( ) ) and ( this->bytes + chunkBytes > ::cached_chunk_bytes ) )
+        {
+            samples = ::std::move( this->chunks.back( ).second );
+            this->bytes -= samples.size( ) * sizeof( ::hinalea::f32 );
+            this->chunks.pop_back( );
+        }
+
+        samples.resize( static_cast< ::std::size_t >( bandCount * area ) );
+        this->cube.read( firstBand, bandCount, tile.window, samples.data( ) );
+        this->bytes += chunkBytes;
+        this->chunks.emplace_front( number, ::std::move( samples ) );
+
+        tile.samples = this->chunks.front( ).second.data( ) + ( band - firstBand ) * area;
+        return tile;
+    }
+};
+
+EnviCube::EnviCube(
+    ) noexcept = default;
+
+EnviCube::~EnviCube(
+    ) = default;
+
+EnviCube::EnviCube(
+    EnviCube && other
+    ) noexcept = default;
+
+auto EnviCube::operator=(
+    EnviCube && other
+    ) noexcept -> EnviCube & = default;
+
+auto EnviCube::open(
+    HINALEA_IN ::hinalea::fs::path const & path
+    ) -> EnviCube
+{
+    auto const extension = ::lowered( path.extension( ).string( ) );
+
+    /* NOTE: A chunked cube has no ENVI header, only its chunk index is read here. */
+    if ( extension == ".hcc" )
+    {
+        auto cube = EnviCube{ };
+        cube.chunked = ::std::make_unique< Chunked >( );
+        cube.chunked->cube = ChunkedCube::open( path );
+        cube.path = path;
+        cube.width = cube.chunked->cube.samples( );
+        cube.height = cube.chunked->cube.lines( );
+        cube.bandCount = cube.chunked->cube.bands( );
+        cube.dataType = 4;
+        cube.sampleBytes = ::dataTypeBytes( cube.dataType );
+        cube.layout = Interleave::Bsq;
+        cube.bandWavelengths = cube.chunked->cube.wavelengths( );
+        return cube;
+    }
+
+    auto const isHeader = extension == ".hdr";
+    auto const headerPath = isHeader ? path : ::findHeader( path );
+    auto const fields = ::parseHeader( headerPath );
+
+    auto const compressed = fields.contains( "hinalea codec" );
+
+    auto cube = EnviCube{ };
+    cube.path = isHeader ? ( compressed ? ::hinalea::fs::path{ headerPath }.replace_extension( ".hfc" ) : ::findData( path ) ) : path;
+    cube.width = ::parseInteger( fields, "samples" );
+    cube.height = ::parseInteger( fields, "lines" );
+    cube.bandCount = ::parseInteger( fields, "bands" );
+    cube.dataType = static_cast< int >( ::parseInteger( fields, "data type" ) );
+    cube.sampleBytes = ::dataTypeBytes( cube.dataType );
+
+    auto const headerOffset = ::parseInteger( fields, "header offset", 0 );
+    auto const byteOrder = ::parseInteger( fields, "byte order", 0 );
+
+    if ( ( cube.width < 1 ) or ( cube.height < 1 ) or ( cube.bandCount < 1 ) or ( headerOffset < 0 ) )
+    {
+        throw ::std::runtime_error{ "ENVI header is missing the cube dimensions: " + headerPath.string( ) };
+    }
+
+    if ( cube.sampleBytes == 0 )
+    {
+        throw ::std::runtime_error{ "Unsupported ENVI data type: " + ::std::to_string( cube.dataType ) };
+    }
+
+    if ( ( byteOrder != 0 ) and ( byteOrder != 1 ) )
+    {
+        throw ::std::runtime_error{ "Unsupported ENVI byte order: " + ::std::to_string( byteOrder ) };
+    }
+
+    auto const nativeOrder = ( ::std::endian::native == ::std::endian::little ) ? 0 : 1;
+    cube.swapBytes = ( cube.sampleBytes > 1 ) and ( byteOrder != nativeOrder );
+    cube.headerOffset = static_cast< ::std::size_t >( headerOffset );
+
+    if ( auto const interleave = fields.find( "interleave" );
+         interleave == fields.end( ) )
+    {
+        cube.layout = Interleave::Bsq;
+    }
+    else if ( auto const value = ::lowered( interleave->second );
+              value == "bsq" )
+    {
+        cube.layout = Interleave::Bsq;
+    }
+    else if ( value == "bil" )
+    {
+        cube.layout = Interleave::Bil;
+    }
+    else if ( value == "bip" )
+    {
+        cube.layout = Interleave::Bip;
+    }
+    else
+    {
+        throw ::std::runtime_error{ "Unsupported ENVI interleave: " + interleave->second };
+    }
+
+    if ( auto const wavelengths = fields.find( "wavelength" );
+         wavelengths != fields.end( ) )
+    {
+        cube.bandWavelengths = ::parseList( wavelengths->second );
+
+        /* NOTE: Micrometers are converted so band expressions and chart axes are always in nanometers. */
+        if ( auto const units = fields.find( "wavelength units" );
+             ( units != fields.end( ) ) and ( ::lowered( units->second ).rfind( "micro", 0 ) == 0 ) )
+        {
+            for ( auto & wavelength : cube.bandWavelengths )
+            {
+                wavelength *= 1000;
+            }
+        }
+
+        if ( cube.bandWavelengths.size( ) != static_cast< ::std::size_t >( cube.bandCount ) )
+        {
+            cube.bandWavelengths.clear( );
+        }
+    }
+
+    auto const bytes = static_cast< ::std::size_t >( cube.width * cube.height * cube.bandCount * cube.sampleBytes );
+
+    if ( compressed )
+    {
+        /* NOTE: Only the index is read here, frames are decoded straight from the mapping when they are first read. */
+        auto const recording = RawRecording::open( headerPath );
+        auto const & format = recording.format( );
+        auto const frameBytes = static_cast< ::std::size_t >( format.width * format.height * RawRecorder::bytesPerPixel( format.bitDepth ) );
+
+        if ( ( format.width != cube.width ) or ( format.height != cube.height ) or ( frameBytes * static_cast< ::std::size_t >( recording.frames( ) ) != bytes ) )
+        {
+            throw ::std::runtime_error{ "Compressed raw stream does not match its header: " + headerPath.string( ) };
+        }
+
+        cube.headerOffset = 0;
+        cube.mapping = ::std::make_unique< Mapping >( cube.path );
+        cube.stream = ::std::make_unique< Stream >( );
+        cube.stream->format = format;
+        cube.stream->offsets = recording.frameOffsets( );
+
+        if ( cube.mapping->size < cube.stream->offsets.back( ) )
+        {
+            throw ::std::runtime_error{ "Compressed raw stream is smaller than its index describes: " + cube.path.string( ) };
+        }
+
+        return cube;
+    }
+
+    cube.mapping = ::std::make_unique< Mapping >( cube.path );
+
+    if ( cube.mapping->size < cube.headerOffset + bytes )
+    {
+        throw ::std::runtime_error{ "ENVI data file is smaller than its header describes: " + cube.path.string( ) };
+    }
+
+    return cube;
+}
+
+auto EnviCube::isOpen(
+    ) const noexcept -> bool
+{
+    return ( this->mapping != nullptr ) or ( this->chunked != nullptr );
+}
+
+auto EnviCube::samples(
+    ) const noexcept -> ::hinalea::Int
+{
+    return this->width;
+}
+
+auto EnviCube::lines(
+    ) const noexcept -> ::hinalea::Int
+{
+    return this->height;
+}
+
+auto EnviCube::bands(
+    ) const noexcept -> ::hinalea::Int
+{
+    return this->bandCount;
+}
+
+auto EnviCube::interleave(
+    ) const noexcept -> Interleave
+{
+    return this->layout;
+}
+
+auto EnviCube::wavelengths(
+    ) const noexcept -> ::std::vector< double > const &
+{
+    return this->bandWavelengths;
+}
+
+auto EnviCube::dataPath(
+    ) const noexcept -> ::hinalea::fs::path const &
+{
+    return this->path;
+}
+
+auto EnviCube::describe(
+    ) const -> ::std::string
+{
+    static char const * const names[ ]{ "bsq", "bil", "bip" };
+
+    return ::std::to_string( this->width ) + " x " + ::std::to_string( this->height ) + " x " + ::std::to_string( this->bandCount )
+        + ", " + names[ static_cast< int >( this->layout ) ] + ", " + ::dataTypeName( this->dataType );
+}
+
+auto EnviCube::plane(
+    HINALEA_IN ::hinalea::Int const band
+    ) const noexcept -> ::hinalea::f32 const *
+{
+    if ( ( this->layout != Interleave::Bsq ) or ( this->dataType != 4 ) or this->swapBytes or ( this->mapping == nullptr ) )
+    {
+        return nullptr;
+    }
+
+    auto const * const first = this->mapping->data + this->offset( band, 0, 0 );
+
+    /* NOTE: A header offset that is not a multiple of 4 leaves the planes misaligned for float access. */
+    if ( reinterpret_cast< ::std::uintptr_t >( first ) % alignof( ::hinalea::f32 ) != 0 )
+    {
+        return nullptr;
+    }
+
+    return reinterpret_cast< ::hinalea::f32 const * >( first );
+}
+
+auto EnviCube::readBand(
+    HINALEA_IN  ::hinalea::Int        const band,
+    HINALEA_IN  PreviewRegion const &       region,
+    HINALEA_OUT ::hinalea::f32 *      const out,
+    HINALEA_IN  ::hinalea::Int        const linePitch
+    ) const -> void
+{
+    HINALEA_ASSERT( ( band >= 0 ) and ( band < this->bandCount ) );
+    HINALEA_ASSERT( ( region.x >= 0 ) and ( region.x + region.width <= this->width ) );
+    HINALEA_ASSERT( ( region.y >= 0 ) and ( region.y + region.height <= this->height ) );
+
+    auto const sampleStride = ( this->layout == Interleave::Bip ) ? this->bandCount : ::hinalea::Int{ 1 };
+    auto const outputWidth = region.outputWidth( );
+    auto const outputHeight = region.outputHeight( );
+
+    if ( this->chunked )
+    {
+        auto const lock = ::std::scoped_lock{ this->chunked->mutex };
+        auto const tileSize = this->chunked->tileSize( );
+
+        /* NOTE: Tile by tile, so every chunk under the region is looked up once. */
+        for ( auto tileY = region.y / tileSize; tileY <= ( region.y + region.height - 1 ) / tileSize; ++tileY )
+        {
+            for ( auto tileX = region.x / tileSize; tileX <= ( region.x + region.width - 1 ) / tileSize; ++tileX )
+            {
+                auto const tile = this->chunked->tile( band, tileX, tileY );
+                auto const [ row0, row1 ] = ::sampledRange( region.y, region.step, outputHeight, tile.window.y, tile.window.y + tile.window.height );
+                auto const [ column0, column1 ] = ::sampledRange( region.x, region.step, outputWidth, tile.window.x, tile.window.x + tile.window.width );
+
+                for ( auto row = row0; row < row1; ++row )
+                {
+                    auto const * const line = tile.samples + ( region.y + row * region.step - tile.window.y ) * tile.window.width;
+
+                    for ( auto column = column0; column < column1; ++column )
+                    {
+                        out[ row * linePitch + column ] = line[ region.x + column * region.step - tile.window.x ];
+                    }
+                }
+            }
+        }
+
+        return;
+    }
+
+    if ( this->stream )
+    {
+        auto const lock = ::std::scoped_lock{ this->stream->mutex };
+        auto const * const frame = this->stream->frame( *this->mapping, band );
+
+        for ( auto row = ::hinalea::Int{ 0 }; row < outputHeight; ++row )
+        {
+            this->convert( frame + this->offset( 0, region.x, region.y + row * region.step ), region.step, outputWidth, out + row * linePitch );
+        }
+
+        return;
+    }
+
+    for ( auto row = ::hinalea::Int{ 0 }; row < outputHeight; ++row )
+    {
+        this->convert(
+            this->mapping->data + this->offset( band, region.x, region.y + row * region.step ),
+            sampleStride * region.step,
+            outputWidth,
+            out + row * linePitch
+            );
+    }
+}
+
+auto EnviCube::readSpectrum(
+    HINALEA_IN  ::hinalea::Int   const x,
+    HINALEA_IN  ::hinalea::Int   const y,
+    HINALEA_OUT ::hinalea::f32 * const out
+    ) const -> void
+{
+    HINALEA_ASSERT( ( x >= 0 ) and ( x < this->width ) and ( y >= 0 ) and ( y < this->height ) );
+
+    auto const bandStride = [ & ]{
+        switch ( this->layout )
+        {
+            case Interleave::Bsq: return this->width * this->height;
+            case Interleave::Bil: return this->width;
+            case Interleave::Bip: return ::hinalea::Int{ 1 };
+        }
+
+        return ::hinalea::Int{ 1 };
+    }( );
+
+    if ( this->chunked )
+    {
+        auto const lock = ::std::scoped_lock{ this->chunked->mutex };
+        auto const tileSize = this->chunked->tileSize( );
+
+        for ( auto band = ::hinalea::Int{ 0 }; band < this->bandCount; ++band )
+        {
+            auto const tile = this->chunked->tile( band, x / tileSize, y / tileSize );
+            out[ band ] = tile.samples[ ( y - tile.window.y ) * tile.window.width + ( x - tile.window.x ) ];
+        }
+
+        return;
+    }
+
+    if ( this->stream )
+    {
+        auto const lock = ::std::scoped_lock{ this->stream->mutex };
+
+        for ( auto band = ::hinalea::Int{ 0 }; band < this->bandCount; ++band )
+        {
+            this->convert( this->stream->row( *this->mapping, band, y ) + x * this->sampleBytes, 1, 1, out + band );
+        }
+
+        return;
+    }
+
+    this->convert( this->mapping->data + this->offset( 0, x, y ), bandStride, this->bandCount, out );
+}
+
+auto EnviCube::readSpans(
+    HINALEA_IN  ::hinalea::Int                     const band,
+    HINALEA_IN  ::std::vector< PixelSpan > const &       spans,
+    HINALEA_OUT ::hinalea::f32 *                   const plane
+    ) const -> void
+{
+    auto const sampleStride = ( this->layout == Interleave::Bip ) ? this->bandCount : ::hinalea::Int{ 1 };
+
+    if ( this->chunked )
+    {
+        auto const lock = ::std::scoped_lock{ this->chunked->mutex };
+        auto const tileSize = this->chunked->tileSize( );
+
+        /* NOTE: A span is split where it leaves a tile or a line. */
+        for ( auto const & span : spans )
+        {
+            for ( auto offset = span.offset; offset < span.offset + span.length; )
+            {
+                auto const y = offset / this->width;
+                auto const x = offset % this->width;
+                auto const tile = this->chunked->tile( band, x / tileSize, y / tileSize );
+                auto const count = ::std::min( span.offset + span.length - offset, tile.window.x + tile.window.width - x );
+                auto const * const source = tile.samples + ( y - tile.window.y ) * tile.window.width + ( x - tile.window.x );
+
+                ::std::copy( source, source + count, plane + offset );
+                offset += count;
+            }
+        }
+
+        return;
+    }
+
+    if ( this->stream )
+    {
+        auto const lock = ::std::scoped_lock{ this->stream->mutex };
+        auto const * const frame = this->stream->frame( *this->mapping, band );
+
+        for ( auto const & span : spans )
+        {
+            this->convert( frame + this->offset( 0, span.offset % this->width, span.offset / this->width ), 1, span.length, plane + span.offset );
+        }
+
+        return;
+    }
+
+    for ( auto const & span : spans )
+    {
+        auto const y = span.offset / this->width;
+        auto const x = span.offset % this->width;
+        this->convert( this->mapping->data + this->offset( band, x, y ), sampleStride, span.length, plane + span.offset );
+    }
+}
+
+auto EnviCube::offset(
+    HINALEA_IN ::hinalea::Int const band,
+    HINALEA_IN ::hinalea::Int const x,
+    HINALEA_IN ::hinalea::Int const y
+    ) const noexcept -> ::std::size_t
+{
+    auto const element = [ & ]{
+        switch ( this->layout )
+        {
+            case Interleave::Bsq: return ( band * this->height + y ) * this->width + x;
+            case Interleave::Bil: return ( y * this->bandCount + band ) * this->width + x;
+            case Interleave::Bip: return ( y * this->width + x ) * this->bandCount + band;
+        }
+
+        return ::hinalea::Int{ 0 };
+    }( );
+
+    return this->headerOffset + static_cast< ::std::size_t >( element * this->sampleBytes );
+}
+
+auto EnviCube::convert(
+    HINALEA_IN  ::std::byte const * const source,
+    HINALEA_IN  ::hinalea::Int      const stride,
+    HINALEA_IN  ::hinalea::Int      const count,
+    HINALEA_OUT ::hinalea::f32 *    const out
+    ) const -> void
+{
+    switch ( this->dataType )
+    {
+        case 1:  ::convertSamples< ::std::uint8_t  >( false,           source, stride, count, out ); return;
+        case 2:  ::convertSamples< ::std::int16_t  >( this->swapBytes, source, stride, count, out ); return;
+        case 3:  ::convertSamples< ::std::int32_t  >( this->swapBytes, source, stride, count, out ); return;
+        case 4:  ::convertSamples< ::hinalea::f32  >( this->swapBytes, source, stride, count, out ); return;
+        case 5:  ::convertSamples< double          >( this->swapBytes, source, stride, count, out ); return;
+        case 12: ::convertSamples< ::std::uint16_t >( this->swapBytes, source, stride, count, out ); return;
+        case 13: ::convertSamples< ::std::uint32_t >( this->swapBytes, source, stride, count, out ); return;
+    }
+
+    HINALEA_ASSERT( false );
+}
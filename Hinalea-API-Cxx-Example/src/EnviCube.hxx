@@ -0,0 +1,149 @@
+#pragma once
+
+#include "Preview.hxx"
+#include "ProbeSet.hxx"
+
+#include <Hinalea.h>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+/* Read only view of an ENVI cube, eg. a processed cube under `processed/` or a `RawRecorder` stream.
+ *
+ * Opening parses the header and memory maps the data file, nothing of the data is read. Every read touches only the
+ * samples it returns, so the pages the OS pulls in are those of the bands, lines or pixels on screen and the process
+ * never holds a copy of the cube. BSQ, BIL and BIP with 8, 16 and 32 bit integer and 32 and 64 bit float samples of
+ * either byte order are supported, and every read converts to float.
+ *
+ * A compressed `RawRecorder` stream, whose header has a `hinalea codec` key, maps its `.hfc` file and decodes a frame,
+ * one band, only when it is first read, at the offset its `.idx` gives; the last few are kept. A spectrum decodes only
+ * the stripe holding its pixel in every frame. A chunked cube, `.hcc`, reads its chunk index at `open` and then each
+ * chunk through `ChunkedCube::read` when it is first read; decoded chunks are kept up to a few tens of MB.
+ */
+class EnviCube
+{
+public:
+    enum class Interleave { Bsq, Bil, Bip };
+
+    EnviCube(
+        ) noexcept;
+
+    ~EnviCube(
+        );
+
+    EnviCube(
+        EnviCube && other
+        ) noexcept;
+
+    auto operator=(
+        EnviCube && other
+        ) noexcept -> EnviCube &;
+
+    /* `path` is the header or the data file. Throws `std::runtime_error` if the cube is not supported or truncated. */
+    [[ nodiscard ]]
+    static
+    auto open(
+        HINALEA_IN ::hinalea::fs::path const & path
+        ) -> EnviCube;
+
+    [[ nodiscard ]]
+    auto isOpen(
+        ) const noexcept -> bool;
+
+    [[ nodiscard ]]
+    auto samples(
+        ) const noexcept -> ::hinalea::Int;
+
+    [[ nodiscard ]]
+    auto lines(
+        ) const noexcept -> ::hinalea::Int;
+
+    [[ nodiscard ]]
+    auto bands(
+        ) const noexcept -> ::hinalea::Int;
+
+    [[ nodiscard ]]
+    auto interleave(
+        ) const noexcept -> Interleave;
+
+    /* Band wavelengths in nanometers, empty if the header has none. */
+    [[ nodiscard ]]
+    auto wavelengths(
+        ) const noexcept -> ::std::vector< double > const &;
+
+    [[ nodiscard ]]
+    auto dataPath(
+        ) const noexcept -> ::hinalea::fs::path const &;
+
+    /* Eg. "2048 x 2048 x 120, bsq, float32". */
+    [[ nodiscard ]]
+    auto describe(
+        ) const -> ::std::string;
+
+    /* Band `band` as one plane of `samples * lines` values straight from the mapping, or null unless the cube is BSQ
+     * 32 bit float in native byte order.
+     */
+    [[ nodiscard ]]
+    auto plane(
+        HINALEA_IN ::hinalea::Int band
+        ) const noexcept -> ::hinalea::f32 const *;
+
+    /* Samples one pixel per `region.step` square of band `band`, `region.outputWidth( )` values per output line. */
+    auto readBand(
+        HINALEA_IN  ::hinalea::Int        band,
+        HINALEA_IN  PreviewRegion const & region,
+        HINALEA_OUT ::hinalea::f32 *      out,
+        HINALEA_IN  ::hinalea::Int        linePitch
+        ) const -> void;
+
+    /* All bands of one pixel. */
+    auto readSpectrum(
+        HINALEA_IN  ::hinalea::Int   x,
+        HINALEA_IN  ::hinalea::Int   y,
+        HINALEA_OUT ::hinalea::f32 * out
+        ) const -> void;
+
+    /* Writes only the pixels of `spans` of band `band` into `plane`, at their offsets; the rest is left untouched. */
+    auto readSpans(
+        HINALEA_IN  ::hinalea::Int                      band,
+        HINALEA_IN  ::std::vector< PixelSpan > const & spans,
+        HINALEA_OUT ::hinalea::f32 *                    plane
+        ) const -> void;
+
+private:
+    struct Chunked;
+    struct Mapping;
+    struct Stream;
+
+    /* Byte offset of a sample in the mapping. */
+    [[ nodiscard ]]
+    auto offset(
+        HINALEA_IN ::hinalea::Int band,
+        HINALEA_IN ::hinalea::Int x,
+        HINALEA_IN ::hinalea::Int y
+        ) const noexcept -> ::std::size_t;
+
+    /* Converts `count` samples starting at `source`, `stride` samples apart. */
+    auto convert(
+        HINALEA_IN  ::std::byte const * source,
+        HINALEA_IN  ::hinalea::Int      stride,
+        HINALEA_IN  ::hinalea::Int      count,
+        HINALEA_OUT ::hinalea::f32 *    out
+        ) const -> void;
+
+    ::std::unique_ptr< Mapping > mapping;
+    ::std::unique_ptr< Stream > stream;   /* Compressed streams only. */
+    ::std::unique_ptr< Chunked > chunked; /* Chunked cubes only, which have no mapping. */
+    ::hinalea::fs::path path{ };
+    ::hinalea::Int width{ 0 };
+    ::hinalea::Int height{ 0 };
+    ::hinalea::Int bandCount{ 0 };
+    Interleave layout{ Interleave::Bsq };
+    int dataType{ 0 };
+    ::hinalea::Int sampleBytes{ 0 };
+    bool swapBytes{ false };
+    ::std::size_t headerOffset{ 0 };
+    ::std::vector< double > bandWavelengths{ };
+};
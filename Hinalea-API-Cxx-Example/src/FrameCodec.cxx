@@ -0,0 +1,757 @@
+#include "FrameCodec.hxx"
+
+#include "ThreadPool.hxx"
+
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+static_assert( ::std::endian::native == ::std::endian::little, "Encoded frames are written in native byte order." );
+
+namespace {
+
+auto constexpr codecVersion = ::std::uint8_t{ 1 };
+auto constexpr headerBytes = ::std::size_t{ 16 };
+auto constexpr blockSamples = ::hinalea::Int{ 32 };
+auto constexpr parameterBits = 5U;
+
+/* A quotient this long is not worth coding in unary, the residual follows raw instead. */
+auto constexpr escapeLength = 24U;
+
+/* Bits are packed from the least significant end, 32 at a time. */
+class BitWriter
+{
+public:
+    explicit
+    BitWriter(
+        HINALEA_OUT ::std::byte * const out
+        ) noexcept
+        : begin{ out }
+        , next{ out }
+    {
+    }
+
+    /* `value` must fit in `count` bits, `count` is at most 32. */
+    auto put(
+        HINALEA_IN ::std::uint64_t const value,
+        HINALEA_IN unsigned        const count
+        ) noexcept -> void
+    {
+        this->bits |= value << this->fill;
+        this->fill += count;
+
+        if ( this->fill >= 32 )
+        {
+            auto const word = static_cast< ::std::uint32_t >( this->bits );
+            ::std::memcpy( this->next, &word, sizeof( word ) );
+            this->next += sizeof( word );
+            this->bits >>= 32;
+            this->fill -= 32;
+        }
+    }
+
+    /* Flushes the last partial byte and returns the bytes written. */
+    [[ nodiscard ]]
+    auto finish(
+        ) noexcept -> ::std::size_t
+    {
+        for ( ; this->fill > 0; this->fill = ( this->fill > 8 ) ? this->fill - 8 : 0 )
+        {
+            *this->next++ = static_cast< ::std::byte >( this->bits );
+            this->bits >>= 8;
+        }
+
+        return static_cast< ::std::size_t >( this->next - this->begin );
+    }
+
+private:
+    ::std::byte * begin;
+    ::std::byte * next;
+    ::std::uint64_t bits{ 0 };
+    unsigned fill{ 0 };
+};
+
+class BitReader
+{
+public:
+    BitReader(
+        HINALEA_IN ::std::byte const * const data,
+        HINALEA_IN ::std::size_t       const size
+        ) noexcept
+        : next{ data }
+        , end{ data + size }
+    {
+    }
+
+    /* Unary quotient, or `escapeLength` for an escaped residual. */
+    [[ nodiscard ]]
+    auto quotient(
+        ) -> unsigned
+    {
+        this->refill( );
+        auto const ones = static_cast< unsigned >( ::std::countr_one( this->bits ) );
+
+        if ( ones >= escapeLength )
+        {
+            this->skip( escapeLength );
+            return escapeLength;
+        }
+
+        this->skip( ones + 1 );
+        return ones;
+    }
+
+    /* `count` is at most 32. */
+    [[ nodiscard ]]
+    auto take(
+        HINALEA_IN unsigned const count
+        ) -> ::std::uint32_t
+    {
+        this->refill( );
+        auto const value = static_cast< ::std::uint32_t >( this->bits & ( ( ::std::uint64_t{ 1 } << count ) - 1 ) );
+        this->skip( count );
+        return value;
+    }
+
+private:
+    auto refill(
+        ) noexcept -> void
+    {
+        if ( ( this->fill <= 32 ) and ( this->end - this->next >= 4 ) )
+        {
+            auto word = ::std::uint32_t{ };
+            ::std::memcpy( &word, this->next, sizeof( word ) );
+            this->bits |= static_cast< ::std::uint64_t >( word ) << this->fill;
+            this->next += sizeof( word );
+            this->fill += 32;
+            return;
+        }
+
+        for ( ; ( this->fill <= 56 ) and ( this->next < this->end ); ++this->next, this->fill += 8 )
+        {
+            this->bits |= static_cast< ::std::uint64_t >( *this->next ) << this->fill;
+        }
+    }
+
+    auto skip(
+        HINALEA_IN unsigned const count
+        ) -> void
+    {
+        if ( count > this->fill )
+        {
+            throw ::std::runtime_error{ "Encoded frame stripe is truncated." };
+        }
+
+        this->bits >>= count;
+        this->fill -= count;
+    }
+
+    ::std::byte const * next;
+    ::std::byte const * end;
+    ::std::uint64_t bits{ 0 };
+    unsigned fill{ 0 };
+};
+
+template <
+    typename T
+    >
+[[ nodiscard ]]
+constexpr
+auto zigzag(
+    HINALEA_IN T const residual
+    ) noexcept -> T
+{
+    auto const negative = static_cast< ::std::make_signed_t< T > >( residual ) < 0;
+    return static_cast< T >( ( static_cast< unsigned >( residual ) << 1 ) ^ ( negative ? ~0U : 0U ) );
+}
+
+template <
+    typename T
+    >
+[[ nodiscard ]]
+constexpr
+auto unzigzag(
+    HINALEA_IN T const value
+    ) noexcept -> T
+{
+    return static_cast< T >( ( static_cast< unsigned >( value ) >> 1 ) ^ ( 0U - ( static_cast< unsigned >( value ) & 1U ) ) );
+}
+
+template <
+    typename T
+    >
+[[ nodiscard ]]
+constexpr
+auto paeth(
+    HINALEA_IN T const left,
+    HINALEA_IN T const upper,
+    HINALEA_IN T const upperLeft
+    ) noexcept -> T
+{
+    auto const estimate = int{ left } + int{ upper } - int{ upperLeft };
+    auto const toLeft = ::std::abs( estimate - int{ left } );
+    auto const toUpper = ::std::abs( estimate - int{ upper } );
+    auto const toUpperLeft = ::std::abs( estimate - int{ upperLeft } );
+
+    if ( ( toLeft <= toUpper ) and ( toLeft <= toUpperLeft ) )
+    {
+        return left;
+    }
+
+    return ( toUpper <= toUpperLeft ) ? upper : upperLeft;
+}
+
+/* Prediction of sample `x` of `row` from its already coded neighbours, `above` is null on the first row of a stripe. */
+template <
+    typename       T,
+    FramePredictor Predictor
+    >
+auto predictRow(
+    HINALEA_IN T const *      const row,
+    HINALEA_IN T const *      const above,
+    HINALEA_IN ::hinalea::Int const x
+    ) noexcept -> T
+{
+    if ( x == 0 )
+    {
+        return ( above != nullptr ) ? above[ 0 ] : T{ 0 };
+    }
+
+    if constexpr ( Predictor == FramePredictor::Paeth )
+    {
+        if ( above != nullptr )
+        {
+            return ::paeth( row[ x - 1 ], above[ x ], above[ x - 1 ] );
+        }
+    }
+
+    return row[ x - 1 ];
+}
+
+[[ nodiscard ]]
+auto stripeCount(
+    HINALEA_IN ::hinalea::Int const height,
+    HINALEA_IN ::hinalea::Int const stripeRows
+    ) noexcept -> ::hinalea::Int
+{
+    return ( height + stripeRows - 1 ) / stripeRows;
+}
+
+/* Largest coding of one stripe: a parameter per block and an escape per sample, plus the flushed partial word. */
+[[ nodiscard ]]
+auto maxStripeBytes(
+    HINALEA_IN ::hinalea::Int const width,
+    HINALEA_IN ::hinalea::Int const rows,
+    HINALEA_IN unsigned       const sampleBits
+    ) noexcept -> ::std::size_t
+{
+    auto const blocks = static_cast< ::std::size_t >( ( width + blockSamples - 1 ) / blockSamples );
+    auto const rowBits = blocks * parameterBits + static_cast< ::std::size_t >( width ) * ( escapeLength + sampleBits );
+    return ( static_cast< ::std::size_t >( rows ) * rowBits + 7 ) / 8 + 8;
+}
+
+template <
+    typename T
+    >
+auto encodeRow(
+    HINALEA_INOUT BitWriter &          writer,
+    HINALEA_IN    T const *      const values,
+    HINALEA_IN    ::hinalea::Int const width
+    ) noexcept -> void
+{
+    auto constexpr sampleBits = static_cast< unsigned >( 8 * sizeof( T ) );
+
+    for ( auto begin = ::hinalea::Int{ 0 }; begin < width; begin += blockSamples )
+    {
+        auto const count = ::std::min( blockSamples, width - begin );
+        auto sum = ::std::uint64_t{ 0 };
+
+        for ( auto i = ::hinalea::Int{ 0 }; i < count; ++i )
+        {
+            sum += values[ begin + i ];
+        }
+
+        /* Rice parameter near log2 of the mean residual. */
+        auto k = 0U;
+
+        while ( ( k < sampleBits ) and ( ( static_cast< ::std::uint64_t >( count ) << ( k + 1 ) ) <= sum ) )
+        {
+            ++k;
+        }
+
+        writer.put( k, parameterBits );
+
+        for ( auto i = ::hinalea::Int{ 0 }; i < count; ++i )
+        {
+            auto const value = static_cast< ::std::uint32_t >( values[ begin + i ] );
+
+            if ( auto const quotient = value >> k;
+                 quotient < escapeLength )
+            {
+                writer.put( ( ::std::uint64_t{ 1 } << quotient ) - 1, quotient + 1 );
+                writer.put( value & ( ( 1U << k ) - 1 ), k );
+            }
+            else
+            {
+                writer.put( ( ::std::uint64_t{ 1 } << escapeLength ) - 1, escapeLength );
+                writer.put( value, sampleBits );
+            }
+        }
+    }
+}
+
+template <
+    typename T
+    >
+auto decodeRow(
+    HINALEA_INOUT BitReader &          reader,
+    HINALEA_OUT   T *            const values,
+    HINALEA_IN    ::hinalea::Int const width
+    ) -> void
+{
+    auto constexpr sampleBits = static_cast< unsigned >( 8 * sizeof( T ) );
+
+    for ( auto begin = ::hinalea::Int{ 0 }; begin < width; begin += blockSamples )
+    {
+        auto const count = ::std::min( blockSamples, width - begin );
+        auto const k = reader.take( parameterBits );
+
+        if ( k > sampleBits )
+        {
+            throw ::std::runtime_error{ "Encoded frame has an invalid Rice parameter." };
+        }
+
+        for ( auto i = ::hinalea::Int{ 0 }; i < count; ++i )
+        {
+            if ( auto const quotient = reader.quotient( );
+                 quotient < escapeLength )
+            {
+                values[ begin + i ] = static_cast< T >( ( quotient << k ) | reader.take( k ) );
+            }
+            else
+            {
+                values[ begin + i ] = static_cast< T >( reader.take( sampleBits ) );
+            }
+        }
+    }
+}
+
+template <
+    typename       T,
+    FramePredictor Predictor
+    >
+auto encodeStripe(
+    HINALEA_IN  FrameView const &    frame,
+    HINALEA_IN  ::hinalea::Int const first,
+    HINALEA_IN  ::hinalea::Int const rows,
+    HINALEA_OUT ::std::byte *  const out,
+    HINALEA_OUT T *            const residuals
+    ) noexcept -> ::std::size_t
+{
+    auto const * const source = static_cast< ::std::byte const * >( frame.data );
+    auto writer = ::BitWriter{ out };
+    auto const * above = static_cast< T const * >( nullptr );
+
+    for ( auto y = first; y < first + rows; ++y )
+    {
+        auto const * const row = reinterpret_cast< T const * >( source + y * frame.linePitch );
+
+        for ( auto x = ::hinalea::Int{ 0 }; x < frame.width; ++x )
+        {
+            residuals[ x ] = ::zigzag( static_cast< T >( row[ x ] - ::predictRow< T, Predictor >( row, above, x ) ) );
+        }
+
+        ::encodeRow( writer, residuals, frame.width );
+        above = row;
+    }
+
+    return writer.finish( );
+}
+
+template <
+    typename       T,
+    FramePredictor Predictor
+    >
+auto decodeStripe(
+    HINALEA_IN  ::std::byte const * const data,
+    HINALEA_IN  ::std::size_t       const size,
+    HINALEA_IN  ::hinalea::Int      const width,
+    HINALEA_IN  ::hinalea::Int      const rows,
+    HINALEA_OUT ::std::byte *       const out,
+    HINALEA_IN  ::hinalea::Int      const linePitch,
+    HINALEA_OUT T *                 const residuals
+    ) -> void
+{
+    auto reader = ::BitReader{ data, size };
+    auto const * above = static_cast< T const * >( nullptr );
+
+    for ( auto y = ::hinalea::Int{ 0 }; y < rows; ++y )
+    {
+        auto * const row = reinterpret_cast< T * >( out + y * linePitch );
+        ::decodeRow( reader, residuals, width );
+
+        for ( auto x = ::hinalea::Int{ 0 }; x < width; ++x )
+        {
+            row[ x ] = static_cast< T >( ::predictRow< T, Predictor >( row, above, x ) + ::unzigzag( residuals[ x ] ) );
+        }
+
+        above = row;
+    }
+}
+
+template <
+    typename T
+    >
+auto encodeStripes(
+    HINALEA_IN  FrameView const &                  frame,
+    HINALEA_IN  FrameCodecSettings const &         settings,
+    HINALEA_OUT ::std::byte *                const payload,
+    HINALEA_IN  ::std::size_t                const stride,
+    HINALEA_OUT ::std::vector< ::std::size_t > &   sizes
+    ) -> void
+{
+    auto const stripes = ::stripeCount( frame.height, settings.stripeRows );
+
+    ThreadPool::global( ).parallelFor(
+        static_cast< ::std::size_t >( stripes ),
+        1,
+        [ & ]( ::std::size_t const begin, ::std::size_t const end )
+        {
+            auto residuals = ::std::vector< T >( static_cast< ::std::size_t >( frame.width ) );
+
+            for ( auto stripe = begin; stripe < end; ++stripe )
+            {
+                auto const first = static_cast< ::hinalea::Int >( stripe ) * settings.stripeRows;
+                auto const rows = ::std::min( settings.stripeRows, frame.height - first );
+                auto * const out = payload + stripe * stride;
+
+                sizes[ stripe ] = ( settings.predictor == FramePredictor::Paeth )
+                    ? ::encodeStripe< T, FramePredictor::Paeth >( frame, first, rows, out, residuals.data( ) )
+                    : ::encodeStripe< T, FramePredictor::Left >( frame, first, rows, out, residuals.data( ) );
+            }
+        }
+        );
+}
+
+template <
+    typename T
+    >
+auto decodeStripes(
+    HINALEA_IN  ::std::byte const * const              payload,
+    HINALEA_IN  ::std::vector< ::std::size_t > const & offsets,
+    HINALEA_IN  FramePredictor                         predictor,
+    HINALEA_IN  ::hinalea::Int                         width,
+    HINALEA_IN  ::hinalea::Int                         height,
+    HINALEA_IN  ::hinalea::Int                         stripeRows,
+    HINALEA_OUT ::std::byte *                          out,
+    HINALEA_IN  ::hinalea::Int                         linePitch
+    ) -> void
+{
+    ThreadPool::global( ).parallelFor(
+        offsets.size( ) - 1,
+        1,
+        [ & ]( ::std::size_t const begin, ::std::size_t const end )
+        {
+            auto residuals = ::std::vector< T >( static_cast< ::std::size_t >( width ) );
+
+            for ( auto stripe = begin; stripe < end; ++stripe )
+            {
+                auto const first = static_cast< ::hinalea::Int >( stripe ) * stripeRows;
+                auto const rows = ::std::min( stripeRows, height - first );
+                auto const * const data = payload + offsets[ stripe ];
+                auto const size = offsets[ stripe + 1 ] - offsets[ stripe ];
+
+                auto * const stripeOut = out + first * linePitch;
+
+                if ( predictor == FramePredictor::Paeth )
+                {
+                    ::decodeStripe< T, FramePredictor::Paeth >( data, size, width, rows, stripeOut, linePitch, residuals.data( ) );
+                }
+                else
+                {
+                    ::decodeStripe< T, FramePredictor::Left >( data, size, width, rows, stripeOut, linePitch, residuals.data( ) );
+                }
+            }
+        }
+        );
+}
+
+template <
+    typename T
+    >
+auto store(
+    HINALEA_OUT ::std::byte * const out,
+    HINALEA_IN  T             const value
+    ) noexcept -> void
+{
+    ::std::memcpy( out, &value, sizeof( T ) );
+}
+
+template <
+    typename T
+    >
+[[ nodiscard ]]
+auto load(
+    HINALEA_IN ::std::byte const * const data
+    ) noexcept -> T
+{
+    auto value = T{ };
+    ::std::memcpy( &value, data, sizeof( T ) );
+    return value;
+}
+
+struct EncodedFrame
+{
+    FramePredictor predictor{ };
+    ::hinalea::Int stripeRows{ };
+    ::std::byte const * payload{ };
+    ::std::vector< ::std::size_t > offsets{ }; /* Of the stripes in the payload, with the end of the last appended. */
+};
+
+/* Checks the header and stripe table of an encoded frame against the recording format. */
+[[ nodiscard ]]
+auto parseFrame(
+    HINALEA_IN ::std::byte const * const data,
+    HINALEA_IN ::std::size_t       const size,
+    HINALEA_IN ::hinalea::Int      const width,
+    HINALEA_IN ::hinalea::Int      const height,
+    HINALEA_IN ::hinalea::Int      const bytesPerPixel
+    ) -> EncodedFrame
+{
+    if ( ( size < ::headerBytes ) or
+         ( ::load< ::std::uint8_t >( data + 0 ) != ::codecVersion ) or
+         ( ::load< ::std::uint8_t >( data + 1 ) > static_cast< ::std::uint8_t >( FramePredictor::Paeth ) ) or
+         ( ::load< ::std::uint8_t >( data + 2 ) != bytesPerPixel ) or
+         ( ::load< ::std::uint32_t >( data + 4 ) != static_cast< ::std::uint32_t >( width ) ) or
+         ( ::load< ::std::uint32_t >( data + 8 ) != static_cast< ::std::uint32_t >( height ) ) or
+         ( ::load< ::std::uint32_t >( data + 12 ) == 0 ) )
+    {
+        throw ::std::runtime_error{ "Encoded frame does not match the recording format." };
+    }
+
+    auto frame = EncodedFrame{ };
+    frame.predictor = static_cast< FramePredictor >( ::load< ::std::uint8_t >( data + 1 ) );
+    frame.stripeRows = static_cast< ::hinalea::Int >( ::load< ::std::uint32_t >( data + 12 ) );
+
+    auto const stripes = static_cast< ::std::size_t >( ::stripeCount( height, frame.stripeRows ) );
+    auto const table = ::headerBytes + stripes * sizeof( ::std::uint32_t );
+
+    if ( size < table )
+    {
+        throw ::std::runtime_error{ "Encoded frame is truncated." };
+    }
+
+    frame.payload = data + table;
+    frame.offsets.assign( stripes + 1, 0 );
+
+    for ( auto stripe = ::std::size_t{ 0 }; stripe < stripes; ++stripe )
+    {
+        frame.offsets[ stripe + 1 ] = frame.offsets[ stripe ] + ::load< ::std::uint32_t >( data + ::headerBytes + stripe * sizeof( ::std::uint32_t ) );
+    }
+
+    if ( frame.offsets.back( ) > size - table )
+    {
+        throw ::std::runtime_error{ "Encoded frame is truncated." };
+    }
+
+    return frame;
+}
+
+template <
+    typename T
+    >
+auto decodeRows(
+    HINALEA_IN  EncodedFrame const & frame,
+    HINALEA_IN  ::hinalea::Int       width,
+    HINALEA_IN  ::hinalea::Int       height,
+    HINALEA_IN  ::hinalea::Int       first,
+    HINALEA_IN  ::hinalea::Int       rows,
+    HINALEA_OUT ::std::byte *        out,
+    HINALEA_IN  ::hinalea::Int       linePitch
+    ) -> void
+{
+    auto residuals = ::std::vector< T >( static_cast< ::std::size_t >( width ) );
+    auto scratch = ::std::vector< ::std::byte >( );
+    auto const rowBytes = width * static_cast< ::hinalea::Int >( sizeof( T ) );
+
+    for ( auto stripe = first / frame.stripeRows; stripe * frame.stripeRows < first + rows; ++stripe )
+    {
+        auto const stripeFirst = stripe * frame.stripeRows;
+        auto const stripeRows = ::std::min( frame.stripeRows, height - stripeFirst );
+        auto const * const data = frame.payload + frame.offsets[ static_cast< ::std::size_t >( stripe ) ];
+        auto const size = frame.offsets[ static_cast< ::std::size_t >( stripe ) + 1 ] - frame.offsets[ static_cast< ::std::size_t >( stripe ) ];
+
+        /* NOTE: Stripes are predicted from their own first row on, so one at either end of the rows is decoded aside. */
+        auto const whole = ( stripeFirst >= first ) and ( stripeFirst + stripeRows <= first + rows );
+        auto * target = out + ( stripeFirst - first ) * linePitch;
+        auto pitch = linePitch;
+
+        if ( not whole )
+        {
+            scratch.resize( static_cast< ::std::size_t >( stripeRows * rowBytes ) );
+            target = scratch.data( );
+            pitch = rowBytes;
+        }
+
+        if ( frame.predictor == FramePredictor::Paeth )
+        {
+            ::decodeStripe< T, FramePredictor::Paeth >( data, size, width, stripeRows, target, pitch, residuals.data( ) );
+        }
+        else
+        {
+            ::decodeStripe< T, FramePredictor::Left >( data, size, width, stripeRows, target, pitch, residuals.data( ) );
+        }
+
+        if ( not whole )
+        {
+            auto const begin = ::std::max( first, stripeFirst );
+            auto const end = ::std::min( first + rows, stripeFirst + stripeRows );
+
+            for ( auto y = begin; y < end; ++y )
+            {
+                ::std::memcpy( out + ( y - first ) * linePitch, scratch.data( ) + ( y - stripeFirst ) * rowBytes, static_cast< ::std::size_t >( rowBytes ) );
+            }
+        }
+    }
+}
+
+} /* namespace anonymous */
+
+FrameEncoder::FrameEncoder(
+    HINALEA_IN FrameCodecSettings const & settings
+    )
+    : codecSettings{ settings }
+{
+    this->codecSettings.stripeRows = ::std::max< ::hinalea::Int >( this->codecSettings.stripeRows, 1 );
+}
+
+auto FrameEncoder::maxEncodedBytes(
+    HINALEA_IN ::hinalea::Int const width,
+    HINALEA_IN ::hinalea::Int const height,
+    HINALEA_IN ::hinalea::Int const bitDepth,
+    HINALEA_IN ::hinalea::Int const stripeRows
+    ) noexcept -> ::std::size_t
+{
+    auto const rows = ::std::max< ::hinalea::Int >( stripeRows, 1 );
+    auto const stripes = static_cast< ::std::size_t >( ::stripeCount( height, rows ) );
+    auto const sampleBits = ( bitDepth > 8 ) ? 16U : 8U;
+    return ::headerBytes + stripes * sizeof( ::std::uint32_t ) + stripes * ::maxStripeBytes( width, rows, sampleBits );
+}
+
+auto FrameEncoder::encode(
+    HINALEA_IN FrameView const & frame
+    ) -> ::std::size_t
+{
+    HINALEA_ASSERT( ( frame.width > 0 ) and ( frame.height > 0 ) );
+
+    auto const rows = this->codecSettings.stripeRows;
+    auto const stripes = static_cast< ::std::size_t >( ::stripeCount( frame.height, rows ) );
+    auto const bytesPerPixel = ( frame.bitDepth > 8 ) ? 2 : 1;
+    auto const stride = ::maxStripeBytes( frame.width, rows, static_cast< unsigned >( 8 * bytesPerPixel ) );
+    auto const table = ::headerBytes + stripes * sizeof( ::std::uint32_t );
+
+    /* NOTE: Sized for the worst case once per shape, so encoding never allocates from frame to frame. */
+    if ( auto const required = table + stripes * stride;
+         required > this->capacity )
+    {
+        this->buffer = ::std::make_unique_for_overwrite< ::std::byte[ ] >( required );
+        this->capacity = required;
+    }
+
+    this->stripeBytes.resize( stripes );
+    auto * const out = this->buffer.get( );
+
+    if ( bytesPerPixel == 2 )
+    {
+        ::encodeStripes< ::std::uint16_t >( frame, this->codecSettings, out + table, stride, this->stripeBytes );
+    }
+    else
+    {
+        ::encodeStripes< ::std::uint8_t >( frame, this->codecSettings, out + table, stride, this->stripeBytes );
+    }
+
+    ::store( out + 0, ::codecVersion );
+    ::store( out + 1, static_cast< ::std::uint8_t >( this->codecSettings.predictor ) );
+    ::store( out + 2, static_cast< ::std::uint8_t >( bytesPerPixel ) );
+    ::store( out + 3, ::std::uint8_t{ 0 } );
+    ::store( out + 4, static_cast< ::std::uint32_t >( frame.width ) );
+    ::store( out + 8, static_cast< ::std::uint32_t >( frame.height ) );
+    ::store( out + 12, static_cast< ::std::uint32_t >( rows ) );
+
+    /* Pack the stripes behind each other, every stripe only moves towards the front. */
+    auto size = table;
+
+    for ( auto stripe = ::std::size_t{ 0 }; stripe < stripes; ++stripe )
+    {
+        ::store( out + ::headerBytes + stripe * sizeof( ::std::uint32_t ), static_cast< ::std::uint32_t >( this->stripeBytes[ stripe ] ) );
+        ::std::memmove( out + size, out + table + stripe * stride, this->stripeBytes[ stripe ] );
+        size += this->stripeBytes[ stripe ];
+    }
+
+    return size;
+}
+
+auto FrameEncoder::data(
+    ) const noexcept -> ::std::byte const *
+{
+    return this->buffer.get( );
+}
+
+auto FrameEncoder::settings(
+    ) const noexcept -> FrameCodecSettings const &
+{
+    return this->codecSettings;
+}
+
+auto decodeFrame(
+    HINALEA_IN  ::std::byte const * const data,
+    HINALEA_IN  ::std::size_t       const size,
+    HINALEA_IN  ::hinalea::Int      const width,
+    HINALEA_IN  ::hinalea::Int      const height,
+    HINALEA_IN  ::hinalea::Int      const bitDepth,
+    HINALEA_OUT void *              const out,
+    HINALEA_IN  ::hinalea::Int      const linePitch
+    ) -> void
+{
+    auto const bytesPerPixel = ( bitDepth > 8 ) ? 2 : 1;
+    auto const frame = ::parseFrame( data, size, width, height, bytesPerPixel );
+
+    if ( bytesPerPixel == 2 )
+    {
+        ::decodeStripes< ::std::uint16_t >( frame.payload, frame.offsets, frame.predictor, width, height, frame.stripeRows, static_cast< ::std::byte * >( out ), linePitch );
+    }
+    else
+    {
+        ::decodeStripes< ::std::uint8_t >( frame.payload, frame.offsets, frame.predictor, width, height, frame.stripeRows, static_cast< ::std::byte * >( out ), linePitch );
+    }
+}
+
+auto decodeFrameRows(
+    HINALEA_IN  ::std::byte const * const data,
+    HINALEA_IN  ::std::size_t       const size,
+    HINALEA_IN  ::hinalea::Int      const width,
+    HINALEA_IN  ::hinalea::Int      const height,
+    HINALEA_IN  ::hinalea::Int      const bitDepth,
+    HINALEA_IN  ::hinalea::Int      const first,
+    HINALEA_IN  ::hinalea::Int      const rows,
+    HINALEA_OUT void *              const out,
+    HINALEA_IN  ::hinalea::Int      const linePitch
+    ) -> void
+{
+    HINALEA_ASSERT( ( first >= 0 ) and ( rows >= 0 ) and ( first + rows <= height ) );
+
+    auto const bytesPerPixel = ( bitDepth > 8 ) ? 2 : 1;
+    auto const frame = ::parseFrame( data, size, width, height, bytesPerPixel );
+
+    if ( bytesPerPixel == 2 )
+    {
+        ::decodeRows< ::std::uint16_t >( frame, width, height, first, rows, static_cast< ::std::byte * >( out ), linePitch );
+    }
+    else
+    {
+        ::decodeRows< ::std::uint8_t >( frame, width, height, first, rows, static_cast< ::std::byte * >( out ), linePitch );
+    }
+}
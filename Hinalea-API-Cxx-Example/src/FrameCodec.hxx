@@ -0,0 +1,101 @@
+#pragma once
+
+#include "FrameStatistics.hxx"
+
+#include <Hinalea.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+enum class FramePredictor : ::std::uint8_t
+{
+    Left,  /* Left neighbour, ie. a per row delta. */
+    Paeth, /* Left, upper or upper left neighbour, whichever is closest to left + upper - upper left, as in PNG. */
+};
+
+struct FrameCodecSettings
+{
+    FramePredictor predictor{ FramePredictor::Left };
+    ::hinalea::Int stripeRows{ 32 };
+};
+
+/* Lossless codec for 8 and 16 bit raw frames, for recordings whose rate is limited by the disk rather than the camera.
+ *
+ * A frame is split into stripes of `stripeRows` rows that are coded independently, and in parallel on
+ * `ThreadPool::global( )`. Every sample is predicted from its neighbours within the stripe, the wrapped residual is
+ * zigzag mapped and Rice coded with a parameter picked per block of 32 samples, so the coder follows the local noise
+ * level without any tables. What is left after prediction is mostly sensor noise, so the ratio depends on how many
+ * of the low bits are noise; expect little from a dark, high gain frame and most from a smooth, well exposed one.
+ *
+ * An encoded frame is: u8 version 1, u8 predictor, u8 bytes per pixel, u8 0, u32 width, height and stripe rows, a u32
+ * byte count per stripe, then the stripes. All integers are little endian.
+ */
+class FrameEncoder
+{
+public:
+    explicit
+    FrameEncoder(
+        HINALEA_IN FrameCodecSettings const & settings = FrameCodecSettings{ }
+        );
+
+    /* Encodes `frame` and returns its encoded size; the bytes are at `data( )` until the next call. Samples above 8 bits
+     * are coded as 16 bit, rows may be padded.
+     */
+    auto encode(
+        HINALEA_IN FrameView const & frame
+        ) -> ::std::size_t;
+
+    [[ nodiscard ]]
+    auto data(
+        ) const noexcept -> ::std::byte const *;
+
+    [[ nodiscard ]]
+    auto settings(
+        ) const noexcept -> FrameCodecSettings const &;
+
+    /* Largest possible encoding of a frame, ie. of pure noise. */
+    [[ nodiscard ]]
+    static
+    auto maxEncodedBytes(
+        HINALEA_IN ::hinalea::Int width,
+        HINALEA_IN ::hinalea::Int height,
+        HINALEA_IN ::hinalea::Int bitDepth,
+        HINALEA_IN ::hinalea::Int stripeRows
+        ) noexcept -> ::std::size_t;
+
+private:
+    FrameCodecSettings codecSettings{ };
+    ::std::unique_ptr< ::std::byte[ ] > buffer{ }; /* Stripes are coded at fixed offsets, then packed. */
+    ::std::size_t capacity{ 0 };
+    ::std::vector< ::std::size_t > stripeBytes{ };
+};
+
+/* Decodes a frame of `FrameEncoder` into `out`, `linePitch` bytes per row. Throws `std::runtime_error` if the frame is
+ * corrupt or of another shape.
+ */
+auto decodeFrame(
+    HINALEA_IN  ::std::byte const * data,
+    HINALEA_IN  ::std::size_t       size,
+    HINALEA_IN  ::hinalea::Int      width,
+    HINALEA_IN  ::hinalea::Int      height,
+    HINALEA_IN  ::hinalea::Int      bitDepth,
+    HINALEA_OUT void *              out,
+    HINALEA_IN  ::hinalea::Int      linePitch
+    ) -> void;
+
+/* Decodes rows `first` to `first + rows` of a frame of `FrameEncoder` into `out`, whose row 0 is row `first`. Only the
+ * stripes holding them are decoded, eg. one stripe for a single pixel. Throws like `decodeFrame`.
+ */
+auto decodeFrameRows(
+    HINALEA_IN  ::std::byte const * data,
+    HINALEA_IN  ::std::size_t       size,
+    HINALEA_IN  ::hinalea::Int      width,
+    HINALEA_IN  ::hinalea::Int      height,
+    HINALEA_IN  ::hinalea::Int      bitDepth,
+    HINALEA_IN  ::hinalea::Int      first,
+    HINALEA_IN  ::hinalea::Int      rows,
+    HINALEA_OUT void *              out,
+    HINALEA_IN  ::hinalea::Int      linePitch
+    ) -> void;
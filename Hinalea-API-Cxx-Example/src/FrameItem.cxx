@@ -0,0 +1,102 @@
+#include "FrameItem.hxx"
+
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
+FrameItem::FrameItem(
+    HINALEA_IN_OPT QGraphicsItem * const parent
+    )
+    : QGraphicsItem{ parent }
+{
+    /* Frames are always opaque and fully replaced, so there is no need to cache them in a pixmap. */
+    this->setCacheMode( QGraphicsItem::NoCache );
+    this->setFlag( QGraphicsItem::ItemUsesExtendedStyleOption );
+}
+
+auto FrameItem::setImage(
+    HINALEA_IN QImage image
+    ) -> void
+{
+    auto const rect = QRectF{ image.rect( ) };
+    this->setImage( ::std::move( image ), rect );
+}
+
+auto FrameItem::setImage(
+    HINALEA_IN QImage         image,
+    HINALEA_IN QRectF const & newTarget
+    ) -> void
+{
+    if ( newTarget != this->target )
+    {
+        this->prepareGeometryChange( );
+        this->target = newTarget;
+    }
+
+    this->frame = ::std::move( image );
+    this->update( );
+}
+
+auto FrameItem::image(
+    ) const -> QImage const &
+{
+    return this->frame;
+}
+
+auto FrameItem::mutableImage(
+    ) -> QImage &
+{
+    return this->frame;
+}
+
+auto FrameItem::imageChanged(
+    HINALEA_IN QRect const & rect
+    ) -> void
+{
+    if ( this->frame.isNull( ) )
+    {
+        return;
+    }
+
+    auto const scaleX = this->target.width( )  / this->frame.width( );
+    auto const scaleY = this->target.height( ) / this->frame.height( );
+    this->update(
+        QRectF{
+            this->target.x( ) + rect.x( ) * scaleX,
+            this->target.y( ) + rect.y( ) * scaleY,
+            rect.width( )  * scaleX,
+            rect.height( ) * scaleY,
+            }
+        );
+}
+
+auto FrameItem::boundingRect(
+    ) const -> QRectF
+{
+    return this->target;
+}
+
+auto FrameItem::paint(
+    HINALEA_IN     QPainter *                       const painter,
+    HINALEA_IN     QStyleOptionGraphicsItem const * const option,
+    HINALEA_IN_OPT QWidget *                        const widget
+    ) -> void
+{
+    HINALEA_UNUSED( widget );
+
+    if ( this->frame.isNull( ) or this->target.isEmpty( ) )
+    {
+        return;
+    }
+
+    /* Only draw the exposed part of the frame, mapped back into image pixels. */
+    auto const exposed = option->exposedRect.intersected( this->target );
+    auto const scaleX = this->frame.width( )  / this->target.width( );
+    auto const scaleY = this->frame.height( ) / this->target.height( );
+    auto const source = QRectF{
+        ( exposed.x( ) - this->target.x( ) ) * scaleX,
+        ( exposed.y( ) - this->target.y( ) ) * scaleY,
+        exposed.width( )  * scaleX,
+        exposed.height( ) * scaleY,
+        };
+    painter->drawImage( exposed, this->frame, source );
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <Hinalea.h>
+
+#include <QGraphicsItem>
+#include <QImage>
+
+/* Graphics item that paints straight from a QImage instead of converting it to a QPixmap first.
+ *
+ * The image usually wraps pooled camera memory (see `FramePool::wrapImage`), so setting a new frame is free and the
+ * only pixel work left on the GUI thread is the paint of the exposed region. The image may be a decimated or cropped
+ * preview, in which case it is stretched over the `target` rect in item coordinates.
+ */
+class FrameItem
+    : public QGraphicsItem
+{
+public:
+    explicit
+    FrameItem(
+        HINALEA_IN_OPT QGraphicsItem * parent = nullptr
+        );
+
+    /* Covers the rect of the image itself. */
+    auto setImage(
+        HINALEA_IN QImage image
+        ) -> void;
+
+    auto setImage(
+        HINALEA_IN QImage         image,
+        HINALEA_IN QRectF const & target
+        ) -> void;
+
+    [[ nodiscard ]]
+    auto image(
+        ) const -> QImage const &;
+
+    /* Lets the owner draw into the image in place; call `imageChanged` afterwards with the touched pixels. */
+    [[ nodiscard ]]
+    auto mutableImage(
+        ) -> QImage &;
+
+    /* Repaints only `rect`, in image pixels. */
+    auto imageChanged(
+        HINALEA_IN QRect const & rect
+        ) -> void;
+
+    [[ nodiscard ]]
+    virtual
+    auto boundingRect(
+        ) const -> QRectF override;
+
+    virtual
+    auto paint(
+        HINALEA_IN     QPainter *                       painter,
+        HINALEA_IN     QStyleOptionGraphicsItem const * option,
+        HINALEA_IN_OPT QWidget *                        widget
+        ) -> void override;
+
+private:
+    QImage frame{ };
+    QRectF target{ };
+};
@@ -0,0 +1,141 @@
+#include "FramePool.hxx"
+
+#include <algorithm>
+#include <memory>
+#include <new>
+
+auto FramePool::acquire(
+    HINALEA_IN Key const &       newKey,
+    HINALEA_IN Allocator const & allocate
+    ) -> ::hinalea::Camera::Image
+{
+    {
+        auto const lock = ::std::scoped_lock{ this->mutex };
+        auto * list = this->find( newKey );
+
+        if ( list == nullptr )
+        {
+            if ( this->freeLists.size( ) == maxKeys )
+            {
+                auto const oldest = ::std::min_element(
+                    this->freeLists.begin( ),
+                    this->freeLists.end( ),
+                    []( FreeList const & a, FreeList const & b ){ return a.used < b.used; }
+                    );
+                this->freeLists.erase( oldest );
+                ++this->stats.rebuilds;
+            }
+
+            list = &this->freeLists.emplace_back( );
+            list->key = newKey;
+        }
+
+        list->used = ++this->tick;
+
+        if ( not list->images.empty( ) )
+        {
+            auto image = ::std::move( list->images.back( ) );
+            list->images.pop_back( );
+            ++this->stats.hits;
+            return image;
+        }
+
+        ++this->stats.misses;
+    }
+
+    /* Allocate outside of the lock since aligned allocations of full frames are slow. */
+    auto image = allocate( );
+
+    if ( not image )
+    {
+        throw ::std::bad_alloc{ };
+    }
+
+    return image;
+}
+
+auto FramePool::release(
+    HINALEA_IN Key const &                   imageKey,
+    HINALEA_IN ::hinalea::Camera::Image && image
+    ) -> void
+{
+    if ( not image )
+    {
+        return;
+    }
+
+    auto const lock = ::std::scoped_lock{ this->mutex };
+
+    if ( auto * const list = this->find( imageKey );
+         list != nullptr )
+    {
+        list->images.push_back( ::std::move( image ) );
+    }
+}
+
+auto FramePool::wrapImage(
+    HINALEA_IN Key const &                   imageKey,
+    HINALEA_IN ::hinalea::Camera::Image && image,
+    HINALEA_IN QSize                   const size,
+    HINALEA_IN qsizetype               const bytesPerLine,
+    HINALEA_IN QImage::Format          const format
+    ) -> QImage
+{
+    struct Owner
+    {
+        FramePool *              pool;
+        Key                      key;
+        ::hinalea::Camera::Image image;
+    };
+
+    auto owner = ::std::make_unique< Owner >( Owner{ this, imageKey, ::std::move( image ) } );
+    auto * const data = reinterpret_cast< uchar * >( owner->image.get( ) );
+
+    auto const cleanup =
+        [ ]( void * const info )
+        {
+            auto const released = ::std::unique_ptr< Owner >{ static_cast< Owner * >( info ) };
+            released->pool->release( released->key, ::std::move( released->image ) );
+        };
+
+    auto wrapped = QImage{
+        data,
+        size.width( ),
+        size.height( ),
+        bytesPerLine,
+        format,
+        cleanup,
+        owner.get( )
+        };
+
+    /* QImage now owns the buffer and will call the cleanup function. */
+    static_cast< void >( owner.release( ) );
+    return wrapped;
+}
+
+auto FramePool::clear(
+    ) -> void
+{
+    auto const lock = ::std::scoped_lock{ this->mutex };
+    this->freeLists.clear( );
+}
+
+auto FramePool::statistics(
+    ) const -> Statistics
+{
+    auto const lock = ::std::scoped_lock{ this->mutex };
+    return this->stats;
+}
+
+auto FramePool::find(
+    HINALEA_IN Key const & key
+    ) -> FreeList *
+{
+    auto const list = ::std::find_if(
+        this->freeLists.begin( ),
+        this->freeLists.end( ),
+        [ & ]( FreeList const & candidate ){ return candidate.key == key; }
+        );
+
+    return ( list == this->freeLists.end( ) ) ? nullptr : &*list;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <Hinalea.h>
+
+#include <QImage>
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+/* Recycles aligned camera frame buffers so the display path does not allocate and free megabytes at frame rate.
+ *
+ * Buffers are keyed by their geometry and pixel format, and every key has a free list of its own, so the raw frames of
+ * the display thread and the display frames of the GUI thread are recycled side by side. Once more than `maxKeys` keys
+ * are in use, eg. after binning, bit depth or ROI changed, the free list used longest ago is dropped. Free lists are
+ * filled lazily from the allocator passed to `acquire`.
+ */
+class FramePool
+{
+public:
+    struct Key
+    {
+        ::hinalea::Int width{ };
+        ::hinalea::Int height{ };
+        ::hinalea::Int channels{ };
+        ::hinalea::Int bitDepth{ };
+        ::hinalea::Int linePitch{ }; /* Keeps padded and packed buffers of the same format apart. */
+
+        [[ nodiscard ]]
+        friend auto operator==(
+            Key const &,
+            Key const &
+            ) -> bool = default;
+    };
+
+    struct Statistics
+    {
+        ::std::uint64_t hits{ };
+        ::std::uint64_t misses{ };
+        ::std::uint64_t rebuilds{ }; /* Free lists dropped for a newer key. */
+    };
+
+    /* Raw and display frames of one format, and room for the next format while the old frames drain. */
+    static auto constexpr maxKeys = ::std::size_t{ 4 };
+
+    using Allocator = ::std::function< ::hinalea::Camera::Image ( ) >;
+
+    /* Returns a recycled buffer matching `key`, or a new one from `allocate` if the pool is empty. */
+    [[ nodiscard ]]
+    auto acquire(
+        HINALEA_IN Key const &       key,
+        HINALEA_IN Allocator const & allocate
+        ) -> ::hinalea::Camera::Image;
+
+    /* Hands a buffer previously obtained with `key` back to the pool. Stale buffers are dropped. */
+    auto release(
+        HINALEA_IN Key const &                   key,
+        HINALEA_IN ::hinalea::Camera::Image && image
+        ) -> void;
+
+    /* Wraps `image` in a QImage without copying. The buffer is handed back to the pool once the last QImage
+     * referencing it is destroyed, so the pool must outlive every wrapped image.
+     */
+    [[ nodiscard ]]
+    auto wrapImage(
+        HINALEA_IN Key const &                   imageKey,
+        HINALEA_IN ::hinalea::Camera::Image && image,
+        HINALEA_IN QSize                         size,
+        HINALEA_IN qsizetype                     bytesPerLine,
+        HINALEA_IN QImage::Format                format
+        ) -> QImage;
+
+    auto clear(
+        ) -> void;
+
+    [[ nodiscard ]]
+    auto statistics(
+        ) const -> Statistics;
+
+private:
+    struct FreeList
+    {
+        Key key{ };
+        ::std::vector< ::hinalea::Camera::Image > images{ };
+        ::std::uint64_t used{ }; /* Tick of the last `acquire`. */
+    };
+
+    /* Free list of `key`, or nullptr. */
+    [[ nodiscard ]]
+    auto find(
+        HINALEA_IN Key const & key
+        ) -> FreeList *;
+
+    mutable ::std::mutex mutex{ };
+    ::std::vector< FreeList > freeLists{ };
+    ::std::uint64_t tick{ 0 };
+    Statistics stats{ };
+};
@@ -0,0 +1,318 @@
+#include "FrameStatistics.hxx"
+
+#include "Simd.hxx"
+#include "ThreadPool.hxx"
+
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+namespace {
+
+struct RowStatistics
+{
+    ::std::uint32_t min;
+    ::std::uint32_t max;
+    ::std::uint64_t saturation;
+};
+
+template <
+    typename T
+    >
+auto rowStatisticsScalar(
+    HINALEA_IN    T const * const       row,
+    HINALEA_IN    ::hinalea::Int const  begin,
+    HINALEA_IN    ::hinalea::Int const  width,
+    HINALEA_IN    ::std::uint32_t const threshold,
+    HINALEA_INOUT RowStatistics &       stats
+    ) -> void
+{
+    for ( auto x = begin; x < width; ++x )
+    {
+        auto const value = static_cast< ::std::uint32_t >( row[ x ] );
+        stats.min = ::std::min( stats.min, value );
+        stats.max = ::std::max( stats.max, value );
+        stats.saturation += ( value >= threshold ) ? 1 : 0;
+    }
+}
+
+template <
+    typename T
+    >
+SIMD_TARGET_SSE41
+auto rowStatisticsSse41(
+    HINALEA_IN    T const * const       row,
+    HINALEA_IN    ::hinalea::Int const  width,
+    HINALEA_IN    ::std::uint32_t const threshold,
+    HINALEA_INOUT RowStatistics &       stats
+    ) -> void
+{
+    auto constexpr lanes = static_cast< ::hinalea::Int >( sizeof( __m128i ) / sizeof( T ) );
+    auto const saturating = threshold <= ::std::numeric_limits< T >::max( );
+
+    auto vmin = _mm_set1_epi8( -1 );
+    auto vmax = _mm_setzero_si128( );
+    auto const vthreshold = ( sizeof( T ) == 1 )
+        ? _mm_set1_epi8( static_cast< char >( ::std::min< ::std::uint32_t >( threshold, 0xFF ) ) )
+        : _mm_set1_epi16( static_cast< short >( ::std::min< ::std::uint32_t >( threshold, 0xFFFF ) ) )
+        ;
+    auto saturation = ::std::uint64_t{ 0 };
+    auto x = ::hinalea::Int{ 0 };
+
+    for ( ; x + lanes <= width; x += lanes )
+    {
+        auto const v = _mm_loadu_si128( reinterpret_cast< __m128i const * >( row + x ) );
+        __m128i ge;
+
+        if constexpr ( sizeof( T ) == 1 )
+        {
+            vmin = _mm_min_epu8( vmin, v );
+            vmax = _mm_max_epu8( vmax, v );
+            ge = _mm_cmpeq_epi8( _mm_max_epu8( v, vthreshold ), v );
+        }
+        else
+        {
+            vmin = _mm_min_epu16( vmin, v );
+            vmax = _mm_max_epu16( vmax, v );
+            ge = _mm_cmpeq_epi16( _mm_max_epu16( v, vthreshold ), v );
+        }
+
+        saturation += static_cast< ::std::uint64_t >( ::std::popcount( static_cast< unsigned >( _mm_movemask_epi8( ge ) ) ) );
+    }
+
+    alignas( 16 ) T mins[ lanes ];
+    alignas( 16 ) T maxs[ lanes ];
+    _mm_store_si128( reinterpret_cast< __m128i * >( mins ), vmin );
+    _mm_store_si128( reinterpret_cast< __m128i * >( maxs ), vmax );
+
+    if ( x > 0 )
+    {
+        stats.min = ::std::min( stats.min, static_cast< ::std::uint32_t >( *::std::min_element( mins, mins + lanes ) ) );
+        stats.max = ::std::max( stats.max, static_cast< ::std::uint32_t >( *::std::max_element( maxs, maxs + lanes ) ) );
+    }
+
+    if ( saturating )
+    {
+        stats.saturation += saturation / sizeof( T );
+    }
+
+    rowStatisticsScalar( row, x, width, threshold, stats );
+}
+
+template <
+    typename T
+    >
+SIMD_TARGET_AVX2
+auto rowStatisticsAvx2(
+    HINALEA_IN    T const * const       row,
+    HINALEA_IN    ::hinalea::Int const  width,
+    HINALEA_IN    ::std::uint32_t const threshold,
+    HINALEA_INOUT RowStatistics &       stats
+    ) -> void
+{
+    auto constexpr lanes = static_cast< ::hinalea::Int >( sizeof( __m256i ) / sizeof( T ) );
+    auto const saturating = threshold <= ::std::numeric_limits< T >::max( );
+
+    auto vmin = _mm256_set1_epi8( -1 );
+    auto vmax = _mm256_setzero_si256( );
+    auto const vthreshold = ( sizeof( T ) == 1 )
+        ? _mm256_set1_epi8( static_cast< char >( ::std::min< ::std::uint32_t >( threshold, 0xFF ) ) )
+        : _mm256_set1_epi16( static_cast< short >( ::std::min< ::std::uint32_t >( threshold, 0xFFFF ) ) )
+        ;
+    auto saturation = ::std::uint64_t{ 0 };
+    auto x = ::hinalea::Int{ 0 };
+
+    for ( ; x + lanes <= width; x += lanes )
+    {
+        auto const v = _mm256_loadu_si256( reinterpret_cast< __m256i const * >( row + x ) );
+        __m256i ge;
+
+        if constexpr ( sizeof( T ) == 1 )
+        {
+            vmin = _mm256_min_epu8( vmin, v );
+            vmax = _mm256_max_epu8( vmax, v );
+            ge = _mm256_cmpeq_epi8( _mm256_max_epu8( v, vthreshold ), v );
+        }
+        else
+        {
+            vmin = _mm256_min_epu16( vmin, v );
+            vmax = _mm256_max_epu16( vmax, v );
+            ge = _mm256_cmpeq_epi16( _mm256_max_epu16( v, vthreshold ), v );
+        }
+
+        saturation += static_cast< ::std::uint64_t >( ::std::popcount( static_cast< unsigned >( _mm256_movemask_epi8( ge ) ) ) );
+    }
+
+    alignas( 32 ) T mins[ lanes ];
+    alignas( 32 ) T maxs[ lanes ];
+    _mm256_store_si256( reinterpret_cast< __m256i * >( mins ), vmin );
+    _mm256_store_si256( reinterpret_cast< __m256i * >( maxs ), vmax );
+
+    if ( x > 0 )
+    {
+        stats.min = ::std::min( stats.min, static_cast< ::std::uint32_t >( *::std::min_element( mins, mins + lanes ) ) );
+        stats.max = ::std::max( stats.max, static_cast< ::std::uint32_t >( *::std::max_element( maxs, maxs + lanes ) ) );
+    }
+
+    if ( saturating )
+    {
+        stats.saturation += saturation / sizeof( T );
+    }
+
+    rowStatisticsScalar( row, x, width, threshold, stats );
+}
+
+template <
+    typename T
+    >
+auto rowStatistics(
+    HINALEA_IN    simd::Level const     level,
+    HINALEA_IN    T const * const       row,
+    HINALEA_IN    ::hinalea::Int const  width,
+    HINALEA_IN    ::std::uint32_t const threshold,
+    HINALEA_INOUT RowStatistics &       stats
+    ) -> void
+{
+    switch ( level )
+    {
+        case simd::Level::Avx2:   { ::rowStatisticsAvx2 ( row, width, threshold, stats ); break; }
+        case simd::Level::Sse41:  { ::rowStatisticsSse41( row, width, threshold, stats ); break; }
+        case simd::Level::Scalar: { ::rowStatisticsScalar( row, 0, width, threshold, stats ); break; }
+    }
+}
+
+template <
+    typename T
+    >
+auto histogramRow(
+    HINALEA_IN    T const * const       row,
+    HINALEA_IN    ::hinalea::Int const  width,
+    HINALEA_IN    ::std::uint32_t const lastBin,
+    HINALEA_INOUT ::std::uint32_t *     histogram
+    ) -> void
+{
+    for ( auto x = ::hinalea::Int{ 0 }; x < width; ++x )
+    {
+        ++histogram[ ::std::min( static_cast< ::std::uint32_t >( row[ x ] ), lastBin ) ];
+    }
+}
+
+} /* namespace anonymous */
+
+auto FrameStatisticsKernel::compute(
+    HINALEA_IN FrameView      const & frame,
+    HINALEA_IN ::hinalea::Int const   threshold,
+    HINALEA_IN ::hinalea::Int const   ignoreCount
+    ) -> FrameStatistics const &
+{
+    if ( ( frame.bitDepth < 1 ) or ( frame.bitDepth > 16 ) )
+    {
+        throw ::std::invalid_argument{ "Frame statistics only support 1 to 16 bit frames." };
+    }
+
+    auto const bins = ::std::size_t{ 1 } << frame.bitDepth;
+    auto const lastBin = static_cast< ::std::uint32_t >( bins - 1 );
+    auto const level = simd::level( );
+    auto const height = static_cast< ::std::size_t >( frame.height );
+    auto const bandCount = ::std::max< ::std::size_t >( ::std::min( ThreadPool::global( ).concurrency( ), height ), 1 );
+    auto const rowsPerBand = ::std::max< ::std::size_t >( ( height + bandCount - 1 ) / bandCount, 1 );
+    auto const clampedThreshold = static_cast< ::std::uint32_t >( ::std::max< ::hinalea::Int >( threshold, 0 ) );
+
+    this->bands.resize( ( height + rowsPerBand - 1 ) / rowsPerBand );
+
+    auto const run =
+        [ & ]( auto const sample )
+        {
+            using T = HINALEA_TYPEOF( sample );
+            auto const * const bytes = static_cast< ::std::byte const * >( frame.data );
+
+            ThreadPool::global( ).parallelFor(
+                height,
+                rowsPerBand,
+                [ & ]( ::std::size_t const begin, ::std::size_t const end )
+                {
+                    auto & band = this->bands[ begin / rowsPerBand ];
+                    band.histogram.assign( bins, 0 );
+
+                    auto stats = RowStatistics{ ::std::numeric_limits< ::std::uint32_t >::max( ), 0, 0 };
+
+                    for ( auto y = begin; y < end; ++y )
+                    {
+                        auto const * const row = reinterpret_cast< T const * >( bytes + y * frame.linePitch );
+                        ::rowStatistics( level, row, frame.width, clampedThreshold, stats );
+                        ::histogramRow( row, frame.width, lastBin, band.histogram.data( ) );
+                    }
+
+                    band.min = stats.min;
+                    band.max = stats.max;
+                    band.saturation = stats.saturation;
+                }
+                );
+        };
+
+    if ( frame.bitDepth <= 8 )
+    {
+        run( ::std::uint8_t{ } );
+    }
+    else
+    {
+        run( ::std::uint16_t{ } );
+    }
+
+    auto & result = this->statistics;
+    result.bitDepth = frame.bitDepth;
+    result.histogram.assign( bins, 0 );
+
+    auto min = ::std::numeric_limits< ::std::uint32_t >::max( );
+    auto max = ::std::uint32_t{ 0 };
+    auto saturation = ::std::uint64_t{ 0 };
+
+    for ( auto const & band : this->bands )
+    {
+        min = ::std::min( min, band.min );
+        max = ::std::max( max, band.max );
+        saturation += band.saturation;
+        ::std::transform(
+            band.histogram.begin( ), band.histogram.end( ),
+            result.histogram.begin( ),
+            result.histogram.begin( ),
+            ::std::plus< >{ }
+            );
+    }
+
+    if ( ignoreCount > 0 )
+    {
+        /* Skip the brightest `ignoreCount` pixels when reporting the maximum. */
+        auto remaining = static_cast< ::std::uint64_t >( ignoreCount );
+        auto bin = static_cast< ::std::int64_t >( ::std::min( max, lastBin ) );
+
+        for ( ; bin > 0; --bin )
+        {
+            auto const count = static_cast< ::std::uint64_t >( result.histogram[ bin ] );
+
+            if ( count > remaining )
+            {
+                break;
+            }
+
+            remaining -= count;
+        }
+
+        max = static_cast< ::std::uint32_t >( bin );
+        saturation -= ::std::min( saturation, static_cast< ::std::uint64_t >( ignoreCount ) );
+    }
+
+    result.min = ( frame.width * frame.height > 0 ) ? min : 0;
+    result.max = max;
+    result.saturation = static_cast< ::hinalea::Int >( saturation );
+    return result;
+}
+
+auto FrameStatisticsKernel::result(
+    ) const noexcept -> FrameStatistics const &
+{
+    return this->statistics;
+}
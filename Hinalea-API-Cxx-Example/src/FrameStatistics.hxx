@@ -0,0 +1,60 @@
+#pragma once
+
+#include <Hinalea.h>
+
+#include <cstdint>
+#include <vector>
+
+/* Non-owning view over a raw monochrome or color filter array frame. Samples above 8 bits are stored in 16 bits. */
+struct FrameView
+{
+    void const *   data{ nullptr };
+    ::hinalea::Int width{ };
+    ::hinalea::Int height{ };
+    ::hinalea::Int linePitch{ }; /* Bytes between the starts of two consecutive rows. */
+    ::hinalea::Int bitDepth{ };
+};
+
+struct FrameStatistics
+{
+    ::hinalea::Int min{ };
+    ::hinalea::Int max{ };
+    ::hinalea::Int saturation{ };
+    ::hinalea::Int bitDepth{ };
+
+    /* One bin per representable intensity, ie. `1 << bitDepth` bins. */
+    ::std::vector< ::std::uint32_t > histogram{ };
+};
+
+/* Computes min, max, saturated pixel count and a full resolution histogram of a raw frame in a single pass.
+ *
+ * Rows are split into bands processed in parallel on `ThreadPool::global( )`. Each row runs an AVX2 or SSE4.1
+ * min/max/saturation kernel (picked at runtime, with a scalar fallback) and is histogrammed while still in L1 cache.
+ * The `ignoreCount` brightest pixels (eg. hot pixels) are excluded from the reported maximum and saturation count.
+ * Scratch buffers are kept between calls, so a kernel should be reused from frame to frame by a single thread.
+ */
+class FrameStatisticsKernel
+{
+public:
+    auto compute(
+        HINALEA_IN FrameView const & frame,
+        HINALEA_IN ::hinalea::Int    threshold,
+        HINALEA_IN ::hinalea::Int    ignoreCount
+        ) -> FrameStatistics const &;
+
+    [[ nodiscard ]]
+    auto result(
+        ) const noexcept -> FrameStatistics const &;
+
+private:
+    struct Band
+    {
+        ::std::uint32_t min{ };
+        ::std::uint32_t max{ };
+        ::std::uint64_t saturation{ };
+        ::std::vector< ::std::uint32_t > histogram{ };
+    };
+
+    ::std::vector< Band > bands{ };
+    FrameStatistics statistics{ };
+};
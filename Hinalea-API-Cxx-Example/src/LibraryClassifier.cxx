@@ -0,0 +1,362 @@
+#include "LibraryClassifier.hxx"
+
+#include "ThreadPool.hxx"
+
+#include <mkl.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+struct TileScratch
+{
+    ::std::vector< SpectralPixel > pixels{ };
+    ::std::vector< ::std::uint8_t > valid{ };
+    ::std::vector< ::hinalea::f32 > inputs{ };  /* `terms x bands x tileSize`, only for measures with transformed terms. */
+    ::std::vector< ::hinalea::f32 > outputs{ }; /* `terms x blockSize x tileSize` */
+    ::std::vector< ::hinalea::f32 > best{ };
+    ::std::vector< ::hinalea::Int > index{ };
+};
+
+/* MKL threads every call by default, which would oversubscribe the pool; each tile is one single threaded GEMM. */
+class SequentialMkl
+{
+public:
+    SequentialMkl(
+        )
+        : previous{ ::mkl_set_num_threads_local( 1 ) }
+    {
+    }
+
+    ~SequentialMkl(
+        )
+    {
+        ::mkl_set_num_threads_local( this->previous );
+    }
+
+    SequentialMkl(
+        SequentialMkl const &
+        ) = delete;
+
+    auto operator=(
+        SequentialMkl const &
+        ) -> SequentialMkl & = delete;
+
+private:
+    int previous;
+};
+
+[[ nodiscard ]]
+auto quantizeConfidence(
+    HINALEA_IN ::hinalea::f32 const distance,
+    HINALEA_IN ::hinalea::f32 const threshold
+    ) noexcept -> ::std::uint8_t
+{
+    auto constexpr levels = LibraryClassifier::confidenceLevels - 1;
+    auto const closeness = ( threshold > 0 ) ? ::std::clamp( 1 - distance / threshold, 0.0f, 1.0f ) : 1.0f;
+    auto const level = static_cast< int >( closeness * levels + 0.5f );
+    return static_cast< ::std::uint8_t >( level * 255 / levels );
+}
+
+template <
+    SpectralMeasure Measure
+    >
+auto fitEndmembers(
+    HINALEA_IN  ::hinalea::f32 const *               const endmembers,
+    HINALEA_IN  ::hinalea::Int                       const observations,
+    HINALEA_IN  ::hinalea::Int                       const bands,
+    HINALEA_OUT ::std::vector< ::hinalea::f32 > &          weights,
+    HINALEA_OUT ::std::vector< SpectralEndmember > &       constants
+    ) -> void
+{
+    using T = SpectralTraits< Measure >;
+
+    auto const matrix = static_cast< ::std::size_t >( observations * bands );
+    weights.resize( T::terms * matrix );
+    constants.resize( static_cast< ::std::size_t >( observations ) );
+
+    for ( auto e = ::hinalea::Int{ 0 }; e < observations; ++e )
+    {
+        auto const * const y = endmembers + e * bands;
+        constants[ static_cast< ::std::size_t >( e ) ] = T::endmember( y, bands );
+
+        for ( auto k = ::std::size_t{ 0 }; k < T::terms; ++k )
+        {
+            auto * const row = weights.data( ) + k * matrix + static_cast< ::std::size_t >( e * bands );
+
+            for ( auto b = ::hinalea::Int{ 0 }; b < bands; ++b )
+            {
+                row[ b ] = T::weightTerm( k, y[ b ] );
+            }
+        }
+    }
+}
+
+template <
+    SpectralMeasure Measure
+    >
+auto classifyTiles(
+    HINALEA_IN  ::hinalea::f32 const *    const cube,
+    HINALEA_IN  ::hinalea::Int            const area,
+    HINALEA_IN  ::hinalea::Int            const bands,
+    HINALEA_IN  ::hinalea::f32 const *    const weights,
+    HINALEA_IN  SpectralEndmember const * const endmembers,
+    HINALEA_IN  ::std::uint8_t const *    const endmemberLabels,
+    HINALEA_IN  ::hinalea::Int            const observations,
+    HINALEA_IN  ::hinalea::f32            const threshold,
+    HINALEA_OUT ::std::uint8_t *          const labels,
+    HINALEA_OUT ::std::uint8_t *          const confidences
+    ) -> void
+{
+    using T = SpectralTraits< Measure >;
+
+    auto constexpr tileSize = LibraryClassifier::tileSize;
+    auto constexpr blockSize = LibraryClassifier::blockSize;
+    auto constexpr terms = static_cast< ::hinalea::Int >( T::terms );
+    auto const matrix = observations * bands;
+    auto const tiles = static_cast< ::std::size_t >( ( area + tileSize - 1 ) / tileSize );
+
+    ThreadPool::global( ).parallelFor(
+        tiles,
+        1,
+        [ & ]( ::std::size_t const beginTile, ::std::size_t const endTile )
+        {
+            auto const sequential = ::SequentialMkl{ };
+
+            thread_local auto scratch = ::TileScratch{ };
+            scratch.pixels.resize( static_cast< ::std::size_t >( tileSize ) );
+            scratch.valid.resize( static_cast< ::std::size_t >( tileSize ) );
+            scratch.outputs.resize( static_cast< ::std::size_t >( terms * blockSize * tileSize ) );
+            scratch.best.resize( static_cast< ::std::size_t >( tileSize ) );
+            scratch.index.resize( static_cast< ::std::size_t >( tileSize ) );
+
+            if constexpr ( not T::identityTerms )
+            {
+                scratch.inputs.resize( static_cast< ::std::size_t >( terms * bands * tileSize ) );
+            }
+
+            for ( auto tile = beginTile; tile < endTile; ++tile )
+            {
+                auto const begin = static_cast< ::hinalea::Int >( tile ) * tileSize;
+                auto const count = ::std::min( tileSize, area - begin );
+
+                ::std::fill( scratch.pixels.begin( ), scratch.pixels.end( ), SpectralPixel{ } );
+
+                for ( auto b = ::hinalea::Int{ 0 }; b < bands; ++b )
+                {
+                    auto const * const plane = cube + b * area + begin;
+
+                    for ( auto p = ::hinalea::Int{ 0 }; p < count; ++p )
+                    {
+                        T::accumulate( scratch.pixels[ static_cast< ::std::size_t >( p ) ], plane[ p ] );
+                    }
+
+                    if constexpr ( not T::identityTerms )
+                    {
+                        for ( auto k = ::hinalea::Int{ 0 }; k < terms; ++k )
+                        {
+                            auto * const row = scratch.inputs.data( ) + ( k * bands + b ) * count;
+
+                            for ( auto p = ::hinalea::Int{ 0 }; p < count; ++p )
+                            {
+                                row[ p ] = T::pixelTerm( static_cast< ::std::size_t >( k ), plane[ p ] );
+                            }
+                        }
+                    }
+                }
+
+                for ( auto p = ::hinalea::Int{ 0 }; p < count; ++p )
+                {
+                    auto const i = static_cast< ::std::size_t >( p );
+                    scratch.valid[ i ] = T::prepare( scratch.pixels[ i ], bands );
+                    scratch.best[ i ] = -::std::numeric_limits< ::hinalea::f32 >::infinity( );
+                    scratch.index[ i ] = 0;
+                }
+
+                for ( auto first = ::hinalea::Int{ 0 }; first < observations; first += blockSize )
+                {
+                    auto const block = ::std::min( blockSize, observations - first );
+
+                    /* outputs[ k ] ( block x count ) = weights[ k ] ( block x bands ) * inputs[ k ] ( bands x count ) */
+                    for ( auto k = ::hinalea::Int{ 0 }; k < terms; ++k )
+                    {
+                        auto const * const input = T::identityTerms ? cube + begin : scratch.inputs.data( ) + k * bands * count;
+                        auto const inputPitch = T::identityTerms ? area : count;
+
+                        ::cblas_sgemm(
+                            CblasRowMajor,
+                            CblasNoTrans,
+                            CblasNoTrans,
+                            static_cast< MKL_INT >( block ),
+                            static_cast< MKL_INT >( count ),
+                            static_cast< MKL_INT >( bands ),
+                            1.0f,
+                            weights + k * matrix + first * bands,
+                            static_cast< MKL_INT >( bands ),
+                            input,
+                            static_cast< MKL_INT >( inputPitch ),
+                            0.0f,
+                            scratch.outputs.data( ) + k * blockSize * tileSize,
+                            static_cast< MKL_INT >( count )
+                            );
+                    }
+
+                    for ( auto e = ::hinalea::Int{ 0 }; e < block; ++e )
+                    {
+                        auto const & em = endmembers[ first + e ];
+
+                        for ( auto p = ::hinalea::Int{ 0 }; p < count; ++p )
+                        {
+                            auto const i = static_cast< ::std::size_t >( p );
+                            ::hinalea::f32 dots[ T::terms ];
+
+                            for ( auto k = ::hinalea::Int{ 0 }; k < terms; ++k )
+                            {
+                                dots[ k ] = scratch.outputs[ static_cast< ::std::size_t >( k * blockSize * tileSize + e * count + p ) ];
+                            }
+
+                            if ( auto const score = T::score( scratch.pixels[ i ], em, dots );
+                                 score > scratch.best[ i ] )
+                            {
+                                scratch.best[ i ] = score;
+                                scratch.index[ i ] = first + e;
+                            }
+                        }
+                    }
+                }
+
+                for ( auto p = ::hinalea::Int{ 0 }; p < count; ++p )
+                {
+                    auto const i = static_cast< ::std::size_t >( p );
+                    auto label = ::std::uint8_t{ 0 };
+                    auto confidence = ::std::uint8_t{ 0 };
+
+                    if ( scratch.valid[ i ] )
+                    {
+                        if ( auto const distance = T::distance( scratch.best[ i ] );
+                             distance <= threshold )
+                        {
+                            label = endmemberLabels[ scratch.index[ i ] ];
+                            confidence = ::quantizeConfidence( distance, threshold );
+                        }
+                    }
+
+                    labels[ begin + p ] = label;
+                    confidences[ begin + p ] = confidence;
+                }
+            }
+        }
+        );
+}
+
+} /* namespace anonymous */
+
+auto LibraryClassifier::fit(
+    HINALEA_IN     SpectralMeasure        const newMeasure,
+    HINALEA_IN     ::hinalea::f32 const * const newEndmembers,
+    HINALEA_IN     ::hinalea::Int         const newObservations,
+    HINALEA_IN     ::hinalea::Int         const newBands,
+    HINALEA_IN_OPT ::std::uint8_t const * const newClasses
+    ) -> void
+{
+    if ( ( newObservations < 1 ) or ( newBands < 1 ) )
+    {
+        throw ::std::invalid_argument{ "Library classification requires at least 1 endmember and 1 band." };
+    }
+
+    if ( ( newClasses == nullptr ) and ( newObservations > 255 ) )
+    {
+        throw ::std::invalid_argument{ "More than 255 endmembers need to be grouped into classes." };
+    }
+
+    this->measure = newMeasure;
+    this->observations = newObservations;
+    this->bands = newBands;
+
+    ::visitSpectralMeasure(
+        newMeasure,
+        [ & ]( auto const tag )
+        {
+            ::fitEndmembers< decltype( tag )::value >( newEndmembers, newObservations, newBands, this->weights, this->endmembers );
+        }
+        );
+
+    this->endmemberLabels.resize( static_cast< ::std::size_t >( newObservations ) );
+
+    for ( auto e = ::hinalea::Int{ 0 }; e < newObservations; ++e )
+    {
+        auto const index = ( newClasses != nullptr ) ? ::hinalea::Int{ newClasses[ e ] } : e;
+        this->endmemberLabels[ static_cast< ::std::size_t >( e ) ] = static_cast< ::std::uint8_t >( index + 1 );
+    }
+}
+
+auto LibraryClassifier::thresholdRange(
+    HINALEA_IN SpectralMeasure const measure
+    ) const noexcept -> SpectralThresholdRange
+{
+    return this->ranges[ static_cast< ::std::size_t >( measure ) ];
+}
+
+auto LibraryClassifier::setThresholdLimits(
+    HINALEA_IN SpectralMeasure const measure,
+    HINALEA_IN double          const lower,
+    HINALEA_IN double          const upper
+    ) -> void
+{
+    auto & range = this->ranges[ static_cast< ::std::size_t >( measure ) ];
+    range.lower = ::std::min( lower, upper );
+    range.upper = ::std::max( lower, upper );
+    range.initial = ::std::clamp( range.initial, range.lower, range.upper );
+}
+
+auto LibraryClassifier::classify(
+    HINALEA_IN ::hinalea::f32 const * const cube,
+    HINALEA_IN ::hinalea::Int         const area,
+    HINALEA_IN double                 const threshold
+    ) -> void
+{
+    if ( this->observations == 0 )
+    {
+        throw ::std::logic_error{ "Library classifier was not fit." };
+    }
+
+    this->labels.resize( static_cast< ::std::size_t >( area ) );
+    this->confidences.resize( static_cast< ::std::size_t >( area ) );
+
+    auto const range = this->thresholdRange( this->measure );
+    auto const limit = static_cast< ::hinalea::f32 >( ::std::clamp( threshold, range.lower, range.upper ) );
+
+    ::visitSpectralMeasure(
+        this->measure,
+        [ & ]( auto const tag )
+        {
+            ::classifyTiles< decltype( tag )::value >(
+                cube,
+                area,
+                this->bands,
+                this->weights.data( ),
+                this->endmembers.data( ),
+                this->endmemberLabels.data( ),
+                this->observations,
+                limit,
+                this->labels.data( ),
+                this->confidences.data( )
+                );
+        }
+        );
+}
+
+auto LibraryClassifier::classes(
+    ) const noexcept -> ::std::vector< ::std::uint8_t > const &
+{
+    return this->labels;
+}
+
+auto LibraryClassifier::confidence(
+    ) const noexcept -> ::std::vector< ::std::uint8_t > const &
+{
+    return this->confidences;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "SpectralMeasure.hxx"
+
+#include <Hinalea.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+/* Endmember classifier for large spectral libraries.
+ *
+ * `SpectralClassifier` keeps one accumulator per endmember and pixel, which is the fastest for the handful of
+ * spectra picked from the image but does not scale to hundreds of library spectra. This classifier computes every
+ * pixel-endmember dot product of a tile as one MKL `cblas_sgemm`, reading the BSQ cube in place when the measure
+ * needs no per-sample transform. Scores, argmax, threshold and confidence are fused on each GEMM output block while
+ * it is still in cache, so the full `pixels x endmembers` similarity matrix never exists.
+ *
+ * Several spectra may share a class; the label is `1 + class` of the closest spectrum, or 0 beyond the threshold.
+ * Confidence is 255 for a perfect match and falls to 0 at the threshold, quantized so that noise does not dirty
+ * every tile of the class map.
+ */
+class LibraryClassifier
+{
+public:
+    /* Pixels per GEMM, ie. the columns of each output block. */
+    static auto constexpr tileSize = ::hinalea::Int{ 256 };
+
+    /* Endmembers per GEMM, bounds the output block to `blockSize x tileSize` per term. */
+    static auto constexpr blockSize = ::hinalea::Int{ 256 };
+
+    static auto constexpr confidenceLevels = 16;
+
+    /* `spectralThresholdRanges` until changed by `setThresholdLimits`. */
+    [[ nodiscard ]]
+    auto thresholdRange(
+        HINALEA_IN SpectralMeasure measure
+        ) const noexcept -> SpectralThresholdRange;
+
+    /* Thresholds passed to `classify` are clamped into these limits. Not thread safe, set them up front. */
+    auto setThresholdLimits(
+        HINALEA_IN SpectralMeasure measure,
+        HINALEA_IN double          lower,
+        HINALEA_IN double          upper
+        ) -> void;
+
+    /* `endmembers` is `observations x bands`, row major. `classes` gives the class index of every endmember, or
+     * may be null to give every endmember its own class.
+     */
+    auto fit(
+        HINALEA_IN     SpectralMeasure        measure,
+        HINALEA_IN     ::hinalea::f32 const * endmembers,
+        HINALEA_IN     ::hinalea::Int         observations,
+        HINALEA_IN     ::hinalea::Int         bands,
+        HINALEA_IN_OPT ::std::uint8_t const * classes
+        ) -> void;
+
+    /* `cube` is BSQ with the bands given to `fit`, ie. `bands` planes of `area` pixels. */
+    auto classify(
+        HINALEA_IN ::hinalea::f32 const * cube,
+        HINALEA_IN ::hinalea::Int         area,
+        HINALEA_IN double                 threshold
+        ) -> void;
+
+    [[ nodiscard ]]
+    auto classes(
+        ) const noexcept -> ::std::vector< ::std::uint8_t > const &;
+
+    [[ nodiscard ]]
+    auto confidence(
+        ) const noexcept -> ::std::vector< ::std::uint8_t > const &;
+
+private:
+    SpectralMeasure measure{ SpectralMeasure::SpectralAngle };
+    ::hinalea::Int observations{ 0 };
+    ::hinalea::Int bands{ 0 };
+
+    /* Transformed endmembers, `terms` row major `observations x bands` matrices. */
+    ::std::vector< ::hinalea::f32 > weights{ };
+    ::std::vector< SpectralEndmember > endmembers{ };
+    ::std::vector< ::std::uint8_t > endmemberLabels{ };
+
+    ::std::array< SpectralThresholdRange, spectralMeasureCount > ranges{ spectralThresholdRanges };
+
+    ::std::vector< ::std::uint8_t > labels{ };
+    ::std::vector< ::std::uint8_t > confidences{ };
+};
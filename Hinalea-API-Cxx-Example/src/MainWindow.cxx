@@ -1,25 +1,42 @@
 #include "MainWindow.hxx"
 #include "ui_MainWindow.h"
 
+#include "DisplayPacer.hxx"
+#include "FrameItem.hxx"
+#include "ThreadPool.hxx"
+
+#include <QAbstractItemView>
 #include <QApplication>
 #include <QChart>
+#include <QColor>
 #include <QDateTime>
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QFileDialog>
-#include <QGraphicsPixmapItem>
+#include <QGraphicsLineItem>
+#include <QGraphicsPathItem>
 #include <QImage>
+#include <QImageReader>
 #include <QLineSeries>
 #include <QMap>
 #include <QMessageBox>
 #include <QMouseEvent>
-#include <QSemaphoreReleaser>
+#include <QPainterPath>
+#include <QPen>
 #include <QSettings>
 #include <QStandardPaths>
 #include <QTimer>
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <mutex>
 #include <type_traits>
+#include <utility>
 
 #ifdef HINALEA_FREE_FLY
 HINALEA_EXTERN_C
@@ -70,6 +87,38 @@ auto debugSeries(
     ::debugSeries( { series... } );
 }
 
+/* Codec of compressed streams. Paeth follows edges better, the left neighbour codes faster. */
+// inline auto constexpr record_codec = FrameCodecSettings{ FramePredictor::Paeth, 32 };
+inline auto constexpr record_codec = FrameCodecSettings{ FramePredictor::Left, 32 };
+
+/* What continuous realtime recording does once the disk falls behind and its queue is full: drop the cube and count it,
+ * or hold the realtime thread until the writer frees a buffer, which lowers the cube rate instead.
+ */
+// inline auto constexpr cube_record_overflow = CubeRecorder::Overflow::Block;
+inline auto constexpr cube_record_overflow = CubeRecorder::Overflow::Drop;
+
+/* Memory the queue of continuous realtime recording may hold before it overflows. */
+inline auto constexpr cube_record_queue_bytes = ::std::size_t{ 1 } << 30;
+
+/* Set to true to also write processed cubes and realtime snapshots as chunked cubes, `.hcc`, which Open Cube reads. */
+// inline bool constexpr write_chunked_cubes = true;
+inline bool constexpr write_chunked_cubes = false;
+
+/* Chunk shape of chunked cubes. One band per chunk is fastest for single bands, more for reading spectra. */
+// inline auto constexpr chunked_cube_options = ChunkedCube::Options{ 16, 64, ChunkedCube::Compression::Deflate, 1 };
+inline auto constexpr chunked_cube_options = ChunkedCube::Options{ 1, 256, ChunkedCube::Compression::Deflate, 1 };
+
+/* Scale factor of processed cubes, smaller processes faster for debugging purposes. */
+// inline auto constexpr process_scale_factor = ::hinalea::ndebug ? 0.5 : 0.1;
+inline auto constexpr process_scale_factor = 1.0;
+
+/* Cores the processor keeps busy per capture; a batch processes core count / this many captures at once. */
+inline auto constexpr batch_cores_per_job = 4u;
+
+/* Memory the captures a batch processes at once may take, and the estimate per frame pixel at a scale factor of one. */
+inline auto constexpr batch_memory_budget_bytes = ::std::uint64_t{ 8 } << 30;
+inline auto constexpr batch_bytes_per_sample = ::std::uint64_t{ 8 }; /* The f32 cube and a working copy of it. */
+
 [[ nodiscard ]]
 auto cameraTypes(
     ) -> QMap< QString, ::hinalea::CameraType > const &
@@ -154,6 +203,22 @@ auto exposureCast(
     }
 }
 
+/* Pattern of the SDK's color filter array, as read out by the sensor before any flip. */
+[[ nodiscard ]]
+constexpr
+auto cfaPatternCast(
+    HINALEA_IN ::hinalea::ColorFilterArray const cfa
+    ) noexcept -> CfaPattern
+{
+    switch ( cfa )
+    {
+        case ::hinalea::ColorFilterArray::GRBG: { return CfaPattern::Grbg; }
+        case ::hinalea::ColorFilterArray::GBRG: { return CfaPattern::Gbrg; }
+        case ::hinalea::ColorFilterArray::BGGR: { return CfaPattern::Bggr; }
+        default:                                { return CfaPattern::Rggb; }
+    }
+}
+
 [[ nodiscard ]]
 constexpr
 auto gainCast(
@@ -199,6 +264,165 @@ auto joinThread(
     }
 }
 
+/* Logs the size of a written chunked cube, `Hinalea-API-Cxx-Bench chunked-cube` measures reading it. */
+auto logChunkedCube(
+    HINALEA_IN ::hinalea::fs::path const &          path,
+    HINALEA_IN ChunkedCube::WriteStatistics const & statistics
+    ) -> void
+{
+    qInfo( ).noquote( )
+        << "Chunked cube:" << ::pathCast( path ) << "," << statistics.chunks << "chunks,"
+        << static_cast< double >( statistics.rawBytes ) / static_cast< double >( qMax< ::std::uint64_t >( statistics.bytes, 1 ) ) << ": 1,"
+        << ::std::chrono::duration< double, ::std::milli >( statistics.elapsed ).count( ) << "ms";
+}
+
+/* Writes every ENVI cube under `dir` a second time as a chunked cube next to it. Files `EnviCube` does not support are
+ * skipped.
+ */
+auto writeChunkedCubes(
+    HINALEA_IN ::hinalea::fs::path const & dir
+    ) -> void
+{
+    for ( auto const & entry : ::hinalea::fs::recursive_directory_iterator{ dir } )
+    {
+        if ( ( not entry.is_regular_file( ) ) or ( entry.path( ).extension( ) != ".hdr" ) )
+        {
+            continue;
+        }
+
+        auto cube = EnviCube{ };
+
+        try
+        {
+            cube = EnviCube::open( entry.path( ) );
+        }
+        catch ( ::std::exception const & exc )
+        {
+            qWarning( ).noquote( ) << "Not writing a chunked cube of" << ::pathCast( entry.path( ) ) << ":" << exc.what( );
+            continue;
+        }
+
+        auto path = entry.path( );
+        path.replace_extension( ".hcc" );
+
+        try
+        {
+            ::logChunkedCube( path, ChunkedCube::write( path, cube, ::chunked_cube_options ) );
+        }
+        catch ( ... )
+        {
+            /* NOTE: A cut short chunked cube does not open anyway. */
+            auto ignored = ::std::error_code{ };
+            ::hinalea::fs::remove( path, ignored );
+            throw;
+        }
+    }
+}
+
+/* Raw data directories of a batch selection: `dir` itself if it holds files, otherwise each of its directories. Dark
+ * data does not need to be processed.
+ */
+[[ nodiscard ]]
+auto rawCaptures(
+    HINALEA_IN ::hinalea::fs::path const & dir
+    ) -> ::std::vector< ::hinalea::fs::path >
+{
+    auto captures = ::std::vector< ::hinalea::fs::path >{ };
+    auto holdsFiles = false;
+
+    for ( auto const & entry : ::hinalea::fs::directory_iterator{ dir } )
+    {
+        if ( entry.is_directory( ) )
+        {
+            if ( not entry.path( ).filename( ).string( ).ends_with( "_dark" ) )
+            {
+                captures.push_back( entry.path( ) );
+            }
+        }
+        else
+        {
+            holdsFiles = true;
+        }
+    }
+
+    if ( holdsFiles )
+    {
+        return dir.filename( ).string( ).ends_with( "_dark" ) ? ::std::vector< ::hinalea::fs::path >{ } : ::std::vector{ dir };
+    }
+
+    ::std::sort( captures.begin( ), captures.end( ) );
+    return captures;
+}
+
+/* Job processing `rawDir` into `processDir`. Its memory is estimated from the frame count and the size of the first
+ * frame, read from the PNG header or the raw stream header, scaled by `process_scale_factor` in both directions; without
+ * frames, from the size of the capture as if it were 16 bit samples.
+ */
+[[ nodiscard ]]
+auto makeBatchJob(
+    HINALEA_IN ::hinalea::fs::path const & rawDir,
+    HINALEA_IN ::hinalea::fs::path const & processDir
+    ) -> BatchQueue::Job
+{
+    auto job = BatchQueue::Job{ };
+    job.input = rawDir;
+    job.output = processDir;
+
+    auto frames = ::std::uint64_t{ 0 };
+    auto pixels = ::std::uint64_t{ 0 };
+
+    for ( auto const & entry : ::hinalea::fs::recursive_directory_iterator{ rawDir } )
+    {
+        if ( not entry.is_regular_file( ) )
+        {
+            continue;
+        }
+
+        job.inputBytes += entry.file_size( );
+
+        if ( entry.path( ).extension( ) == ".png" )
+        {
+            ++frames;
+
+            if ( pixels == 0 )
+            {
+                auto const size = QImageReader{ ::pathCast( entry.path( ) ) }.size( );
+                pixels = size.isValid( ) ? static_cast< ::std::uint64_t >( size.width( ) ) * static_cast< ::std::uint64_t >( size.height( ) ) : 0;
+            }
+        }
+    }
+
+    if ( auto const stream = StreamCapture::find( rawDir ) )
+    {
+        auto const recording = RawRecording::open( *stream );
+        frames = static_cast< ::std::uint64_t >( recording.frames( ) );
+        pixels = static_cast< ::std::uint64_t >( recording.format( ).width * recording.format( ).height );
+    }
+
+    auto const samples = ( pixels > 0 ) ? frames * pixels : job.inputBytes / 2;
+    job.memoryBytes = static_cast< ::std::uint64_t >(
+        static_cast< double >( samples * ::batch_bytes_per_sample ) * ::process_scale_factor * ::process_scale_factor
+        );
+    return job;
+}
+
+[[ nodiscard ]]
+auto batchStateName(
+    HINALEA_IN BatchQueue::State const state
+    ) -> QString
+{
+    switch ( state )
+    {
+    case BatchQueue::State::Queued:    return QObject::tr( "Queued" );
+    case BatchQueue::State::Running:   return QObject::tr( "Running" );
+    case BatchQueue::State::Done:      return QObject::tr( "Done" );
+    case BatchQueue::State::Failed:    return QObject::tr( "Failed" );
+    case BatchQueue::State::Cancelled: return QObject::tr( "Cancelled" );
+    }
+
+    return QString{ };
+}
+
 [[ nodiscard ]]
 auto makeTimestamp(
     ) -> QString
@@ -211,6 +435,59 @@ auto makeTimestamp(
     return datetime;
 }
 
+/* Fades a premultiplied color by the classification confidence. */
+[[ nodiscard ]]
+auto fadeColor(
+    HINALEA_IN QRgb          const color,
+    HINALEA_IN ::std::uint8_t const confidence
+    ) -> QRgb
+{
+    if ( confidence == 255 )
+    {
+        return color;
+    }
+
+    auto const fade = [ = ]( int const channel ){ return ( channel * confidence + 127 ) / 255; };
+    return qRgba( fade( qRed( color ) ), fade( qGreen( color ) ), fade( qBlue( color ) ), fade( qAlpha( color ) ) );
+}
+
+/* Columns of the waterfall image, ie. the cubes it shows; older history rows are only kept for the exports. */
+auto constexpr maxWaterfallColumns = ::hinalea::Int{ 2048 };
+
+/* Maps `value` within `[ lower, upper ]` from blue to red, used by the waterfall and the index layer. */
+[[ nodiscard ]]
+auto heatColor(
+    HINALEA_IN ::hinalea::f32 const value,
+    HINALEA_IN double         const lower,
+    HINALEA_IN double         const upper
+    ) -> QRgb
+{
+    static auto const table =
+        [ ]
+        {
+            auto colors = ::std::array< QRgb, 256 >{ };
+
+            for ( auto i = 0; i < 256; ++i )
+            {
+                colors[ static_cast< ::std::size_t >( i ) ] = QColor::fromHsv( 240 - 240 * i / 255, 255, 255 ).rgb( );
+            }
+
+            return colors;
+        }( );
+
+    auto const scaled = ( upper > lower ) ? ( value - lower ) / ( upper - lower ) : 0.0;
+    return table[ static_cast< ::std::size_t >( ::std::clamp( scaled, 0.0, 1.0 ) * 255 + 0.5 ) ];
+}
+
+/* Probe hues step by the golden angle, like the class colors, so neighbouring probes stay distinguishable. */
+[[ nodiscard ]]
+auto probeColor(
+    HINALEA_IN int const index
+    ) -> QColor
+{
+    return QColor::fromHsv( index * 137 % 360, 255, 255 );
+}
+
 } /* namespace anonymous */
 
 MainWindow::MainWindow(
@@ -219,8 +496,12 @@ MainWindow::MainWindow(
     : QMainWindow{ parent }
     , ui{ new Ui::MainWindow{ } }
     , displayTimer{ new QTimer{ this } }
-    , displayItem{ new QGraphicsPixmapItem{ } }
-    , classifyItem{ new QGraphicsPixmapItem{ } }
+    , batchTimer{ new QTimer{ this } }
+    , displayItem{ new FrameItem{ } }
+    , indexItem{ new FrameItem{ } }
+    , classifyItem{ new FrameItem{ } }
+    , waterfallItem{ new FrameItem{ } }
+    , waterfallCursor{ new QGraphicsLineItem{ } }
     , chart{ new QChart{ } }
     , seriesL{ new QLineSeries{ } }
     , seriesR{ new QLineSeries{ } }
@@ -228,6 +509,7 @@ MainWindow::MainWindow(
     , seriesB{ new QLineSeries{ } }
 {
     Q_SET_OBJECT_NAME( displayTimer );
+    Q_SET_OBJECT_NAME( batchTimer );
     Q_SET_OBJECT_NAME( chart );
     Q_SET_OBJECT_NAME( seriesL );
     Q_SET_OBJECT_NAME( seriesR );
@@ -256,6 +538,7 @@ MainWindow::MainWindow(
     this->initConnections( );
     this->initChartView( );
     this->initImageView( );
+    this->initWaterfallView( );
     this->initSpectralMetric( );
 
     this->enablePowerWidgets( false );
@@ -285,11 +568,20 @@ MainWindow::~MainWindow(
     this->cancel( );
     this->powerOff( );
 
+    /* NOTE: Running captures cannot be interrupted, closing waits for them. */
+    this->batchQueue.cancelAll( );
+    this->batchQueue.wait( );
+
+    /* The displayed frame is owned by the frame pool, so release it before the pool is destroyed. */
+    this->displayItem->setImage( QImage{ } );
+
     for ( auto thread : {
         ::std::ref( this->recordThread ),
         ::std::ref( this->realtimeThread ),
         ::std::ref( this->displayThread ),
         ::std::ref( this->processThread ),
+        ::std::ref( this->exportThread ),
+        ::std::ref( this->snapshotThread ),
     } )
     {
         ::joinThread( thread.get( ) );
@@ -307,12 +599,24 @@ auto MainWindow::loadSettings(
     ui->gainSpinBox    ->setValue( settings.value( "gain"    , 0 ).toInt( ) );
     ui->gapIndexSpinBox->setValue( settings.value( "gapIndex", 0 ).toInt( ) );
     ui->smoothSpinBox  ->setValue( settings.value( "smooth"  , 5 ).toInt( ) );
+    ui->refreshSpinBox ->setValue( settings.value( "refresh" , 30 ).toInt( ) );
+    ui->chartRefreshSpinBox->setValue( settings.value( "chartRefresh", 15 ).toInt( ) );
+    ui->toneMapLowerSpinBox->setValue( settings.value( "toneMapLower", -1 ).toInt( ) );
+    ui->toneMapUpperSpinBox->setValue( settings.value( "toneMapUpper", -1 ).toInt( ) );
+    ui->historyBudgetSpinBox->setValue( settings.value( "historyBudget", 64 ).toInt( ) );
+    ui->preTriggerBudgetSpinBox->setValue( settings.value( "preTriggerBudget", 2048 ).toInt( ) );
+    ui->preTriggerWindowSpinBox->setValue( settings.value( "preTriggerWindow", 5 ).toInt( ) );
+    ui->indexLineEdit->setText( settings.value( "indexExpression" ).toString( ) );
+
+    /* The measure sets the threshold range, so restore it before the threshold. */
+    ui->measureComboBox->setCurrentIndex( settings.value( "measure" ).toInt( ) );
 
     ui->reflectanceSpinBox->setValue( settings.value( "reflectance", 95.0 ).toDouble( ) );
     ui->thresholdSpinBox  ->setValue( settings.value( "threshold"  ,  0.2 ).toDouble( ) );
 
     ui->darkLineEdit    ->setText( settings.value( "dark"     ).toString( ) );
     ui->gapLineEdit     ->setText( settings.value( "gaps"     ).toString( ) );
+    ui->libraryLineEdit ->setText( settings.value( "library"  ).toString( ) );
     ui->freeFlyLineEdit ->setText( settings.value( "free-fly" ).toString( ) );
     ui->matrixLineEdit  ->setText( settings.value( "matrix"   ).toString( ) );
     ui->settingsLineEdit->setText( settings.value( "settings" ).toString( ) );
@@ -323,6 +627,10 @@ auto MainWindow::loadSettings(
     ui->measurementTypeComboBox->setCurrentIndex( settings.value( "measurement" ).toInt( ) );
     ui->modeComboBox           ->setCurrentIndex( settings.value( "mode"        ).toInt( ) );
     ui->movePatternComboBox    ->setCurrentIndex( settings.value( "movePattern" ).toInt( ) );
+    ui->recordFormatComboBox   ->setCurrentIndex( settings.value( "recordFormat" ).toInt( ) );
+    ui->toneMapComboBox        ->setCurrentIndex( settings.value( "toneMap"     ).toInt( ) );
+
+    ui->recordEverySpinBox->setValue( settings.value( "recordEvery" ).toInt( ) );
 
     ui->cameraComboBox->setCurrentText( settings.value( "camera" ).toString( ) );
 
@@ -330,6 +638,8 @@ auto MainWindow::loadSettings(
     ui->verticalCheckBox   ->setChecked( settings.value( "flipVertical"   ).toBool( ) );
     ui->reflectanceCheckBox->setChecked( settings.value( "useReflectance" ).toBool( ) );
     ui->activeDarkButton   ->setChecked( settings.value( "activeDark"     ).toBool( ) );
+    ui->indexCheckBox      ->setChecked( settings.value( "showIndex"      ).toBool( ) );
+    ui->preTriggerCheckBox ->setChecked( settings.value( "preTrigger"     ).toBool( ) );
 
     if ( auto const geometry = settings.value( "geometry" ).toByteArray( );
          geometry.isEmpty( ) )
@@ -343,6 +653,8 @@ auto MainWindow::loadSettings(
 
     this->updateDark( );
     this->updateWhite( );
+    this->updateLibrary( );
+    this->updateIndexExpression( );
 }
 
 auto MainWindow::saveSettings(
@@ -354,12 +666,21 @@ auto MainWindow::saveSettings(
     settings.setValue( "gain"    , ui->gainSpinBox    ->value( ) );
     settings.setValue( "gapIndex", ui->gapIndexSpinBox->value( ) );
     settings.setValue( "smooth"  , ui->smoothSpinBox  ->value( ) );
+    settings.setValue( "refresh" , ui->refreshSpinBox ->value( ) );
+    settings.setValue( "chartRefresh", ui->chartRefreshSpinBox->value( ) );
+    settings.setValue( "toneMapLower", ui->toneMapLowerSpinBox->value( ) );
+    settings.setValue( "toneMapUpper", ui->toneMapUpperSpinBox->value( ) );
+    settings.setValue( "historyBudget", ui->historyBudgetSpinBox->value( ) );
+    settings.setValue( "preTriggerBudget", ui->preTriggerBudgetSpinBox->value( ) );
+    settings.setValue( "preTriggerWindow", ui->preTriggerWindowSpinBox->value( ) );
+    settings.setValue( "indexExpression", ui->indexLineEdit->text( ) );
 
     settings.setValue( "reflectance", ui->reflectanceSpinBox->value( ) );
     settings.setValue( "threshold"  , ui->thresholdSpinBox  ->value( ) );
 
     settings.setValue( "dark"    , ui->darkLineEdit    ->text( ) );
     settings.setValue( "gaps"    , ui->gapLineEdit     ->text( ) );
+    settings.setValue( "library" , ui->libraryLineEdit ->text( ) );
     settings.setValue( "free-fly", ui->freeFlyLineEdit ->text( ) );
     settings.setValue( "matrix"  , ui->matrixLineEdit  ->text( ) );
     settings.setValue( "settings", ui->settingsLineEdit->text( ) );
@@ -370,13 +691,20 @@ auto MainWindow::saveSettings(
     settings.setValue( "measurement", ui->measurementTypeComboBox->currentIndex( ) );
     settings.setValue( "mode"       , ui->modeComboBox           ->currentIndex( ) );
     settings.setValue( "movePattern", ui->movePatternComboBox    ->currentIndex( ) );
+    settings.setValue( "recordFormat", ui->recordFormatComboBox  ->currentIndex( ) );
+    settings.setValue( "toneMap"    , ui->toneMapComboBox        ->currentIndex( ) );
+    settings.setValue( "measure"    , ui->measureComboBox        ->currentIndex( ) );
 
     settings.setValue( "camera", ui->cameraComboBox->currentText( ) );
 
+    settings.setValue( "recordEvery", ui->recordEverySpinBox->value( ) );
+
     settings.setValue( "flipHorizontal", ui->horizontalCheckBox ->isChecked( ) );
     settings.setValue( "flipVertical"  , ui->verticalCheckBox   ->isChecked( ) );
     settings.setValue( "useReflectance", ui->reflectanceCheckBox->isChecked( ) );
     settings.setValue( "activeDark"    , ui->activeDarkButton   ->isChecked( ) );
+    settings.setValue( "showIndex"     , ui->indexCheckBox      ->isChecked( ) );
+    settings.setValue( "preTrigger"    , ui->preTriggerCheckBox ->isChecked( ) );
 
     settings.setValue( "geometry", this->saveGeometry( ) );
 }
@@ -405,25 +733,25 @@ auto MainWindow::initConnections(
 
     QObject::connect(
         this,
-        &MainWindow::doUpdateImage,
+        &MainWindow::doUpdateClassify,
         this,
-        &MainWindow::onUpdateImage,
+        &MainWindow::onUpdateClassify,
         Qt::QueuedConnection
         );
 
     QObject::connect(
         this,
-        &MainWindow::doUpdateClassify,
+        &MainWindow::doUpdateSeries,
         this,
-        &MainWindow::onUpdateClassify,
+        &MainWindow::onUpdateSeries,
         Qt::QueuedConnection
         );
 
     QObject::connect(
         this,
-        &MainWindow::doUpdateSeries,
+        &MainWindow::doUpdateIndex,
         this,
-        &MainWindow::onUpdateSeries,
+        &MainWindow::onUpdateIndex,
         Qt::QueuedConnection
         );
 
@@ -463,6 +791,41 @@ auto MainWindow::initConnections(
         &MainWindow::onReflectanceCheckBoxToggled
         );
 
+    QObject::connect(
+        ui->indexCheckBox,
+        &QAbstractButton::toggled,
+        this,
+        &MainWindow::onIndexCheckBoxToggled
+        );
+
+    QObject::connect(
+        ui->indexLineEdit,
+        &QLineEdit::editingFinished,
+        this,
+        &MainWindow::updateIndexExpression
+        );
+
+    QObject::connect(
+        ui->openCubeButton,
+        &QAbstractButton::clicked,
+        this,
+        &MainWindow::onOpenCubeClicked
+        );
+
+    QObject::connect(
+        ui->closeCubeButton,
+        &QAbstractButton::clicked,
+        this,
+        &MainWindow::onCloseCubeClicked
+        );
+
+    QObject::connect(
+        ui->cubeBandSpinBox,
+        qOverload< int >( &QSpinBox::valueChanged ),
+        this,
+        &MainWindow::onCubeBandSpinBoxValueChanged
+        );
+
     QObject::connect(
         ui->processButton,
         &QAbstractButton::clicked,
@@ -470,6 +833,27 @@ auto MainWindow::initConnections(
         &MainWindow::onProcessButtonClicked
         );
 
+    QObject::connect(
+        ui->batchButton,
+        &QAbstractButton::clicked,
+        this,
+        &MainWindow::onBatchButtonClicked
+        );
+
+    QObject::connect(
+        ui->cancelBatchButton,
+        &QAbstractButton::clicked,
+        this,
+        &MainWindow::onCancelBatchClicked
+        );
+
+    QObject::connect(
+        this->batchTimer,
+        &QTimer::timeout,
+        this,
+        &MainWindow::onBatchTimerTimeout
+        );
+
     QObject::connect(
         ui->cameraComboBox,
         qOverload< int >( &QComboBox::currentIndexChanged ),
@@ -505,6 +889,20 @@ auto MainWindow::initConnections(
         &MainWindow::onGainSpinBoxValueChanged
         );
 
+    QObject::connect(
+        ui->refreshSpinBox,
+        qOverload< int >( &QSpinBox::valueChanged ),
+        this,
+        &MainWindow::onRefreshSpinBoxValueChanged
+        );
+
+    QObject::connect(
+        ui->chartRefreshSpinBox,
+        qOverload< int >( &QSpinBox::valueChanged ),
+        this,
+        &MainWindow::onRefreshSpinBoxValueChanged
+        );
+
     QObject::connect(
         ui->gainModeSpinBox,
         qOverload< int >( &QSpinBox::valueChanged ),
@@ -519,6 +917,13 @@ auto MainWindow::initConnections(
         &MainWindow::onGapIndexSpinBoxValueChanged
         );
 
+    QObject::connect(
+        ui->thresholdSpinBox,
+        qOverload< double >( &QDoubleSpinBox::valueChanged ),
+        this,
+        &MainWindow::onThresholdSpinBoxValueChanged
+        );
+
     QObject::connect(
         ui->loadSettingsButton,
         &QAbstractButton::clicked,
@@ -563,6 +968,13 @@ auto MainWindow::initConnections(
         &MainWindow::onLoadGapClicked
         );
 
+    QObject::connect(
+        ui->loadLibraryButton,
+        &QAbstractButton::clicked,
+        this,
+        &MainWindow::onLoadLibraryClicked
+        );
+
     QObject::connect(
         ui->clearSettingsButton,
         &QAbstractButton::clicked,
@@ -607,6 +1019,41 @@ auto MainWindow::initConnections(
         &MainWindow::onClearGapClicked
         );
 
+    QObject::connect(
+        ui->clearLibraryButton,
+        &QAbstractButton::clicked,
+        this,
+        &MainWindow::onClearLibraryClicked
+        );
+
+    QObject::connect(
+        ui->clearProbesButton,
+        &QAbstractButton::clicked,
+        this,
+        &MainWindow::onClearProbesClicked
+        );
+
+    QObject::connect(
+        ui->exportHistoryButton,
+        &QAbstractButton::clicked,
+        this,
+        &MainWindow::onExportHistoryClicked
+        );
+
+    QObject::connect(
+        ui->clearHistoryButton,
+        &QAbstractButton::clicked,
+        this,
+        &MainWindow::onClearHistoryClicked
+        );
+
+    QObject::connect(
+        ui->historyBudgetSpinBox,
+        qOverload< int >( &QSpinBox::valueChanged ),
+        this,
+        &MainWindow::onHistoryBudgetSpinBoxValueChanged
+        );
+
     QObject::connect(
         ui->activeDarkButton,
         &QAbstractButton::toggled,
@@ -614,6 +1061,23 @@ auto MainWindow::initConnections(
         &MainWindow::onActiveDarkToggled
         );
 
+    QObject::connect(
+        ui->toneMapComboBox,
+        qOverload< int >( &QComboBox::currentIndexChanged ),
+        this,
+        &MainWindow::onToneMapModeChanged
+        );
+
+    for ( auto * const spinBox : { ui->toneMapLowerSpinBox, ui->toneMapUpperSpinBox } )
+    {
+        QObject::connect(
+            spinBox,
+            qOverload< int >( &QSpinBox::valueChanged ),
+            this,
+            &MainWindow::onToneMapWindowChanged
+            );
+    }
+
     for ( auto * const spinBox : { ui->xAxisLowerSpinBox, ui->xAxisUpperSpinBox } )
     {
         QObject::connect(
@@ -650,6 +1114,27 @@ auto MainWindow::initConnections(
         this,
         &MainWindow::onMovePatternComboBoxCurrentIndexChanged
         );
+
+    QObject::connect(
+        ui->measureComboBox,
+        &QComboBox::currentIndexChanged,
+        this,
+        &MainWindow::onMeasureComboBoxCurrentIndexChanged
+        );
+
+    QObject::connect(
+        ui->probeComboBox,
+        &QComboBox::currentIndexChanged,
+        this,
+        &MainWindow::onProbeComboBoxCurrentIndexChanged
+        );
+
+    QObject::connect(
+        ui->probeStatisticComboBox,
+        &QComboBox::currentIndexChanged,
+        this,
+        &MainWindow::onProbeStatisticComboBoxCurrentIndexChanged
+        );
 }
 
 auto MainWindow::initImageView(
@@ -659,6 +1144,7 @@ auto MainWindow::initImageView(
 
     for ( auto * const item : ::std::initializer_list< QGraphicsItem * >{
         this->displayItem,
+        this->indexItem,
         this->classifyItem,
     } )
     {
@@ -666,6 +1152,16 @@ auto MainWindow::initImageView(
     }
 }
 
+auto MainWindow::initWaterfallView(
+    ) -> void
+{
+    ui->waterfallView->setScene( new QGraphicsScene{ this } );
+    ui->waterfallView->scene( )->addItem( this->waterfallItem );
+    ui->waterfallView->scene( )->addItem( this->waterfallCursor );
+    this->waterfallCursor->setPen( QPen{ Qt::white, 0 } );
+    this->waterfallCursor->setZValue( 1 );
+}
+
 auto MainWindow::initChartView(
     ) -> void
 {
@@ -679,6 +1175,11 @@ auto MainWindow::initChartView(
     this->seriesG->setColor( Qt::green );
     this->seriesB->setColor( Qt::blue  );
 
+    for ( auto * const series : this->allSeries( ) )
+    {
+        series->setUseOpenGL( ::chart_use_opengl );
+    }
+
     this->chart->legend( )->hide( );
     this->chart->createDefaultAxes( );
     this->chart->setTitle( QObject::tr( "Spectra" ) );
@@ -689,29 +1190,69 @@ auto MainWindow::initSpectralMetric(
     ) -> void
 {
     auto const [ lower, upper ] = this->spectral_metric.threshold_limits( );
-    ui->thresholdSpinBox->setRange( lower, upper );
+    this->spectralClassifier.setThresholdLimits( SpectralMeasure::SpectralAngle, lower, upper );
+    this->libraryClassifier.setThresholdLimits( SpectralMeasure::SpectralAngle, lower, upper );
+    this->updateThresholdRange( this->spectralMeasure( ) );
 }
 
-auto MainWindow::setupClassifyColorTable(
-    HINALEA_INOUT QImage & classifyImage
+auto MainWindow::updateThresholdRange(
+    HINALEA_IN SpectralMeasure const measure
     ) -> void
 {
-    static auto constexpr colors = ::std::array{
-        qRgba(   0,   0,   0,   0 ),    /* Transparent */
+    auto const range = this->spectralClassifier.thresholdRange( measure );
+    auto const threshold = this->measureThresholds[ static_cast< ::std::size_t >( measure ) ].value_or( range.initial );
+
+    {
+        /* The old value may be out of the new range, do not let it leak into the classify settings. */
+        auto const blocker = QSignalBlocker{ ui->thresholdSpinBox };
+        ui->thresholdSpinBox->setRange( range.lower, range.upper );
+        ui->thresholdSpinBox->setSingleStep( range.step );
+        ui->thresholdSpinBox->setValue( threshold );
+    }
+
+    this->classifySettings.store( { measure, ui->thresholdSpinBox->value( ) }, ::std::memory_order_relaxed );
+}
+
+auto MainWindow::classifyColorTable(
+    ) const -> QVector< QRgb >
+{
+    static auto constexpr primaries = ::std::array{
         qRgba( 255,   0,   0, 255 ),    /* Red */
         qRgba(   0, 255,   0, 255 ),    /* Green */
         qRgba(   0,   0, 255, 255 ),    /* Blue */
-        /* etc */
         };
 
-    classifyImage.setColorTable( { colors.begin( ), colors.end( ) } );
-}
-
-auto MainWindow::settingsPath(
-    ) const -> ::hinalea::fs::path
-{
-    return ::pathCast( ui->settingsLineEdit );
-}
+    /* NOTE:
+     * Label 0 is unclassified and stays transparent. Library classes use their own color when the file gives one.
+     * Past the primaries, hues step by the golden angle so that any number of classes stay distinguishable.
+     */
+    auto const library = this->currentLibrary( );
+    auto table = QVector< QRgb >( 256, qRgba( 0, 0, 0, 0 ) );
+
+    for ( auto label = 1; label < table.size( ); ++label )
+    {
+        auto const index = static_cast< ::std::size_t >( label - 1 );
+        auto color = ( index < primaries.size( ) )
+            ? primaries[ index ]
+            : QColor::fromHsv( static_cast< int >( index * 137 % 360 ), 200, 255 ).rgba( )
+            ;
+
+        if ( library and ( index < library->classes( ).size( ) ) )
+        {
+            color = library->classes( )[ index ].color.value_or( color );
+        }
+
+        table[ label ] = qPremultiply( color );
+    }
+
+    return table;
+}
+
+auto MainWindow::settingsPath(
+    ) const -> ::hinalea::fs::path
+{
+    return ::pathCast( ui->settingsLineEdit );
+}
 
 auto MainWindow::whitePath(
     ) const -> ::hinalea::fs::path
@@ -737,12 +1278,56 @@ auto MainWindow::gapPath(
     return ::pathCast( ui->gapLineEdit );
 }
 
+auto MainWindow::libraryPath(
+    ) const -> ::hinalea::fs::path
+{
+    return ::pathCast( ui->libraryLineEdit );
+}
+
+auto MainWindow::currentLibrary(
+    ) const -> ::std::shared_ptr< EndmemberLibrary const >
+{
+    auto const lock = ::std::scoped_lock{ this->libraryMutex };
+    return this->library;
+}
+
+auto MainWindow::currentIndexLayer(
+    ) const -> ::std::shared_ptr< IndexLayer const >
+{
+    auto const lock = ::std::scoped_lock{ this->indexMutex };
+    return this->indexLayer;
+}
+
 auto MainWindow::exposure(
     ) const -> ::hinalea::MicrosecondsI
 {
     return ::exposureCast( ui->exposureSpinBox->value( ) );
 }
 
+auto MainWindow::refreshRate(
+    ) const -> int
+{
+    return ui->refreshSpinBox->value( );
+}
+
+auto MainWindow::chartRefreshRate(
+    ) const -> int
+{
+    return ui->chartRefreshSpinBox->value( );
+}
+
+auto MainWindow::preTriggerBudget(
+    ) const -> ::std::size_t
+{
+    return static_cast< ::std::size_t >( ui->preTriggerBudgetSpinBox->value( ) ) << 20;
+}
+
+auto MainWindow::preTriggerWindow(
+    ) const -> ::std::chrono::seconds
+{
+    return ::std::chrono::seconds{ ui->preTriggerWindowSpinBox->value( ) };
+}
+
 auto MainWindow::gain(
     ) const -> ::hinalea::Real
 {
@@ -789,6 +1374,147 @@ auto MainWindow::displayChannels(
     }
 }
 
+auto MainWindow::rawFrameKey(
+    ) const -> FramePool::Key
+{
+    /* Raw images are always monochrome. */
+    return { this->camera.width( ), this->camera.height( ), 1, this->camera.bit_depth( ), this->camera.line_pitch( ) };
+}
+
+auto MainWindow::displayFrameKey(
+    ) const -> FramePool::Key
+{
+    /* Static mode frames are always tone mapped to 8-bit for display. */
+    auto const bitDepth = ( this->operationMode( ) == OperationMode::StaticMode ) ? 8 : this->camera.bit_depth( );
+    return { this->camera.width( ), this->camera.height( ), this->displayChannels( ), bitDepth, this->displayLinePitch };
+}
+
+auto MainWindow::displayIsDemosaiced(
+    ) const -> bool
+{
+    return ( this->operationMode( ) == OperationMode::StaticMode ) and ( this->displayChannels( ) == 4 );
+}
+
+auto MainWindow::allocateDisplayImage(
+    ) -> ::hinalea::Camera::Image
+{
+    if ( this->operationMode( ) == OperationMode::RealtimeMode )
+    {
+        return this->realtime.allocate_image( );
+    }
+    else
+    {
+        auto const bytes = static_cast< ::hinalea::Size >( this->camera.height( ) * this->displayLinePitch );
+        return ::hinalea::make_aligned< ::std::byte[ ] >( this->camera.alignment( ), bytes );
+    }
+}
+
+auto MainWindow::resetDisplayBuffer(
+    ) -> void
+{
+    auto const key = this->displayFrameKey( );
+    auto const size = this->camera.qt_size( );
+    auto const full = PreviewRegion{ 0, 0, size.width( ), size.height( ), 1 };
+
+    this->displayBuffer.reset(
+        [ & ]
+        {
+            return DisplayFrame{ this->framePool.acquire( key, [ this ]{ return this->allocateDisplayImage( ); } ), full };
+        }
+        );
+
+    auto const lock = ::std::scoped_lock{ this->displayRegionMutex };
+    this->displayRegion = full;
+}
+
+auto MainWindow::updateDisplayRegion(
+    ) -> void
+{
+    if ( this->operationMode( ) == OperationMode::RealtimeMode )
+    {
+        /* Realtime images are rendered by the API, always at full resolution. */
+        return;
+    }
+
+    auto const * const view = ui->imageView;
+    auto const visible = view->mapToScene( view->viewport( )->rect( ) ).boundingRect( );
+    auto const scale = qAbs( view->transform( ).m11( ) ) * view->devicePixelRatioF( );
+    auto const region = ::previewRegion( this->camera.qt_size( ), visible, scale );
+
+    auto const lock = ::std::scoped_lock{ this->displayRegionMutex };
+    this->displayRegion = region;
+}
+
+auto MainWindow::currentDisplayRegion(
+    ) -> PreviewRegion
+{
+    auto const lock = ::std::scoped_lock{ this->displayRegionMutex };
+    return this->displayRegion;
+}
+
+auto MainWindow::displayFormat(
+    ) const -> QImage::Format
+{
+    if ( this->operationMode( ) == OperationMode::RealtimeMode )
+    {
+        return QImage::Format_RGB888;
+    }
+    else if ( this->displayIsDemosaiced( ) )
+    {
+        return QImage::Format_RGBA8888;
+    }
+    else
+    {
+        return QImage::Format_Grayscale8;
+    }
+}
+
+auto MainWindow::updateCfaPattern(
+    ) -> void
+{
+    auto const pattern = ::flipCfaPattern(
+        ::cfaPatternCast( this->camera.color_filter_array( ) ),
+        this->horizontalFlip( ),
+        this->verticalFlip( ),
+        this->camera.width( ),
+        this->camera.height( )
+        );
+
+    this->cfaPattern.store( pattern, ::std::memory_order_relaxed );
+}
+
+auto MainWindow::updateToneMap(
+    HINALEA_IN FrameStatistics const & statistics
+    ) -> void
+{
+    if ( this->toneMapMode.load( ::std::memory_order_relaxed ) == ToneMapMode::AutoPercentile )
+    {
+        this->toneMapper.setPercentiles( statistics, 0.005, 0.995 );
+        return;
+    }
+
+    /* Follow the window of the tone map spin boxes, or the frame itself while they do not form one. */
+    auto const window = this->toneMapWindow.load( ::std::memory_order_relaxed );
+    auto const lower = static_cast< ::hinalea::Int >( window >> 32 );
+    auto const upper = static_cast< ::hinalea::Int >( window & 0xFFFF'FFFF );
+
+    if ( upper > lower )
+    {
+        this->toneMapper.setWindow( lower, upper, statistics.bitDepth );
+    }
+    else
+    {
+        this->toneMapper.setWindow( statistics.min, statistics.max, statistics.bitDepth );
+    }
+}
+
+auto MainWindow::demosaicMethod(
+    ) const -> DemosaicMethod
+{
+    // return DemosaicMethod::Bilinear;
+    return DemosaicMethod::EdgeAware;
+}
+
 auto MainWindow::intensityThreshold(
     ) const -> ::hinalea::Int
 {
@@ -844,6 +1570,117 @@ auto MainWindow::displayMode(
     // return ::hinalea::DisplayMode::ProcessedPseudoRgb;
 }
 
+auto MainWindow::classifyEngine(
+    ) const -> ClassifyEngine
+{
+    // return ClassifyEngine::SpectralMetric;
+    return ClassifyEngine::SpectralClassifier;
+}
+
+auto MainWindow::spectralMeasure(
+    ) const -> SpectralMeasure
+{
+    switch ( ui->measureComboBox->currentIndex( ) )
+    {
+        case 0:
+        {
+            return SpectralMeasure::SpectralAngle;
+        }
+        case 1:
+        {
+            return SpectralMeasure::SpectralInformationDivergence;
+        }
+        case 2:
+        {
+            return SpectralMeasure::Euclidean;
+        }
+        case 3:
+        {
+            return SpectralMeasure::NormalizedCorrelation;
+        }
+        case 4:
+        {
+            return SpectralMeasure::JeffriesMatusita;
+        }
+    }
+
+    Q_UNREACHABLE( );
+}
+
+auto MainWindow::recordFormat(
+    ) const -> RecordFormat
+{
+    switch ( ui->recordFormatComboBox->currentIndex( ) )
+    {
+        case 0:
+        {
+            return RecordFormat::Png;
+        }
+        case 1:
+        {
+            return RecordFormat::RawStream;
+        }
+        case 2:
+        {
+            return RecordFormat::CompressedStream;
+        }
+    }
+
+    Q_UNREACHABLE( );
+}
+
+auto MainWindow::probeTool(
+    ) const -> ProbeTool
+{
+    switch ( ui->probeComboBox->currentIndex( ) )
+    {
+        case 0:
+        {
+            return ProbeTool::Endmember;
+        }
+        case 1:
+        {
+            return ProbeTool::Point;
+        }
+        case 2:
+        {
+            return ProbeTool::Rectangle;
+        }
+        case 3:
+        {
+            return ProbeTool::Polygon;
+        }
+    }
+
+    Q_UNREACHABLE( );
+}
+
+auto MainWindow::probeStatistic(
+    ) const -> ::std::vector< ::hinalea::f32 > ProbeSpectra::*
+{
+    switch ( ui->probeStatisticComboBox->currentIndex( ) )
+    {
+        case 0:
+        {
+            return &ProbeSpectra::mean;
+        }
+        case 1:
+        {
+            return &ProbeSpectra::deviation;
+        }
+        case 2:
+        {
+            return &ProbeSpectra::minimum;
+        }
+        case 3:
+        {
+            return &ProbeSpectra::maximum;
+        }
+    }
+
+    Q_UNREACHABLE( );
+}
+
 auto MainWindow::realtimeMode(
     ) const -> ::hinalea::Realtime::RealtimeModeVariant
 {
@@ -1000,10 +1837,24 @@ auto MainWindow::yAxisRange(
     }
 }
 
+auto MainWindow::chartWavelengths(
+    ) const -> ::std::vector< double >
+{
+    if ( this->offlineCube.isOpen( ) )
+    {
+        return this->offlineCube.wavelengths( );
+    }
+
+    auto const wavelengths = this->realtime.band_wavelengths( );
+    return { wavelengths.begin( ), wavelengths.end( ) };
+}
+
 auto MainWindow::powerOn(
     ) -> void
 try
 {
+    this->closeCube( );
+
     if ( auto const settings = this->settingsPath( );
          not ::hinalea::fs::exists( settings ) )
     {
@@ -1036,16 +1887,24 @@ try
     }
 
     this->displayItem->show( );
-    this->displayItem->setPixmap( QPixmap{ this->camera.qt_size( ) } );
+    this->displayItem->setImage( QImage{ } );
 
+    this->indexItem->setImage( QImage{ } );
     this->classifyItem->show( );
 
-    auto classifyImage = QImage{ this->camera.qt_size( ), QImage::Format_Indexed8 };
-    this->setupClassifyColorTable( classifyImage );
-    this->classifyItem->setPixmap( QPixmap::fromImage( ::std::move( classifyImage ) ) );
+    /* The overlay is kept premultiplied so painting it is a plain blend, labels are only converted for dirty tiles. */
+    auto classifyImage = QImage{ this->camera.qt_size( ), QImage::Format_ARGB32_Premultiplied };
+    classifyImage.fill( Qt::transparent );
+    this->classifyItem->setImage( ::std::move( classifyImage ) );
+    this->classMap.reset( this->camera.width( ), this->camera.height( ) );
 
     if ( this->operationMode( ) == OperationMode::RealtimeMode )
     {
+        /* One worker, the spectral metric keeps its fit between `fit` and `classes` so it cannot be shared. */
+        this->classifySettings.store( { this->spectralMeasure( ), ui->thresholdSpinBox->value( ) }, ::std::memory_order_relaxed );
+        this->classifyStage.start( 1, [ this ]( ClassifyStage::Job const & job ){ this->classifyJob( job ); } );
+        this->indexStage.start( 1, [ this ]( CubeStage< >::Job const & job ){ this->updateIndex( job.cube.data( ), job.bands, job.area ); } );
+
         this->realtimeThread = ::std::thread{
             [ this ]
             {
@@ -1085,6 +1944,7 @@ try
     QTimer::singleShot( 10000, adjust_frame_rate_coefficient );
 
     this->updateImageTimerInterval( );
+    this->startDisplayThread( );
     this->displayTimer->start( );
 
     this->enablePowerWidgets( true );
@@ -1101,18 +1961,13 @@ auto MainWindow::powerOff(
 {
     qDebug( ) << Q_FUNC_INFO;
 
-    auto const lock = ::std::scoped_lock{ this->displayMutex };
     this->displayTimer->stop( );
+    this->displayRateTimer.invalidate( );
+    this->displayedFrames = 0;
+    this->stopDisplayThread( );
 
-    if ( not this->displaySemaphore.tryAcquire( ) )
-    {
-        QApplication::processEvents( );
-        auto const timeout = ::std::chrono::duration_cast< ::std::chrono::milliseconds >( this->exposure( ) );
-        /* Use timeout.count( ) since Qt5 QSemaphore does not have chrono overloads. */
-        this->displaySemaphore.tryAcquire( 1, timeout.count( ) );
-    }
-
-    auto const releaser = QSemaphoreReleaser{ this->displaySemaphore };
+    /* NOTE: Waits for a triggered recording to be written completely. */
+    this->preTriggerRing.release( );
 
     {
         auto const blocker = QSignalBlocker{ ui->powerButton };
@@ -1129,6 +1984,9 @@ auto MainWindow::powerOff(
     {
         this->realtime.cancel( );
         ::joinThread( this->realtimeThread );
+        this->classifyStage.stop( );
+        this->indexStage.stop( );
+        this->stopCubeRecording( );
         this->realtime.close( );
     }
     else
@@ -1143,8 +2001,28 @@ auto MainWindow::powerOff(
     }
 
     this->displayItem->hide( );
+    this->indexItem->hide( );
     this->classifyItem->hide( );
-    this->displayImage.reset( );
+
+    if ( auto const stage = this->classifyStage.statistics( );
+         stage.submitted > 0 )
+    {
+        qInfo( )
+            << "Cubes submitted for classification:" << stage.submitted
+            << "classified:" << stage.completed
+            << "dropped:" << stage.dropped
+            << "failed:" << stage.failed;
+    }
+
+    if ( auto const classify = this->classMap.statistics( );
+         classify.published > 0 )
+    {
+        qInfo( )
+            << "Class maps published:" << classify.published
+            << "consumed:" << classify.consumed
+            << "tiles uploaded:" << classify.dirtyTiles << "of" << classify.totalTiles;
+    }
+    this->displayBuffer.reset( [ ]{ return DisplayFrame{ }; } );
     this->enablePowerWidgets( false );
 
     for ( auto * const spinBox : ::std::initializer_list< QAbstractSpinBox * >{
@@ -1152,10 +2030,20 @@ auto MainWindow::powerOff(
         ui->maxSpinBox,
         ui->saturationSpinBox,
         ui->fpsSpinBox,
+        ui->dpsSpinBox,
+        ui->classifyLatencySpinBox,
+        ui->queueSpinBox,
+        ui->droppedSpinBox,
     } )
     {
         spinBox->setProperty( "value", spinBox->property( "minimum" ) );
     }
+
+    this->callbackRateTimer.invalidate( );
+    this->callbackRate = 0.0;
+    this->callbackShortSeconds = 0;
+
+    ui->recordTelemetryLabel->clear( );
 }
 
 auto MainWindow::onPowerOnFailure(
@@ -1185,16 +2073,42 @@ auto MainWindow::powerOnAcquisition(
                 this->displayLinePitch = channels * width * bpp;
                 this->displayLinePitch += this->displayLinePitch % qImageAlignment;
                 auto const bytes = this->camera.height( ) * this->displayLinePitch;
-                this->displayImage = ::hinalea::make_aligned< ::std::byte[ ] >( alignment, bytes );
+                this->displayBuffer.reset(
+                    [ & ]
+                    {
+                        auto image = ::hinalea::make_aligned< ::std::byte[ ] >( alignment, bytes );
 
-                if ( not this->displayImage )
-                {
-                    throw ::std::bad_alloc{ };
-                }
+                        if ( not image )
+                        {
+                            throw ::std::bad_alloc{ };
+                        }
+
+                        return DisplayFrame{ ::std::move( image ) };
+                    }
+                    );
             }
 #else
-            this->displayImage = this->camera.allocate_image( this->displayChannels( ) );
+            /* Display frames are tone mapped to 8-bit, padded to 64 byte rows. */
+            this->displayLinePitch = ( ( this->camera.width( ) * this->displayChannels( ) + 63 ) / 64 ) * 64;
+
+            if ( this->displayIsDemosaiced( ) )
+            {
+                this->analysisImage.resize( static_cast< ::std::size_t >( this->camera.width( ) * this->camera.height( ) * 4 ) );
+            }
+            else
+            {
+                this->analysisImage.clear( );
+            }
+
+            this->resetDisplayBuffer( );
 #endif
+            if ( ui->preTriggerCheckBox->isChecked( ) )
+            {
+                auto const format = RawRecorder::Format{ this->camera.width( ), this->camera.height( ), this->camera.bit_depth( ) };
+                this->preTriggerRing.allocate( format, this->preTriggerBudget( ) );
+                qInfo( ) << "Pre-trigger ring of" << this->preTriggerRing.capacity( ) << "frames of" << format.width << "x" << format.height;
+            }
+
             this->camera.start_acquisition( );
         };
 
@@ -1230,7 +2144,12 @@ auto MainWindow::powerOnRealtime(
 
     this->setupAll( );
 
-    this->displayImage = this->realtime.allocate_image( );
+    /* Realtime display images are packed RGB888. */
+    this->displayLinePitch = this->camera.width( ) * 3;
+    this->resetDisplayBuffer( );
+    this->seriesBuffer.reset( [ ]{ return SeriesFrame{ }; } );
+    this->indexBuffer.reset( [ ]{ return IndexFrame{ }; } );
+    this->updateProbeLayout( );
     this->realtime.set_display_mode( this->displayMode( ) );
     this->realtime.set_selected_index( 0 );
 
@@ -1275,7 +2194,8 @@ auto MainWindow::powerOnRealtime(
             }
             else
             {
-                this->displayImage = this->realtime.allocate_image( );
+                this->displayLinePitch = this->camera.width( ) * 3;
+                this->resetDisplayBuffer( );
             }
         }
     }
@@ -1300,6 +2220,7 @@ auto MainWindow::powerOnRealtime(
 
     this->setupXAxis( );
     this->setupYAxis( );
+    this->updateIndexExpression( );
     return true;
 }
 
@@ -1329,15 +2250,60 @@ auto MainWindow::record(
     this->enableRecordWidgets( false );
     this->isRecording = true;
 
+    if ( auto const format = this->recordFormat( );
+         format != RecordFormat::Png )
+    {
+        /* NOTE: A frame delivered one exposure and one frame interval after the FPI settled was exposed entirely at its gap. */
+        auto const fps = qMax( static_cast< double >( this->camera.frames_per_second( ) ), 1.0 );
+        auto const settle = ::std::chrono::duration_cast< ::std::chrono::nanoseconds >( this->exposure( ) )
+                          + ::std::chrono::duration_cast< ::std::chrono::nanoseconds >( ::std::chrono::duration< double >( 1.0 / fps ) );
+
+        QApplication::setOverrideCursor( Qt::BusyCursor );
+        this->streamCancelled.store( false, ::std::memory_order_release );
+
+        this->recordThread = ::std::thread{
+            [ this, HINALEA_CAPTURE( saveDir ), HINALEA_CAPTURE( id ), format, settle ]
+            {
+                try
+                {
+                    this->recordStream( saveDir / id, format, settle );
+                }
+                catch ( ::std::exception const & exc )
+                {
+                    Q_EMIT this->threadFailed( QObject::tr( "Record Error" ), QString{ exc.what( ) } );
+                }
+
+                this->sweepFeed.stop( );
+
+                {
+                    auto const lock = ::std::scoped_lock{ this->streamRecorderMutex };
+                    this->streamRecorder.reset( );
+                }
+
+                Q_EMIT this->progressChanged( 100 );
+            }
+            };
+        return;
+    }
+
     this->recordThread = ::std::thread{
         [ this, HINALEA_CAPTURE( saveDir ), HINALEA_CAPTURE( id ) ]
         {
             try
             {
+                auto const start = ::std::chrono::steady_clock::now( );
+
                 if ( not this->acquisition.record( saveDir, id, this->makeProgressCallback( ) ) )
                 {
                     Q_EMIT this->threadFailed( QObject::tr( "Record Error" ), "Recording failed to complete." );
                 }
+
+                /* NOTE: Logged like the raw stream summary, so both formats can be compared at each bit depth. */
+                auto const seconds = ::std::chrono::duration< double >( ::std::chrono::steady_clock::now( ) - start ).count( );
+                auto const frames = static_cast< double >( this->fpi.gap_indexes( ).size( ) );
+                qInfo( )
+                    << "Recorded" << frames << "PNG frames of" << this->camera.bit_depth( ) << "bit in" << seconds << "s:"
+                    << frames / seconds << "frames/s";
             }
             catch ( ::std::exception const & exc )
             {
@@ -1350,6 +2316,9 @@ auto MainWindow::record(
 auto MainWindow::cancel(
     ) -> void
 {
+    this->streamCancelled.store( true, ::std::memory_order_release );
+    this->sweepFeed.stop( );
+
     if ( this->isRecording )
     {
         qInfo( ) << "Recording cancelled.";
@@ -1366,14 +2335,222 @@ auto MainWindow::cancel(
     }
 }
 
-auto MainWindow::process(
+auto MainWindow::recordStream(
+    HINALEA_IN ::hinalea::fs::path const &      base,
+    HINALEA_IN RecordFormat               const format,
+    HINALEA_IN ::std::chrono::nanoseconds const settle
     ) -> void
 {
-    ::joinThread( this->processThread );
-    auto const dir = QFileDialog::getExistingDirectory(
-        this,
-        QObject::tr( "Load raw data directory." ),
-        ::pathCast( ::ioDir( ) / HINALEA_PATH( "raw" ) )
+    auto const gapIndexes = this->fpi.gap_indexes( );
+    auto const count = static_cast< ::hinalea::Int >( gapIndexes.size( ) );
+    auto const bitDepth = this->camera.bit_depth( );
+
+    auto const codec = ( format == RecordFormat::CompressedStream )
+        ? ::std::optional< FrameCodecSettings >{ ::record_codec }
+        : ::std::nullopt;
+
+    auto const recorder = ::std::make_shared< RawRecorder >( );
+    recorder->open( base, RawRecorder::Format{ this->camera.width( ), this->camera.height( ), bitDepth }, count, codec );
+    recorder->setSettings( RawRecorder::Settings{
+        static_cast< double >( this->exposure( ).count( ) ),
+        static_cast< double >( this->gain( ) ),
+        this->gainMode( ),
+        this->binning( ),
+        } );
+
+    {
+        auto const lock = ::std::scoped_lock{ this->streamRecorderMutex };
+        this->streamRecorder = recorder;
+    }
+
+    auto const start = ::std::chrono::steady_clock::now( );
+    this->sweepFeed.start( recorder );
+
+    /* NOTE: A cancel between `record` and `start` would have been lost by `start`. */
+    if ( this->streamCancelled.load( ::std::memory_order_acquire ) )
+    {
+        this->sweepFeed.stop( );
+    }
+
+    for ( auto i = ::hinalea::Int{ 0 }; i < count; ++i )
+    {
+        auto const gapIndex = gapIndexes[ static_cast< ::std::size_t >( i ) ];
+        /* NOTE: `set_gap_index` returns once the FPI has settled, frames fetched sooner than `settle` after that may
+         * have been exposed while it moved. The display thread fetches every frame while the feed is active.
+         */
+        this->fpi.set_gap_index( gapIndex );
+        auto const notBefore = SweepFeed::Clock::now( ) + settle;
+
+        if ( not this->sweepFeed.take( notBefore, notBefore + 10 * settle + ::std::chrono::seconds{ 1 }, static_cast< ::hinalea::Int >( gapIndex ), static_cast< ::std::uint64_t >( i ) ) )
+        {
+            break;
+        }
+
+        /* 100 is sent once the recording is closed, it finishes the recording on the GUI thread. */
+        Q_EMIT this->progressChanged( static_cast< int >( ( i + 1 ) * 99 / count ) );
+    }
+
+    this->sweepFeed.stop( );
+    auto const statistics = recorder->close( );
+    auto const seconds = ::std::chrono::duration< double >( ::std::chrono::steady_clock::now( ) - start ).count( );
+    auto const & telemetry = statistics.telemetry;
+    qInfo( )
+        << "Recorded" << statistics.frames << "raw frames of" << bitDepth << "bit in" << seconds << "s:"
+        << static_cast< double >( statistics.frames ) / seconds << "frames/s,"
+        << static_cast< double >( statistics.bytes ) / seconds / 1e6 << "MB/s,"
+        << "writer stalls:" << statistics.stalls << "max queued:" << statistics.maxQueued;
+    qInfo( )
+        << "Recording telemetry: late frames:" << telemetry.late << "dropped:" << telemetry.dropped
+        << "queue wait p99:" << ::std::chrono::duration< double, ::std::milli >( telemetry.queueWait.quantile( 0.99 ) ).count( ) << "ms"
+        << "max:" << ::std::chrono::duration< double, ::std::milli >( telemetry.queueWait.max( ) ).count( ) << "ms,"
+        << "write p99:" << ::std::chrono::duration< double, ::std::milli >( telemetry.writeLatency.quantile( 0.99 ) ).count( ) << "ms"
+        << "max:" << ::std::chrono::duration< double, ::std::milli >( telemetry.writeLatency.max( ) ).count( ) << "ms";
+
+    if ( codec )
+    {
+        auto const encodeSeconds = ::std::chrono::duration< double >( statistics.encodeTime ).count( );
+        auto const encodeRate = static_cast< double >( statistics.rawBytes ) / qMax( encodeSeconds, 1e-9 ) / 1e6;
+        qInfo( )
+            << "Compression ratio:" << static_cast< double >( statistics.rawBytes ) / static_cast< double >( qMax( statistics.bytes, ::std::uint64_t{ 1 } ) ) << ","
+            << "encoded" << encodeRate << "MB/s," << encodeRate / static_cast< double >( ThreadPool::global( ).concurrency( ) ) << "MB/s per core";
+    }
+}
+
+auto MainWindow::triggerRecording(
+    ) -> void
+{
+    auto const id = ::makeTimestamp( ).toStdString( ) + "_pretrigger";
+    auto const base = ::ioDir( ) / HINALEA_PATH( "raw" ) / id / id;
+
+    /* NOTE: The ring holds raw frames, so a PNG recording format is streamed raw as well. */
+    auto const codec = ( this->recordFormat( ) == RecordFormat::CompressedStream )
+        ? ::std::optional< FrameCodecSettings >{ ::record_codec }
+        : ::std::nullopt;
+
+    auto const finished =
+        [ this ]( RawRecorder::Statistics const & statistics, ::std::exception_ptr const error )
+        {
+            if ( error )
+            {
+                try
+                {
+                    ::std::rethrow_exception( error );
+                }
+                catch ( ::std::exception const & exc )
+                {
+                    Q_EMIT this->threadFailed( QObject::tr( "Record Error" ), QString{ exc.what( ) } );
+                }
+
+                return;
+            }
+
+            auto const ring = this->preTriggerRing.statistics( );
+            auto const seconds = ::std::chrono::duration< double >( statistics.elapsed ).count( );
+            qInfo( )
+                << "Pre-trigger recording of" << statistics.frames << "frames," << ring.preTrigger << "before the trigger,"
+                << "dropped:" << ring.dropped << ", missed since power on:" << ring.missed << "," << static_cast< double >( statistics.bytes ) / qMax( seconds, 1e-9 ) / 1e6 << "MB/s,"
+                << "writer stalls:" << statistics.stalls;
+        };
+
+    if ( not this->preTriggerRing.trigger( base, this->preTriggerWindow( ), codec, finished ) )
+    {
+        {
+            auto const blocker = QSignalBlocker{ ui->recordButton };
+            ui->recordButton->setChecked( false );
+        }
+
+        QMessageBox::information( this, QObject::tr( "Recording" ), QObject::tr( "The previous pre-trigger recording is still being written." ) );
+        return;
+    }
+
+    this->enableRecordWidgets( false );
+    qInfo( ).noquote( ) << "Triggered recording to:" << ::pathCast( base.parent_path( ) );
+}
+
+auto MainWindow::startCubeRecording(
+    HINALEA_IN ::hinalea::fs::path const & base,
+    HINALEA_IN ::hinalea::Int        const every
+    ) -> void
+try
+{
+    auto options = CubeRecorder::Options{ };
+    options.width = this->camera.width( );
+    options.height = this->camera.height( );
+    options.wavelengths = this->chartWavelengths( );
+    options.bands = static_cast< ::hinalea::Int >( options.wavelengths.size( ) );
+    options.every = every;
+    options.queueBytes = ::cube_record_queue_bytes;
+    options.overflow = ::cube_record_overflow;
+
+    auto recorder = ::std::make_shared< CubeRecorder >( );
+    recorder->open( base, ::std::move( options ) );
+
+    {
+        auto const lock = ::std::scoped_lock{ this->cubeRecorderMutex };
+        this->cubeRecorder = recorder;
+    }
+
+    ui->recordEverySpinBox->setEnabled( false );
+    qInfo( ).noquote( ) << "Recording every" << every << "realtime cubes to" << ::pathCast( recorder->path( ) );
+}
+catch ( ::std::exception const & exc )
+{
+    ::hinalea::log::error( exc.what( ), __FILE__, __func__, __LINE__ );
+    QMessageBox::critical( this, QObject::tr( "Record Error" ), exc.what( ) );
+
+    auto const blocker = QSignalBlocker{ ui->recordButton };
+    ui->recordButton->setChecked( false );
+}
+
+auto MainWindow::stopCubeRecording(
+    ) -> void
+try
+{
+    auto recorder = ::std::shared_ptr< CubeRecorder >{ };
+
+    {
+        auto const lock = ::std::scoped_lock{ this->cubeRecorderMutex };
+        recorder.swap( this->cubeRecorder );
+    }
+
+    ui->recordEverySpinBox->setEnabled( true );
+
+    {
+        auto const blocker = QSignalBlocker{ ui->recordButton };
+        ui->recordButton->setChecked( false );
+    }
+
+    if ( recorder == nullptr )
+    {
+        return;
+    }
+
+    /* NOTE: The realtime thread may still be inside `push` with its own reference, `close` waits for it. */
+    auto const statistics = recorder->close( );
+    auto const seconds = ::std::chrono::duration< double >( statistics.elapsed ).count( );
+    auto const pushed = statistics.offered - statistics.skipped;
+    qInfo( )
+        << "Recorded" << statistics.recorded << "of" << statistics.offered << "realtime cubes in" << seconds << "s,"
+        << "skipped:" << statistics.skipped << "dropped:" << statistics.dropped << "stalls:" << statistics.stalls << ","
+        << static_cast< double >( statistics.recorded ) / qMax( seconds, 1e-9 ) << "cubes/s,"
+        << static_cast< double >( statistics.bytes ) / qMax( seconds, 1e-9 ) / 1e6 << "MB/s,"
+        << "mean push:" << ::std::chrono::duration< double, ::std::milli >{ statistics.pushTime }.count( ) / static_cast< double >( qMax( pushed, ::std::uint64_t{ 1 } ) ) << "ms,"
+        << "buffers:" << statistics.buffers << "max queued:" << statistics.maxQueued << "chunks:" << statistics.chunks;
+}
+catch ( ::std::exception const & exc )
+{
+    ::hinalea::log::error( exc.what( ), __FILE__, __func__, __LINE__ );
+    QMessageBox::critical( this, QObject::tr( "Record Error" ), exc.what( ) );
+}
+
+auto MainWindow::process(
+    ) -> void
+{
+    ::joinThread( this->processThread );
+    auto const dir = QFileDialog::getExistingDirectory(
+        this,
+        QObject::tr( "Load raw data directory." ),
+        ::pathCast( ::ioDir( ) / HINALEA_PATH( "raw" ) )
         );
 
     if ( dir.isEmpty( ) )
@@ -1391,7 +2568,7 @@ auto MainWindow::process(
         return;
     }
 
-    this->setupProcess( );
+    this->setupProcess( this->processor );
 
     auto rawDir = ::hinalea::fs::path{ dir.toStdString( ) };
     auto processDir = ::ioDir( ) / HINALEA_PATH( "processed" ) / rawDir.filename( );
@@ -1409,16 +2586,474 @@ auto MainWindow::process(
         {
             try
             {
-                this->processor.process( rawDir, processDir, this->makeProgressCallback( ) );
+                auto source = rawDir;
+
+                /* NOTE: The processor only reads captures, a raw stream is turned into one first. */
+                if ( auto const stream = StreamCapture::find( rawDir ) )
+                {
+                    source = StreamCapture::convert( *stream );
+                    qInfo( ).noquote( ) << "Raw stream capture:" << ::pathCast( source );
+                }
+
+                this->processor.process( source, processDir, this->makeProgressCallback( ) );
             }
             catch ( ::std::exception const & exc )
             {
                 Q_EMIT this->threadFailed( QObject::tr( "Process Error" ), QString{ exc.what( ) } );
+                return;
+            }
+
+            if constexpr ( ::write_chunked_cubes )
+            {
+                this->writeChunkedCubes( processDir );
             }
         }
         };
 }
 
+auto MainWindow::processBatch(
+    ) -> void
+try
+{
+    auto dialog = QFileDialog{
+        this,
+        QObject::tr( "Load raw data directories, or a folder of them." ),
+        ::pathCast( ::ioDir( ) / HINALEA_PATH( "raw" ) )
+        };
+    dialog.setFileMode( QFileDialog::Directory );
+    dialog.setOption( QFileDialog::ShowDirsOnly );
+
+    /* NOTE: Only the Qt dialog can select several directories, through the selection mode of its views. */
+    dialog.setOption( QFileDialog::DontUseNativeDialog );
+
+    for ( auto * const view : dialog.findChildren< QAbstractItemView * >( ) )
+    {
+        view->setSelectionMode( QAbstractItemView::ExtendedSelection );
+    }
+
+    if ( dialog.exec( ) != QDialog::Accepted )
+    {
+        return;
+    }
+
+    /* Captures processed before, eg. by a cancelled batch, are not processed again. */
+    auto jobs = ::std::vector< BatchQueue::Job >{ };
+    auto skipped = 0;
+
+    for ( auto const & selected : dialog.selectedFiles( ) )
+    {
+        for ( auto const & rawDir : ::rawCaptures( ::pathCast( selected ) ) )
+        {
+            auto processDir = ::ioDir( ) / HINALEA_PATH( "processed" ) / rawDir.filename( );
+
+            if ( ::hinalea::fs::exists( processDir ) )
+            {
+                ++skipped;
+                continue;
+            }
+
+            jobs.push_back( ::makeBatchJob( rawDir, processDir ) );
+        }
+    }
+
+    if ( jobs.empty( ) )
+    {
+        QMessageBox::information(
+            this,
+            QObject::tr( "Batch Process Information" ),
+            QObject::tr( "Nothing to process, %0 captures are processed already." ).arg( skipped )
+            );
+        return;
+    }
+
+    auto limits = BatchQueue::Limits{ };
+    limits.jobs = ::std::min< ::std::size_t >( qMax( ::std::thread::hardware_concurrency( ) / ::batch_cores_per_job, 1u ), jobs.size( ) );
+    limits.memoryBytes = ::batch_memory_budget_bytes;
+
+    /* NOTE: Every worker gets its own processor, set up like the one of `process`. */
+    auto processors = ::std::make_shared< ::std::vector< ::hinalea::Processor > >( limits.jobs );
+
+    for ( auto & processor : *processors )
+    {
+        this->setupProcess( processor );
+        processor.set_white_path( this->whitePath( ) );
+    }
+
+    qInfo( ).noquote( )
+        << "Batch processing" << jobs.size( ) << "captures," << limits.jobs << "at once, skipped" << skipped << "processed before.";
+
+    ui->batchTableWidget->clearContents( );
+    ui->batchTableWidget->setRowCount( static_cast< int >( jobs.size( ) ) );
+
+    for ( auto row = 0; row < static_cast< int >( jobs.size( ) ); ++row )
+    {
+        auto * const item = new QTableWidgetItem{ ::pathCast( jobs[ static_cast< ::std::size_t >( row ) ].input.filename( ) ) };
+        item->setToolTip( ::pathCast( jobs[ static_cast< ::std::size_t >( row ) ].input ) );
+        ui->batchTableWidget->setItem( row, 0, item );
+        ui->batchTableWidget->setItem( row, 1, new QTableWidgetItem{ } );
+        ui->batchTableWidget->setItem( row, 2, new QTableWidgetItem{ } );
+    }
+
+    this->batchQueue.start(
+        ::std::move( jobs ),
+        limits,
+        [ this, processors ]( ::std::size_t const worker, BatchQueue::Job const & job, BatchQueue::Progress const & progress )
+        {
+            auto const stream = StreamCapture::find( job.input );
+            auto const source = stream ? StreamCapture::convert( *stream ) : job.input;
+
+            ( *processors )[ worker ].process(
+                source,
+                job.output,
+                [ & ]( ::hinalea::Int const percent )
+                {
+                    progress( static_cast< int >( percent ) );
+                }
+                );
+
+            if constexpr ( ::write_chunked_cubes )
+            {
+                this->writeChunkedCubes( job.output );
+            }
+        }
+        );
+
+    this->enableProcessWidgets( false );
+    ui->cancelBatchButton->setEnabled( true );
+    this->updateBatch( );
+    this->batchTimer->start( 500 );
+}
+catch ( ::std::exception const & exc )
+{
+    ::hinalea::log::error( exc.what( ), __FILE__, __func__, __LINE__ );
+    QMessageBox::critical( this, QObject::tr( "Batch Process Error" ), exc.what( ) );
+}
+
+auto MainWindow::updateBatch(
+    ) -> void
+{
+    auto const status = this->batchQueue.status( );
+    auto const rows = qMin( static_cast< int >( status.size( ) ), ui->batchTableWidget->rowCount( ) );
+
+    for ( auto row = 0; row < rows; ++row )
+    {
+        auto const & job = status[ static_cast< ::std::size_t >( row ) ];
+        ui->batchTableWidget->item( row, 1 )->setText( ::batchStateName( job.state ) );
+        ui->batchTableWidget->item( row, 1 )->setToolTip( QString::fromStdString( job.error ) );
+        ui->batchTableWidget->item( row, 2 )->setText(
+            QStringLiteral( "%0 % %1 s" ).arg( job.percent ).arg( ::std::chrono::duration< double >( job.elapsed ).count( ), 0, 'f', 0 )
+            );
+    }
+
+    auto const statistics = this->batchQueue.statistics( );
+    auto const seconds = qMax( ::std::chrono::duration< double >( statistics.elapsed ).count( ), 1e-3 );
+    ui->batchLabel->setText(
+        QObject::tr( "%0 / %1 done, %2 running, %3 failed, %4 cancelled\n%5 MB/s, %6 captures/min" )
+            .arg( statistics.done )
+            .arg( status.size( ) )
+            .arg( statistics.running )
+            .arg( statistics.failed )
+            .arg( statistics.cancelled )
+            .arg( static_cast< double >( statistics.inputBytesDone ) / 1e6 / seconds, 0, 'f', 1 )
+            .arg( static_cast< double >( statistics.done ) * 60.0 / seconds, 0, 'f', 1 )
+        );
+}
+
+auto MainWindow::openCube(
+    HINALEA_IN ::hinalea::fs::path const & path
+    ) -> void
+try
+{
+    auto timer = QElapsedTimer{ };
+    timer.start( );
+    auto cube = EnviCube::open( path );
+    auto const opened = static_cast< double >( timer.nsecsElapsed( ) ) / 1e6;
+
+    this->closeCube( );
+    this->offlineCube = ::std::move( cube );
+
+    auto const bands = static_cast< int >( this->offlineCube.bands( ) );
+    auto const rect = QRect{ 0, 0, static_cast< int >( this->offlineCube.samples( ) ), static_cast< int >( this->offlineCube.lines( ) ) };
+    ui->imageView->scene( )->setSceneRect( rect );
+    ui->imageView->fitInView( rect, Qt::KeepAspectRatio );
+
+    this->displayItem->setImage( QImage{ } );
+    this->displayItem->show( );
+    this->indexItem->hide( );
+    this->classifyItem->hide( );
+
+    {
+        auto const blocker = QSignalBlocker{ ui->cubeBandSpinBox };
+        ui->cubeBandSpinBox->setRange( 0, bands - 1 );
+        ui->cubeBandSpinBox->setValue( bands / 2 );
+    }
+
+    ui->cubeBandSpinBox->setEnabled( true );
+    ui->closeCubeButton->setEnabled( true );
+    ui->cubeLineEdit->setText( ::pathCast( path ) );
+    ui->cubeLineEdit->setToolTip( QString::fromStdString( this->offlineCube.describe( ) ) );
+
+    if ( auto const wavelengths = this->chartWavelengths( );
+         wavelengths.empty( ) )
+    {
+        this->setupAxis(
+            Qt::Horizontal,
+            QObject::tr( "Band" ),
+            { 0.0, static_cast< ::hinalea::Real >( qMax( bands - 1, 1 ) ) },
+            ui->xAxisLowerSpinBox,
+            ui->xAxisUpperSpinBox
+            );
+    }
+    else
+    {
+        this->setupAxis(
+            Qt::Horizontal,
+            QObject::tr( "Wavelength (nm)" ),
+            { wavelengths.front( ), wavelengths.back( ) },
+            ui->xAxisLowerSpinBox,
+            ui->xAxisUpperSpinBox
+            );
+    }
+
+    this->setupOfflineYAxis( 0.0, 1.0 );
+
+    for ( auto * const series : this->allSeries( ) )
+    {
+        series->clear( );
+    }
+
+    this->endmemberLocation_.store( -1, ::std::memory_order_relaxed );
+    this->updateProbeLayout( );
+
+    /* NOTE: The display timer only polls the view for pans and resizes here, nothing is read unless it changed. */
+    this->updateImageTimerInterval( );
+    this->displayTimer->start( );
+    this->updateOfflineView( );
+
+    qInfo( ).noquote( ) << "Opened" << QString::fromStdString( this->offlineCube.describe( ) ) << "cube in" << opened << "ms";
+}
+catch ( ::std::exception const & exc )
+{
+    ::hinalea::log::error( exc.what( ), __FILE__, __func__, __LINE__ );
+    QMessageBox::critical( this, QObject::tr( "Open Cube Error" ), exc.what( ) );
+}
+
+auto MainWindow::closeCube(
+    ) -> void
+{
+    if ( not this->offlineCube.isOpen( ) )
+    {
+        return;
+    }
+
+    this->displayTimer->stop( );
+    this->displayItem->setImage( QImage{ } );
+    this->displayItem->hide( );
+
+    for ( auto * const series : this->allSeries( ) )
+    {
+        series->clear( );
+    }
+
+    /* The probes stay, they are rasterized again for the camera once it is powered on. */
+    this->probeSet.setProbes( { }, 0 );
+
+    this->offlineCube = EnviCube{ };
+    this->offlineRegion = PreviewRegion{ };
+    this->offlineBand = -1;
+    this->offlineValues = { };
+
+    ui->cubeLineEdit->clear( );
+    ui->cubeLineEdit->setToolTip( { } );
+    ui->cubeBandSpinBox->setEnabled( false );
+    ui->closeCubeButton->setEnabled( false );
+}
+
+auto MainWindow::updateOfflineView(
+    ) -> void
+{
+    auto const & cube = this->offlineCube;
+    auto const * const view = ui->imageView;
+    auto const visible = view->mapToScene( view->viewport( )->rect( ) ).boundingRect( );
+    auto const scale = qAbs( view->transform( ).m11( ) ) * view->devicePixelRatioF( );
+    auto const size = QSize{ static_cast< int >( cube.samples( ) ), static_cast< int >( cube.lines( ) ) };
+    auto const region = ::previewRegion( size, visible, scale );
+    auto const band = static_cast< ::hinalea::Int >( ui->cubeBandSpinBox->value( ) );
+
+    if ( ( region == this->offlineRegion ) and ( band == this->offlineBand ) )
+    {
+        return;
+    }
+
+    auto timer = QElapsedTimer{ };
+    timer.start( );
+
+    auto const width = region.outputWidth( );
+    auto const height = region.outputHeight( );
+    auto & values = this->offlineValues;
+    values.resize( static_cast< ::std::size_t >( width * height ) );
+    cube.readBand( band, region, values.data( ), width );
+
+    /* NOTE: Stretches the 1st to 99th percentile of the finite values on screen, single hot pixels would flatten it. */
+    auto finite = ::std::vector< ::hinalea::f32 >{ };
+    finite.reserve( values.size( ) );
+    ::std::copy_if( values.begin( ), values.end( ), ::std::back_inserter( finite ), [ ]( ::hinalea::f32 const v ){ return ::std::isfinite( v ); } );
+
+    auto lower = 0.0f;
+    auto upper = 1.0f;
+
+    if ( not finite.empty( ) )
+    {
+        auto const percentile = [ & ]( ::std::size_t const percent )
+        {
+            auto const nth = finite.begin( ) + static_cast< ::std::ptrdiff_t >( ( finite.size( ) - 1 ) * percent / 100 );
+            ::std::nth_element( finite.begin( ), nth, finite.end( ) );
+            return *nth;
+        };
+
+        lower = percentile( 1 );
+        upper = qMax( percentile( 99 ), lower + ::std::numeric_limits< ::hinalea::f32 >::min( ) );
+    }
+
+    auto image = QImage{ static_cast< int >( width ), static_cast< int >( height ), QImage::Format_Grayscale8 };
+    auto const gain = 255.0f / ( upper - lower );
+
+    for ( auto y = ::hinalea::Int{ 0 }; y < height; ++y )
+    {
+        auto const * const row = values.data( ) + y * width;
+        auto * const line = image.scanLine( static_cast< int >( y ) );
+
+        for ( auto x = ::hinalea::Int{ 0 }; x < width; ++x )
+        {
+            line[ x ] = ::std::isfinite( row[ x ] )
+                ? static_cast< uchar >( ::std::clamp( ( row[ x ] - lower ) * gain, 0.0f, 255.0f ) )
+                : uchar{ 0 };
+        }
+    }
+
+    this->displayItem->setImage( ::std::move( image ), region.sceneRect( ) );
+    this->displayStep = region.step;
+    this->offlineRegion = region;
+    this->offlineBand = band;
+
+    qDebug( ) << "Offline band" << band << "step" << region.step << "read in" << static_cast< double >( timer.nsecsElapsed( ) ) / 1e6 << "ms";
+}
+
+auto MainWindow::showOfflineSpectrum(
+    HINALEA_IN QPoint const & location
+    ) -> void
+{
+    auto const & cube = this->offlineCube;
+
+    if ( ( location.x( ) < 0 ) or ( location.y( ) < 0 ) or ( location.x( ) >= cube.samples( ) ) or ( location.y( ) >= cube.lines( ) ) )
+    {
+        return;
+    }
+
+    auto values = ::std::vector< ::hinalea::f32 >( static_cast< ::std::size_t >( cube.bands( ) ) );
+    cube.readSpectrum( location.x( ), location.y( ), values.data( ) );
+
+    auto const wavelengths = this->chartWavelengths( );
+    auto points = QVector< QPointF >{ };
+    points.reserve( static_cast< int >( values.size( ) ) );
+    auto lower = ::std::numeric_limits< double >::infinity( );
+    auto upper = -::std::numeric_limits< double >::infinity( );
+
+    for ( auto b = ::std::size_t{ 0 }; b < values.size( ); ++b )
+    {
+        if ( not ::std::isfinite( values[ b ] ) )
+        {
+            continue;
+        }
+
+        points.append( QPointF{ wavelengths.empty( ) ? static_cast< qreal >( b ) : wavelengths[ b ], values[ b ] } );
+        lower = qMin( lower, static_cast< double >( values[ b ] ) );
+        upper = qMax( upper, static_cast< double >( values[ b ] ) );
+    }
+
+    this->seriesL->replace( points );
+
+    if ( not points.isEmpty( ) )
+    {
+        this->setupOfflineYAxis( lower, upper );
+    }
+}
+
+auto MainWindow::reduceOfflineProbes(
+    ) -> void
+{
+    auto const & cube = this->offlineCube;
+    auto const area = cube.samples( ) * cube.lines( );
+
+    /* NOTE:
+     * Float BSQ bands are reduced straight from the mapping. Any other band is converted into a scratch plane at the
+     * probe pixels only; the rest of the plane is never written, so it is never backed by memory either.
+     */
+    auto scratch = ::std::unique_ptr< ::hinalea::f32[ ] >{ };
+    auto const planes = [ & ](
+        ::hinalea::Int                              const   band,
+        ::std::vector< ::std::vector< PixelSpan > > const & probes
+        ) -> ::hinalea::f32 const *
+    {
+        if ( auto const * const plane = cube.plane( band );
+             plane != nullptr )
+        {
+            return plane;
+        }
+
+        if ( not scratch )
+        {
+            scratch = ::std::make_unique_for_overwrite< ::hinalea::f32[ ] >( static_cast< ::std::size_t >( area ) );
+        }
+
+        for ( auto const & spans : probes )
+        {
+            cube.readSpans( band, spans, scratch.get( ) );
+        }
+
+        return scratch.get( );
+    };
+
+    if ( not this->probeSet.reduce( planes, cube.bands( ), area ) )
+    {
+        return;
+    }
+
+    auto lower = ::std::numeric_limits< double >::infinity( );
+    auto upper = -::std::numeric_limits< double >::infinity( );
+
+    for ( auto const & probe : this->probeSet.spectra( ) )
+    {
+        for ( auto const value : probe.minimum )
+        {
+            lower = ::std::isfinite( value ) ? qMin( lower, static_cast< double >( value ) ) : lower;
+        }
+
+        for ( auto const value : probe.maximum )
+        {
+            upper = ::std::isfinite( value ) ? qMax( upper, static_cast< double >( value ) ) : upper;
+        }
+    }
+
+    if ( lower <= upper )
+    {
+        this->setupOfflineYAxis( lower, upper );
+    }
+
+    qDebug( ) << "Offline probes reduced in" << this->probeSet.lastDuration( ) << "ms";
+    this->updateProbeSeries( );
+}
+
+auto MainWindow::setupOfflineYAxis(
+    HINALEA_IN double const lower,
+    HINALEA_IN double const upper
+    ) -> void
+{
+    auto const from = qMin( 0.0, lower );
+    auto const to = ( upper > from ) ? upper + ( upper - from ) * 0.05 : from + 1.0;
+    this->setupAxis( Qt::Vertical, QObject::tr( "Value" ), { from, to }, ui->yAxisLowerSpinBox, ui->yAxisUpperSpinBox );
+}
+
 auto MainWindow::allSeries(
     ) const -> QVector< QLineSeries * >
 {
@@ -1485,6 +3120,7 @@ auto MainWindow::setupAcquisition(
 }
 
 auto MainWindow::setupProcess(
+    HINALEA_INOUT ::hinalea::Processor & processor
     ) -> void
 {
     auto cube_type = ::hinalea::CubeType::Intensity;
@@ -1499,17 +3135,16 @@ auto MainWindow::setupProcess(
         cube_type or_eq ::hinalea::CubeType::RealtimeModel;
     }
 
-    this->processor.set_cube_type( cube_type );
+    processor.set_cube_type( cube_type );
 
-    this->processor.set_data_type( ::hinalea::DataType::Float32 );
-    // this->processor.set_scale_factor( ::hinalea::ndebug ? 0.5 : 0.1 ); /* make processing faster for debugging purposes */
-    this->processor.set_scale_factor( 1.0 );
-    this->processor.set_spatial_smooth_size( ui->smoothSpinBox->value( ) );
-    this->processor.set_spectral_smooth_size( ui->smoothSpinBox->value( ) );
-    this->processor.set_settings_path( this->settingsPath( ) );
+    processor.set_data_type( ::hinalea::DataType::Float32 );
+    processor.set_scale_factor( ::process_scale_factor );
+    processor.set_spatial_smooth_size( ui->smoothSpinBox->value( ) );
+    processor.set_spectral_smooth_size( ui->smoothSpinBox->value( ) );
+    processor.set_settings_path( this->settingsPath( ) );
 
-    this->processor.set_suffix( ::hinalea::CubeType::Intensity  , HINALEA_PATH( "" ) );
-    this->processor.set_suffix( ::hinalea::CubeType::Reflectance, HINALEA_PATH( "_ref" ) );
+    processor.set_suffix( ::hinalea::CubeType::Intensity  , HINALEA_PATH( "" ) );
+    processor.set_suffix( ::hinalea::CubeType::Reflectance, HINALEA_PATH( "_ref" ) );
 }
 
 auto MainWindow::setupBitDepth(
@@ -1596,6 +3231,7 @@ auto MainWindow::setupGapIndex(
         auto const maxGapIndex = static_cast< int >( gapIndexes.back( ) );
         ui->gapIndexSpinBox->setRange( minGapIndex, maxGapIndex );
         this->fpi.set_gap_index( this->gapIndex( ) );
+        this->liveGapIndex.store( static_cast< ::hinalea::Int >( this->gapIndex( ) ), ::std::memory_order_relaxed );
         // this->fpi.set_gap_index_async( this->gapIndex( ) );
     }
 }
@@ -1632,6 +3268,8 @@ auto MainWindow::setupFlip(
     {
         qWarning( ) << "Failed to setup vertical flip.";
     }
+
+    this->updateCfaPattern( );
 }
 
 auto MainWindow::setupAll(
@@ -1664,6 +3302,31 @@ auto MainWindow::finishProcess(
     qInfo( ) << "Processing finished.";
 }
 
+auto MainWindow::finishBatch(
+    ) -> void
+{
+    this->batchTimer->stop( );
+    this->batchQueue.wait( );
+    this->updateBatch( );
+    ui->cancelBatchButton->setEnabled( false );
+    this->enableProcessWidgets( true );
+
+    auto const statistics = this->batchQueue.statistics( );
+    qInfo( ).noquote( )
+        << "Batch processing finished:" << statistics.done << "done," << statistics.failed << "failed,"
+        << statistics.cancelled << "cancelled in" << ::std::chrono::duration< double >( statistics.elapsed ).count( ) << "s.";
+
+    auto const status = this->batchQueue.status( );
+
+    for ( auto index = ::std::size_t{ 0 }; index < status.size( ); ++index )
+    {
+        if ( status[ index ].state == BatchQueue::State::Failed )
+        {
+            qWarning( ).noquote( ) << "Batch processing failed:" << ::pathCast( this->batchQueue.jobs( )[ index ].input ) << ":" << QString::fromStdString( status[ index ].error );
+        }
+    }
+}
+
 auto MainWindow::updateCameraType(
     ) -> void
 {
@@ -1689,35 +3352,241 @@ auto MainWindow::updateDark(
     this->acquisition.set_dark_path( path );
 }
 
+auto MainWindow::updateLibrary(
+    ) -> void
+try
+{
+    auto next = ::std::shared_ptr< EndmemberLibrary const >{ };
+
+    if ( auto const path = this->libraryPath( );
+         not path.empty( ) )
+    {
+        next = ::std::make_shared< EndmemberLibrary const >( EndmemberLibrary::load( path ) );
+    }
+
+    {
+        auto const lock = ::std::scoped_lock{ this->libraryMutex };
+        this->library = ::std::move( next );
+    }
+
+    /* Class colors may have changed, repaint the whole overlay. */
+    this->classMap.invalidate( );
+}
+catch ( ::std::exception const & exc )
+{
+    ::hinalea::log::error( exc.what( ), __FILE__, __func__, __LINE__ );
+    QMessageBox::critical( this, QObject::tr( "Error" ), exc.what( ) );
+    ui->libraryLineEdit->clear( );
+
+    auto const lock = ::std::scoped_lock{ this->libraryMutex };
+    this->library.reset( );
+}
+
+auto MainWindow::updateIndexExpression(
+    ) -> void
+try
+{
+    auto next = ::std::shared_ptr< IndexLayer const >{ };
+    auto const active = this->realtime.is_active( );
+    ui->indexLineEdit->setToolTip( QString{ } );
+    ui->indexRangeLabel->clear( );
+
+    if ( auto const text = ui->indexLineEdit->text( ).trimmed( ).toStdString( );
+         not text.empty( ) )
+    {
+        /* NOTE: Parsed even while powered off, so typos are reported as soon as the expression is entered. */
+        auto expression = BandExpression::parse( text );
+
+        if ( active )
+        {
+            auto wavelengths = ::std::vector< double >{ };
+
+            for ( auto const wavelength : this->realtime.band_wavelengths( ) )
+            {
+                wavelengths.push_back( static_cast< double >( wavelength ) );
+            }
+
+            expression = expression.bind( wavelengths );
+            ui->indexLineEdit->setToolTip( QString::fromStdString( expression.describe( ) ) );
+
+            if ( ui->indexCheckBox->isChecked( ) )
+            {
+                next = ::std::make_shared< IndexLayer const >( IndexLayer{ ::std::move( expression ), this->camera.width( ), this->camera.height( ) } );
+            }
+        }
+    }
+
+    this->indexItem->setVisible( active and ui->indexCheckBox->isChecked( ) );
+
+    auto const lock = ::std::scoped_lock{ this->indexMutex };
+    this->indexLayer = ::std::move( next );
+}
+catch ( ::std::exception const & exc )
+{
+    ::hinalea::log::error( exc.what( ), __FILE__, __func__, __LINE__ );
+    QMessageBox::critical( this, QObject::tr( "Index Expression" ), exc.what( ) );
+    this->indexItem->hide( );
+
+    auto const lock = ::std::scoped_lock{ this->indexMutex };
+    this->indexLayer.reset( );
+}
+
+auto MainWindow::writeChunkedCubes(
+    HINALEA_IN ::hinalea::fs::path const & dir
+    ) -> void
+{
+    try
+    {
+        ::writeChunkedCubes( dir );
+    }
+    catch ( ::std::exception const & exc )
+    {
+        Q_EMIT this->threadFailed(
+            QObject::tr( "Chunked Cube Error" ),
+            QObject::tr( "The cubes were saved, but their chunked cubes could not be written:\n" ) + QString{ exc.what( ) }
+            );
+    }
+}
+
+auto MainWindow::saveChunkedSnapshot(
+    HINALEA_IN ::hinalea::fs::path const & dir
+    ) -> void
+{
+    ::joinThread( this->snapshotThread );
+
+    this->snapshotThread = ::std::thread{
+        [ this, HINALEA_CAPTURE( dir ) ]
+        {
+            this->writeChunkedCubes( dir );
+        }
+        };
+}
+
+auto MainWindow::recordCube(
+    HINALEA_IN ::hinalea::f32 const * const cube,
+    HINALEA_IN ::hinalea::Int         const bands,
+    HINALEA_IN ::hinalea::Int         const area
+    ) -> void
+{
+    auto recorder = ::std::shared_ptr< CubeRecorder >{ };
+
+    {
+        auto const lock = ::std::scoped_lock{ this->cubeRecorderMutex };
+        recorder = this->cubeRecorder;
+    }
+
+    if ( recorder == nullptr )
+    {
+        return;
+    }
+
+    try
+    {
+        auto const now = ::std::chrono::system_clock::now( ).time_since_epoch( );
+        recorder->push( cube, bands, area, ::std::chrono::duration_cast< ::std::chrono::nanoseconds >( now ).count( ) );
+    }
+    catch ( ::std::exception const & exc )
+    {
+        /* NOTE: Detach the recorder so the failure is reported once, releasing the record button closes it. */
+        {
+            auto const lock = ::std::scoped_lock{ this->cubeRecorderMutex };
+
+            if ( this->cubeRecorder == recorder )
+            {
+                this->cubeRecorder.reset( );
+            }
+        }
+
+        Q_EMIT this->threadFailed( QObject::tr( "Record Error" ), QString{ exc.what( ) } );
+    }
+}
+
+auto MainWindow::updateIndex(
+    HINALEA_IN ::hinalea::f32 const * const cube,
+    HINALEA_IN ::hinalea::Int         const bands,
+    HINALEA_IN ::hinalea::Int         const area
+    ) -> void
+{
+    auto const layer = this->currentIndexLayer( );
+
+    /* NOTE: The camera was reconfigured since the expression was bound, wait for it to be bound again. */
+    if ( ( layer == nullptr ) or ( layer->expression.bands( ) != bands ) or ( layer->width * layer->height != area ) )
+    {
+        return;
+    }
+
+    this->indexValues.resize( static_cast< ::std::size_t >( area ) );
+    auto const [ minimum, maximum ] = layer->expression.evaluate( cube, area, this->indexValues.data( ) );
+
+    auto & frame = this->indexBuffer.backBuffer( );
+    auto const size = QSize{ static_cast< int >( layer->width ), static_cast< int >( layer->height ) };
+
+    /* The GUI thread hands its previous image back, so this only allocates when the resolution changes. */
+    if ( frame.image.size( ) != size )
+    {
+        frame.image = QImage{ size, QImage::Format_ARGB32_Premultiplied };
+    }
+
+    auto const width = layer->width;
+    auto const * const values = this->indexValues.data( );
+    auto & image = frame.image;
+
+    ThreadPool::global( ).parallelFor(
+        static_cast< ::std::size_t >( layer->height ),
+        16,
+        [ & ]( ::std::size_t const begin, ::std::size_t const end )
+        {
+            for ( auto y = begin; y < end; ++y )
+            {
+                auto * const pixels = reinterpret_cast< QRgb * >( image.scanLine( static_cast< int >( y ) ) );
+                auto const * const row = values + static_cast< ::hinalea::Int >( y ) * width;
+
+                for ( auto x = ::hinalea::Int{ 0 }; x < width; ++x )
+                {
+                    pixels[ x ] = ::std::isfinite( row[ x ] ) ? ::heatColor( row[ x ], minimum, maximum ) : QRgb{ 0 };
+                }
+            }
+        }
+        );
+
+    frame.minimum = minimum;
+    frame.maximum = maximum;
+    this->indexBuffer.publish( );
+    Q_EMIT this->doUpdateIndex( );
+}
+
 template < >
-auto MainWindow::updateSeries< ::hinalea::RealtimeMode::ProcessedWavelength_t >(
+auto MainWindow::fillSeries< ::hinalea::RealtimeMode::ProcessedWavelength_t >(
+    HINALEA_OUT SeriesFrame &  frame,
+    HINALEA_IN  QPoint const & location
     ) -> void
 {
-    auto const & location = *this->endmemberLocation_;
     auto const spectra = this->realtime.spectra< qreal >( location.y( ), location.x( ) );
     auto const wavelengths = this->realtime.band_wavelengths( );
     auto const count = wavelengths.size( );
+    auto & points = frame.points[ 0 ];
 
     for ( auto i = ::std::size_t{ 0 }; i < count; ++i )
     {
-        this->seriesL->append( wavelengths[ i ], spectra[ i ] );
+        points.append( QPointF( wavelengths[ i ], spectra[ i ] ) );
     }
-
-    ::debugSeries( this->seriesL );
 }
 
 template < >
-auto MainWindow::updateSeries< ::hinalea::RealtimeMode::FreeFly_t >(
+auto MainWindow::fillSeries< ::hinalea::RealtimeMode::FreeFly_t >(
+    HINALEA_OUT SeriesFrame &  frame,
+    HINALEA_IN  QPoint const & location
     ) -> void
 {
-    this->updateSeries< ::hinalea::RealtimeMode::ProcessedWavelength_t >( );
+    this->fillSeries< ::hinalea::RealtimeMode::ProcessedWavelength_t >( frame, location );
 }
 
 template < >
-auto MainWindow::updateSeries< ::hinalea::RealtimeMode::RawChannelSignals_t >(
+auto MainWindow::fillSeries< ::hinalea::RealtimeMode::RawChannelSignals_t >(
+    HINALEA_OUT SeriesFrame &  frame,
+    HINALEA_IN  QPoint const & location
     ) -> void
 {
-    auto const & location = *this->endmemberLocation_;
     auto const spectra = this->realtime.spectra< qreal >( location.y( ), location.x( ) );
     auto const gap_indexes = this->realtime.gap_indexes( );
     auto const count = gap_indexes.size( );
@@ -1727,10 +3596,8 @@ auto MainWindow::updateSeries< ::hinalea::RealtimeMode::RawChannelSignals_t >(
     {
         for ( auto i = ::std::size_t{ 0 }; i < count; ++i )
         {
-            this->seriesL->append( gap_indexes[ i ], spectra[ i ] );
+            frame.points[ 0 ].append( QPointF( gap_indexes[ i ], spectra[ i ] ) );
         }
-
-        ::debugSeries( this->seriesL );
     }
     else
     {
@@ -1739,126 +3606,449 @@ auto MainWindow::updateSeries< ::hinalea::RealtimeMode::RawChannelSignals_t >(
         for ( auto i = ::std::size_t{ 0 }; i < count; ++i )
         {
             auto const x = gap_indexes[ i ];
-            this->seriesR->append( x, spectra[ i + count * 0 ] );
-            this->seriesG->append( x, spectra[ i + count * 1 ] );
-            this->seriesB->append( x, spectra[ i + count * 2 ] );
+            frame.points[ 1 ].append( QPointF( x, spectra[ i + count * 0 ] ) );
+            frame.points[ 2 ].append( QPointF( x, spectra[ i + count * 1 ] ) );
+            frame.points[ 3 ].append( QPointF( x, spectra[ i + count * 2 ] ) );
+        }
+    }
+}
+
+auto MainWindow::updateSeriesBuffer(
+    ) -> void
+{
+    auto const now = ::std::chrono::steady_clock::now( );
+
+    if ( now < this->nextSeriesUpdate )
+    {
+        return;
+    }
+
+    this->nextSeriesUpdate = now + ::hinalea::MicrosecondsI{ this->chartPeriod.load( ::std::memory_order_relaxed ) };
+
+    /* NOTE:
+     * `resize( 0 )` keeps the capacity, so the points are refilled in place unless the chart still shares them,
+     * in which case the copy is made here rather than on the GUI thread.
+     */
+    auto & frame = this->seriesBuffer.backBuffer( );
+
+    for ( auto & points : frame.points )
+    {
+        points.resize( 0 );
+    }
+
+    if ( auto const packed = this->endmemberLocation_.load( ::std::memory_order_relaxed );
+         packed >= 0 )
+    {
+        auto const location = QPoint{ static_cast< int >( packed & 0xFFFFFFFF ), static_cast< int >( packed >> 32 ) };
+
+        ::std::visit(
+            [ & ]( auto && realtime_mode )
+            {
+                using RealtimeMode = HINALEA_TYPEOF( realtime_mode );
+                this->fillSeries< RealtimeMode >( frame, location );
+            },
+            this->realtime.realtime_mode( )
+            );
+    }
+
+    this->seriesBuffer.publish( );
+    Q_EMIT this->doUpdateSeries( );
+}
+
+auto MainWindow::onUpdateSeries(
+    ) -> void
+{
+    if ( auto * const slot = this->seriesBuffer.consume( );
+         slot != nullptr )
+    {
+        auto timer = QElapsedTimer{ };
+        timer.start( );
+
+        /* NOTE: One `replace` per series repaints it once, where `clear` plus `append` per point repainted per point. */
+        auto const series = this->allSeries( );
+
+        for ( auto i = 0; i < series.size( ); ++i )
+        {
+            series[ i ]->replace( slot->points[ static_cast< ::std::size_t >( i ) ] );
+        }
+
+        ::debugSeries( this->seriesL, this->seriesR, this->seriesG, this->seriesB );
+
+        /* Exponential moving average of the GUI thread cost per chart update. */
+        auto const elapsed = ::std::chrono::nanoseconds{ timer.nsecsElapsed( ) };
+        this->guiChartTime += ( elapsed - this->guiChartTime ) / 16;
+    }
+
+    this->updateProbeSeries( );
+    this->updateWaterfall( );
+}
+
+auto MainWindow::updateProbeSeries(
+    ) -> void
+{
+    auto const generation = this->probeSet.generation( );
+
+    if ( this->probeSeries.isEmpty( ) or ( generation == this->probeGeneration ) )
+    {
+        return;
+    }
+
+    this->probeGeneration = generation;
+
+    auto const spectra = this->probeSet.spectra( );
+
+    /* NOTE: Probes changed since the last cube, their series stay empty until the next one is reduced. */
+    if ( spectra.size( ) != static_cast< ::std::size_t >( this->probeSeries.size( ) ) )
+    {
+        for ( auto * const series : this->probeSeries )
+        {
+            series->clear( );
+        }
+
+        return;
+    }
+
+    auto const statistic = this->probeStatistic( );
+    auto const wavelengths = this->chartWavelengths( );
+
+    for ( auto i = ::std::size_t{ 0 }; i < spectra.size( ); ++i )
+    {
+        auto const & values = spectra[ i ].*statistic;
+        auto const useWavelengths = wavelengths.size( ) == values.size( );
+        auto points = QVector< QPointF >( static_cast< int >( values.size( ) ) );
+
+        for ( auto b = ::std::size_t{ 0 }; b < values.size( ); ++b )
+        {
+            points[ static_cast< int >( b ) ] = QPointF{
+                useWavelengths ? static_cast< qreal >( wavelengths[ b ] ) : static_cast< qreal >( b ),
+                static_cast< qreal >( values[ b ] )
+                };
+        }
+
+        /* NOTE: One `replace` per probe repaints the series once, rather than once per appended point. */
+        this->probeSeries[ static_cast< int >( i ) ]->replace( points );
+    }
+}
+
+auto MainWindow::addProbe(
+    HINALEA_IN QRegion const &      region,
+    HINALEA_IN QPainterPath const & outline
+    ) -> void
+{
+    if ( region.isEmpty( ) )
+    {
+        return;
+    }
+
+    auto const color = ::probeColor( this->probeRegions.size( ) );
+
+    auto * const item = new QGraphicsPathItem{ outline };
+    item->setPen( QPen{ color, 0 } );
+    item->setZValue( 1 );
+    ui->imageView->scene( )->addItem( item );
+
+    auto * const series = new QLineSeries{ };
+    series->setColor( color );
+    series->setName( QObject::tr( "Probe %1" ).arg( this->probeRegions.size( ) + 1 ) );
+    series->setUseOpenGL( ::chart_use_opengl );
+    this->chart->addSeries( series );
+
+    for ( auto * const axis : this->chart->axes( ) )
+    {
+        series->attachAxis( axis );
+    }
+
+    this->probeRegions.append( region );
+    this->probeItems.append( item );
+    this->probeSeries.append( series );
+    this->updateProbeLayout( );
+}
+
+auto MainWindow::updateProbeLayout(
+    ) -> void
+{
+    auto const offline = this->offlineCube.isOpen( );
+    auto const width = offline ? this->offlineCube.samples( ) : static_cast< ::hinalea::Int >( this->camera.width( ) );
+    auto const height = offline ? this->offlineCube.lines( ) : static_cast< ::hinalea::Int >( this->camera.height( ) );
+    auto probes = ::std::vector< ::std::vector< PixelSpan > >{ };
+    probes.reserve( static_cast< ::std::size_t >( this->probeRegions.size( ) ) );
+
+    for ( auto const & region : this->probeRegions )
+    {
+        probes.push_back( ::probeSpans( region, width, height ) );
+    }
+
+    /* NOTE: The history of the probes already drawn is kept, only a new probe starts with an empty ring. */
+    this->spectralHistory.setProbes( static_cast< ::hinalea::Int >( probes.size( ) ) );
+    this->probeSet.setProbes( ::std::move( probes ), width * height );
+
+    /* NOTE: Offline there is no cube thread, the probes are reduced once per layout. */
+    if ( offline )
+    {
+        this->reduceOfflineProbes( );
+    }
+}
+
+auto MainWindow::updateProbeDraft(
+    ) -> void
+{
+    if ( this->probeDraft.isEmpty( ) )
+    {
+        delete this->probeDraftItem;
+        this->probeDraftItem = nullptr;
+        return;
+    }
+
+    if ( this->probeDraftItem == nullptr )
+    {
+        this->probeDraftItem = new QGraphicsPathItem{ };
+        this->probeDraftItem->setPen( QPen{ ::probeColor( this->probeRegions.size( ) ), 0, Qt::DashLine } );
+        this->probeDraftItem->setZValue( 1 );
+        ui->imageView->scene( )->addItem( this->probeDraftItem );
+    }
+
+    auto path = QPainterPath{ };
+    path.addPolygon( QPolygonF{ this->probeDraft } );
+    this->probeDraftItem->setPath( path );
+}
+
+auto MainWindow::onProbeClicked(
+    HINALEA_IN QPoint const & location,
+    HINALEA_IN bool     const finish
+    ) -> void
+{
+    auto outline = QPainterPath{ };
+
+    switch ( this->probeTool( ) )
+    {
+        case ProbeTool::Endmember:
+        {
+            return;
+        }
+        case ProbeTool::Point:
+        {
+            auto const pixel = QRect{ location, QSize{ 1, 1 } };
+            outline.addRect( pixel );
+            this->addProbe( QRegion{ pixel }, outline );
+            return;
+        }
+        case ProbeTool::Rectangle:
+        {
+            /* NOTE: The first click sets one corner, the second click the opposite corner, both inclusive. */
+            if ( this->probeDraft.isEmpty( ) )
+            {
+                this->probeDraft.append( location );
+                this->updateProbeDraft( );
+                return;
+            }
+
+            auto const rect = QRect{ this->probeDraft.first( ), location }.normalized( );
+            this->probeDraft.clear( );
+            this->updateProbeDraft( );
+            outline.addRect( rect );
+            this->addProbe( QRegion{ rect }, outline );
+            return;
         }
+        case ProbeTool::Polygon:
+        {
+            /* NOTE: Every click adds a vertex; the right button, or a click next to the first vertex, closes it. */
+            auto constexpr closeDistance = 8;
+            auto const closes =
+                ( this->probeDraft.size( ) >= 3 ) and
+                (
+                    finish or
+                    (
+                        ui->imageView->mapFromScene( this->probeDraft.first( ) ) -
+                        ui->imageView->mapFromScene( location )
+                    ).manhattanLength( ) <= closeDistance
+                );
+
+            if ( not closes )
+            {
+                if ( not finish )
+                {
+                    this->probeDraft.append( location );
+                    this->updateProbeDraft( );
+                }
+
+                return;
+            }
 
-        ::debugSeries( this->seriesR, this->seriesG, this->seriesB );
+            auto const polygon = this->probeDraft;
+            this->probeDraft.clear( );
+            this->updateProbeDraft( );
+            outline.addPolygon( QPolygonF{ polygon } );
+            outline.closeSubpath( );
+            this->addProbe( QRegion{ polygon, Qt::OddEvenFill }, outline );
+            return;
+        }
     }
+
+    Q_UNREACHABLE( );
 }
 
-auto MainWindow::onUpdateSeries(
+auto MainWindow::updateImageTimerInterval(
     ) -> void
 {
-    for ( auto * const series : this->allSeries( ) )
-    {
-        series->clear( );
-    }
+    auto const periods = DisplayPacer::periods( this->exposure( ), this->refreshRate( ) );
+    this->displayTimer->setInterval( periods.timerInterval );
+    this->displayPeriod.store( periods.displayPeriod.count( ), ::std::memory_order_relaxed );
+    this->fetchPeriod.store( periods.fetchPeriod.count( ), ::std::memory_order_relaxed );
+
+    /* NOTE: The camera can be slower than one frame per exposure, eg. limited by its readout. */
+    auto framePeriod = ::std::chrono::duration_cast< ::std::chrono::nanoseconds >( this->exposure( ) );
 
-    if ( this->endmemberLocation_.has_value( ) )
+    if ( this->camera.is_open( ) )
     {
-        ::std::visit(
-            [ this ]( auto && realtime_mode )
-            {
-                using RealtimeMode = HINALEA_TYPEOF( realtime_mode );
-                this->updateSeries< RealtimeMode >( );
-            },
-            this->realtime.realtime_mode( )
-            );
+        auto const fps = static_cast< double >( this->camera.frames_per_second( ) );
+
+        if ( fps > 0.0 )
+        {
+            framePeriod = ::std::max( framePeriod, ::std::chrono::duration_cast< ::std::chrono::nanoseconds >( ::std::chrono::duration< double >( 1.0 / fps ) ) );
+        }
     }
-}
 
-auto MainWindow::updateImageTimerInterval(
-    ) -> void
-{
-    using namespace ::std::chrono_literals;
-#if 0
-    auto const interval = qMax(
-        30ms,
-        ::std::chrono::ceil< ::std::chrono::milliseconds >( this->exposure( ) )
-        );
-#else
-    auto const interval = ::std::chrono::ceil< ::std::chrono::milliseconds >( this->exposure( ) );
-#endif
-    this->displayTimer->setInterval( interval );
+    this->preTriggerRing.setFramePeriod( framePeriod );
+
+    auto const chartPeriod = ::std::chrono::duration_cast< ::hinalea::MicrosecondsI >(
+        ::std::chrono::seconds{ 1 } ) / this->chartRefreshRate( );
+    this->chartPeriod.store( chartPeriod.count( ), ::std::memory_order_relaxed );
 }
 
 auto MainWindow::updateAcquisitionImage(
-    ) -> void
+    HINALEA_IN bool const render
+    ) -> bool
 try
 {
-    auto releaser = QSemaphoreReleaser{ this->displaySemaphore };
-    auto const lock = ::std::scoped_lock{ this->displayMutex };
-
     /* Raw images are always monochrome, so allocate only 1 channel. */
-    auto rawImage = this->camera.allocate_image( 1 );
+    auto const rawKey = this->rawFrameKey( );
+    auto rawImage = this->framePool.acquire( rawKey, [ this ]{ return this->camera.allocate_image( 1 ); } );
 
     /* Do not use Camera::image instead of Acquisition::image since the
      * Acquisition class does extra internal synchronizations.
      */
     if ( not this->acquisition.image( rawImage ) )
     {
-        return;
+        this->framePool.release( rawKey, ::std::move( rawImage ) );
+        return false;
     }
 
+    auto const fetched = ::std::chrono::steady_clock::now( );
+
+    auto const rawFrame = FrameView{
+        rawImage.get( ),
+        this->camera.width( ),
+        this->camera.height( ),
+        this->camera.line_pitch( ),
+        this->camera.bit_depth( ),
+        };
+
+    auto const timestamp = ::std::chrono::duration_cast< ::std::chrono::nanoseconds >( ::std::chrono::system_clock::now( ).time_since_epoch( ) ).count( );
+
+    if ( this->preTriggerRing.isAllocated( ) )
     {
-        auto const [ min, max, saturation ] = ::hinalea::image_statistics(
-            this->camera.qt_image( rawImage ),
-            this->intensityThreshold( ),
-            this->ignoreCount( )
-            );
+        this->preTriggerRing.push( rawFrame, this->liveGapIndex.load( ::std::memory_order_relaxed ), timestamp );
+    }
+
+    if ( this->sweepFeed.isActive( ) )
+    {
+        this->sweepFeed.offer( rawFrame, fetched, timestamp );
+    }
+
+    if ( not render )
+    {
+        this->framePool.release( rawKey, ::std::move( rawImage ) );
+        return true;
+    }
+
+    {
+        auto const & statistics = this->frameStatistics.compute( rawFrame, this->intensityThreshold( ), this->ignoreCount( ) );
+
+        this->updateToneMap( statistics );
+
         auto const fps = this->camera.frames_per_second( );
-        Q_EMIT this->doUpdateStatistics( min, max, saturation, fps, ui->cpsSpinBox->minimum( ) );
+        Q_EMIT this->doUpdateStatistics(
+            static_cast< int >( statistics.min ),
+            static_cast< int >( statistics.max ),
+            static_cast< int >( statistics.saturation ),
+            fps,
+            ui->cpsSpinBox->minimum( )
+            );
     }
 
+    /* NOTE:
+     * Only the part of the frame shown by the image view is rendered, decimated to roughly the view resolution.
+     * A fit-to-window view of a large sensor therefore costs a fraction of a full frame conversion.
+     */
     auto const channels = this->displayChannels( );
+    auto const region = this->currentDisplayRegion( );
+    auto & displayFrame = this->displayBuffer.backBuffer( );
+    auto * const display = reinterpret_cast< ::std::uint8_t * >( displayFrame.image.get( ) );
 
     if ( channels == 1 )
     {
-        /* Monochrome sensor; no processing required. */
-        this->displayImage = ::std::move( rawImage );
+        /* Monochrome sensor; only tone map into the 8-bit display buffer. */
+        if ( region.step == 1 )
+        {
+            this->toneMapper.apply( ::cropFrame( rawFrame, region ), display, this->displayLinePitch );
+        }
+        else
+        {
+            ::previewMonochrome( rawFrame, region, this->toneMapper.table( ), display, this->displayLinePitch );
+        }
     }
     else
     {
         /* RGB sensor, need to convert monochrome color filter array into RGBA image. */
 #if 0
-        ::hinalea::demosaic(
-            rawImage.get( ),
-            this->displayImage.get( ),
-            this->camera.width( ),
-            this->camera.height( ),
-            this->camera.bit_depth( ),
-            this->camera.line_pitch( ),
-            this->displayLinePitch,
-            this->camera.color_filter_array( ),
-            channels
-            );
+        ::hinalea::demosaic( this->camera, rawImage, displayFrame.image, channels );
 #else
-        ::hinalea::demosaic( this->camera, rawImage, this->displayImage, channels );
+        if ( region.step == 1 )
+        {
+            /* Writes 8-bit RGBA for display and, for full frames, full precision RGBA for analysis in the same pass.
+             * The region origin is even, so the cropped frame keeps the color filter array pattern.
+             */
+            auto const fullFrame = region.isFullFrame( this->camera.qt_size( ) );
+            ::demosaic(
+                ::cropFrame( rawFrame, region ),
+                this->cfaPattern.load( ::std::memory_order_relaxed ),
+                this->demosaicMethod( ),
+                DemosaicOutput{
+                    display,
+                    this->displayLinePitch,
+                    fullFrame ? this->analysisImage.data( ) : nullptr,
+                    this->camera.width( ) * 4 * static_cast< ::hinalea::Int >( sizeof( ::std::uint16_t ) ),
+                    this->toneMapper.table( ),
+                    }
+                );
+        }
+        else
+        {
+            ::previewColorFilterArray( rawFrame, this->cfaPattern.load( ::std::memory_order_relaxed ), region, this->toneMapper.table( ), display, this->displayLinePitch );
+        }
 #endif
     }
 
-    if ( this->displayTimer->isActive( ) )
-    {
-        releaser.cancel( );
-        Q_EMIT this->doUpdateImage( );
-    }
+    displayFrame.region = region;
+
+    this->framePool.release( rawKey, ::std::move( rawImage ) );
+    this->displayBuffer.publish( );
+    return true;
 }
 catch ( ::std::exception const & exc )
 {
     ::std::cerr << exc.what( ) << '\n';
+    return false;
 }
 
 auto MainWindow::updateRealtimeImage(
     ) -> void
 try
 {
-    auto releaser = QSemaphoreReleaser{ this->displaySemaphore };
-    auto const lock = ::std::scoped_lock{ this->displayMutex };
-    this->displayImage = this->realtime.allocate_image( );
+    /* The triple buffer slots are allocated once at power on, so just overwrite the back buffer in place. */
+    auto & displayFrame = this->displayBuffer.backBuffer( );
 
-    if ( not this->realtime.image( this->displayImage ) )
+    if ( not this->realtime.image( displayFrame.image ) )
     {
         return;
     }
@@ -1870,18 +4060,77 @@ try
         Q_EMIT this->doUpdateStatistics( min, max, ui->saturationSpinBox->minimum( ), fps, cps );
     }
 
-    if ( this->displayTimer->isActive( ) )
-    {
-        releaser.cancel( );
-        Q_EMIT this->doUpdateSeries( );
-        Q_EMIT this->doUpdateImage( );
-    }
+    this->displayBuffer.publish( );
+    this->updateSeriesBuffer( );
 }
 catch ( ::std::exception const & exc )
 {
     ::std::cerr << exc.what( ) << '\n';
 }
 
+auto MainWindow::startDisplayThread(
+    ) -> void
+{
+    HINALEA_ASSERT( not this->displayThread.joinable( ) );
+    this->displayRunning.store( true, ::std::memory_order_release );
+    this->displayThread = ::std::thread{ &MainWindow::runDisplayThread, this };
+}
+
+auto MainWindow::stopDisplayThread(
+    ) -> void
+{
+    this->displayRunning.store( false, ::std::memory_order_release );
+    ::joinThread( this->displayThread );
+
+    auto const counters = this->displayBuffer.counters( );
+    qInfo( )
+        << "Display frames produced:" << counters.produced
+        << "displayed:" << counters.consumed
+        << "overwritten:" << counters.overwritten;
+}
+
+auto MainWindow::runDisplayThread(
+    ) -> void
+{
+    /* NOTE:
+     * One long lived producer thread replaces spawning a thread per display timer tick.
+     * Frames are handed to the GUI thread through the triple buffer, so neither side ever blocks the other.
+     */
+    auto pacer = DisplayPacer{ };
+    auto nextRender = DisplayPacer::Clock::now( );
+
+    while ( this->displayRunning.load( ::std::memory_order_acquire ) )
+    {
+        auto const displayPeriod = ::hinalea::MicrosecondsI{ this->displayPeriod.load( ::std::memory_order_relaxed ) };
+
+        if ( this->realtime.is_active( ) )
+        {
+            this->updateRealtimeImage( );
+            pacer.wait( displayPeriod );
+        }
+        else if ( this->sweepFeed.isActive( ) or this->preTriggerRing.isAllocated( ) )
+        {
+            /* NOTE: Every frame is fetched for the sweep and the pre-trigger ring, the preview is still only rendered once
+             * per display period.
+             */
+            auto const now = DisplayPacer::Clock::now( );
+            auto const render = now >= nextRender;
+
+            if ( this->updateAcquisitionImage( render ) and render )
+            {
+                nextRender = now + displayPeriod;
+            }
+
+            pacer.wait( ::hinalea::MicrosecondsI{ this->fetchPeriod.load( ::std::memory_order_relaxed ) } );
+        }
+        else
+        {
+            this->updateAcquisitionImage( true );
+            pacer.wait( displayPeriod );
+        }
+    }
+}
+
 auto MainWindow::realtimeReflectanceIsActive(
     ) const -> bool
 {
@@ -1905,11 +4154,15 @@ auto MainWindow::enablePowerWidgets(
     ui->recordButton->setEnabled( enable );
 
     for ( auto * const widget : ::std::initializer_list< QWidget * >{
+        ui->batchButton,
         ui->binningGroupBox,
         ui->bitDepthGroupBox,
         ui->cameraComboBox,
         ui->loadSettingsButton,
         ui->loadWhiteButton,
+        ui->openCubeButton,
+        ui->preTriggerBudgetSpinBox,
+        ui->preTriggerCheckBox,
         ui->processButton,
         ui->smoothSpinBox,
     } )
@@ -1930,6 +4183,7 @@ auto MainWindow::enableRecordWidgets(
         ui->gapIndexSpinBox,
         ui->loadDarkButton,
         ui->reflectanceSpinBox,
+        ui->recordFormatComboBox,
     } )
     {
         widget->setEnabled( enable );
@@ -1941,6 +4195,7 @@ auto MainWindow::enableProcessWidgets(
     ) -> void
 {
     for ( auto * const widget : ::std::initializer_list< QWidget * >{
+        ui->batchButton,
         ui->cameraComboBox,
         ui->loadSettingsButton,
         ui->powerButton,
@@ -1956,43 +4211,103 @@ auto MainWindow::enableProcessWidgets(
 auto MainWindow::onUpdateImage(
     ) -> void
 {
-    auto const releaser = QSemaphoreReleaser{ this->displaySemaphore };
-    auto const channels = this->displayChannels( );
+    auto * const slot = this->displayBuffer.consume( );
 
-    // FIXME: (1) good for Kinetix, (2) good for Matrix Vision at 16-bit
-#if 0
-    auto qImage = QImage{
-        reinterpret_cast< uchar * >( this->displayImage.get( ) ),
-        this->camera.width( ),
-        this->camera.height( ),
+    if ( not slot )
+    {
+        /* Nothing new was published since the last repaint. */
+        return;
+    }
+
+    auto timer = QElapsedTimer{ };
+    timer.start( );
+
+    /* Take ownership of the frame and give the slot a recycled buffer for the display thread to fill next.
+     * The QImage wraps the frame memory directly and hands it back to the pool once it is no longer displayed.
+     */
+    auto const key = this->displayFrameKey( );
+    auto const region = slot->region;
+    auto frame = ::std::exchange(
+        slot->image,
+        this->framePool.acquire( key, [ this ]{ return this->allocateDisplayImage( ); } )
+        );
+
+    auto qImage = this->framePool.wrapImage(
+        key,
+        ::std::move( frame ),
+        QSize{ static_cast< int >( region.outputWidth( ) ), static_cast< int >( region.outputHeight( ) ) },
         this->displayLinePitch,
-        ( this->operationMode() == OperationMode::StaticMode )
-            ? this->camera.qt_format( channels )
-            : QImage::Format::Format_RGB888
-        }.copy( );
-#else
-    auto qImage = this->camera.qt_image( this->displayImage, channels );
-#endif
-    this->displayItem->setPixmap( QPixmap::fromImage( ::std::move( qImage ) ) );
+        this->displayFormat( )
+        );
+    this->displayItem->setImage( ::std::move( qImage ), region.sceneRect( ) );
+    this->displayStep = region.step;
+
+    /* Exponential moving average of the GUI thread cost per displayed frame. */
+    auto const elapsed = ::std::chrono::nanoseconds{ timer.nsecsElapsed( ) };
+    this->guiFrameTime += ( elapsed - this->guiFrameTime ) / 16;
 }
 
 auto MainWindow::onUpdateClassify(
     ) -> void
 {
-    // TODO: the classes might need to be saved in callback function to make sure no data races while reading data?
-    auto const classes = this->spectral_metric.classes( );
-    auto const qSize = this->camera.qt_size( );
+    /* NOTE:
+     * The realtime thread publishes a copy of the classes into the class map, so reading them here cannot race
+     * with the next classification. Only tiles whose labels changed since the last update are converted and repainted.
+     */
+    auto & overlay = this->classifyItem->mutableImage( );
 
-    auto classifyImage = QImage{
-        classes.data( ),
-        qSize.width( ),
-        qSize.height( ),
-        qSize.width( ),
-        QImage::Format_Indexed8
-        };
+    if ( overlay.isNull( ) )
+    {
+        return;
+    }
+
+    auto const colors = this->classifyColorTable( );
+
+    this->classMap.consume(
+        [ & ](
+            QRect const &                tile,
+            ::std::uint8_t const * const labels,
+            ::std::uint8_t const * const confidence,
+            ::hinalea::Int         const linePitch
+            )
+        {
+            for ( auto y = 0; y < tile.height( ); ++y )
+            {
+                auto const * const row = labels + y * linePitch;
+                auto const * const weights = confidence + y * linePitch;
+                auto * const pixels = reinterpret_cast< QRgb * >( overlay.scanLine( tile.y( ) + y ) ) + tile.x( );
+
+                for ( auto x = 0; x < tile.width( ); ++x )
+                {
+                    pixels[ x ] = ::fadeColor( colors[ row[ x ] ], weights[ x ] );
+                }
+            }
+
+            this->classifyItem->imageChanged( tile );
+        }
+        );
+}
+
+auto MainWindow::onUpdateIndex(
+    ) -> void
+{
+    auto * const frame = this->indexBuffer.consume( );
+
+    if ( frame == nullptr )
+    {
+        return;
+    }
+
+    /* NOTE: The previous image goes back into the consumed slot, so the realtime thread refills it without detaching. */
+    auto previous = ::std::exchange( this->indexItem->mutableImage( ), QImage{ } );
+    this->indexItem->setImage( ::std::move( frame->image ) );
+    frame->image = ::std::move( previous );
 
-    this->setupClassifyColorTable( classifyImage );
-    this->classifyItem->setPixmap( QPixmap::fromImage( ::std::move( classifyImage ) ) );
+    ui->indexRangeLabel->setText(
+        ::std::isnan( frame->minimum )
+            ? QObject::tr( "No finite values" )
+            : QStringLiteral( "%1 to %2" ).arg( frame->minimum, 0, 'g', 4 ).arg( frame->maximum, 0, 'g', 4 )
+        );
 }
 
 auto MainWindow::onUpdateStatistics(
@@ -2008,95 +4323,288 @@ auto MainWindow::onUpdateStatistics(
     ui->saturationSpinBox->setValue( saturation );
     ui->fpsSpinBox->setValue( fps );
     ui->cpsSpinBox->setValue( cps );
+
+    if ( this->realtime.is_active( ) )
+    {
+        this->checkCallbackRate( cps );
+
+        auto const classify = this->classifyStage.statistics( );
+        ui->classifyLatencySpinBox->setValue( ::std::chrono::duration< double, ::std::milli >{ classify.latency }.count( ) );
+        ui->queueSpinBox->setValue( static_cast< int >( classify.depth ) );
+        ui->droppedSpinBox->setValue( static_cast< int >( qMin( classify.dropped, static_cast< ::std::uint64_t >( ui->droppedSpinBox->maximum( ) ) ) ) );
+    }
+
+    auto const counters = this->displayBuffer.counters( );
+    auto const pool = this->framePool.statistics( );
+    ui->statusbar->showMessage(
+        QObject::tr( "Display frames produced: %0, displayed: %1, overwritten: %2 | Frame pool hits: %3, misses: %4 | GUI frame time: %5 ms | GUI chart time: %6 ms | Preview: 1/%7 | Cube callbacks: %8/s" )
+            .arg( counters.produced )
+            .arg( counters.consumed )
+            .arg( counters.overwritten )
+            .arg( pool.hits )
+            .arg( pool.misses )
+            .arg( ::std::chrono::duration< double, ::std::milli >{ this->guiFrameTime }.count( ), 0, 'f', 3 )
+            .arg( ::std::chrono::duration< double, ::std::milli >{ this->guiChartTime }.count( ), 0, 'f', 3 )
+            .arg( this->displayStep )
+            .arg( this->callbackRate, 0, 'f', 1 )
+        );
+}
+
+auto MainWindow::checkCallbackRate(
+    HINALEA_IN double const cps
+    ) -> void
+{
+    if ( not this->callbackRateTimer.isValid( ) )
+    {
+        this->callbackRateTimer.start( );
+        this->callbackCubesSeen = this->callbackCubes.load( ::std::memory_order_relaxed );
+        return;
+    }
+
+    auto const elapsed = this->callbackRateTimer.nsecsElapsed( );
+
+    if ( elapsed < 1'000'000'000 )
+    {
+        return;
+    }
+
+    auto const cubes = this->callbackCubes.load( ::std::memory_order_relaxed );
+    this->callbackRate = static_cast< double >( cubes - this->callbackCubesSeen ) * 1.0e9 / static_cast< double >( elapsed );
+    this->callbackCubesSeen = cubes;
+    this->callbackRateTimer.restart( );
+
+    this->callbackShortSeconds = ( this->callbackRate < cps / 2 ) ? this->callbackShortSeconds + 1 : 0;
+
+    if ( ( this->callbackShortSeconds >= 5 ) and not this->callbackShortWarned )
+    {
+        this->callbackShortWarned = true;
+        qWarning( )
+            << "The classify callback ran for" << this->callbackRate << "of" << cps << "cubes per second;"
+            << "probes, spectral history, the index layer and cube recording miss the other cubes.";
+    }
+}
+
+auto MainWindow::updateRecordTelemetry(
+    ) -> void
+{
+    auto statistics = this->preTriggerRing.recording( );
+
+    {
+        auto const lock = ::std::scoped_lock{ this->streamRecorderMutex };
+
+        if ( this->streamRecorder != nullptr )
+        {
+            statistics = this->streamRecorder->statistics( );
+        }
+    }
+
+    if ( not statistics )
+    {
+        return;
+    }
+
+    auto const & telemetry = statistics->telemetry;
+    auto const milliseconds = [ ]( ::std::chrono::nanoseconds const duration ){ return ::std::chrono::duration< double, ::std::milli >( duration ).count( ); };
+
+    ui->recordTelemetryLabel->setText(
+        QObject::tr( "Rec: %1 frames, %2 dropped, %3 late, wait p99 %4 ms, write p99 %5 ms" )
+            .arg( telemetry.frames )
+            .arg( telemetry.dropped )
+            .arg( telemetry.late )
+            .arg( milliseconds( telemetry.queueWait.quantile( 0.99 ) ), 0, 'f', 1 )
+            .arg( milliseconds( telemetry.writeLatency.quantile( 0.99 ) ), 0, 'f', 1 )
+        );
+    ui->recordTelemetryLabel->setToolTip(
+        QObject::tr( "Longest queue wait: %1 ms, longest write: %2 ms, stalled pushes: %3" )
+            .arg( milliseconds( telemetry.queueWait.max( ) ), 0, 'f', 1 )
+            .arg( milliseconds( telemetry.writeLatency.max( ) ), 0, 'f', 1 )
+            .arg( telemetry.stalled )
+        );
 }
 
 auto MainWindow::onDisplayTimerTimeout(
     ) -> void
 {
-    if ( not this->displaySemaphore.tryAcquire( ) )
+    if ( this->offlineCube.isOpen( ) )
     {
+        this->updateOfflineView( );
         return;
     }
 
-    try
+    this->updateDisplayRegion( );
+
+    auto const before = this->displayBuffer.counters( ).consumed;
+    this->onUpdateImage( );
+    this->displayedFrames += this->displayBuffer.counters( ).consumed - before;
+
+    /* Report the display rate once per second. */
+    if ( not this->displayRateTimer.isValid( ) )
+    {
+        this->displayRateTimer.start( );
+    }
+    else if ( auto const elapsed = this->displayRateTimer.elapsed( );
+              elapsed >= 1000 )
     {
-        auto releaser = QSemaphoreReleaser{ this->displaySemaphore };
-        ::joinThread( this->displayThread );
+        ui->dpsSpinBox->setValue( static_cast< double >( this->displayedFrames ) * 1000.0 / static_cast< double >( elapsed ) );
+        this->displayedFrames = 0;
+        this->displayRateTimer.restart( );
+        this->updateRecordTelemetry( );
+    }
+}
 
-        this->displayThread = ::std::thread(
-            [ this ]
+auto MainWindow::onPowerButtonToggled(
+    HINALEA_IN bool const checked
+    ) -> void
+{
+    QApplication::setOverrideCursor( Qt::BusyCursor );
+
+    if ( checked )
+    {
+        this->powerOn( );
+    }
+    else
+    {
+        this->powerOff( );
+    }
+
+    QApplication::restoreOverrideCursor( );
+}
+
+auto MainWindow::onRecordButtonToggled(
+    HINALEA_IN bool const checked
+    ) -> void
+{
+    if ( this->operationMode( ) == OperationMode::StaticMode )
+    {
+        if ( this->preTriggerRing.isAllocated( ) )
+        {
+            if ( checked )
             {
-                if ( this->realtime.is_active( ) )
-                {
-                    this->updateRealtimeImage( );
-                }
-                else
-                {
-                    this->updateAcquisitionImage( );
-                }
+                this->triggerRecording( );
+            }
+            else
+            {
+                this->preTriggerRing.stop( );
+                this->enableRecordWidgets( true );
+            }
+        }
+        else if ( checked )
+        {
+            this->record( );
+        }
+        else
+        {
+            this->cancel( );
+        }
+    }
+    else
+    {
+        if ( not checked )
+        {
+            this->stopCubeRecording( );
+            return;
+        }
+
+        auto const id = ::makeTimestamp( ).toStdWString( );
+        auto realtimeDir = ::ioDir( ) / HINALEA_PATH( "realtime" ) / id;
+
+        if ( auto const every = ui->recordEverySpinBox->value( );
+             every > 0 )
+        {
+            this->startCubeRecording( realtimeDir, every );
+        }
+        else
+        {
+            this->realtime.save( realtimeDir );
+
+            if constexpr ( ::write_chunked_cubes )
+            {
+                this->saveChunkedSnapshot( realtimeDir );
             }
-            );
 
-        releaser.cancel( );
-    }
-    catch ( ::std::exception const & exc )
-    {
-        ::std::cerr << exc.what( ) << '\n';
+            /* Realtime saving is a snapshot so reset the record button. */
+            auto const blocker = QSignalBlocker{ ui->recordButton };
+            ui->recordButton->setChecked( false );
+        }
     }
 }
 
-auto MainWindow::onPowerButtonToggled(
-    HINALEA_IN bool const checked
+auto MainWindow::onProcessButtonClicked(
     ) -> void
 {
-    QApplication::setOverrideCursor( Qt::BusyCursor );
+    this->process( );
+}
 
-    if ( checked )
+auto MainWindow::onBatchButtonClicked(
+    ) -> void
+{
+    this->processBatch( );
+}
+
+auto MainWindow::onCancelBatchClicked(
+    ) -> void
+{
+    auto const rows = ui->batchTableWidget->selectionModel( )->selectedRows( );
+
+    if ( rows.isEmpty( ) )
     {
-        this->powerOn( );
+        this->batchQueue.cancelAll( );
     }
     else
     {
-        this->powerOff( );
+        for ( auto const & row : rows )
+        {
+            this->batchQueue.cancel( static_cast< ::std::size_t >( row.row( ) ) );
+        }
     }
 
-    QApplication::restoreOverrideCursor( );
+    this->updateBatch( );
 }
 
-auto MainWindow::onRecordButtonToggled(
-    HINALEA_IN bool const checked
+auto MainWindow::onBatchTimerTimeout(
     ) -> void
 {
-    if ( this->operationMode( ) == OperationMode::StaticMode )
+    if ( this->batchQueue.isBusy( ) )
     {
-        if ( checked )
-        {
-            this->record( );
-        }
-        else
-        {
-            this->cancel( );
-        }
+        this->updateBatch( );
     }
     else
     {
-        if ( checked )
-        {
-            auto const id = ::makeTimestamp( ).toStdWString( );
-            auto realtimeDir = ::ioDir( ) / HINALEA_PATH( "realtime" ) / id;
-            this->realtime.save( realtimeDir );
+        this->finishBatch( );
+    }
+}
 
-            /* Realtime saving is a snapshot so reset the record button. */
-            auto const blocker = QSignalBlocker{ ui->recordButton };
-            ui->recordButton->setChecked( false );
-        }
+auto MainWindow::onOpenCubeClicked(
+    ) -> void
+{
+    if ( auto const path = QFileDialog::getOpenFileName(
+            this,
+            QObject::tr( "Open ENVI cube." ),
+            ::pathCast( ::ioDir( ) / HINALEA_PATH( "processed" ) ),
+            QObject::tr( "ENVI cube, chunked cube or raw stream (*.hdr *.raw *.hfc *.hcc *.img *.dat *.bsq *.bil *.bip);;All files (*)" )
+            );
+         not path.isEmpty( ) )
+    {
+        this->openCube( ::pathCast( path ) );
     }
 }
 
-auto MainWindow::onProcessButtonClicked(
+auto MainWindow::onCloseCubeClicked(
     ) -> void
 {
-    this->process( );
+    this->closeCube( );
+}
+
+auto MainWindow::onCubeBandSpinBoxValueChanged(
+    HINALEA_IN int const value
+    ) -> void
+{
+    HINALEA_UNUSED( value );
+
+    if ( this->offlineCube.isOpen( ) )
+    {
+        this->updateOfflineView( );
+    }
 }
 
 auto MainWindow::onCameraComboBoxCurrentIndexChanged(
@@ -2117,6 +4625,8 @@ auto MainWindow::onHorizontalCheckBoxToggled(
         {
             qWarning( ) << "Failed to change horizontal flip:" << checked;
         }
+
+        this->updateCfaPattern( );
     }
 }
 
@@ -2130,6 +4640,8 @@ auto MainWindow::onVerticalCheckBoxToggled(
         {
             qWarning( ) << "Failed to change vertical flip:" << checked;
         }
+
+        this->updateCfaPattern( );
     }
 }
 
@@ -2159,6 +4671,14 @@ auto MainWindow::onExposureSpinBoxValueChanged(
     }
 }
 
+auto MainWindow::onRefreshSpinBoxValueChanged(
+    HINALEA_IN int const value
+    ) -> void
+{
+    HINALEA_UNUSED( value );
+    this->updateImageTimerInterval( );
+}
+
 auto MainWindow::onGainSpinBoxValueChanged(
     HINALEA_IN int const value
     ) -> void
@@ -2212,6 +4732,7 @@ auto MainWindow::onGapIndexSpinBoxValueChanged(
     else if ( this->fpi.is_open( ) )
     {
         this->fpi.set_gap_index( gapIndex );
+        this->liveGapIndex.store( static_cast< ::hinalea::Int >( gapIndex ), ::std::memory_order_relaxed );
     }
 }
 
@@ -2229,7 +4750,49 @@ auto MainWindow::onThresholdSpinBoxValueChanged(
     HINALEA_IN double const value
     ) -> void
 {
-    HINALEA_UNUSED( value );
+    this->classifySettings.store( { this->spectralMeasure( ), value }, ::std::memory_order_relaxed );
+}
+
+auto MainWindow::onProbeComboBoxCurrentIndexChanged(
+    HINALEA_IN int const index
+    ) -> void
+{
+    HINALEA_UNUSED( index );
+    this->probeDraft.clear( );
+    this->updateProbeDraft( );
+}
+
+auto MainWindow::onProbeStatisticComboBoxCurrentIndexChanged(
+    HINALEA_IN int const index
+    ) -> void
+{
+    HINALEA_UNUSED( index );
+
+    /* NOTE: Forces the next series update to redraw the probes with the new statistic. */
+    this->probeGeneration = 0;
+
+    if ( this->offlineCube.isOpen( ) )
+    {
+        this->updateProbeSeries( );
+    }
+}
+
+auto MainWindow::onHistoryBudgetSpinBoxValueChanged(
+    HINALEA_IN int const value
+    ) -> void
+{
+    this->spectralHistory.setByteBudget( static_cast< ::std::size_t >( value ) << 20 );
+}
+
+auto MainWindow::onMeasureComboBoxCurrentIndexChanged(
+    HINALEA_IN int const index
+    ) -> void
+{
+    HINALEA_UNUSED( index );
+
+    auto const previous = this->classifySettings.load( ::std::memory_order_relaxed );
+    this->measureThresholds[ static_cast< ::std::size_t >( previous.measure ) ] = previous.threshold;
+    this->updateThresholdRange( this->spectralMeasure( ) );
 }
 
 auto MainWindow::onLoadSettingsClicked(
@@ -2344,6 +4907,22 @@ auto MainWindow::onLoadGapClicked(
     }
 }
 
+auto MainWindow::onLoadLibraryClicked(
+    ) -> void
+{
+    if ( auto const txt = QFileDialog::getOpenFileName(
+            this,
+            QObject::tr( "Load endmember library file." ),
+            { },
+            QObject::tr( "Endmember library (*.csv *.txt)" )
+            );
+         not txt.isEmpty( ) )
+    {
+        ui->libraryLineEdit->setText( txt );
+        this->updateLibrary( );
+    }
+}
+
 auto MainWindow::onClearSettingsClicked(
     ) -> void
 {
@@ -2384,6 +4963,168 @@ auto MainWindow::onClearGapClicked(
     ui->gapLineEdit->clear( );
 }
 
+auto MainWindow::updateWaterfall(
+    ) -> void
+{
+    auto const shape = this->spectralHistory.shape( );
+    auto const probe = static_cast< ::hinalea::Int >( ui->waterfallProbeSpinBox->value( ) - 1 );
+    auto const columns = ::std::min( shape.capacity, ::maxWaterfallColumns );
+
+    /* NOTE: The image is only reallocated when the history or the probe change, otherwise each new row is one column. */
+    if ( ( shape.epoch != this->waterfallEpoch ) or ( probe != this->waterfallProbe ) or this->waterfallItem->image( ).isNull( ) )
+    {
+        this->waterfallEpoch = shape.epoch;
+        this->waterfallProbe = probe;
+        this->waterfallSequence = shape.begin;
+
+        auto image = QImage{ };
+
+        if ( ( columns > 0 ) and ( shape.bands > 0 ) )
+        {
+            image = QImage{ static_cast< int >( columns ), static_cast< int >( shape.bands ), QImage::Format_RGB32 };
+            image.fill( Qt::black );
+        }
+
+        this->waterfallItem->setImage( ::std::move( image ) );
+        ui->waterfallView->setSceneRect( this->waterfallItem->boundingRect( ) );
+    }
+
+    if ( ( columns == 0 ) or ( probe >= shape.probes ) or ( this->waterfallSequence >= shape.end ) )
+    {
+        return;
+    }
+
+    auto const first = this->spectralHistory.read(
+        shape.epoch,
+        ::std::max( this->waterfallSequence, shape.end - ::std::min( shape.end, static_cast< ::std::uint64_t >( columns ) ) ),
+        shape.end,
+        probe,
+        this->waterfallTimestamps,
+        this->waterfallValues
+        );
+
+    auto & image = this->waterfallItem->mutableImage( );
+    auto const lower = ui->yAxisLowerSpinBox->value( );
+    auto const upper = ui->yAxisUpperSpinBox->value( );
+    auto const bands = static_cast< int >( shape.bands );
+
+    for ( auto i = ::std::size_t{ 0 }; i < this->waterfallTimestamps.size( ); ++i )
+    {
+        auto const column = static_cast< int >( ( first + i ) % static_cast< ::std::uint64_t >( columns ) );
+        auto const * const spectrum = this->waterfallValues.data( ) + i * static_cast< ::std::size_t >( bands );
+
+        /* Time runs along x, the first band is at the bottom. */
+        for ( auto b = 0; b < bands; ++b )
+        {
+            reinterpret_cast< QRgb * >( image.scanLine( bands - 1 - b ) )[ column ] = ::heatColor( spectrum[ b ], lower, upper );
+        }
+
+        this->waterfallItem->imageChanged( QRect{ column, 0, 1, bands } );
+    }
+
+    /* NOTE: New columns overwrite the oldest ones in place, the cursor marks where the next one goes. */
+    this->waterfallSequence = shape.end;
+    auto const cursor = static_cast< qreal >( shape.end % static_cast< ::std::uint64_t >( columns ) );
+    this->waterfallCursor->setLine( cursor, 0, cursor, bands );
+    ui->waterfallView->fitInView( this->waterfallItem, Qt::IgnoreAspectRatio );
+}
+
+auto MainWindow::onClearProbesClicked(
+    ) -> void
+{
+    qDeleteAll( this->probeItems );
+
+    for ( auto * const series : this->probeSeries )
+    {
+        this->chart->removeSeries( series );
+        delete series;
+    }
+
+    this->probeRegions.clear( );
+    this->probeItems.clear( );
+    this->probeSeries.clear( );
+    this->probeDraft.clear( );
+    this->updateProbeDraft( );
+    this->probeSet.setProbes( { }, 0 );
+    this->spectralHistory.setProbes( 0 );
+}
+
+auto MainWindow::onExportHistoryClicked(
+    ) -> void
+{
+    if ( this->isExporting.load( ::std::memory_order_acquire ) )
+    {
+        QMessageBox::information( this, QObject::tr( "Export History" ), QObject::tr( "The previous export is still running." ) );
+        return;
+    }
+
+    auto const txt = QFileDialog::getSaveFileName(
+        this,
+        QObject::tr( "Export spectral history." ),
+        { },
+        QObject::tr( "Comma separated values (*.csv);;Binary (*.bin)" )
+        );
+
+    if ( txt.isEmpty( ) )
+    {
+        return;
+    }
+
+    auto path = ::pathCast( txt );
+    auto const binary = path.extension( ) == ".bin";
+
+    /* NOTE: Band positions are read here, the realtime API is not used from the export thread. */
+    auto bandPositions = ::std::vector< double >{ };
+
+    if ( this->realtime.is_active( ) )
+    {
+        for ( auto const wavelength : this->realtime.band_wavelengths( ) )
+        {
+            bandPositions.push_back( static_cast< double >( wavelength ) );
+        }
+    }
+
+    ::joinThread( this->exportThread );
+    this->isExporting.store( true, ::std::memory_order_release );
+
+    /* The history is only locked per chunk, so acquisition keeps running while the file is written. */
+    this->exportThread = ::std::thread{
+        [ this, HINALEA_CAPTURE( path ), binary, HINALEA_CAPTURE( bandPositions ) ]
+        {
+            try
+            {
+                if ( binary )
+                {
+                    this->spectralHistory.exportBinary( path );
+                }
+                else
+                {
+                    this->spectralHistory.exportCsv( path, bandPositions );
+                }
+            }
+            catch ( ::std::exception const & exc )
+            {
+                Q_EMIT this->threadFailed( QObject::tr( "Export Error" ), QString{ exc.what( ) } );
+            }
+
+            this->isExporting.store( false, ::std::memory_order_release );
+        }
+        };
+}
+
+auto MainWindow::onClearHistoryClicked(
+    ) -> void
+{
+    this->spectralHistory.clear( );
+}
+
+auto MainWindow::onClearLibraryClicked(
+    ) -> void
+{
+    ui->libraryLineEdit->clear( );
+    this->updateLibrary( );
+}
+
 auto MainWindow::onActiveDarkToggled(
     HINALEA_IN bool const checked
     ) -> void
@@ -2403,6 +5144,14 @@ auto MainWindow::onReflectanceCheckBoxToggled(
     }
 }
 
+auto MainWindow::onIndexCheckBoxToggled(
+    HINALEA_IN bool const checked
+    ) -> void
+{
+    HINALEA_UNUSED( checked );
+    this->updateIndexExpression( );
+}
+
 auto MainWindow::onProgressChanged(
     HINALEA_IN int const percent
     ) -> void
@@ -2434,6 +5183,28 @@ auto MainWindow::onThreadFailed(
     QMessageBox::critical( this, title, what );
 }
 
+auto MainWindow::onToneMapModeChanged(
+    HINALEA_IN int const index
+    ) -> void
+{
+    auto const mode = ( index == 1 ) ? ToneMapMode::AutoPercentile : ToneMapMode::WindowLevel;
+    this->toneMapMode.store( mode, ::std::memory_order_relaxed );
+
+    for ( auto * const spinBox : { ui->toneMapLowerSpinBox, ui->toneMapUpperSpinBox } )
+    {
+        spinBox->setEnabled( mode == ToneMapMode::WindowLevel );
+    }
+}
+
+auto MainWindow::onToneMapWindowChanged(
+    ) -> void
+{
+    /* Packed into one atomic so the display thread never sees half of an update. */
+    auto const lower = static_cast< ::std::uint64_t >( qMax( ui->toneMapLowerSpinBox->value( ), 0 ) );
+    auto const upper = static_cast< ::std::uint64_t >( qMax( ui->toneMapUpperSpinBox->value( ), 0 ) );
+    this->toneMapWindow.store( ( lower << 32 ) | upper, ::std::memory_order_relaxed );
+}
+
 auto MainWindow::onXAxisRangeChanged(
     ) -> void
 {
@@ -2480,8 +5251,46 @@ auto MainWindow::classifyCallback(
     HINALEA_IN ::hinalea::Int      const   observations
     ) -> void
 {
-    // FIXME: testing
-    // if ( qIsNull( ui->thresholdSpinBox->value( ) ) )
+    /* NOTE:
+     * Runs on the realtime thread, so only hand the cube over to the classify stage and return.
+     * Classification time no longer cuts into the cube rate; if the stage falls behind, the oldest cubes are dropped.
+     * This callback is the only place the SDK hands out whole cubes, so the per cube work below has nowhere else to
+     * run. `checkCallbackRate` compares the rate of calls with the cube rate and warns if cubes go by without one.
+     */
+    this->callbackCubes.fetch_add( 1, ::std::memory_order_relaxed );
+
+    if ( auto const & spatial = data_cube.spatial;
+         ::std::holds_alternative< ::hinalea::make_data_type_t< ::hinalea::f32 > >( data_cube.data_type( ) ) and
+         ::std::holds_alternative< ::hinalea::Interleave::Bsq_t >( data_cube.interleave( ) ) )
+    {
+        /* NOTE: Probes see every cube, the classify stage may drop cubes when it falls behind. */
+        auto probes = ::hinalea::Int{ };
+        auto bands = ::hinalea::Int{ };
+
+        if ( this->probeSet.reduce( static_cast< ::hinalea::f32 const * >( data_cube.data( ) ), spatial.bands( ), spatial.area( ) ) and
+             this->probeSet.means( this->historySpectra, probes, bands ) )
+        {
+            auto const now = ::std::chrono::system_clock::now( ).time_since_epoch( );
+            this->spectralHistory.push(
+                ::std::chrono::duration_cast< ::std::chrono::nanoseconds >( now ).count( ),
+                this->historySpectra.data( ),
+                probes,
+                bands
+                );
+        }
+
+        /* NOTE: The cube is only copied while an index layer is shown. */
+        if ( this->currentIndexLayer( ) != nullptr )
+        {
+            this->indexStage.submit( static_cast< ::hinalea::f32 const * >( data_cube.data( ) ), spatial.bands( ), spatial.area( ) );
+        }
+
+        this->recordCube( static_cast< ::hinalea::f32 const * >( data_cube.data( ) ), spatial.bands( ), spatial.area( ) );
+    }
+
+    auto const [ measure, threshold ] = this->classifySettings.load( ::std::memory_order_relaxed );
+
+    if ( qIsNull( threshold ) )
     {
         return;
     }
@@ -2499,22 +5308,76 @@ auto MainWindow::classifyCallback(
         );
 
     auto const & spatial = data_cube.spatial;
-    auto const bands = spatial.bands( );
-    auto const area  = spatial.area( );
 
-    auto const cast =
-        [ ]( void const * ptr )
+    this->classifyStage.submit(
+        static_cast< T const * >( data_cube.data( ) ),
+        spatial.bands( ),
+        spatial.area( ),
+        static_cast< T const * >( endmembers ),
+        observations,
+        measure,
+        threshold
+        );
+}
+
+auto MainWindow::classifyJob(
+    HINALEA_IN ClassifyStage::Job const & job
+    ) -> void
+{
+    using T = HINALEA_TYPEOF( this->spectral_metric )::value_type;
+
+    auto const classifySpectralMetric =
+        [ & ]
         {
-            return ::hinalea::non_null{ static_cast< T const * >( ptr ) };
+            auto const cast =
+                [ ]( T const * ptr )
+                {
+                    return ::hinalea::non_null{ ptr };
+                };
+
+            auto const X = ::hinalea::Matrix{ cast( job.cube.data( ) ), job.bands, job.area, true };
+            auto const Y = ::hinalea::Matrix{ cast( job.endmembers.data( ) ), job.observations, job.bands, false };
+
+            this->spectral_metric.fit( X, Y );
+            this->spectral_metric.classify( job.threshold );
         };
 
-    auto const X = ::hinalea::Matrix{ cast( data_cube.data( ) ), bands, area, true };
-    auto const Y = ::hinalea::Matrix{ cast( endmembers ), observations, bands, false };
+    /* NOTE:
+     * A loaded library replaces the spectra picked from the image, as long as it was measured with the cube's bands.
+     * `hinalea::SpectralMetric` only measures spectral angles, every other measure needs the in-project classifier.
+     */
+    if ( auto const library = this->currentLibrary( );
+         library and ( library->bands( ) == job.bands ) )
+    {
+        if ( ( library != this->fittedLibrary ) or ( job.measure != this->fittedMeasure ) )
+        {
+            this->libraryClassifier.fit(
+                job.measure,
+                library->spectra( ),
+                library->observations( ),
+                library->bands( ),
+                library->spectrumClasses( )
+                );
+            this->fittedLibrary = library;
+            this->fittedMeasure = job.measure;
+        }
+
+        this->libraryClassifier.classify( job.cube.data( ), job.area, job.threshold );
+        this->classMap.publish( this->libraryClassifier.classes( ).data( ), this->libraryClassifier.confidence( ).data( ) );
+    }
+    else if ( ( this->classifyEngine( ) == ClassifyEngine::SpectralClassifier ) or ( job.measure != SpectralMeasure::SpectralAngle ) )
+    {
+        this->spectralClassifier.fit( job.measure, job.endmembers.data( ), job.observations, job.bands );
+        this->spectralClassifier.classify( job.cube.data( ), job.area, job.threshold );
 
-    this->spectral_metric.fit( X, Y );
-    this->spectral_metric.classify( ui->thresholdSpinBox->value( ) );
+        this->classMap.publish( this->spectralClassifier.classes( ).data( ) );
+    }
+    else
+    {
+        classifySpectralMetric( );
+        this->classMap.publish( reinterpret_cast< ::std::uint8_t const * >( this->spectral_metric.classes( ).data( ) ) );
+    }
 
-    // FIXME: crashed with [X]'d application?
     Q_EMIT this->doUpdateClassify( );
 }
 
@@ -2534,6 +5397,22 @@ auto MainWindow::mousePressEvent(
     auto const imageViewPos = ui->imageView->mapFromGlobal( globalPos );
     auto const scenePos = ui->imageView->mapToScene( imageViewPos ).toPoint( );
 
+    if ( this->probeTool( ) != ProbeTool::Endmember )
+    {
+        if ( ui->imageView->sceneRect( ).contains( scenePos ) )
+        {
+            this->onProbeClicked( scenePos, event->button( ) == Qt::RightButton );
+        }
+
+        return;
+    }
+
+    if ( this->offlineCube.isOpen( ) )
+    {
+        this->showOfflineSpectrum( scenePos );
+        return;
+    }
+
     if ( ui->imageView->sceneRect( ).contains( scenePos ) )
     {
         qDebug( ) << Q_FUNC_INFO << scenePos;
@@ -2541,11 +5420,11 @@ auto MainWindow::mousePressEvent(
         HINALEA_ASSERT( scenePos.y( ) >= 0 );
         HINALEA_ASSERT( scenePos.x( ) < this->camera.width( ) );
         HINALEA_ASSERT( scenePos.y( ) < this->camera.height( ) );
-        this->endmemberLocation_ = scenePos;
+        this->endmemberLocation_.store( ( ::std::int64_t{ scenePos.y( ) } << 32 ) | scenePos.x( ), ::std::memory_order_relaxed );
         this->realtime.set_endmember_location( scenePos );
     }
     else
     {
-        this->endmemberLocation_ = ::std::nullopt;
+        this->endmemberLocation_.store( -1, ::std::memory_order_relaxed );
     }
 }
@@ -1,13 +1,47 @@
 #pragma once
 
+#include "BandMath.hxx"
+#include "BatchQueue.hxx"
+#include "ChunkedCube.hxx"
+#include "ClassMap.hxx"
+#include "ClassifyStage.hxx"
+#include "CubeRecorder.hxx"
+#include "CubeStage.hxx"
+#include "Demosaic.hxx"
+#include "EndmemberLibrary.hxx"
+#include "EnviCube.hxx"
+#include "FramePool.hxx"
+#include "FrameStatistics.hxx"
+#include "LibraryClassifier.hxx"
+#include "PreTriggerRing.hxx"
+#include "Preview.hxx"
+#include "ProbeSet.hxx"
+#include "RawRecorder.hxx"
+#include "SpectralClassifier.hxx"
+#include "SpectralHistory.hxx"
+#include "StreamCapture.hxx"
+#include "SweepFeed.hxx"
+#include "ToneMap.hxx"
+#include "TripleBuffer.hxx"
+
 #include <Hinalea.h>
 
 #include <QChartGlobal>
+#include <QElapsedTimer>
+#include <QImage>
 #include <QMainWindow>
-#include <QSemaphore>
-
+#include <QPointF>
+#include <QPolygon>
+#include <QRegion>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <thread>
+#include <vector>
 
 #ifdef HINALEA_INTERNAL
 /* NOTE: Free fly mode is undocumented and will __not__ recieve any support from Hinalea for how to use it. */
@@ -31,15 +65,22 @@ QT_CHARTS_END_NAMESPACE
 QT_CHARTS_USE_NAMESPACE
 #endif /* QT_VERSION_CHECK */
 
+class FrameItem;
+
 QT_BEGIN_NAMESPACE
 class QDoubleSpinBox;
-class QGraphicsPixmapItem;
-class QImage;
+class QGraphicsLineItem;
+class QGraphicsPathItem;
+class QPainterPath;
 class QTimer;
 namespace Ui { class MainWindow; }
 QT_END_NAMESPACE
 QT_USE_NAMESPACE
 
+/* Set to false if the chart series should be drawn by the raster engine instead of OpenGL. */
+// inline bool constexpr chart_use_opengl = false;
+inline bool constexpr chart_use_opengl = true;
+
 /* The UI is set to show milliseconds by default. If you wish to use microseconds instead, change the value to `false`. */
 // inline bool constexpr ui_exposure_is_milliseconds = false;
 inline bool constexpr ui_exposure_is_milliseconds = true;
@@ -59,6 +100,23 @@ public:
     enum OperationMode { StaticMode, RealtimeMode };
     Q_ENUM( OperationMode );
 
+    enum class ClassifyEngine { SpectralMetric, SpectralClassifier };
+
+    /* How static recordings are written: by `hinalea::Acquisition` as PNG, or streamed by `RawRecorder`, raw or encoded
+     * by `FrameEncoder`.
+     */
+    enum class RecordFormat { Png, RawStream, CompressedStream };
+
+    /* What a click on the image does: pick the endmember, or draw a probe of the given shape. */
+    enum class ProbeTool { Endmember, Point, Rectangle, Polygon };
+
+    /* Measure and threshold travel together, so a cube is never classified with another measure's threshold. */
+    struct ClassifySettings
+    {
+        SpectralMeasure measure{ SpectralMeasure::SpectralAngle };
+        double threshold{ 0 };
+    };
+
     explicit
     MainWindow(
         HINALEA_IN_OPT QWidget * parent = nullptr
@@ -81,15 +139,15 @@ Q_SIGNALS:
         HINALEA_IN QString what
         );
 
-    void doUpdateImage(
-        );
-
     void doUpdateClassify(
         );
 
     void doUpdateSeries(
         );
 
+    void doUpdateIndex(
+        );
+
     void doUpdateStatistics(
         HINALEA_IN int    min,
         HINALEA_IN int    max,
@@ -99,10 +157,43 @@ Q_SIGNALS:
         );
 
 private:
+    /* Display buffer slot, the image only holds the rendered `region`. */
+    struct DisplayFrame
+    {
+        ::hinalea::Camera::Image image{ };
+        PreviewRegion region{ };
+    };
+
+    /* Chart points of the endmember spectra, in the order of `allSeries`. Unused series are left empty. */
+    struct SeriesFrame
+    {
+        ::std::array< QVector< QPointF >, 4 > points{ };
+    };
+
+    /* Index layer buffer slot, non finite values are transparent. */
+    struct IndexFrame
+    {
+        QImage image{ };
+        ::hinalea::f32 minimum{ };
+        ::hinalea::f32 maximum{ };
+    };
+
+    /* Index expression bound to the bands and resolution of the running cubes. */
+    struct IndexLayer
+    {
+        BandExpression expression{ };
+        ::hinalea::Int width{ };
+        ::hinalea::Int height{ };
+    };
+
     QScopedPointer< Ui::MainWindow > ui;
     QTimer * displayTimer;
-    QGraphicsPixmapItem * displayItem;
-    QGraphicsPixmapItem * classifyItem;
+    QTimer * batchTimer;
+    FrameItem * displayItem;
+    FrameItem * indexItem;
+    FrameItem * classifyItem;
+    FrameItem * waterfallItem;
+    QGraphicsLineItem * waterfallCursor;
     QChart * chart;
     QLineSeries * seriesL; // raw signal luminosity (monochrome) -- also used for processed wavelength mode
     QLineSeries * seriesR; // raw signal red
@@ -117,23 +208,138 @@ private:
     ::hinalea::Realtime realtime{ this->camera, this->fpi };
     ::hinalea::SpectralMetric< ::hinalea::f32 > spectral_metric{ ::hinalea::SpectralMetricType::SpectralAngle };
 
-    ::std::optional< QPoint > endmemberLocation_{ ::std::nullopt };
+    /* Packed as ( y << 32 ) | x and negative while unset. Written by the GUI thread, read by the display thread. */
+    ::std::atomic< ::std::int64_t > endmemberLocation_{ -1 };
+
+    /* Probe statistics are reduced on the realtime thread once per cube, everything else about probes is GUI only. */
+    ProbeSet probeSet{ };
+    QVector< QRegion > probeRegions{ };
+    QVector< QGraphicsPathItem * > probeItems{ };
+    QVector< QLineSeries * > probeSeries{ };
+    QPolygon probeDraft{ }; /* Corners or vertices clicked so far of the probe being drawn. */
+    QGraphicsPathItem * probeDraftItem{ nullptr };
+    ::std::uint64_t probeGeneration{ 0 }; /* Of the results shown in the probe series. */
+
+    /* Mean spectra of the probes over time, pushed by the realtime thread and drawn by the GUI thread as a waterfall. */
+    SpectralHistory spectralHistory{ };
+    ::std::vector< ::hinalea::f32 > historySpectra{ }; /* Only used by the realtime thread. */
+    ::std::uint64_t waterfallEpoch{ 0 };
+    ::std::uint64_t waterfallSequence{ 0 }; /* Next history row to draw. */
+    ::hinalea::Int waterfallProbe{ -1 };
+    ::std::vector< ::std::int64_t > waterfallTimestamps{ };
+    ::std::vector< ::hinalea::f32 > waterfallValues{ };
+
+    /* Replaced by the GUI thread and evaluated on every cube by the realtime thread, null while the layer is hidden. */
+    mutable ::std::mutex indexMutex{ };
+    ::std::shared_ptr< IndexLayer const > indexLayer{ };
+    ::std::vector< ::hinalea::f32 > indexValues{ }; /* Only used by the index stage worker. */
+
+    /* Continuous realtime recording, replaced by the GUI thread and fed by the realtime thread while recording. */
+    mutable ::std::mutex cubeRecorderMutex{ };
+    ::std::shared_ptr< CubeRecorder > cubeRecorder{ };
+
+    /* Cube of the offline viewer, shown while the camera is off. Only used by the GUI thread. */
+    EnviCube offlineCube{ };
+    PreviewRegion offlineRegion{ }; /* Region and band on screen, so an unchanged view is not read again. */
+    ::hinalea::Int offlineBand{ -1 };
+    ::std::vector< ::hinalea::f32 > offlineValues{ };
+
+    FramePool framePool{ };
+
+    /* Cubes from the realtime thread are classified by their own stage, its labels are consumed by the GUI thread.
+     * The stage is declared last so its workers are gone before the class map is destroyed.
+     */
+    ClassMap classMap{ };
+    SpectralClassifier spectralClassifier{ }; /* Only used by the classify stage worker, apart from its threshold ranges. */
+    ::std::atomic< ClassifySettings > classifySettings{ };
+    ::std::array< ::std::optional< double >, spectralMeasureCount > measureThresholds{ }; /* Last threshold of each measure. */
+
+    /* Replaced by the GUI thread, the classify stage worker keeps its own reference while it classifies. */
+    mutable ::std::mutex libraryMutex{ };
+    ::std::shared_ptr< EndmemberLibrary const > library{ };
+
+    /* Only used by the classify stage worker, refit when the library or the measure changes. */
+    LibraryClassifier libraryClassifier{ };
+    ::std::shared_ptr< EndmemberLibrary const > fittedLibrary{ };
+    SpectralMeasure fittedMeasure{ };
+    ClassifyStage classifyStage{ 2 };
+
+    /* Evaluates the index layer off the realtime thread, on a stage of its own so it never queues behind classification.
+     * It only keeps the newest cube, and its jobs are the cube only.
+     */
+    CubeStage< > indexStage{ 1 };
 
-    ::hinalea::Camera::Image displayImage{ };
+    /* Only used by the display thread. */
+    FrameStatisticsKernel frameStatistics{ };
+    ::std::vector< ::std::uint16_t > analysisImage{ }; /* Full precision demosaiced RGBA of the last full frame render. */
+    ToneMapper toneMapper{ };
 
-    ::hinalea::Int displayLinePitch{ };
-    QSemaphore displaySemaphore{ 1 };
+    /* Color filter array of the frames as flipped, set by the GUI thread at power on and on every flip change. */
+    ::std::atomic< CfaPattern > cfaPattern{ CfaPattern::Rggb };
+
+    /* Tone mapping mode and window from the GUI, the window packed as ( lower << 32 ) | upper. */
+    ::std::atomic< ToneMapMode > toneMapMode{ ToneMapMode::WindowLevel };
+    ::std::atomic< ::std::uint64_t > toneMapWindow{ 0 };
+
+    /* Written by the display thread, read by the GUI thread. */
+    TripleBuffer< DisplayFrame > displayBuffer{ };
+    TripleBuffer< SeriesFrame > seriesBuffer{ };
+
+    /* Written by the realtime thread, read by the GUI thread. */
+    TripleBuffer< IndexFrame > indexBuffer{ };
 
-    ::std::mutex displayMutex{ };
+    /* Only used by the display thread. */
+    ::std::chrono::steady_clock::time_point nextSeriesUpdate{ };
+
+    /* Part of the frame visible in the image view, written by the GUI thread and read by the display thread. */
+    ::std::mutex displayRegionMutex{ };
+    PreviewRegion displayRegion{ };
+
+    ::hinalea::Int displayLinePitch{ };
+    ::std::atomic< bool > displayRunning{ false };
+    ::std::atomic< ::hinalea::MicrosecondsI::rep > displayPeriod{ 0 };
+    ::std::atomic< ::hinalea::MicrosecondsI::rep > fetchPeriod{ 0 }; /* Between fetches while every frame is needed. */
+    ::std::atomic< ::hinalea::MicrosecondsI::rep > chartPeriod{ 0 }; /* Between chart updates of the display thread. */
+    ::std::chrono::nanoseconds guiFrameTime{ 0 };
+    ::std::chrono::nanoseconds guiChartTime{ 0 };
+    ::hinalea::Int displayStep{ 1 }; /* Decimation of the frame on screen. */
+    QElapsedTimer displayRateTimer{ };
+    ::std::uint64_t displayedFrames{ 0 };
+
+    /* Cubes delivered to `classifyCallback` by the realtime thread, and their rate as last measured by the GUI thread
+     * against the SDK's cube rate.
+     */
+    ::std::atomic< ::std::uint64_t > callbackCubes{ 0 };
+    ::std::uint64_t callbackCubesSeen{ 0 };
+    QElapsedTimer callbackRateTimer{ };
+    double callbackRate{ 0.0 };
+    int callbackShortSeconds{ 0 };
+    bool callbackShortWarned{ false };
 
     ::std::thread displayThread{ };
     ::std::thread recordThread{ };
     ::std::thread processThread{ };
     ::std::thread realtimeThread{ };
+    ::std::thread exportThread{ };
+    ::std::thread snapshotThread{ };
 
     bool isRecording{ false };
+    ::std::atomic< bool > streamCancelled{ false };
+    SweepFeed sweepFeed{ }; /* Active while the record thread sweeps the FPI, which it owns until then. */
+
+    /* Recorder of the running raw stream, published by the record thread so its telemetry can be shown. */
+    mutable ::std::mutex streamRecorderMutex{ };
+    ::std::shared_ptr< RawRecorder const > streamRecorder{ };
     bool isProcessing{ false };
 
+    /* Captures processed by `processBatch`, each worker with its own processor. Only used by the GUI thread. */
+    BatchQueue batchQueue{ };
+    ::std::atomic< bool > isExporting{ false };
+
+    /* Live frames of the last seconds, filled by the display thread while a static mode camera is on. */
+    PreTriggerRing preTriggerRing{ };
+    ::std::atomic< ::hinalea::Int > liveGapIndex{ 0 }; /* Gap index the FPI was last set to outside of a recording. */
+
     auto loadSettings(
         ) -> void;
 
@@ -149,13 +355,22 @@ private:
     auto initChartView(
         ) -> void;
 
+    auto initWaterfallView(
+        ) -> void;
+
     auto initSpectralMetric(
         ) -> void;
 
-    auto setupClassifyColorTable(
-        HINALEA_INOUT QImage & classifyImage
+    /* Switches the threshold spin box to the range of `measure`, restoring its last threshold. */
+    auto updateThresholdRange(
+        HINALEA_IN SpectralMeasure measure
         ) -> void;
 
+    /* Premultiplied overlay color of each class label. */
+    [[ nodiscard ]]
+    auto classifyColorTable(
+        ) const -> QVector< QRgb >;
+
     [[ nodiscard ]]
     auto settingsPath(
         ) const -> ::hinalea::fs::path;
@@ -176,10 +391,43 @@ private:
     auto gapPath(
         ) const -> ::hinalea::fs::path;
 
+    [[ nodiscard ]]
+    auto libraryPath(
+        ) const -> ::hinalea::fs::path;
+
+    [[ nodiscard ]]
+    auto currentLibrary(
+        ) const -> ::std::shared_ptr< EndmemberLibrary const >;
+
+    [[ nodiscard ]]
+    auto currentIndexLayer(
+        ) const -> ::std::shared_ptr< IndexLayer const >;
+
     [[ nodiscard ]]
     auto exposure(
         ) const -> ::hinalea::MicrosecondsI;
 
+    [[ nodiscard ]]
+    auto refreshRate(
+        ) const -> int;
+
+    /* Chart refreshes per second, independent of the image refresh rate. Spectra are not read at image rates, a higher
+     * rate only costs GUI thread time, which the status bar shows per update.
+     */
+    [[ nodiscard ]]
+    auto chartRefreshRate(
+        ) const -> int;
+
+    /* Memory of the pre-trigger ring, allocated at power on. */
+    [[ nodiscard ]]
+    auto preTriggerBudget(
+        ) const -> ::std::size_t;
+
+    /* How far before the trigger a pre-trigger recording starts. */
+    [[ nodiscard ]]
+    auto preTriggerWindow(
+        ) const -> ::std::chrono::seconds;
+
     [[ nodiscard ]]
     auto gain(
         ) const -> ::hinalea::Real;
@@ -204,6 +452,48 @@ private:
     auto displayChannels(
         ) const -> ::hinalea::Int;
 
+    [[ nodiscard ]]
+    auto rawFrameKey(
+        ) const -> FramePool::Key;
+
+    [[ nodiscard ]]
+    auto displayFrameKey(
+        ) const -> FramePool::Key;
+
+    [[ nodiscard ]]
+    auto displayIsDemosaiced(
+        ) const -> bool;
+
+    /* Stores the pattern of `camera.color_filter_array( )` after the flips for the display thread. */
+    auto updateCfaPattern(
+        ) -> void;
+
+    [[ nodiscard ]]
+    auto demosaicMethod(
+        ) const -> DemosaicMethod;
+
+    auto updateToneMap(
+        HINALEA_IN FrameStatistics const & statistics
+        ) -> void;
+
+    [[ nodiscard ]]
+    auto allocateDisplayImage(
+        ) -> ::hinalea::Camera::Image;
+
+    auto resetDisplayBuffer(
+        ) -> void;
+
+    auto updateDisplayRegion(
+        ) -> void;
+
+    [[ nodiscard ]]
+    auto currentDisplayRegion(
+        ) -> PreviewRegion;
+
+    [[ nodiscard ]]
+    auto displayFormat(
+        ) const -> QImage::Format;
+
     [[ nodiscard ]]
     auto intensityThreshold(
         ) const -> ::hinalea::Int;
@@ -228,6 +518,26 @@ private:
     auto displayMode(
         ) const -> ::hinalea::Realtime::DisplayModeVariant;
 
+    [[ nodiscard ]]
+    auto classifyEngine(
+        ) const -> ClassifyEngine;
+
+    [[ nodiscard ]]
+    auto spectralMeasure(
+        ) const -> SpectralMeasure;
+
+    [[ nodiscard ]]
+    auto recordFormat(
+        ) const -> RecordFormat;
+
+    [[ nodiscard ]]
+    auto probeTool(
+        ) const -> ProbeTool;
+
+    [[ nodiscard ]]
+    auto probeStatistic(
+        ) const -> ::std::vector< ::hinalea::f32 > ProbeSpectra::*;
+
     [[ nodiscard ]]
     auto realtimeMode(
         ) const -> ::hinalea::Realtime::RealtimeModeVariant;
@@ -272,6 +582,11 @@ private:
     auto yAxisRange(
         ) const -> ::std::array< ::hinalea::Real, 2 >;
 
+    /* Band wavelengths of the offline cube, or of the realtime cubes. */
+    [[ nodiscard ]]
+    auto chartWavelengths(
+        ) const -> ::std::vector< double >;
+
     auto powerOn(
         ) -> void;
 
@@ -296,9 +611,69 @@ private:
     auto cancel(
         ) -> void;
 
+    /* Records the pre-trigger window and every new frame until the record button is released. */
+    auto triggerRecording(
+        ) -> void;
+
+    /* Records every Nth realtime cube into `<base>.hcs` until `stopCubeRecording`. */
+    auto startCubeRecording(
+        HINALEA_IN ::hinalea::fs::path const & base,
+        HINALEA_IN ::hinalea::Int              every
+        ) -> void;
+
+    /* Completes the recording and logs its statistics. */
+    auto stopCubeRecording(
+        ) -> void;
+
+    /* Runs on the record thread, sweeps the gap indexes and streams one frame per gap into `<base>.raw`, or encoded into
+     * `<base>.hfc`. The frames come from the display thread through `sweepFeed`, the first one fetched `settle` after
+     * the FPI reached its gap is kept.
+     */
+    auto recordStream(
+        HINALEA_IN ::hinalea::fs::path const & base,
+        HINALEA_IN RecordFormat                format,
+        HINALEA_IN ::std::chrono::nanoseconds  settle
+        ) -> void;
+
+    /* Shows the telemetry of the running raw stream or pre-trigger recording, or keeps that of the last one. */
+    auto updateRecordTelemetry(
+        ) -> void;
+
     auto process(
         ) -> void;
 
+    /* Processes every selected raw data directory, or every directory of a selected folder, on `batchQueue`. */
+    auto processBatch(
+        ) -> void;
+
+    /* Shows the state of every job of the batch and its throughput. */
+    auto updateBatch(
+        ) -> void;
+
+    auto openCube(
+        HINALEA_IN ::hinalea::fs::path const & path
+        ) -> void;
+
+    auto closeCube(
+        ) -> void;
+
+    /* Reads the band on screen from the offline cube, only if the view or the band changed since the last read. */
+    auto updateOfflineView(
+        ) -> void;
+
+    auto showOfflineSpectrum(
+        HINALEA_IN QPoint const & location
+        ) -> void;
+
+    auto reduceOfflineProbes(
+        ) -> void;
+
+    /* Offline cubes hold anything from raw counts to reflectance, so the range follows the data shown. */
+    auto setupOfflineYAxis(
+        HINALEA_IN double lower,
+        HINALEA_IN double upper
+        ) -> void;
+
     auto allSeries(
         ) const -> QVector< QLineSeries * >;
 
@@ -320,6 +695,7 @@ private:
         ) -> void;
 
     auto setupProcess(
+        HINALEA_INOUT ::hinalea::Processor & processor
         ) -> void;
 
     auto setupBitDepth(
@@ -352,6 +728,9 @@ private:
     auto finishProcess(
         ) -> void;
 
+    auto finishBatch(
+        ) -> void;
+
     auto updateCameraType(
         ) -> void;
 
@@ -361,24 +740,108 @@ private:
     auto updateDark(
         ) -> void;
 
+    auto updateLibrary(
+        ) -> void;
+
+    /* Compiles the index expression, and binds it to the camera bands while realtime is active. */
+    auto updateIndexExpression(
+        ) -> void;
+
+    /* Writes every ENVI cube under `dir` as a chunked cube too, a failure is reported on its own and leaves the ENVI
+     * cubes as they are. Runs on a processing or snapshot thread.
+     */
+    auto writeChunkedCubes(
+        HINALEA_IN ::hinalea::fs::path const & dir
+        ) -> void;
+
+    /* Converts the ENVI files a realtime save wrote to `dir` into chunked cubes next to them, on `snapshotThread`. */
+    auto saveChunkedSnapshot(
+        HINALEA_IN ::hinalea::fs::path const & dir
+        ) -> void;
+
+    /* Runs on the realtime thread, hands the cube to the continuous recording if one is running. */
+    auto recordCube(
+        HINALEA_IN ::hinalea::f32 const * cube,
+        HINALEA_IN ::hinalea::Int         bands,
+        HINALEA_IN ::hinalea::Int         area
+        ) -> void;
+
+    /* Runs on the index stage worker. */
+    auto updateIndex(
+        HINALEA_IN ::hinalea::f32 const * cube,
+        HINALEA_IN ::hinalea::Int         bands,
+        HINALEA_IN ::hinalea::Int         area
+        ) -> void;
+
     template <
         typename RealtimeMode
         >
-    auto updateSeries(
+    auto fillSeries(
+        HINALEA_OUT SeriesFrame &  frame,
+        HINALEA_IN  QPoint const & location
+        ) -> void;
+
+    /* Runs on the display thread, publishes the endmember spectra once the chart is due for a refresh. */
+    auto updateSeriesBuffer(
         ) -> void;
 
     auto onUpdateSeries(
         ) -> void;
 
+    auto updateProbeSeries(
+        ) -> void;
+
+    /* Measures the rate of `classifyCallback` once a second and warns, once per session, if it stays well below the
+     * cube rate `cps`: the probes, the spectral history, the index layer and cube recording only see those cubes.
+     */
+    auto checkCallbackRate(
+        HINALEA_IN double cps
+        ) -> void;
+
+    /* Adds a probe covering `region`, outlined by `outline` in the image view. */
+    auto addProbe(
+        HINALEA_IN QRegion const &      region,
+        HINALEA_IN QPainterPath const & outline
+        ) -> void;
+
+    /* Rasterizes the probes for the current camera resolution and hands them to the probe set. */
+    auto updateProbeLayout(
+        ) -> void;
+
+    auto updateProbeDraft(
+        ) -> void;
+
+    /* Draws the history rows pushed since the last update, one column each. */
+    auto updateWaterfall(
+        ) -> void;
+
+    auto onProbeClicked(
+        HINALEA_IN QPoint const & location,
+        HINALEA_IN bool           finish
+        ) -> void;
+
     auto updateImageTimerInterval(
         ) -> void;
 
+    /* Fetches the newest frame, if any, hands it to the consumers that need every frame and renders it if `render`.
+     * Returns whether there was a new frame.
+     */
     auto updateAcquisitionImage(
-        ) -> void;
+        HINALEA_IN bool render
+        ) -> bool;
 
     auto updateRealtimeImage(
         ) -> void;
 
+    auto startDisplayThread(
+        ) -> void;
+
+    auto stopDisplayThread(
+        ) -> void;
+
+    auto runDisplayThread(
+        ) -> void;
+
     auto realtimeReflectanceIsActive(
         ) const -> bool;
 
@@ -400,6 +863,9 @@ private:
     auto onUpdateClassify(
         ) -> void;
 
+    auto onUpdateIndex(
+        ) -> void;
+
     auto onUpdateStatistics(
         HINALEA_IN int    min,
         HINALEA_IN int    max,
@@ -422,6 +888,25 @@ private:
     auto onProcessButtonClicked(
         ) -> void;
 
+    auto onBatchButtonClicked(
+        ) -> void;
+
+    auto onCancelBatchClicked(
+        ) -> void;
+
+    auto onBatchTimerTimeout(
+        ) -> void;
+
+    auto onOpenCubeClicked(
+        ) -> void;
+
+    auto onCloseCubeClicked(
+        ) -> void;
+
+    auto onCubeBandSpinBoxValueChanged(
+        HINALEA_IN int value
+        ) -> void;
+
     auto onCameraComboBoxCurrentIndexChanged(
         HINALEA_IN int index
         ) -> void;
@@ -438,6 +923,10 @@ private:
         HINALEA_IN int value
         ) -> void;
 
+    auto onRefreshSpinBoxValueChanged(
+        HINALEA_IN int value
+        ) -> void;
+
     auto onGainSpinBoxValueChanged(
         HINALEA_IN int value
         ) -> void;
@@ -458,6 +947,22 @@ private:
         HINALEA_IN double value
         ) -> void;
 
+    auto onMeasureComboBoxCurrentIndexChanged(
+        HINALEA_IN int index
+        ) -> void;
+
+    auto onProbeComboBoxCurrentIndexChanged(
+        HINALEA_IN int index
+        ) -> void;
+
+    auto onHistoryBudgetSpinBoxValueChanged(
+        HINALEA_IN int value
+        ) -> void;
+
+    auto onProbeStatisticComboBoxCurrentIndexChanged(
+        HINALEA_IN int index
+        ) -> void;
+
     auto onLoadSettingsClicked(
         ) -> void;
 
@@ -478,6 +983,9 @@ private:
     auto onLoadGapClicked(
         ) -> void;
 
+    auto onLoadLibraryClicked(
+        ) -> void;
+
     auto onClearSettingsClicked(
         ) -> void;
 
@@ -498,6 +1006,18 @@ private:
     auto onClearGapClicked(
         ) -> void;
 
+    auto onClearLibraryClicked(
+        ) -> void;
+
+    auto onClearProbesClicked(
+        ) -> void;
+
+    auto onExportHistoryClicked(
+        ) -> void;
+
+    auto onClearHistoryClicked(
+        ) -> void;
+
     auto onActiveDarkToggled(
         HINALEA_IN bool checked
         ) -> void;
@@ -506,6 +1026,10 @@ private:
         HINALEA_IN bool checked
         ) -> void;
 
+    auto onIndexCheckBoxToggled(
+        HINALEA_IN bool checked
+        ) -> void;
+
     auto onProgressChanged(
         HINALEA_IN int percent
         ) -> void;
@@ -515,6 +1039,13 @@ private:
         HINALEA_IN QString const & what
         ) -> void;
 
+    auto onToneMapModeChanged(
+        HINALEA_IN int index
+        ) -> void;
+
+    auto onToneMapWindowChanged(
+        ) -> void;
+
     auto onXAxisRangeChanged(
         ) -> void;
 
@@ -534,6 +1065,11 @@ private:
         HINALEA_IN ::hinalea::Int              observations
         ) -> void;
 
+    /* Runs on the classify stage worker. */
+    auto classifyJob(
+        HINALEA_IN ClassifyStage::Job const & job
+        ) -> void;
+
     ::hinalea::RealtimeClassifyCallback classifyCallback_{
         [ this ]( auto &&... args )
         {
@@ -0,0 +1,325 @@
+#include "PreTriggerRing.hxx"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+PreTriggerRing::~PreTriggerRing(
+    )
+{
+    this->release( );
+}
+
+auto PreTriggerRing::allocate(
+    HINALEA_IN RawRecorder::Format const & newFormat,
+    HINALEA_IN ::std::size_t         const budget
+    ) -> void
+{
+    HINALEA_ASSERT( ( newFormat.width > 0 ) and ( newFormat.height > 0 ) );
+
+    this->release( );
+
+    auto const rowSize = static_cast< ::std::size_t >( newFormat.width * RawRecorder::bytesPerPixel( newFormat.bitDepth ) );
+    auto const frameSize = rowSize * static_cast< ::std::size_t >( newFormat.height );
+    auto const count = ::std::max< ::std::size_t >( budget / frameSize, 2 );
+
+    /* NOTE: Touch every page now, so the first lap of the ring does not page fault on the grabbing thread. */
+    this->frames = ::std::make_unique_for_overwrite< ::std::byte[ ] >( count * frameSize );
+    ::std::memset( this->frames.get( ), 0, count * frameSize );
+
+    this->format = newFormat;
+    this->rowBytes = rowSize;
+    this->frameBytes = frameSize;
+
+    auto const lock = ::std::scoped_lock{ this->mutex };
+    this->entries.assign( count, Entry{ } );
+    this->head = 0;
+    this->tail = 0;
+    this->stopAt = unbounded;
+    this->triggered = false;
+    this->sequence = 0;
+    this->lastTimestamp.reset( );
+    this->stats = Statistics{ };
+}
+
+auto PreTriggerRing::release(
+    ) -> void
+{
+    this->stop( );
+
+    if ( this->flusher.joinable( ) )
+    {
+        this->flusher.join( );
+    }
+
+    auto const lock = ::std::scoped_lock{ this->mutex };
+    this->entries.clear( );
+    this->entries.shrink_to_fit( );
+    this->frames.reset( );
+    this->frameBytes = 0;
+}
+
+auto PreTriggerRing::isAllocated(
+    ) const noexcept -> bool
+{
+    return this->frames != nullptr;
+}
+
+auto PreTriggerRing::capacity(
+    ) const noexcept -> ::hinalea::Int
+{
+    return static_cast< ::hinalea::Int >( this->entries.size( ) );
+}
+
+auto PreTriggerRing::setFramePeriod(
+    HINALEA_IN ::std::chrono::nanoseconds const period
+    ) -> void
+{
+    auto const lock = ::std::scoped_lock{ this->mutex };
+    this->framePeriod = period;
+
+    /* NOTE: The gap across a change of exposure is not a missed frame. */
+    this->lastTimestamp.reset( );
+}
+
+auto PreTriggerRing::push(
+    HINALEA_IN FrameView const &    frame,
+    HINALEA_IN ::hinalea::Int const gapIndex,
+    HINALEA_IN ::std::int64_t const timestamp
+    ) noexcept -> void
+{
+    auto slot = ::std::size_t{ };
+    auto number = ::std::uint64_t{ };
+
+    {
+        auto const lock = ::std::scoped_lock{ this->mutex };
+
+        if ( this->entries.empty( ) )
+        {
+            return;
+        }
+
+        if ( auto const period = this->framePeriod.count( );
+             this->lastTimestamp and ( period > 0 ) )
+        {
+            auto const gap = timestamp - *this->lastTimestamp;
+            auto const missed = static_cast< ::std::uint64_t >( ::std::max< ::std::int64_t >( ( gap - period / 2 ) / period, 0 ) );
+            this->stats.missed += missed;
+            this->sequence += missed;
+        }
+
+        this->lastTimestamp = timestamp;
+        number = this->sequence++;
+
+        if ( ( frame.width != this->format.width ) or ( frame.height != this->format.height ) or
+             ( RawRecorder::bytesPerPixel( frame.bitDepth ) != RawRecorder::bytesPerPixel( this->format.bitDepth ) ) )
+        {
+            ++this->stats.ignored;
+            return;
+        }
+
+        if ( this->head - this->tail == this->entries.size( ) )
+        {
+            if ( this->triggered )
+            {
+                /* Frames after `stop` are not part of the recording, only those before it count as lost. */
+                if ( this->head < this->stopAt )
+                {
+                    ++this->stats.dropped;
+                }
+
+                return;
+            }
+
+            ++this->tail;
+        }
+
+        slot = static_cast< ::std::size_t >( this->head % this->entries.size( ) );
+    }
+
+    /* NOTE: The slot is past `head`, so neither the flusher nor a trigger looks at it until it is published below. */
+    auto * const target = this->frames.get( ) + slot * this->frameBytes;
+    auto const * const source = static_cast< ::std::byte const * >( frame.data );
+
+    if ( static_cast< ::std::size_t >( frame.linePitch ) == this->rowBytes )
+    {
+        ::std::memcpy( target, source, this->frameBytes );
+    }
+    else
+    {
+        for ( auto y = ::hinalea::Int{ 0 }; y < frame.height; ++y )
+        {
+            ::std::memcpy( target + static_cast< ::std::size_t >( y ) * this->rowBytes, source + y * frame.linePitch, this->rowBytes );
+        }
+    }
+
+    {
+        auto const lock = ::std::scoped_lock{ this->mutex };
+        this->entries[ slot ] = Entry{ gapIndex, timestamp, number };
+        ++this->head;
+        ++this->stats.pushed;
+    }
+
+    this->pushed.notify_one( );
+}
+
+auto PreTriggerRing::trigger(
+    HINALEA_IN ::hinalea::fs::path const &                   base,
+    HINALEA_IN ::std::chrono::nanoseconds              const window,
+    HINALEA_IN ::std::optional< FrameCodecSettings > const & codec,
+    HINALEA_IN Finished                                      finished
+    ) -> bool
+{
+    HINALEA_ASSERT( this->isAllocated( ) );
+
+    {
+        auto const lock = ::std::scoped_lock{ this->mutex };
+
+        if ( this->triggered )
+        {
+            return false;
+        }
+    }
+
+    /* The previous flusher has finished, it only has to be joined. */
+    if ( this->flusher.joinable( ) )
+    {
+        this->flusher.join( );
+    }
+
+    {
+        auto const lock = ::std::scoped_lock{ this->mutex };
+        auto const now = ::std::chrono::system_clock::now( ).time_since_epoch( );
+        auto const oldest = ::std::chrono::duration_cast< ::std::chrono::nanoseconds >( now - window ).count( );
+
+        while ( ( this->tail < this->head ) and ( this->entries[ this->tail % this->entries.size( ) ].timestamp < oldest ) )
+        {
+            ++this->tail;
+        }
+
+        this->triggered = true;
+        this->stopAt = unbounded;
+        this->stats.preTrigger = this->head - this->tail;
+        this->stats.flushed = 0;
+    }
+
+    this->flusher = ::std::thread{ &PreTriggerRing::run, this, base, codec, ::std::move( finished ) };
+    return true;
+}
+
+auto PreTriggerRing::stop(
+    ) -> void
+{
+    {
+        auto const lock = ::std::scoped_lock{ this->mutex };
+
+        if ( this->triggered and ( this->stopAt == unbounded ) )
+        {
+            this->stopAt = this->head;
+        }
+    }
+
+    this->pushed.notify_one( );
+}
+
+auto PreTriggerRing::isFlushing(
+    ) const -> bool
+{
+    auto const lock = ::std::scoped_lock{ this->mutex };
+    return this->triggered;
+}
+
+auto PreTriggerRing::statistics(
+    ) const -> Statistics
+{
+    auto const lock = ::std::scoped_lock{ this->mutex };
+    return this->stats;
+}
+
+auto PreTriggerRing::recording(
+    ) const -> ::std::optional< RawRecorder::Statistics >
+{
+    auto const lock = ::std::scoped_lock{ this->mutex };
+
+    if ( this->recorder == nullptr )
+    {
+        return ::std::nullopt;
+    }
+
+    return this->recorder->statistics( );
+}
+
+auto PreTriggerRing::run(
+    HINALEA_IN ::hinalea::fs::path                   base,
+    HINALEA_IN ::std::optional< FrameCodecSettings > codec,
+    HINALEA_IN Finished                              finished
+    ) -> void
+{
+    auto statistics = RawRecorder::Statistics{ };
+    auto error = ::std::exception_ptr{ };
+
+    /* NOTE: Outlives the try block, `recording` may look at it until the pointer below is cleared. */
+    auto recorder = RawRecorder{ };
+
+    try
+    {
+        recorder.open( base, this->format, this->capacity( ), codec, 4 );
+
+        {
+            auto const lock = ::std::scoped_lock{ this->mutex };
+            this->recorder = &recorder;
+        }
+
+        while ( true )
+        {
+            auto slot = ::std::size_t{ };
+            auto entry = Entry{ };
+
+            {
+                auto lock = ::std::unique_lock{ this->mutex };
+                this->pushed.wait( lock, [ this ]{ return ( this->tail < this->head ) or ( this->tail >= this->stopAt ); } );
+
+                if ( this->tail >= this->stopAt )
+                {
+                    break;
+                }
+
+                slot = static_cast< ::std::size_t >( this->tail % this->entries.size( ) );
+                entry = this->entries[ slot ];
+            }
+
+            /* NOTE: The recorder copies the frame, so the slot is free again as soon as `push` returns. */
+            auto const frame = FrameView{
+                this->frames.get( ) + slot * this->frameBytes,
+                this->format.width,
+                this->format.height,
+                static_cast< ::hinalea::Int >( this->rowBytes ),
+                this->format.bitDepth,
+                };
+
+            recorder.push( frame, entry.gapIndex, entry.timestamp, entry.sequence );
+
+            auto const lock = ::std::scoped_lock{ this->mutex };
+            ++this->tail;
+            ++this->stats.flushed;
+        }
+
+        statistics = recorder.close( );
+    }
+    catch ( ... )
+    {
+        error = ::std::current_exception( );
+    }
+
+    {
+        auto const lock = ::std::scoped_lock{ this->mutex };
+        this->triggered = false;
+        this->stopAt = unbounded;
+        this->recorder = nullptr;
+    }
+
+    if ( finished )
+    {
+        finished( statistics, error );
+    }
+}
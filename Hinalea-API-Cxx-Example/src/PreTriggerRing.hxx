@@ -0,0 +1,161 @@
+#pragma once
+
+#include "FrameCodec.hxx"
+#include "FrameStatistics.hxx"
+#include "RawRecorder.hxx"
+
+#include <Hinalea.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+/* Keeps the most recent live frames in RAM, so a recording triggered by an event starts before the event.
+ *
+ * `allocate` reserves one block for as many frames as fit in a byte budget and touches every page, so `push` only
+ * copies the frame into the next slot and never allocates or faults. Until a trigger the oldest frame is overwritten.
+ * `trigger` hands the frames of the pre-trigger window, oldest first, to a flusher thread that streams them through
+ * `RawRecorder`, followed by every new frame until `stop`. While triggered a full ring drops the newest frame instead
+ * of overwriting one that is not on disk yet, and counts it. Every pushed frame is numbered, so the telemetry of the
+ * recording shows the dropped frames as sequence gaps. So are the frames the grabbing thread missed, which `push` counts
+ * from the gaps between the timestamps once it knows the frame period.
+ *
+ * `allocate` and `release` must not overlap `push`, ie. they belong before the grabbing thread starts and after it
+ * stopped.
+ */
+class PreTriggerRing
+{
+public:
+    struct Statistics
+    {
+        ::std::uint64_t pushed{ };     /* Frames copied into the ring. */
+        ::std::uint64_t ignored{ };    /* Frames of another format than the ring, eg. after a binning change. */
+        ::std::uint64_t dropped{ };    /* Frames lost because the ring was full of frames not yet flushed. */
+        ::std::uint64_t missed{ };     /* Frames never pushed, estimated from the timestamps and the frame period. */
+        ::std::uint64_t preTrigger{ }; /* Frames of the last trigger that were captured before it. */
+        ::std::uint64_t flushed{ };    /* Frames of the last trigger handed to the recorder. */
+    };
+
+    /* Called on the flusher thread once the recording is closed, with the exception that ended it, if any. */
+    using Finished = ::std::function< void ( RawRecorder::Statistics const &, ::std::exception_ptr ) >;
+
+    PreTriggerRing(
+        ) = default;
+
+    ~PreTriggerRing(
+        );
+
+    PreTriggerRing(
+        PreTriggerRing const &
+        ) = delete;
+
+    auto operator=(
+        PreTriggerRing const &
+        ) -> PreTriggerRing & = delete;
+
+    /* Reserves as many frames of `format` as fit in `budget` bytes, at least two. Waits for a running flush. */
+    auto allocate(
+        HINALEA_IN RawRecorder::Format const & format,
+        HINALEA_IN ::std::size_t               budget
+        ) -> void;
+
+    /* Waits for a running flush and frees the ring. */
+    auto release(
+        ) -> void;
+
+    [[ nodiscard ]]
+    auto isAllocated(
+        ) const noexcept -> bool;
+
+    /* Number of frames the ring holds. */
+    [[ nodiscard ]]
+    auto capacity(
+        ) const noexcept -> ::hinalea::Int;
+
+    /* Period of the camera frames, zero if unknown. Frames are pushed up to half a period late, so a gap of one and a
+     * half periods or more between two pushed timestamps counts as a missed frame.
+     */
+    auto setFramePeriod(
+        HINALEA_IN ::std::chrono::nanoseconds period
+        ) -> void;
+
+    /* Copies `frame` into the ring. Only called by the thread that grabs the frames. */
+    auto push(
+        HINALEA_IN FrameView const & frame,
+        HINALEA_IN ::hinalea::Int    gapIndex,
+        HINALEA_IN ::std::int64_t    timestamp
+        ) noexcept -> void;
+
+    /* Starts recording `<base>`, beginning with the frames captured at most `window` before now. Returns false while
+     * the previous recording is still being flushed.
+     */
+    [[ nodiscard ]]
+    auto trigger(
+        HINALEA_IN ::hinalea::fs::path const &                   base,
+        HINALEA_IN ::std::chrono::nanoseconds                    window,
+        HINALEA_IN ::std::optional< FrameCodecSettings > const & codec,
+        HINALEA_IN Finished                                      finished
+        ) -> bool;
+
+    /* Ends the recording at the newest frame, the flusher writes the rest in the background. */
+    auto stop(
+        ) -> void;
+
+    [[ nodiscard ]]
+    auto isFlushing(
+        ) const -> bool;
+
+    [[ nodiscard ]]
+    auto statistics(
+        ) const -> Statistics;
+
+    /* Statistics of the recording being flushed, if any. */
+    [[ nodiscard ]]
+    auto recording(
+        ) const -> ::std::optional< RawRecorder::Statistics >;
+
+private:
+    struct Entry
+    {
+        ::hinalea::Int gapIndex{ };
+        ::std::int64_t timestamp{ };
+        ::std::uint64_t sequence{ };
+    };
+
+    static auto constexpr unbounded = ::std::numeric_limits< ::std::uint64_t >::max( );
+
+    auto run(
+        HINALEA_IN ::hinalea::fs::path                   base,
+        HINALEA_IN ::std::optional< FrameCodecSettings > codec,
+        HINALEA_IN Finished                              finished
+        ) -> void;
+
+    RawRecorder::Format format{ };
+    ::std::size_t frameBytes{ 0 };
+    ::std::size_t rowBytes{ 0 };
+    ::std::unique_ptr< ::std::byte[ ] > frames{ };
+    ::std::thread flusher{ };
+
+    /* Frames `tail` to `head` are in the ring, frame `i` in slot `i % entries.size( )`. */
+    mutable ::std::mutex mutex{ };
+    ::std::condition_variable pushed{ };
+    ::std::vector< Entry > entries{ };
+    ::std::uint64_t head{ 0 };
+    ::std::uint64_t tail{ 0 };
+    ::std::uint64_t stopAt{ unbounded };
+    bool triggered{ false }; /* Set until the flusher has written every frame up to `stopAt`. */
+    ::std::uint64_t sequence{ 0 }; /* Of the next pushed frame, including dropped, ignored and missed ones. */
+    ::std::chrono::nanoseconds framePeriod{ 0 };
+    ::std::optional< ::std::int64_t > lastTimestamp{ };
+    RawRecorder const * recorder{ nullptr }; /* Of the flusher, while it is open. */
+    Statistics stats{ };
+};
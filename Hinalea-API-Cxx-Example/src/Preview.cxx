@@ -0,0 +1,236 @@
+#include "Preview.hxx"
+
+#include "ThreadPool.hxx"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+/* Beyond this the preview has fewer samples than any sensor has rows on a screen. */
+auto constexpr maxStep = ::hinalea::Int{ 64 };
+
+/* Fraction of the visible size rendered beyond each edge of the view. */
+auto constexpr margin = qreal{ 0.25 };
+
+auto rowBands(
+    HINALEA_IN ::hinalea::Int const rows
+    ) -> ::std::size_t
+{
+    auto const bands = ThreadPool::global( ).concurrency( ) * 2;
+    return ::std::max< ::std::size_t >( ( static_cast< ::std::size_t >( rows ) + bands - 1 ) / bands, 8 );
+}
+
+template <
+    typename Sample
+    >
+auto sampleRow(
+    HINALEA_IN FrameView const & raw,
+    HINALEA_IN ::hinalea::Int    y
+    ) noexcept -> Sample const *
+{
+    return reinterpret_cast< Sample const * >( static_cast< ::std::byte const * >( raw.data ) + y * raw.linePitch );
+}
+
+template <
+    typename Sample
+    >
+auto previewMonochromeImpl(
+    HINALEA_IN  FrameView     const &  raw,
+    HINALEA_IN  PreviewRegion const &  region,
+    HINALEA_IN  ::std::uint8_t const * const toneMap,
+    HINALEA_OUT ::std::uint8_t *       const destination,
+    HINALEA_IN  ::hinalea::Int         const destinationLinePitch
+    ) -> void
+{
+    auto const lastIndex = static_cast< Sample >( ( 1 << raw.bitDepth ) - 1 );
+    auto const width = region.outputWidth( );
+    auto const height = region.outputHeight( );
+
+    ThreadPool::global( ).parallelFor(
+        static_cast< ::std::size_t >( height ),
+        ::rowBands( height ),
+        [ & ]( ::std::size_t const begin, ::std::size_t const end )
+        {
+            for ( auto oy = static_cast< ::hinalea::Int >( begin ); oy < static_cast< ::hinalea::Int >( end ); ++oy )
+            {
+                auto const * const row = ::sampleRow< Sample >( raw, region.y + oy * region.step ) + region.x;
+                auto * const output = destination + oy * destinationLinePitch;
+
+                for ( auto ox = ::hinalea::Int{ 0 }; ox < width; ++ox )
+                {
+                    output[ ox ] = toneMap[ ::std::min( row[ ox * region.step ], lastIndex ) ];
+                }
+            }
+        }
+        );
+}
+
+template <
+    typename Sample
+    >
+auto previewColorFilterArrayImpl(
+    HINALEA_IN  FrameView     const &  raw,
+    HINALEA_IN  CfaPattern     const   pattern,
+    HINALEA_IN  PreviewRegion const &  region,
+    HINALEA_IN  ::std::uint8_t const * const toneMap,
+    HINALEA_OUT ::std::uint8_t *       const destination,
+    HINALEA_IN  ::hinalea::Int         const destinationLinePitch
+    ) -> void
+{
+    /* Offset of the red sample in the quad, blue is diagonally opposite and green fills the other two. */
+    auto const redX = ::hinalea::Int{ ( pattern == CfaPattern::Grbg ) or ( pattern == CfaPattern::Bggr ) };
+    auto const redY = ::hinalea::Int{ ( pattern == CfaPattern::Gbrg ) or ( pattern == CfaPattern::Bggr ) };
+    auto const blueX = 1 - redX;
+    auto const blueY = 1 - redY;
+
+    auto const lastIndex = static_cast< ::std::uint32_t >( ( 1 << raw.bitDepth ) - 1 );
+    auto const lastQuadX = ( raw.width  - 2 ) & ~::hinalea::Int{ 1 };
+    auto const lastQuadY = ( raw.height - 2 ) & ~::hinalea::Int{ 1 };
+    auto const width = region.outputWidth( );
+    auto const height = region.outputHeight( );
+
+    auto const map = [ toneMap, lastIndex ]( ::std::uint32_t const value ) noexcept
+    {
+        return toneMap[ ::std::min( value, lastIndex ) ];
+    };
+
+    ThreadPool::global( ).parallelFor(
+        static_cast< ::std::size_t >( height ),
+        ::rowBands( height ),
+        [ & ]( ::std::size_t const begin, ::std::size_t const end )
+        {
+            for ( auto oy = static_cast< ::hinalea::Int >( begin ); oy < static_cast< ::hinalea::Int >( end ); ++oy )
+            {
+                auto const quadY = ::std::min( region.y + oy * region.step, lastQuadY );
+                Sample const * const rows[ 2 ] = {
+                    ::sampleRow< Sample >( raw, quadY ),
+                    ::sampleRow< Sample >( raw, quadY + 1 ),
+                    };
+                auto * output = destination + oy * destinationLinePitch;
+
+                for ( auto ox = ::hinalea::Int{ 0 }; ox < width; ++ox, output += 4 )
+                {
+                    auto const quadX = ::std::min( region.x + ox * region.step, lastQuadX );
+                    auto const red   = ::std::uint32_t{ rows[ redY  ][ quadX + redX  ] };
+                    auto const blue  = ::std::uint32_t{ rows[ blueY ][ quadX + blueX ] };
+                    auto const green = ( ::std::uint32_t{ rows[ redY  ][ quadX + blueX ] }
+                                       + ::std::uint32_t{ rows[ blueY ][ quadX + redX  ] } + 1 ) / 2;
+
+                    output[ 0 ] = map( red );
+                    output[ 1 ] = map( green );
+                    output[ 2 ] = map( blue );
+                    output[ 3 ] = 255;
+                }
+            }
+        }
+        );
+}
+
+} /* namespace anonymous */
+
+auto previewRegion(
+    HINALEA_IN QSize  const & frameSize,
+    HINALEA_IN QRectF const & visible,
+    HINALEA_IN qreal    const scale
+    ) -> PreviewRegion
+{
+    auto const frameWidth  = static_cast< ::hinalea::Int >( frameSize.width( ) );
+    auto const frameHeight = static_cast< ::hinalea::Int >( frameSize.height( ) );
+
+    if ( frameSize.isEmpty( ) or visible.isEmpty( ) or not ( scale > 0 ) )
+    {
+        return { 0, 0, frameWidth, frameHeight, 1 };
+    }
+
+    auto step = ::hinalea::Int{ 1 };
+
+    while ( ( step < ::maxStep ) and ( static_cast< qreal >( step * 2 ) * scale <= 1 ) )
+    {
+        step *= 2;
+    }
+
+    auto const area = visible.adjusted(
+        -visible.width( ) * ::margin,
+        -visible.height( ) * ::margin,
+        visible.width( ) * ::margin,
+        visible.height( ) * ::margin
+        );
+
+    /* Snap to the sampling grid so panning does not make the decimated image shimmer. */
+    auto const align = static_cast< qreal >( step * 2 );
+    auto const snap = [ align ]( qreal const value, ::hinalea::Int const limit, bool const up )
+    {
+        auto const cells = up ? ::std::ceil( value / align ) : ::std::floor( value / align );
+        return ::std::clamp< ::hinalea::Int >( static_cast< ::hinalea::Int >( cells * align ), 0, limit );
+    };
+
+    auto const left   = snap( area.left( )  , frameWidth , false );
+    auto const top    = snap( area.top( )   , frameHeight, false );
+    auto const right  = snap( area.right( ) , frameWidth , true  );
+    auto const bottom = snap( area.bottom( ), frameHeight, true  );
+
+    if ( ( right <= left ) or ( bottom <= top ) )
+    {
+        /* View scrolled entirely past the frame. */
+        return { 0, 0, frameWidth, frameHeight, step };
+    }
+
+    return { left, top, right - left, bottom - top, step };
+}
+
+auto previewMonochrome(
+    HINALEA_IN  FrameView     const &  raw,
+    HINALEA_IN  PreviewRegion const &  region,
+    HINALEA_IN  ::std::uint8_t const * const toneMap,
+    HINALEA_OUT ::std::uint8_t *       const destination,
+    HINALEA_IN  ::hinalea::Int         const destinationLinePitch
+    ) -> void
+{
+    if ( raw.bitDepth <= 8 )
+    {
+        ::previewMonochromeImpl< ::std::uint8_t >( raw, region, toneMap, destination, destinationLinePitch );
+    }
+    else
+    {
+        ::previewMonochromeImpl< ::std::uint16_t >( raw, region, toneMap, destination, destinationLinePitch );
+    }
+}
+
+auto previewColorFilterArray(
+    HINALEA_IN  FrameView     const &  raw,
+    HINALEA_IN  CfaPattern     const   pattern,
+    HINALEA_IN  PreviewRegion const &  region,
+    HINALEA_IN  ::std::uint8_t const * const toneMap,
+    HINALEA_OUT ::std::uint8_t *       const destination,
+    HINALEA_IN  ::hinalea::Int         const destinationLinePitch
+    ) -> void
+{
+    if ( ::hinalea::is_odd( region.step ) or ( raw.width < 2 ) or ( raw.height < 2 ) )
+    {
+        throw ::std::invalid_argument{ "Superpixel preview requires an even step and at least a 2x2 frame." };
+    }
+
+    if ( raw.bitDepth <= 8 )
+    {
+        ::previewColorFilterArrayImpl< ::std::uint8_t >( raw, pattern, region, toneMap, destination, destinationLinePitch );
+    }
+    else
+    {
+        ::previewColorFilterArrayImpl< ::std::uint16_t >( raw, pattern, region, toneMap, destination, destinationLinePitch );
+    }
+}
+
+auto cropFrame(
+    HINALEA_IN FrameView     const & raw,
+    HINALEA_IN PreviewRegion const & region
+    ) noexcept -> FrameView
+{
+    auto const bytesPerSample = ::hinalea::Int{ ( raw.bitDepth <= 8 ) ? 1 : 2 };
+    auto const * const origin = static_cast< ::std::byte const * >( raw.data )
+        + region.y * raw.linePitch
+        + region.x * bytesPerSample;
+
+    return { origin, region.width, region.height, raw.linePitch, raw.bitDepth };
+}
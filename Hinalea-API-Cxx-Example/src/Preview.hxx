@@ -0,0 +1,109 @@
+#pragma once
+
+#include "Demosaic.hxx"
+#include "FrameStatistics.hxx"
+
+#include <Hinalea.h>
+
+#include <QRectF>
+#include <QSize>
+
+#include <cstdint>
+
+/* Part of the sensor frame the display thread renders, and how coarsely. */
+struct PreviewRegion
+{
+    /* In sensor pixels. The origin is a multiple of `2 * step`, which keeps the color filter array phase. */
+    ::hinalea::Int x{ };
+    ::hinalea::Int y{ };
+    ::hinalea::Int width{ };
+    ::hinalea::Int height{ };
+
+    /* Power of two decimation factor, 1 renders every sensor pixel. */
+    ::hinalea::Int step{ 1 };
+
+    [[ nodiscard ]]
+    auto outputWidth(
+        ) const noexcept -> ::hinalea::Int
+    {
+        return ( this->width + this->step - 1 ) / this->step;
+    }
+
+    [[ nodiscard ]]
+    auto outputHeight(
+        ) const noexcept -> ::hinalea::Int
+    {
+        return ( this->height + this->step - 1 ) / this->step;
+    }
+
+    /* Area covered in sensor (ie. scene) coordinates. */
+    [[ nodiscard ]]
+    auto sceneRect(
+        ) const noexcept -> QRectF
+    {
+        return QRectF{
+            static_cast< qreal >( this->x ),
+            static_cast< qreal >( this->y ),
+            static_cast< qreal >( this->width ),
+            static_cast< qreal >( this->height ),
+            };
+    }
+
+    [[ nodiscard ]]
+    auto isFullFrame(
+        HINALEA_IN QSize const & frameSize
+        ) const noexcept -> bool
+    {
+        return ( this->step == 1 )
+            and ( this->x == 0 ) and ( this->y == 0 )
+            and ( this->width == frameSize.width( ) ) and ( this->height == frameSize.height( ) );
+    }
+
+    friend
+    auto operator==(
+        PreviewRegion const &,
+        PreviewRegion const &
+        ) -> bool = default;
+};
+
+/* Region to render for a view showing `visible` (scene coordinates) at `scale` device pixels per sensor pixel.
+ *
+ * Zoomed out views get the coarsest power of two decimation that still has at least one sample per device pixel.
+ * Zoomed in views get full resolution for the visible rect plus a margin, so small pans do not show blank borders
+ * until the next frame arrives. An empty `visible` rect or non-positive `scale` yields the full frame.
+ */
+[[ nodiscard ]]
+auto previewRegion(
+    HINALEA_IN QSize  const & frameSize,
+    HINALEA_IN QRectF const & visible,
+    HINALEA_IN qreal          scale
+    ) -> PreviewRegion;
+
+/* Point samples one raw pixel per `region.step` square through the tone mapping table into 8-bit grayscale. */
+auto previewMonochrome(
+    HINALEA_IN  FrameView     const & raw,
+    HINALEA_IN  PreviewRegion const & region,
+    HINALEA_IN  ::std::uint8_t const * toneMap,
+    HINALEA_OUT ::std::uint8_t *       destination,
+    HINALEA_IN  ::hinalea::Int         destinationLinePitch
+    ) -> void;
+
+/* Superpixel demosaic: one 2x2 color filter array quad per `region.step` square becomes one tone mapped RGBA pixel.
+ *
+ * Requires an even `region.step`; there is nothing to interpolate, so this is much cheaper than `demosaic`.
+ */
+auto previewColorFilterArray(
+    HINALEA_IN  FrameView     const & raw,
+    HINALEA_IN  CfaPattern            pattern,
+    HINALEA_IN  PreviewRegion const & region,
+    HINALEA_IN  ::std::uint8_t const * toneMap,
+    HINALEA_OUT ::std::uint8_t *       destination,
+    HINALEA_IN  ::hinalea::Int         destinationLinePitch
+    ) -> void;
+
+/* Raw frame restricted to the region, for full resolution kernels. Only valid for `region.step == 1`. */
+[[ nodiscard ]]
+auto cropFrame(
+    HINALEA_IN FrameView     const & raw,
+    HINALEA_IN PreviewRegion const & region
+    ) noexcept -> FrameView;
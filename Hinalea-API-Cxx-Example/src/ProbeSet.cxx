@@ -0,0 +1,323 @@
+#include "ProbeSet.hxx"
+
+#include "Simd.hxx"
+
+#include <QRect>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+struct Moments
+{
+    double sum;
+    double squares;
+    ::hinalea::f32 min;
+    ::hinalea::f32 max;
+};
+
+/* Single precision partial sums are flushed into `Moments` after this many samples per lane. */
+auto constexpr flushSamples = ::hinalea::Int{ 512 };
+
+auto probeMomentsScalar(
+    HINALEA_IN ::hinalea::f32 const * const plane,
+    HINALEA_IN PixelSpan const *      const spans,
+    HINALEA_IN ::std::size_t          const count
+    ) -> Moments
+{
+    auto moments = Moments{ 0, 0, ::std::numeric_limits< ::hinalea::f32 >::infinity( ), -::std::numeric_limits< ::hinalea::f32 >::infinity( ) };
+
+    for ( auto s = ::std::size_t{ 0 }; s < count; ++s )
+    {
+        auto const * const values = plane + spans[ s ].offset;
+        auto sum = 0.0f;
+        auto squares = 0.0f;
+
+        for ( auto i = ::hinalea::Int{ 0 }; i < spans[ s ].length; ++i )
+        {
+            auto const value = values[ i ];
+            sum += value;
+            squares += value * value;
+            moments.min = ::std::min( moments.min, value );
+            moments.max = ::std::max( moments.max, value );
+        }
+
+        moments.sum += sum;
+        moments.squares += squares;
+    }
+
+    return moments;
+}
+
+SIMD_TARGET_AVX2
+auto horizontalSumAvx2(
+    HINALEA_IN __m256 const v
+    ) noexcept -> double
+{
+    auto const half = _mm_add_ps( _mm256_castps256_ps128( v ), _mm256_extractf128_ps( v, 1 ) );
+    auto const pair = _mm_add_ps( half, _mm_movehl_ps( half, half ) );
+    return _mm_cvtss_f32( _mm_add_ss( pair, _mm_shuffle_ps( pair, pair, 1 ) ) );
+}
+
+/* The vector accumulators live across all spans of the probe, so the per span cost is one masked tail load rather
+ * than a scalar remainder and a horizontal reduction; probes are mostly short rows where that overhead dominates.
+ */
+SIMD_TARGET_AVX2
+auto probeMomentsAvx2(
+    HINALEA_IN ::hinalea::f32 const * const plane,
+    HINALEA_IN PixelSpan const *      const spans,
+    HINALEA_IN ::std::size_t          const count
+    ) -> Moments
+{
+    auto constexpr lanes = ::hinalea::Int{ 8 };
+    auto const positiveInfinity = _mm256_set1_ps( ::std::numeric_limits< ::hinalea::f32 >::infinity( ) );
+    auto const negativeInfinity = _mm256_set1_ps( -::std::numeric_limits< ::hinalea::f32 >::infinity( ) );
+    auto const lane = _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 );
+
+    auto moments = Moments{ 0, 0, 0, 0 };
+    auto vsum = _mm256_setzero_ps( );
+    auto vsquares = _mm256_setzero_ps( );
+    auto vmin = positiveInfinity;
+    auto vmax = negativeInfinity;
+    auto pending = ::hinalea::Int{ 0 };
+
+    for ( auto s = ::std::size_t{ 0 }; s < count; ++s )
+    {
+        auto const * const values = plane + spans[ s ].offset;
+        auto const length = spans[ s ].length;
+        auto i = ::hinalea::Int{ 0 };
+
+        for ( ; i + lanes <= length; i += lanes )
+        {
+            auto const v = _mm256_loadu_ps( values + i );
+            vsum = _mm256_add_ps( vsum, v );
+            vsquares = _mm256_fmadd_ps( v, v, vsquares );
+            vmin = _mm256_min_ps( vmin, v );
+            vmax = _mm256_max_ps( vmax, v );
+        }
+
+        if ( i < length )
+        {
+            auto const mask = _mm256_cmpgt_epi32( _mm256_set1_epi32( static_cast< int >( length - i ) ), lane );
+            auto const v = _mm256_maskload_ps( values + i, mask );
+            auto const m = _mm256_castsi256_ps( mask );
+            vsum = _mm256_add_ps( vsum, v );
+            vsquares = _mm256_fmadd_ps( v, v, vsquares );
+            vmin = _mm256_min_ps( vmin, _mm256_blendv_ps( positiveInfinity, v, m ) );
+            vmax = _mm256_max_ps( vmax, _mm256_blendv_ps( negativeInfinity, v, m ) );
+        }
+
+        pending += ( length + lanes - 1 ) / lanes;
+
+        if ( pending >= flushSamples )
+        {
+            moments.sum += ::horizontalSumAvx2( vsum );
+            moments.squares += ::horizontalSumAvx2( vsquares );
+            vsum = _mm256_setzero_ps( );
+            vsquares = _mm256_setzero_ps( );
+            pending = 0;
+        }
+    }
+
+    moments.sum += ::horizontalSumAvx2( vsum );
+    moments.squares += ::horizontalSumAvx2( vsquares );
+
+    alignas( 32 ) ::hinalea::f32 mins[ lanes ];
+    alignas( 32 ) ::hinalea::f32 maxs[ lanes ];
+    _mm256_store_ps( mins, vmin );
+    _mm256_store_ps( maxs, vmax );
+    moments.min = *::std::min_element( mins, mins + lanes );
+    moments.max = *::std::max_element( maxs, maxs + lanes );
+
+    return moments;
+}
+
+} /* namespace anonymous */
+
+auto probeSpans(
+    HINALEA_IN QRegion const &      region,
+    HINALEA_IN ::hinalea::Int const width,
+    HINALEA_IN ::hinalea::Int const height
+    ) -> ::std::vector< PixelSpan >
+{
+    auto const clipped = region.intersected( QRect{ 0, 0, static_cast< int >( width ), static_cast< int >( height ) } );
+    auto spans = ::std::vector< PixelSpan >{ };
+
+    /* NOTE: `QRegion` rectangles are disjoint and y-x banded, so every row of every rectangle is its own span. */
+    for ( auto const & rect : clipped )
+    {
+        for ( auto y = rect.top( ); y <= rect.bottom( ); ++y )
+        {
+            spans.push_back( PixelSpan{ ::hinalea::Int{ y } * width + rect.left( ), ::hinalea::Int{ rect.width( ) } } );
+        }
+    }
+
+    ::std::sort(
+        spans.begin( ),
+        spans.end( ),
+        [ ]( PixelSpan const & a, PixelSpan const & b ){ return a.offset < b.offset; }
+        );
+
+    return spans;
+}
+
+auto ProbeSet::setProbes(
+    HINALEA_IN ::std::vector< ::std::vector< PixelSpan > > probes,
+    HINALEA_IN ::hinalea::Int                        const area
+    ) -> void
+{
+    auto next = ::std::make_shared< Layout const >( Layout{ ::std::move( probes ), area } );
+    auto const lock = ::std::scoped_lock{ this->mutex };
+    this->layout = ::std::move( next );
+    this->published.clear( );
+    this->currentGeneration.fetch_add( 1, ::std::memory_order_release );
+}
+
+auto ProbeSet::reduce(
+    HINALEA_IN ::hinalea::f32 const * const cube,
+    HINALEA_IN ::hinalea::Int         const bands,
+    HINALEA_IN ::hinalea::Int         const area
+    ) -> bool
+{
+    return this->reduce(
+        [ cube, area ]( ::hinalea::Int const band, auto const & ){ return cube + band * area; },
+        bands,
+        area
+        );
+}
+
+auto ProbeSet::reduce(
+    HINALEA_IN PlaneSource const &       planes,
+    HINALEA_IN ::hinalea::Int      const bands,
+    HINALEA_IN ::hinalea::Int      const area
+    ) -> bool
+{
+    auto const start = ::std::chrono::steady_clock::now( );
+    auto current = ::std::shared_ptr< Layout const >{ };
+
+    {
+        auto const lock = ::std::scoped_lock{ this->mutex };
+        current = this->layout;
+    }
+
+    if ( current->probes.empty( ) or ( current->area != area ) or ( bands < 1 ) )
+    {
+        return false;
+    }
+
+    auto const avx2 = simd::level( ) == simd::Level::Avx2;
+    auto const count = current->probes.size( );
+    auto const size = static_cast< ::std::size_t >( bands );
+    this->scratch.resize( count );
+
+    for ( auto i = ::std::size_t{ 0 }; i < count; ++i )
+    {
+        auto & out = this->scratch[ i ];
+        out.mean.assign( size, 0.0f );
+        out.deviation.assign( size, 0.0f );
+        out.minimum.assign( size, 0.0f );
+        out.maximum.assign( size, 0.0f );
+        out.pixels = 0;
+
+        for ( auto const & span : current->probes[ i ] )
+        {
+            out.pixels += span.length;
+        }
+    }
+
+    /* NOTE: Bands are the outer loop so every plane is requested once, however many probes read it. */
+    for ( auto b = ::hinalea::Int{ 0 }; b < bands; ++b )
+    {
+        auto const * const plane = planes( b, current->probes );
+        auto const j = static_cast< ::std::size_t >( b );
+
+        for ( auto i = ::std::size_t{ 0 }; i < count; ++i )
+        {
+            auto const & spans = current->probes[ i ];
+            auto & out = this->scratch[ i ];
+
+            if ( out.pixels == 0 )
+            {
+                continue;
+            }
+
+            auto const moments = avx2
+                ? ::probeMomentsAvx2( plane, spans.data( ), spans.size( ) )
+                : ::probeMomentsScalar( plane, spans.data( ), spans.size( ) );
+
+            auto const n = static_cast< double >( out.pixels );
+            auto const mean = moments.sum / n;
+            out.mean[ j ] = static_cast< ::hinalea::f32 >( mean );
+            out.deviation[ j ] = static_cast< ::hinalea::f32 >( ::std::sqrt( ::std::max( moments.squares / n - mean * mean, 0.0 ) ) );
+            out.minimum[ j ] = moments.min;
+            out.maximum[ j ] = moments.max;
+        }
+    }
+
+    {
+        auto const lock = ::std::scoped_lock{ this->mutex };
+
+        /* NOTE: Probes were replaced while reducing, these results belong to the old layout. */
+        if ( this->layout != current )
+        {
+            return false;
+        }
+
+        ::std::swap( this->published, this->scratch );
+        this->currentGeneration.fetch_add( 1, ::std::memory_order_release );
+    }
+
+    this->duration.store(
+        ::std::chrono::duration< double, ::std::milli >( ::std::chrono::steady_clock::now( ) - start ).count( ),
+        ::std::memory_order_relaxed
+        );
+
+    return true;
+}
+
+auto ProbeSet::generation(
+    ) const noexcept -> ::std::uint64_t
+{
+    return this->currentGeneration.load( ::std::memory_order_acquire );
+}
+
+auto ProbeSet::spectra(
+    ) const -> ::std::vector< ProbeSpectra >
+{
+    auto const lock = ::std::scoped_lock{ this->mutex };
+    return this->published;
+}
+
+auto ProbeSet::means(
+    HINALEA_OUT ::std::vector< ::hinalea::f32 > & values,
+    HINALEA_OUT ::hinalea::Int &                  probes,
+    HINALEA_OUT ::hinalea::Int &                  bands
+    ) const -> bool
+{
+    auto const lock = ::std::scoped_lock{ this->mutex };
+
+    if ( this->published.empty( ) )
+    {
+        return false;
+    }
+
+    probes = static_cast< ::hinalea::Int >( this->published.size( ) );
+    bands = static_cast< ::hinalea::Int >( this->published.front( ).mean.size( ) );
+    values.resize( static_cast< ::std::size_t >( probes * bands ) );
+
+    for ( auto p = ::std::size_t{ 0 }; p < this->published.size( ); ++p )
+    {
+        ::std::copy( this->published[ p ].mean.begin( ), this->published[ p ].mean.end( ), values.begin( ) + static_cast< ::std::ptrdiff_t >( p ) * bands );
+    }
+
+    return true;
+}
+
+auto ProbeSet::lastDuration(
+    ) const noexcept -> double
+{
+    return this->duration.load( ::std::memory_order_relaxed );
+}
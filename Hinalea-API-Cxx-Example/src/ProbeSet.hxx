@@ -0,0 +1,116 @@
+#pragma once
+
+#include <Hinalea.h>
+
+#include <QRegion>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/* Horizontal run of pixels of a probe, `offset` is `y * width + x`. */
+struct PixelSpan
+{
+    ::hinalea::Int offset{ };
+    ::hinalea::Int length{ };
+};
+
+/* Per band statistics over the pixels of a probe. */
+struct ProbeSpectra
+{
+    ::std::vector< ::hinalea::f32 > mean{ };
+    ::std::vector< ::hinalea::f32 > deviation{ };
+    ::std::vector< ::hinalea::f32 > minimum{ };
+    ::std::vector< ::hinalea::f32 > maximum{ };
+    ::hinalea::Int pixels{ };
+};
+
+/* Spans covering `region` clipped to a `width x height` image, in row order. */
+[[ nodiscard ]]
+auto probeSpans(
+    HINALEA_IN QRegion const & region,
+    HINALEA_IN ::hinalea::Int  width,
+    HINALEA_IN ::hinalea::Int  height
+    ) -> ::std::vector< PixelSpan >;
+
+/* Region statistics of user defined probes, computed once per cube on the thread delivering the cubes.
+ *
+ * Probes are rasterized into pixel spans up front, so the reduction only streams contiguous runs of each BSQ band
+ * plane through an AVX2 (scalar fallback) sum, sum of squares, min and max kernel. Partial sums are per span in
+ * single precision and are accumulated per probe in double precision. The reduction is single threaded: 16 probes of
+ * 31x31 pixels over 100 bands are about 1.5M samples, well below a millisecond, and sharing the pool with the display
+ * thread would make the cube thread wait on it.
+ *
+ * Probes are replaced by the GUI thread and results are read back by it, both only under a short lock.
+ */
+class ProbeSet
+{
+public:
+    /* Band `band` of a cube as a plane of `area` pixels, of which only the pixels of `probes` are read. */
+    using PlaneSource = ::std::function< ::hinalea::f32 const * (
+        ::hinalea::Int                                      band,
+        ::std::vector< ::std::vector< PixelSpan > > const & probes
+        ) >;
+
+    /* Only probes whose `area` matches the cube are reduced, so a stale layout after a resolution change is skipped. */
+    auto setProbes(
+        HINALEA_IN ::std::vector< ::std::vector< PixelSpan > > probes,
+        HINALEA_IN ::hinalea::Int                              area
+        ) -> void;
+
+    /* `cube` is BSQ, `bands` planes of `area` pixels. Returns whether results were published for this cube. */
+    auto reduce(
+        HINALEA_IN ::hinalea::f32 const * cube,
+        HINALEA_IN ::hinalea::Int         bands,
+        HINALEA_IN ::hinalea::Int         area
+        ) -> bool;
+
+    /* Same for cubes that are not one BSQ block in memory, eg. a mapped `EnviCube`. Planes are requested in order. */
+    auto reduce(
+        HINALEA_IN PlaneSource const & planes,
+        HINALEA_IN ::hinalea::Int      bands,
+        HINALEA_IN ::hinalea::Int      area
+        ) -> bool;
+
+    /* Incremented by every `reduce` that published results. */
+    [[ nodiscard ]]
+    auto generation(
+        ) const noexcept -> ::std::uint64_t;
+
+    [[ nodiscard ]]
+    auto spectra(
+        ) const -> ::std::vector< ProbeSpectra >;
+
+    /* Mean spectra of the last reduced cube as `probes x bands`, row major, into `values`. False if there are none. */
+    [[ nodiscard ]]
+    auto means(
+        HINALEA_OUT ::std::vector< ::hinalea::f32 > & values,
+        HINALEA_OUT ::hinalea::Int &                  probes,
+        HINALEA_OUT ::hinalea::Int &                  bands
+        ) const -> bool;
+
+    /* Duration of the last reduction. */
+    [[ nodiscard ]]
+    auto lastDuration(
+        ) const noexcept -> double;
+
+private:
+    struct Layout
+    {
+        ::std::vector< ::std::vector< PixelSpan > > probes{ };
+        ::hinalea::Int area{ };
+    };
+
+    mutable ::std::mutex mutex{ };
+    ::std::shared_ptr< Layout const > layout{ ::std::make_shared< Layout const >( ) };
+    ::std::vector< ProbeSpectra > published{ };
+
+    /* Only used by the reducing thread. */
+    ::std::vector< ProbeSpectra > scratch{ };
+
+    ::std::atomic< ::std::uint64_t > currentGeneration{ 0 };
+    ::std::atomic< double > duration{ 0 }; /* Milliseconds. */
+};
@@ -0,0 +1,652 @@
+#include "RawRecorder.hxx"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+/* Frame buffers start on a page, so unbuffered writes of whole frames never need a bounce buffer. */
+auto constexpr slotAlignment = ::std::size_t{ 4096 };
+
+auto constexpr indexMagic = "HNLRAWI1";
+auto constexpr codecIndexMagic = "HNLRAWI2";
+
+template <
+    typename T
+    >
+auto writeRaw(
+    HINALEA_INOUT ::std::ofstream & file,
+    HINALEA_IN    T const &         value
+    ) -> void
+{
+    file.write( reinterpret_cast< char const * >( &value ), sizeof( T ) );
+}
+
+template <
+    typename T
+    >
+auto readRaw(
+    HINALEA_INOUT ::std::ifstream & file
+    ) -> T
+{
+    auto value = T{ };
+    file.read( reinterpret_cast< char * >( &value ), sizeof( T ) );
+    return value;
+}
+
+[[ nodiscard ]]
+auto withExtension(
+    HINALEA_IN ::hinalea::fs::path const & base,
+    HINALEA_IN char const *                extension
+    ) -> ::hinalea::fs::path
+{
+    auto path = base;
+    path += extension;
+    return path;
+}
+
+} /* namespace anonymous */
+
+RawRecorder::~RawRecorder(
+    )
+{
+    if ( this->writer.joinable( ) )
+    {
+        try
+        {
+            this->close( );
+        }
+        catch ( ... )
+        {
+            /* NOTE: Errors were already reported by `push`, or the recording is being abandoned. */
+        }
+    }
+}
+
+auto RawRecorder::AlignedDelete::operator( )(
+    HINALEA_IN ::std::byte * const pointer
+    ) const noexcept -> void
+{
+    ::operator delete[ ]( pointer, ::std::align_val_t{ slotAlignment } );
+}
+
+auto RawRecorder::bytesPerPixel(
+    HINALEA_IN ::hinalea::Int const bitDepth
+    ) noexcept -> ::hinalea::Int
+{
+    return ( bitDepth > 8 ) ? 2 : 1;
+}
+
+auto RawRecorder::open(
+    HINALEA_IN     ::hinalea::fs::path const &                   base,
+    HINALEA_IN     Format const &                                newFormat,
+    HINALEA_IN     ::hinalea::Int const                          capacity,
+    HINALEA_IN_OPT ::std::optional< FrameCodecSettings > const & codec,
+    HINALEA_IN     ::hinalea::Int const                          slotCount
+    ) -> void
+{
+    HINALEA_ASSERT( not this->writer.joinable( ) );
+    HINALEA_ASSERT( ( newFormat.width > 0 ) and ( newFormat.height > 0 ) );
+
+    this->basePath = base;
+    this->format = newFormat;
+    this->settings.reset( );
+    this->frameBytes = static_cast< ::std::size_t >( newFormat.width * newFormat.height * bytesPerPixel( newFormat.bitDepth ) );
+
+    auto const rawPath = ::withExtension( base, codec ? ".hfc" : ".raw" );
+    ::hinalea::fs::create_directories( base.parent_path( ) );
+
+    /* NOTE: Unbuffered, so every frame goes to the OS as one write straight from its slot. */
+    this->file = ::std::ofstream{ };
+    this->file.rdbuf( )->pubsetbuf( nullptr, 0 );
+    this->file.open( rawPath, ::std::ios::binary | ::std::ios::trunc );
+
+    if ( not this->file )
+    {
+        throw ::std::runtime_error{ "Failed to create raw recording: " + rawPath.string( ) };
+    }
+
+    /* Reserving the whole recording up front keeps the file contiguous and the writes free of metadata updates.
+     * Encoded frames are rarely larger than raw ones, and the file simply grows past the reservation if they are.
+     */
+    auto error = ::std::error_code{ };
+    ::hinalea::fs::resize_file( rawPath, this->frameBytes * static_cast< ::std::size_t >( ::std::max< ::hinalea::Int >( capacity, 0 ) ), error );
+
+    if ( error )
+    {
+        throw ::std::runtime_error{ "Failed to preallocate raw recording: " + rawPath.string( ) + ": " + error.message( ) };
+    }
+
+    this->slots.clear( );
+    this->freeSlots.clear( );
+    this->queue.clear( );
+    this->index.clear( );
+    this->index.reserve( static_cast< ::std::size_t >( ::std::max< ::hinalea::Int >( capacity, 0 ) ) );
+    this->frameTelemetry.clear( );
+    this->frameTelemetry.reserve( this->index.capacity( ) );
+    this->tracker = TelemetryTracker{ };
+
+    for ( auto i = ::hinalea::Int{ 0 }; i < ::std::max< ::hinalea::Int >( slotCount, 1 ); ++i )
+    {
+        auto slot = ::std::make_unique< Slot >( );
+        slot->data.reset( static_cast< ::std::byte * >( ::operator new[ ]( this->frameBytes, ::std::align_val_t{ slotAlignment } ) ) );
+        this->freeSlots.push_back( slot.get( ) );
+        this->slots.push_back( ::std::move( slot ) );
+    }
+
+    if ( codec )
+    {
+        this->encoder.emplace( *codec );
+    }
+    else
+    {
+        this->encoder.reset( );
+    }
+
+    this->written = 0;
+    this->error = nullptr;
+    this->stats = Statistics{ };
+    this->closing = false;
+    this->opened = Clock::now( );
+    this->writer = ::std::thread{ &RawRecorder::run, this };
+}
+
+auto RawRecorder::setSettings(
+    HINALEA_IN Settings const & newSettings
+    ) -> void
+{
+    this->settings = newSettings;
+}
+
+auto RawRecorder::push(
+    HINALEA_IN FrameView const &    frame,
+    HINALEA_IN ::hinalea::Int  const gapIndex,
+    HINALEA_IN ::std::int64_t  const timestamp,
+    HINALEA_IN ::std::uint64_t const sequence
+    ) -> void
+{
+    HINALEA_ASSERT( ( frame.width == this->format.width ) and ( frame.height == this->format.height ) );
+    HINALEA_ASSERT( bytesPerPixel( frame.bitDepth ) == bytesPerPixel( this->format.bitDepth ) );
+
+    auto const entered = Clock::now( );
+    auto * slot = static_cast< Slot * >( nullptr );
+    auto stalled = false;
+
+    {
+        auto lock = ::std::unique_lock{ this->mutex };
+
+        if ( this->freeSlots.empty( ) and not this->error )
+        {
+            stalled = true;
+            ++this->stats.stalls;
+            this->released.wait( lock, [ this ]{ return ( not this->freeSlots.empty( ) ) or this->error; } );
+        }
+
+        if ( this->error )
+        {
+            ::std::rethrow_exception( this->error );
+        }
+
+        slot = this->freeSlots.back( );
+        this->freeSlots.pop_back( );
+    }
+
+    /* Copy outside the lock, rows are packed so the file has no line padding. */
+    auto const rowBytes = static_cast< ::std::size_t >( this->format.width * bytesPerPixel( this->format.bitDepth ) );
+    auto const * const source = static_cast< ::std::byte const * >( frame.data );
+
+    if ( static_cast< ::std::size_t >( frame.linePitch ) == rowBytes )
+    {
+        ::std::memcpy( slot->data.get( ), source, this->frameBytes );
+    }
+    else
+    {
+        for ( auto y = ::hinalea::Int{ 0 }; y < frame.height; ++y )
+        {
+            ::std::memcpy( slot->data.get( ) + static_cast< ::std::size_t >( y ) * rowBytes, source + y * frame.linePitch, rowBytes );
+        }
+    }
+
+    auto & telemetry = slot->telemetry;
+    telemetry = FrameTelemetry{ };
+    telemetry.timestamp = timestamp;
+    telemetry.sequence = static_cast< ::std::uint32_t >( sequence );
+    telemetry.gapIndex = static_cast< ::std::int32_t >( gapIndex );
+    telemetry.flags = stalled ? ::std::uint32_t{ FrameTelemetry::Stalled } : ::std::uint32_t{ 0 };
+
+    {
+        auto const lock = ::std::scoped_lock{ this->mutex };
+        slot->queuedAt = Clock::now( );
+        telemetry.pushMicroseconds = ::toMicroseconds( slot->queuedAt - entered );
+        this->queue.push_back( slot );
+        this->stats.maxQueued = ::std::max( this->stats.maxQueued, this->queue.size( ) );
+    }
+
+    this->queued.notify_one( );
+}
+
+auto RawRecorder::close(
+    ) -> Statistics
+{
+    if ( not this->writer.joinable( ) )
+    {
+        return this->statistics( );
+    }
+
+    {
+        auto const lock = ::std::scoped_lock{ this->mutex };
+        this->closing = true;
+    }
+
+    this->queued.notify_one( );
+    this->writer.join( );
+    this->file.close( );
+
+    if ( this->error )
+    {
+        ::std::rethrow_exception( this->error );
+    }
+
+    auto const rawPath = ::withExtension( this->basePath, this->encoder ? ".hfc" : ".raw" );
+    ::hinalea::fs::resize_file( rawPath, this->written );
+    this->writeHeader( );
+    this->writeIndex( );
+    this->writeTelemetry( );
+
+    return this->statistics( );
+}
+
+auto RawRecorder::statistics(
+    ) const -> Statistics
+{
+    auto const lock = ::std::scoped_lock{ this->mutex };
+    return this->stats;
+}
+
+auto RawRecorder::run(
+    ) -> void
+{
+    while ( true )
+    {
+        auto * slot = static_cast< Slot * >( nullptr );
+
+        {
+            auto lock = ::std::unique_lock{ this->mutex };
+            this->queued.wait( lock, [ this ]{ return this->closing or ( not this->queue.empty( ) ); } );
+
+            if ( this->queue.empty( ) )
+            {
+                return;
+            }
+
+            slot = this->queue.front( );
+            this->queue.pop_front( );
+        }
+
+        auto const taken = Clock::now( );
+        auto telemetry = slot->telemetry;
+        telemetry.queueMicroseconds = ::toMicroseconds( taken - slot->queuedAt );
+
+        auto const * data = slot->data.get( );
+        auto bytes = this->frameBytes;
+        auto encodeTime = ::std::chrono::nanoseconds{ 0 };
+
+        if ( this->encoder )
+        {
+            auto const start = Clock::now( );
+            auto const rowBytes = this->format.width * bytesPerPixel( this->format.bitDepth );
+            bytes = this->encoder->encode( FrameView{ data, this->format.width, this->format.height, rowBytes, this->format.bitDepth } );
+            data = this->encoder->data( );
+            encodeTime = Clock::now( ) - start;
+        }
+
+        this->file.write( reinterpret_cast< char const * >( data ), static_cast< ::std::streamsize >( bytes ) );
+        auto const failed = not this->file;
+
+        auto dropped = ::std::uint64_t{ 0 };
+
+        if ( not failed )
+        {
+            telemetry.writeMicroseconds = ::toMicroseconds( Clock::now( ) - taken );
+            dropped = this->tracker.classify( telemetry );
+            this->frameTelemetry.push_back( telemetry );
+            this->index.push_back( Entry{ telemetry.timestamp, telemetry.gapIndex, this->written, bytes } );
+            this->written += bytes;
+        }
+
+        {
+            auto const lock = ::std::scoped_lock{ this->mutex };
+            this->freeSlots.push_back( slot );
+
+            if ( failed )
+            {
+                this->error = ::std::make_exception_ptr(
+                    ::std::runtime_error{ "Failed to write raw recording: " + this->basePath.string( ) + ( this->encoder ? ".hfc" : ".raw" ) }
+                    );
+                this->queue.clear( );
+            }
+            else
+            {
+                ++this->stats.frames;
+                this->stats.bytes += bytes;
+                this->stats.rawBytes += this->frameBytes;
+                this->stats.encodeTime += encodeTime;
+                this->stats.telemetry.add( telemetry, dropped );
+                this->stats.elapsed = ::std::chrono::duration_cast< ::std::chrono::nanoseconds >( Clock::now( ) - this->opened );
+            }
+        }
+
+        this->released.notify_one( );
+
+        if ( failed )
+        {
+            return;
+        }
+    }
+}
+
+auto RawRecorder::writeHeader(
+    ) const -> void
+{
+    auto const path = ::withExtension( this->basePath, ".hdr" );
+    auto header = ::std::ofstream{ path, ::std::ios::binary };
+
+    /* NOTE: `bit depth`, `gap index` and the settings are not ENVI keys, ENVI readers keep them as extra fields. */
+    header
+        << "ENVI\n"
+        << "description = {Hinalea raw frames, one band per frame}\n"
+        << "samples = " << this->format.width << '\n'
+        << "lines = " << this->format.height << '\n'
+        << "bands = " << this->index.size( ) << '\n'
+        << "header offset = 0\n"
+        << "file type = ENVI Standard\n"
+        << "data type = " << ( ( bytesPerPixel( this->format.bitDepth ) == 2 ) ? 12 : 1 ) << '\n'
+        << "interleave = bsq\n"
+        << "byte order = 0\n"
+        << "bit depth = " << this->format.bitDepth << '\n'
+        << "gap index = {";
+
+    for ( auto i = ::std::size_t{ 0 }; i < this->index.size( ); ++i )
+    {
+        header << ( ( i == 0 ) ? "" : ", " ) << this->index[ i ].gapIndex;
+    }
+
+    header << "}\n";
+
+    if ( this->settings )
+    {
+        header
+            << "exposure = " << this->settings->exposure << '\n'
+            << "gain = " << this->settings->gain << '\n'
+            << "gain mode = " << this->settings->gainMode << '\n'
+            << "binning = " << this->settings->binning << '\n';
+    }
+
+    if ( this->encoder )
+    {
+        header << "hinalea codec = 1\n";
+    }
+
+    if ( not header.flush( ) )
+    {
+        throw ::std::runtime_error{ "Failed to write raw recording header: " + path.string( ) };
+    }
+}
+
+auto RawRecorder::writeIndex(
+    ) const -> void
+{
+    auto const path = ::withExtension( this->basePath, ".idx" );
+    auto file = ::std::ofstream{ path, ::std::ios::binary };
+
+    file.write( this->encoder ? ::codecIndexMagic : ::indexMagic, 8 );
+    ::writeRaw( file, static_cast< ::std::uint64_t >( this->index.size( ) ) );
+
+    for ( auto const & entry : this->index )
+    {
+        ::writeRaw( file, entry.timestamp );
+        ::writeRaw( file, entry.gapIndex );
+
+        if ( this->encoder )
+        {
+            ::writeRaw( file, entry.offset );
+            ::writeRaw( file, entry.bytes );
+        }
+    }
+
+    if ( not file.flush( ) )
+    {
+        throw ::std::runtime_error{ "Failed to write raw recording index: " + path.string( ) };
+    }
+}
+
+auto RawRecorder::writeTelemetry(
+    ) const -> void
+{
+    auto sidecar = TelemetrySidecar{ };
+    sidecar.summary = this->statistics( ).telemetry;
+    sidecar.frames = this->frameTelemetry;
+    sidecar.write( ::withExtension( this->basePath, ".tlm" ) );
+}
+
+auto RawRecording::open(
+    HINALEA_IN ::hinalea::fs::path base
+    ) -> RawRecording
+{
+    if ( auto const extension = base.extension( );
+         ( extension == ".raw" ) or ( extension == ".hfc" ) or ( extension == ".hdr" ) or ( extension == ".idx" ) )
+    {
+        base.replace_extension( );
+    }
+
+    auto recording = RawRecording{ };
+    auto const headerPath = ::withExtension( base, ".hdr" );
+    auto header = ::std::ifstream{ headerPath };
+
+    if ( not header )
+    {
+        throw ::std::runtime_error{ "Failed to open raw recording header: " + headerPath.string( ) };
+    }
+
+    auto bands = ::hinalea::Int{ -1 };
+    auto dataType = 0;
+    auto codec = 0;
+    auto const settings = [ & ]( ) -> RawRecorder::Settings & { return recording.recordedSettings ? *recording.recordedSettings : recording.recordedSettings.emplace( ); };
+
+    for ( auto line = ::std::string{ }; ::std::getline( header, line ); )
+    {
+        auto const equals = line.find( '=' );
+
+        if ( equals == ::std::string::npos )
+        {
+            continue;
+        }
+
+        auto key = line.substr( 0, equals );
+        key.erase( key.find_last_not_of( " \t" ) + 1 );
+        auto value = ::std::istringstream{ line.substr( equals + 1 ) };
+
+        if ( key == "samples" )
+        {
+            value >> recording.recordedFormat.width;
+        }
+        else if ( key == "lines" )
+        {
+            value >> recording.recordedFormat.height;
+        }
+        else if ( key == "bands" )
+        {
+            value >> bands;
+        }
+        else if ( key == "data type" )
+        {
+            value >> dataType;
+        }
+        else if ( key == "bit depth" )
+        {
+            value >> recording.recordedFormat.bitDepth;
+        }
+        else if ( key == "hinalea codec" )
+        {
+            value >> codec;
+        }
+        else if ( key == "exposure" )
+        {
+            value >> settings( ).exposure;
+        }
+        else if ( key == "gain" )
+        {
+            value >> settings( ).gain;
+        }
+        else if ( key == "gain mode" )
+        {
+            value >> settings( ).gainMode;
+        }
+        else if ( key == "binning" )
+        {
+            value >> settings( ).binning;
+        }
+    }
+
+    if ( recording.recordedFormat.bitDepth == 0 )
+    {
+        recording.recordedFormat.bitDepth = ( dataType == 12 ) ? 16 : 8;
+    }
+
+    auto const indexPath = ::withExtension( base, ".idx" );
+    auto index = ::std::ifstream{ indexPath, ::std::ios::binary };
+    char magic[ 8 ]{ };
+    index.read( magic, sizeof( magic ) );
+    auto const frames = ::readRaw< ::std::uint64_t >( index );
+
+    if ( codec > 1 )
+    {
+        throw ::std::runtime_error{ "Raw recording uses an unknown codec: " + headerPath.string( ) };
+    }
+
+    auto const compressed = ( codec == 1 );
+
+    if ( ( not index ) or ( ::std::memcmp( magic, compressed ? ::codecIndexMagic : ::indexMagic, sizeof( magic ) ) != 0 ) or ( frames != static_cast< ::std::uint64_t >( bands ) ) )
+    {
+        throw ::std::runtime_error{ "Raw recording index does not match its header: " + indexPath.string( ) };
+    }
+
+    recording.timestamps.resize( frames );
+    recording.gapIndexes.resize( frames );
+
+    recording.offsets.resize( compressed ? frames + 1 : 0 );
+
+    for ( auto i = ::std::uint64_t{ 0 }; i < frames; ++i )
+    {
+        recording.timestamps[ i ] = ::readRaw< ::std::int64_t >( index );
+        recording.gapIndexes[ i ] = ::readRaw< ::std::int64_t >( index );
+
+        /* NOTE: Encoded frames are written back to back, so each frame ends where the next starts. */
+        if ( compressed )
+        {
+            auto const offset = ::readRaw< ::std::uint64_t >( index );
+            auto const bytes = ::readRaw< ::std::uint64_t >( index );
+
+            if ( offset != recording.offsets[ i ] )
+            {
+                throw ::std::runtime_error{ "Raw recording index is corrupt: " + indexPath.string( ) };
+            }
+
+            recording.offsets[ i + 1 ] = offset + bytes;
+        }
+    }
+
+    auto const rawPath = ::withExtension( base, compressed ? ".hfc" : ".raw" );
+    recording.file.open( rawPath, ::std::ios::binary );
+
+    if ( ( not index ) or ( not recording.file ) )
+    {
+        throw ::std::runtime_error{ "Failed to open raw recording: " + rawPath.string( ) };
+    }
+
+    return recording;
+}
+
+auto RawRecording::format(
+    ) const noexcept -> RawRecorder::Format const &
+{
+    return this->recordedFormat;
+}
+
+auto RawRecording::frames(
+    ) const noexcept -> ::hinalea::Int
+{
+    return static_cast< ::hinalea::Int >( this->timestamps.size( ) );
+}
+
+auto RawRecording::gapIndex(
+    HINALEA_IN ::hinalea::Int const frame
+    ) const -> ::hinalea::Int
+{
+    return this->gapIndexes.at( static_cast< ::std::size_t >( frame ) );
+}
+
+auto RawRecording::timestamp(
+    HINALEA_IN ::hinalea::Int const frame
+    ) const -> ::std::int64_t
+{
+    return this->timestamps.at( static_cast< ::std::size_t >( frame ) );
+}
+
+auto RawRecording::isCompressed(
+    ) const noexcept -> bool
+{
+    return not this->offsets.empty( );
+}
+
+auto RawRecording::frameOffsets(
+    ) const noexcept -> ::std::vector< ::std::uint64_t > const &
+{
+    return this->offsets;
+}
+
+auto RawRecording::settings(
+    ) const noexcept -> ::std::optional< RawRecorder::Settings > const &
+{
+    return this->recordedSettings;
+}
+
+auto RawRecording::read(
+    HINALEA_IN  ::hinalea::Int const frame,
+    HINALEA_OUT void *         const out
+    ) -> void
+{
+    HINALEA_ASSERT( ( frame >= 0 ) and ( frame < this->frames( ) ) );
+
+    auto const & format = this->recordedFormat;
+    auto const rowBytes = format.width * RawRecorder::bytesPerPixel( format.bitDepth );
+    auto const bytes = rowBytes * format.height;
+
+    if ( this->isCompressed( ) )
+    {
+        auto const first = this->offsets[ static_cast< ::std::size_t >( frame ) ];
+        this->encoded.resize( static_cast< ::std::size_t >( this->offsets[ static_cast< ::std::size_t >( frame ) + 1 ] - first ) );
+        this->file.seekg( static_cast< ::std::streamoff >( first ) );
+        this->file.read( reinterpret_cast< char * >( this->encoded.data( ) ), static_cast< ::std::streamsize >( this->encoded.size( ) ) );
+    }
+    else
+    {
+        this->file.seekg( static_cast< ::std::streamoff >( frame * bytes ) );
+        this->file.read( static_cast< char * >( out ), static_cast< ::std::streamsize >( bytes ) );
+    }
+
+    if ( not this->file )
+    {
+        this->file.clear( );
+        throw ::std::runtime_error{ "Failed to read raw recording frame " + ::std::to_string( frame ) + "." };
+    }
+
+    if ( this->isCompressed( ) )
+    {
+        ::decodeFrame( this->encoded.data( ), this->encoded.size( ), format.width, format.height, format.bitDepth, out, rowBytes );
+    }
+}
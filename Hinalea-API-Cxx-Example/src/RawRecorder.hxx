@@ -0,0 +1,252 @@
+#pragma once
+
+#include "FrameCodec.hxx"
+#include "FrameStatistics.hxx"
+#include "RecordTelemetry.hxx"
+
+#include <Hinalea.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+/* Streams raw frames into one flat binary file instead of one deflated PNG per frame.
+ *
+ * A recording `<base>` is four files: `<base>.raw` holds the frames back to back, tightly packed, 8 bit or little
+ * endian 16 bit; `<base>.hdr` is an ENVI header describing it as a BSQ cube with one band per frame; `<base>.idx` is
+ * the per frame index (see `RawRecording`); `<base>.tlm` is the telemetry of every frame (see `TelemetrySidecar`). The
+ * raw file is preallocated for the expected frame count at `open`.
+ *
+ * `push` only copies the frame into one of a fixed set of slots allocated at `open`, so the acquisition path never
+ * allocates and never touches the disk. A dedicated writer thread writes each slot as one unbuffered, page aligned,
+ * frame sized sequential write. Once every slot waits for the disk, `push` blocks: raw sweeps must not lose frames.
+ *
+ * With a codec, the writer thread compresses each frame with `FrameEncoder`, spreading its stripes over the global
+ * thread pool, and `<base>.hfc` holds the encoded frames back to back instead of `<base>.raw`. The header then carries
+ * a `hinalea codec` key, so ENVI readers refuse the data instead of misreading it, and the index holds the offset and
+ * size of every encoded frame.
+ *
+ * Telemetry costs `push` two clock reads and the writer two more plus a histogram increment per frame, which is
+ * nanoseconds against frame times of milliseconds. Its summary is part of `statistics`, so it can be shown live.
+ */
+class RawRecorder
+{
+public:
+    using Clock = ::std::chrono::steady_clock;
+
+    struct Format
+    {
+        ::hinalea::Int width{ };
+        ::hinalea::Int height{ };
+        ::hinalea::Int bitDepth{ };
+    };
+
+    /* Camera settings the frames were taken with, kept in the header. */
+    struct Settings
+    {
+        double exposure{ }; /* Microseconds. */
+        double gain{ };
+        ::hinalea::Int gainMode{ };
+        ::hinalea::Int binning{ };
+    };
+
+    struct Statistics
+    {
+        ::std::uint64_t frames{ };
+        ::std::uint64_t bytes{ };    /* Written to the data file. */
+        ::std::uint64_t rawBytes{ }; /* Of the frames before encoding. */
+        ::std::uint64_t stalls{ }; /* Pushes that had to wait for a free slot. */
+        ::std::size_t maxQueued{ };
+        ::std::chrono::nanoseconds elapsed{ };    /* From `open` to the last completed write. */
+        ::std::chrono::nanoseconds encodeTime{ }; /* Wall time spent encoding, zero without a codec. */
+        RecordTelemetry telemetry{ };
+    };
+
+    RawRecorder(
+        ) = default;
+
+    ~RawRecorder(
+        );
+
+    RawRecorder(
+        RawRecorder const &
+        ) = delete;
+
+    auto operator=(
+        RawRecorder const &
+        ) -> RawRecorder & = delete;
+
+    /* Creates `<base>.raw`, or `<base>.hfc` with a codec, with room for `capacity` raw frames and allocates `slots` frame
+     * buffers. Throws on I/O errors.
+     */
+    auto open(
+        HINALEA_IN     ::hinalea::fs::path const &                   base,
+        HINALEA_IN     Format const &                                format,
+        HINALEA_IN     ::hinalea::Int                                capacity,
+        HINALEA_IN_OPT ::std::optional< FrameCodecSettings > const & codec = ::std::nullopt,
+        HINALEA_IN     ::hinalea::Int                                slots = 8
+        ) -> void;
+
+    /* Settings written to the header at `close`, none unless set. */
+    auto setSettings(
+        HINALEA_IN Settings const & settings
+        ) -> void;
+
+    /* Copies `frame`, which must match the format of `open`. `sequence` counts every frame the producer had, so a gap
+     * is counted as dropped frames. Rethrows a failed write of an earlier frame.
+     */
+    auto push(
+        HINALEA_IN FrameView const & frame,
+        HINALEA_IN ::hinalea::Int    gapIndex,
+        HINALEA_IN ::std::int64_t    timestamp,
+        HINALEA_IN ::std::uint64_t   sequence
+        ) -> void;
+
+    /* Writes the queued frames, trims the data file to them and writes the header, index and telemetry. Rethrows write
+     * errors.
+     */
+    auto close(
+        ) -> Statistics;
+
+    [[ nodiscard ]]
+    auto statistics(
+        ) const -> Statistics;
+
+    [[ nodiscard ]]
+    static
+    auto bytesPerPixel(
+        HINALEA_IN ::hinalea::Int bitDepth
+        ) noexcept -> ::hinalea::Int;
+
+private:
+    struct AlignedDelete
+    {
+        auto operator( )(
+            HINALEA_IN ::std::byte * pointer
+            ) const noexcept -> void;
+    };
+
+    struct Slot
+    {
+        ::std::unique_ptr< ::std::byte[ ], AlignedDelete > data{ };
+        FrameTelemetry telemetry{ };
+        Clock::time_point queuedAt{ };
+    };
+
+    struct Entry
+    {
+        ::std::int64_t timestamp{ };
+        ::std::int64_t gapIndex{ };
+        ::std::uint64_t offset{ }; /* Of the frame in the data file. */
+        ::std::uint64_t bytes{ };
+    };
+
+    auto run(
+        ) -> void;
+
+    auto writeHeader(
+        ) const -> void;
+
+    auto writeIndex(
+        ) const -> void;
+
+    auto writeTelemetry(
+        ) const -> void;
+
+    ::hinalea::fs::path basePath{ };
+    Format format{ };
+    ::std::optional< Settings > settings{ };
+    ::std::size_t frameBytes{ 0 };
+    ::std::optional< FrameEncoder > encoder{ }; /* Only used by the writer thread until it is joined. */
+    ::std::uint64_t written{ 0 };
+    ::std::ofstream file{ };
+    ::std::thread writer{ };
+    Clock::time_point opened{ };
+
+    mutable ::std::mutex mutex{ };
+    ::std::condition_variable queued{ };
+    ::std::condition_variable released{ };
+    ::std::deque< Slot * > queue{ };
+    ::std::vector< Slot * > freeSlots{ };
+    ::std::vector< ::std::unique_ptr< Slot > > slots{ };
+    ::std::vector< Entry > index{ }; /* Only used by the writer thread until it is joined. */
+    ::std::vector< FrameTelemetry > frameTelemetry{ }; /* As `index`. */
+    TelemetryTracker tracker{ };                       /* As `index`. */
+    ::std::exception_ptr error{ };
+    Statistics stats{ };
+    bool closing{ false };
+};
+
+/* Reads back a recording of `RawRecorder`, decoding the frames of a compressed recording.
+ *
+ * The index is `HNLRAWI1`, a little endian u64 frame count, then per frame an i64 capture timestamp in nanoseconds
+ * since the Unix epoch and an i64 gap index. Frame `i` starts at byte `i * width * height * bytesPerPixel` of the raw
+ * file. A compressed recording has a `HNLRAWI2` index, whose frames also have a u64 offset and u64 size in the `.hfc`
+ * file.
+ */
+class RawRecording
+{
+public:
+    /* `base` is the recording path with or without any of its extensions. Throws if the files do not match. */
+    [[ nodiscard ]]
+    static
+    auto open(
+        HINALEA_IN ::hinalea::fs::path base
+        ) -> RawRecording;
+
+    [[ nodiscard ]]
+    auto format(
+        ) const noexcept -> RawRecorder::Format const &;
+
+    [[ nodiscard ]]
+    auto frames(
+        ) const noexcept -> ::hinalea::Int;
+
+    [[ nodiscard ]]
+    auto gapIndex(
+        HINALEA_IN ::hinalea::Int frame
+        ) const -> ::hinalea::Int;
+
+    [[ nodiscard ]]
+    auto timestamp(
+        HINALEA_IN ::hinalea::Int frame
+        ) const -> ::std::int64_t;
+
+    [[ nodiscard ]]
+    auto isCompressed(
+        ) const noexcept -> bool;
+
+    /* Byte offsets of the frames in the `.hfc` file and the end of the last one, empty unless compressed. */
+    [[ nodiscard ]]
+    auto frameOffsets(
+        ) const noexcept -> ::std::vector< ::std::uint64_t > const &;
+
+    /* Settings of the header, if the recorder had any. */
+    [[ nodiscard ]]
+    auto settings(
+        ) const noexcept -> ::std::optional< RawRecorder::Settings > const &;
+
+    /* Copies one tightly packed frame into `out`. */
+    auto read(
+        HINALEA_IN  ::hinalea::Int frame,
+        HINALEA_OUT void *         out
+        ) -> void;
+
+private:
+    RawRecorder::Format recordedFormat{ };
+    ::std::optional< RawRecorder::Settings > recordedSettings{ };
+    ::std::vector< ::std::int64_t > timestamps{ };
+    ::std::vector< ::std::int64_t > gapIndexes{ };
+    ::std::vector< ::std::uint64_t > offsets{ }; /* Frame offsets and the end of the last frame, compressed only. */
+    ::std::vector< ::std::byte > encoded{ };
+    ::std::ifstream file{ };
+};
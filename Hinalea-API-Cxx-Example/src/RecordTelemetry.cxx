@@ -0,0 +1,221 @@
+#include "RecordTelemetry.hxx"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+static_assert( ::std::endian::native == ::std::endian::little, "Telemetry sidecars are written in native byte order." );
+
+namespace {
+
+auto constexpr sidecarMagic = "HNLTLM01";
+auto constexpr sidecarVersion = ::std::uint32_t{ 1 };
+
+template <
+    typename T
+    >
+auto writeRaw(
+    HINALEA_INOUT ::std::ofstream & file,
+    HINALEA_IN    T const &         value
+    ) -> void
+{
+    file.write( reinterpret_cast< char const * >( &value ), sizeof( T ) );
+}
+
+template <
+    typename T
+    >
+auto readRaw(
+    HINALEA_INOUT ::std::ifstream & file
+    ) -> T
+{
+    auto value = T{ };
+    file.read( reinterpret_cast< char * >( &value ), sizeof( T ) );
+    return value;
+}
+
+} /* namespace anonymous */
+
+auto LatencyHistogram::add(
+    HINALEA_IN ::std::chrono::nanoseconds const latency
+    ) noexcept -> void
+{
+    auto const microseconds = static_cast< ::std::uint64_t >( ::std::max< ::std::int64_t >( latency.count( ) / 1000, 0 ) );
+    auto const bin = ::std::min< ::std::size_t >( static_cast< ::std::size_t >( ::std::bit_width( microseconds ) ), bins - 1 );
+    ++this->binCounts[ bin ];
+    ++this->total;
+    this->longest = ::std::max( this->longest, latency );
+}
+
+auto LatencyHistogram::count(
+    ) const noexcept -> ::std::uint64_t
+{
+    return this->total;
+}
+
+auto LatencyHistogram::max(
+    ) const noexcept -> ::std::chrono::nanoseconds
+{
+    return this->longest;
+}
+
+auto LatencyHistogram::quantile(
+    HINALEA_IN double const q
+    ) const noexcept -> ::std::chrono::nanoseconds
+{
+    if ( this->total == 0 )
+    {
+        return ::std::chrono::nanoseconds{ 0 };
+    }
+
+    auto const rank = static_cast< ::std::uint64_t >( q * static_cast< double >( this->total - 1 ) );
+    auto seen = ::std::uint64_t{ 0 };
+
+    for ( auto bin = ::std::size_t{ 0 }; bin < bins - 1; ++bin )
+    {
+        seen += this->binCounts[ bin ];
+
+        if ( seen > rank )
+        {
+            return ::std::min( ::std::chrono::nanoseconds{ ::std::int64_t{ 1000 } << bin }, this->longest );
+        }
+    }
+
+    return this->longest;
+}
+
+auto LatencyHistogram::counts(
+    ) const noexcept -> ::std::array< ::std::uint64_t, bins > const &
+{
+    return this->binCounts;
+}
+
+auto RecordTelemetry::add(
+    HINALEA_IN FrameTelemetry const & frame,
+    HINALEA_IN ::std::uint64_t  const dropped
+    ) noexcept -> void
+{
+    ++this->frames;
+    this->dropped += dropped;
+    this->late += ( ( frame.flags & FrameTelemetry::Late ) != 0 ) ? 1 : 0;
+    this->stalled += ( ( frame.flags & FrameTelemetry::Stalled ) != 0 ) ? 1 : 0;
+    this->queueWait.add( ::std::chrono::microseconds{ frame.queueMicroseconds } );
+    this->writeLatency.add( ::std::chrono::microseconds{ frame.writeMicroseconds } );
+}
+
+auto TelemetryTracker::classify(
+    HINALEA_INOUT FrameTelemetry & frame
+    ) noexcept -> ::std::uint64_t
+{
+    auto dropped = ::std::uint64_t{ 0 };
+
+    if ( this->frames > 0 )
+    {
+        dropped = ( frame.sequence > this->lastSequence + 1 ) ? frame.sequence - this->lastSequence - 1 : 0;
+
+        /* NOTE: Dropped frames stretch the interval on their own, so only the interval per frame is judged. */
+        auto const interval = static_cast< double >( frame.timestamp - this->lastTimestamp ) / static_cast< double >( dropped + 1 );
+
+        if ( ( this->frames > 4 ) and ( interval > lateFactor * this->meanInterval ) )
+        {
+            frame.flags |= FrameTelemetry::Late;
+        }
+        else
+        {
+            this->meanInterval = ( this->frames == 1 ) ? interval : this->meanInterval + ( interval - this->meanInterval ) / 16.0;
+        }
+    }
+
+    if ( dropped > 0 )
+    {
+        frame.flags |= FrameTelemetry::AfterDrop;
+    }
+
+    ++this->frames;
+    this->lastSequence = frame.sequence;
+    this->lastTimestamp = frame.timestamp;
+    return dropped;
+}
+
+auto TelemetrySidecar::write(
+    HINALEA_IN ::hinalea::fs::path const & path
+    ) const -> void
+{
+    auto file = ::std::ofstream{ path, ::std::ios::binary };
+
+    file.write( ::sidecarMagic, 8 );
+    ::writeRaw( file, ::sidecarVersion );
+    ::writeRaw( file, static_cast< ::std::uint32_t >( LatencyHistogram::bins ) );
+    ::writeRaw( file, this->summary.frames );
+    ::writeRaw( file, this->summary.dropped );
+    ::writeRaw( file, this->summary.late );
+    ::writeRaw( file, this->summary.stalled );
+
+    for ( auto const * const histogram : { &this->summary.queueWait, &this->summary.writeLatency } )
+    {
+        file.write( reinterpret_cast< char const * >( histogram->binCounts.data( ) ), static_cast< ::std::streamsize >( sizeof( histogram->binCounts ) ) );
+        ::writeRaw( file, static_cast< ::std::uint64_t >( histogram->longest.count( ) ) );
+    }
+
+    ::writeRaw( file, static_cast< ::std::uint64_t >( this->frames.size( ) ) );
+    file.write( reinterpret_cast< char const * >( this->frames.data( ) ), static_cast< ::std::streamsize >( sizeof( FrameTelemetry ) * this->frames.size( ) ) );
+
+    if ( not file.flush( ) )
+    {
+        throw ::std::runtime_error{ "Failed to write recording telemetry: " + path.string( ) };
+    }
+}
+
+auto TelemetrySidecar::read(
+    HINALEA_IN ::hinalea::fs::path const & path
+    ) -> TelemetrySidecar
+{
+    auto file = ::std::ifstream{ path, ::std::ios::binary };
+    char magic[ 8 ]{ };
+    file.read( magic, sizeof( magic ) );
+
+    if ( ( not file ) or ( ::std::memcmp( magic, ::sidecarMagic, sizeof( magic ) ) != 0 ) or
+         ( ::readRaw< ::std::uint32_t >( file ) != ::sidecarVersion ) or ( ::readRaw< ::std::uint32_t >( file ) != LatencyHistogram::bins ) )
+    {
+        throw ::std::runtime_error{ "Not a recording telemetry sidecar: " + path.string( ) };
+    }
+
+    auto sidecar = TelemetrySidecar{ };
+    auto & summary = sidecar.summary;
+    summary.frames = ::readRaw< ::std::uint64_t >( file );
+    summary.dropped = ::readRaw< ::std::uint64_t >( file );
+    summary.late = ::readRaw< ::std::uint64_t >( file );
+    summary.stalled = ::readRaw< ::std::uint64_t >( file );
+
+    for ( auto * const histogram : { &summary.queueWait, &summary.writeLatency } )
+    {
+        file.read( reinterpret_cast< char * >( histogram->binCounts.data( ) ), static_cast< ::std::streamsize >( sizeof( histogram->binCounts ) ) );
+        histogram->longest = ::std::chrono::nanoseconds{ ::readRaw< ::std::uint64_t >( file ) };
+
+        for ( auto const count : histogram->binCounts )
+        {
+            histogram->total += count;
+        }
+    }
+
+    sidecar.frames.resize( static_cast< ::std::size_t >( ::readRaw< ::std::uint64_t >( file ) ) );
+    file.read( reinterpret_cast< char * >( sidecar.frames.data( ) ), static_cast< ::std::streamsize >( sizeof( FrameTelemetry ) * sidecar.frames.size( ) ) );
+
+    if ( not file )
+    {
+        throw ::std::runtime_error{ "Recording telemetry is truncated: " + path.string( ) };
+    }
+
+    return sidecar;
+}
+
+auto toMicroseconds(
+    HINALEA_IN ::std::chrono::nanoseconds const duration
+    ) noexcept -> ::std::uint32_t
+{
+    auto const microseconds = ::std::clamp< ::std::int64_t >( duration.count( ) / 1000, 0, ::std::numeric_limits< ::std::uint32_t >::max( ) );
+    return static_cast< ::std::uint32_t >( microseconds );
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <Hinalea.h>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/* Latency histogram with power of two bins: bin 0 counts latencies below 1 us, bin `k` those from `2^(k-1)` to
+ * `2^k` us, and the last bin everything longer. Adding is a bit scan and an increment.
+ */
+class LatencyHistogram
+{
+public:
+    static auto constexpr bins = ::std::size_t{ 24 };
+
+    auto add(
+        HINALEA_IN ::std::chrono::nanoseconds latency
+        ) noexcept -> void;
+
+    [[ nodiscard ]]
+    auto count(
+        ) const noexcept -> ::std::uint64_t;
+
+    [[ nodiscard ]]
+    auto max(
+        ) const noexcept -> ::std::chrono::nanoseconds;
+
+    /* Upper bound of the bin holding quantile `q`, eg. 0.99; zero while empty. */
+    [[ nodiscard ]]
+    auto quantile(
+        HINALEA_IN double q
+        ) const noexcept -> ::std::chrono::nanoseconds;
+
+    [[ nodiscard ]]
+    auto counts(
+        ) const noexcept -> ::std::array< ::std::uint64_t, bins > const &;
+
+private:
+    friend struct TelemetrySidecar;
+
+    ::std::array< ::std::uint64_t, bins > binCounts{ };
+    ::std::uint64_t total{ 0 };
+    ::std::chrono::nanoseconds longest{ 0 };
+};
+
+/* What happened to one recorded frame, 32 bytes in the sidecar. */
+struct FrameTelemetry
+{
+    enum Flag : ::std::uint32_t
+    {
+        Late      = 1, /* Captured more than `lateFactor` typical frame intervals after the previous frame. */
+        Stalled   = 2, /* `push` waited for the writer to free a slot. */
+        AfterDrop = 4, /* Frames before this one were lost, see the sequence numbers. */
+    };
+
+    ::std::int64_t timestamp{ };          /* Capture, in nanoseconds since the Unix epoch. */
+    ::std::uint32_t sequence{ };          /* Numbered by the producer, a gap is a dropped frame. */
+    ::std::int32_t gapIndex{ };
+    ::std::uint32_t pushMicroseconds{ };  /* Spent in `push`, including a stall. */
+    ::std::uint32_t queueMicroseconds{ }; /* From queued to taken by the writer. */
+    ::std::uint32_t writeMicroseconds{ }; /* Encoding and writing. */
+    ::std::uint32_t flags{ };
+};
+
+static_assert( sizeof( FrameTelemetry ) == 32 );
+
+/* Counters and histograms of a recording so far. */
+struct RecordTelemetry
+{
+    ::std::uint64_t frames{ };
+    ::std::uint64_t dropped{ }; /* Sum of the sequence gaps. */
+    ::std::uint64_t late{ };
+    ::std::uint64_t stalled{ };
+    LatencyHistogram queueWait{ };
+    LatencyHistogram writeLatency{ };
+
+    /* Counts a frame classified by `TelemetryTracker`, and the `dropped` frames before it. */
+    auto add(
+        HINALEA_IN FrameTelemetry const & frame,
+        HINALEA_IN ::std::uint64_t        dropped
+        ) noexcept -> void;
+};
+
+/* Classifies frames by their sequence number and capture interval, for the writer thread of one recording. A frame is
+ * late once its interval exceeds `lateFactor` times the running mean of the intervals of frames that were not late.
+ */
+class TelemetryTracker
+{
+public:
+    static auto constexpr lateFactor = 1.5;
+
+    /* Sets the `Late` and `AfterDrop` flags of `frame` and returns how many frames were dropped before it. */
+    auto classify(
+        HINALEA_INOUT FrameTelemetry & frame
+        ) noexcept -> ::std::uint64_t;
+
+private:
+    ::std::uint64_t frames{ 0 };
+    ::std::uint32_t lastSequence{ 0 };
+    ::std::int64_t lastTimestamp{ 0 };
+    double meanInterval{ 0.0 };
+};
+
+/* Telemetry sidecar of a recording, `<base>.tlm`. All integers are little endian.
+ *
+ * "HNLTLM01", u32 version 1, u32 histogram bins, u64 frames, dropped, late and stalled, the u64 queue wait bins, u64
+ * longest queue wait in nanoseconds, the u64 write latency bins, u64 longest write, u64 frame record count, then one
+ * `FrameTelemetry` per recorded frame.
+ */
+struct TelemetrySidecar
+{
+    RecordTelemetry summary{ };
+    ::std::vector< FrameTelemetry > frames{ };
+
+    /* Throws on I/O errors. */
+    auto write(
+        HINALEA_IN ::hinalea::fs::path const & path
+        ) const -> void;
+
+    /* Throws `std::runtime_error` if `path` is not a sidecar. */
+    [[ nodiscard ]]
+    static
+    auto read(
+        HINALEA_IN ::hinalea::fs::path const & path
+        ) -> TelemetrySidecar;
+};
+
+[[ nodiscard ]]
+auto toMicroseconds(
+    HINALEA_IN ::std::chrono::nanoseconds duration
+    ) noexcept -> ::std::uint32_t;
@@ -0,0 +1,76 @@
+#pragma once
+
+#if defined( _MSC_VER )
+#  include <intrin.h>
+#else
+#  include <cpuid.h>
+#endif
+
+#include <immintrin.h>
+
+/* MSVC accepts AVX2 intrinsics in any function, GCC and Clang need the target to be enabled per function. */
+#if defined( _MSC_VER ) && !defined( __clang__ )
+#  define SIMD_TARGET_AVX2
+#  define SIMD_TARGET_SSE41
+#else
+#  define SIMD_TARGET_AVX2  __attribute__(( target( "avx2,fma" ) ))
+#  define SIMD_TARGET_SSE41 __attribute__(( target( "sse4.1" ) ))
+#endif
+
+namespace simd {
+
+enum class Level { Scalar, Sse41, Avx2 };
+
+/* Highest instruction set available on this CPU, detected once. */
+[[ nodiscard ]]
+inline
+auto level(
+    ) noexcept -> Level
+{
+    static auto const detected =
+        [ ]
+        {
+#if defined( _MSC_VER )
+            int info[ 4 ]{ };
+            __cpuid( info, 0 );
+            auto const maxLeaf = info[ 0 ];
+            __cpuid( info, 1 );
+            auto const ecx1 = info[ 2 ];
+            auto ebx7 = 0;
+
+            if ( maxLeaf >= 7 )
+            {
+                __cpuidex( info, 7, 0 );
+                ebx7 = info[ 1 ];
+            }
+
+            auto const osAvx = ( ( ecx1 >> 27 ) & 1 ) and ( ( _xgetbv( 0 ) & 0x6 ) == 0x6 );
+#else
+            unsigned eax{ }, ebx{ }, ecx{ }, edx{ };
+            __get_cpuid( 1, &eax, &ebx, &ecx, &edx );
+            auto const ecx1 = static_cast< int >( ecx );
+            auto ebx7 = 0;
+
+            if ( __get_cpuid_count( 7, 0, &eax, &ebx, &ecx, &edx ) )
+            {
+                ebx7 = static_cast< int >( ebx );
+            }
+
+            auto const osAvx = __builtin_cpu_supports( "avx" );
+#endif
+            if ( osAvx and ( ( ebx7 >> 5 ) & 1 ) )
+            {
+                return Level::Avx2;
+            }
+
+            if ( ( ecx1 >> 19 ) & 1 )
+            {
+                return Level::Sse41;
+            }
+
+            return Level::Scalar;
+        }( );
+    return detected;
+}
+
+} /* namespace simd */
@@ -0,0 +1,330 @@
+#include "SpectralClassifier.hxx"
+
+#include "Simd.hxx"
+#include "ThreadPool.hxx"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+/* Labels are 8-bit and 0 means unclassified. */
+auto constexpr maxObservations = ::hinalea::Int{ 255 };
+
+struct TileScratch
+{
+    ::std::vector< SpectralPixel > pixels{ };
+    ::std::vector< ::hinalea::f32 > row{ };
+    ::std::vector< ::hinalea::f32 > dots{ }; /* `terms x observations x tileSize` */
+};
+
+auto accumulateScalar(
+    HINALEA_IN    ::hinalea::f32 const * const plane,
+    HINALEA_IN    ::hinalea::Int         const begin,
+    HINALEA_IN    ::hinalea::Int         const count,
+    HINALEA_IN    ::hinalea::f32 const * const weights,
+    HINALEA_IN    ::hinalea::Int         const observations,
+    HINALEA_INOUT ::hinalea::f32 *       const dots
+    ) -> void
+{
+    for ( auto e = ::hinalea::Int{ 0 }; e < observations; ++e )
+    {
+        auto * const dot = dots + e * SpectralClassifier::tileSize;
+
+        for ( auto p = begin; p < count; ++p )
+        {
+            dot[ p ] += weights[ e ] * plane[ p ];
+        }
+    }
+}
+
+SIMD_TARGET_AVX2
+auto accumulateAvx2(
+    HINALEA_IN    ::hinalea::f32 const * const plane,
+    HINALEA_IN    ::hinalea::Int         const count,
+    HINALEA_IN    ::hinalea::f32 const * const weights,
+    HINALEA_IN    ::hinalea::Int         const observations,
+    HINALEA_INOUT ::hinalea::f32 *       const dots
+    ) -> void
+{
+    auto constexpr lanes = ::hinalea::Int{ 8 };
+    auto p = ::hinalea::Int{ 0 };
+
+    for ( ; p + lanes <= count; p += lanes )
+    {
+        auto const values = _mm256_loadu_ps( plane + p );
+
+        for ( auto e = ::hinalea::Int{ 0 }; e < observations; ++e )
+        {
+            auto * const dot = dots + e * SpectralClassifier::tileSize + p;
+            _mm256_storeu_ps( dot, _mm256_fmadd_ps( _mm256_set1_ps( weights[ e ] ), values, _mm256_loadu_ps( dot ) ) );
+        }
+    }
+
+    ::accumulateScalar( plane, p, count, weights, observations, dots );
+}
+
+/* `Bands` of 0 means the band count is only known at runtime. */
+template <
+    SpectralMeasure Measure,
+    ::hinalea::Int  Bands
+    >
+auto classifyTiles(
+    HINALEA_IN  ::hinalea::f32 const *    const cube,
+    HINALEA_IN  ::hinalea::Int            const area,
+    HINALEA_IN  ::hinalea::Int            const runtimeBands,
+    HINALEA_IN  ::hinalea::f32 const *    const weights,
+    HINALEA_IN  SpectralEndmember const * const endmembers,
+    HINALEA_IN  ::hinalea::Int            const observations,
+    HINALEA_IN  ::hinalea::f32            const threshold,
+    HINALEA_OUT ::std::uint8_t *          const labels
+    ) -> void
+{
+    using T = SpectralTraits< Measure >;
+
+    auto constexpr tileSize = SpectralClassifier::tileSize;
+    auto constexpr terms = static_cast< ::hinalea::Int >( T::terms );
+    auto const bands = ( Bands > 0 ) ? Bands : runtimeBands;
+    auto const level = simd::level( );
+    auto const tiles = static_cast< ::std::size_t >( ( area + tileSize - 1 ) / tileSize );
+
+    ThreadPool::global( ).parallelFor(
+        tiles,
+        1,
+        [ & ]( ::std::size_t const beginTile, ::std::size_t const endTile )
+        {
+            thread_local auto scratch = ::TileScratch{ };
+            scratch.pixels.resize( static_cast< ::std::size_t >( tileSize ) );
+            scratch.row.resize( static_cast< ::std::size_t >( tileSize ) );
+            scratch.dots.resize( static_cast< ::std::size_t >( terms * observations * tileSize ) );
+
+            for ( auto tile = beginTile; tile < endTile; ++tile )
+            {
+                auto const begin = static_cast< ::hinalea::Int >( tile ) * tileSize;
+                auto const count = ::std::min( tileSize, area - begin );
+
+                ::std::fill( scratch.pixels.begin( ), scratch.pixels.end( ), SpectralPixel{ } );
+                ::std::fill( scratch.dots.begin( ), scratch.dots.end( ), 0.0f );
+
+                for ( auto b = ::hinalea::Int{ 0 }; b < bands; ++b )
+                {
+                    auto const * const plane = cube + b * area + begin;
+
+                    for ( auto p = ::hinalea::Int{ 0 }; p < count; ++p )
+                    {
+                        T::accumulate( scratch.pixels[ static_cast< ::std::size_t >( p ) ], plane[ p ] );
+                    }
+
+                    for ( auto k = ::hinalea::Int{ 0 }; k < terms; ++k )
+                    {
+                        auto const * source = plane;
+
+                        if constexpr ( not T::identityTerms )
+                        {
+                            for ( auto p = ::hinalea::Int{ 0 }; p < count; ++p )
+                            {
+                                scratch.row[ static_cast< ::std::size_t >( p ) ] = T::pixelTerm( static_cast< ::std::size_t >( k ), plane[ p ] );
+                            }
+
+                            source = scratch.row.data( );
+                        }
+
+                        auto const * const bandWeights = weights + ( k * bands + b ) * observations;
+                        auto * const termDots = scratch.dots.data( ) + k * observations * tileSize;
+
+                        if ( level == simd::Level::Avx2 )
+                        {
+                            ::accumulateAvx2( source, count, bandWeights, observations, termDots );
+                        }
+                        else
+                        {
+                            ::accumulateScalar( source, 0, count, bandWeights, observations, termDots );
+                        }
+                    }
+                }
+
+                for ( auto p = ::hinalea::Int{ 0 }; p < count; ++p )
+                {
+                    auto & pixel = scratch.pixels[ static_cast< ::std::size_t >( p ) ];
+                    auto label = ::std::uint8_t{ 0 };
+
+                    if ( T::prepare( pixel, bands ) )
+                    {
+                        auto bestScore = -::std::numeric_limits< ::hinalea::f32 >::infinity( );
+                        auto bestLabel = ::std::uint8_t{ 0 };
+
+                        for ( auto e = ::hinalea::Int{ 0 }; e < observations; ++e )
+                        {
+                            ::hinalea::f32 dots[ T::terms ];
+
+                            for ( auto k = ::hinalea::Int{ 0 }; k < terms; ++k )
+                            {
+                                dots[ k ] = scratch.dots[ static_cast< ::std::size_t >( ( k * observations + e ) * tileSize + p ) ];
+                            }
+
+                            if ( auto const score = T::score( pixel, endmembers[ e ], dots );
+                                 score > bestScore )
+                            {
+                                bestScore = score;
+                                bestLabel = static_cast< ::std::uint8_t >( e + 1 );
+                            }
+                        }
+
+                        label = ( T::distance( bestScore ) <= threshold ) ? bestLabel : ::std::uint8_t{ 0 };
+                    }
+
+                    labels[ begin + p ] = label;
+                }
+            }
+        }
+        );
+}
+
+template <
+    SpectralMeasure Measure
+    >
+auto fitEndmembers(
+    HINALEA_IN  ::hinalea::f32 const *               const endmembers,
+    HINALEA_IN  ::hinalea::Int                       const observations,
+    HINALEA_IN  ::hinalea::Int                       const bands,
+    HINALEA_OUT ::std::vector< ::hinalea::f32 > &          weights,
+    HINALEA_OUT ::std::vector< SpectralEndmember > &       constants
+    ) -> void
+{
+    using T = SpectralTraits< Measure >;
+
+    weights.resize( T::terms * static_cast< ::std::size_t >( bands * observations ) );
+    constants.resize( static_cast< ::std::size_t >( observations ) );
+
+    for ( auto e = ::hinalea::Int{ 0 }; e < observations; ++e )
+    {
+        auto const * const y = endmembers + e * bands;
+        constants[ static_cast< ::std::size_t >( e ) ] = T::endmember( y, bands );
+
+        for ( auto k = ::std::size_t{ 0 }; k < T::terms; ++k )
+        {
+            for ( auto b = ::hinalea::Int{ 0 }; b < bands; ++b )
+            {
+                auto const index = ( static_cast< ::hinalea::Int >( k ) * bands + b ) * observations + e;
+                weights[ static_cast< ::std::size_t >( index ) ] = T::weightTerm( k, y[ b ] );
+            }
+        }
+    }
+}
+
+/* Band counts with their own kernel instantiations. */
+template <
+    ::hinalea::Int... Counts
+    >
+struct BandCounts { };
+
+using CommonBandCounts = BandCounts< 16, 32, 64, 100, 128, 200, 256 >;
+
+template <
+    SpectralMeasure Measure,
+    ::hinalea::Int... Counts,
+    typename...       Args
+    >
+auto dispatchBands(
+    HINALEA_IN BandCounts< Counts... >,
+    HINALEA_IN ::hinalea::Int bands,
+    HINALEA_IN Args &&...     args
+    ) -> void
+{
+    auto const matched = ( ( ( bands == Counts ) and ( ::classifyTiles< Measure, Counts >( args... ), true ) ) or ... );
+
+    if ( not matched )
+    {
+        ::classifyTiles< Measure, 0 >( args... );
+    }
+}
+
+} /* namespace anonymous */
+
+auto SpectralClassifier::thresholdRange(
+    HINALEA_IN SpectralMeasure const measure
+    ) const noexcept -> ThresholdRange
+{
+    return this->ranges[ static_cast< ::std::size_t >( measure ) ];
+}
+
+auto SpectralClassifier::setThresholdLimits(
+    HINALEA_IN SpectralMeasure const measure,
+    HINALEA_IN double          const lower,
+    HINALEA_IN double          const upper
+    ) -> void
+{
+    auto & range = this->ranges[ static_cast< ::std::size_t >( measure ) ];
+    range.lower = ::std::min( lower, upper );
+    range.upper = ::std::max( lower, upper );
+    range.initial = ::std::clamp( range.initial, range.lower, range.upper );
+}
+
+auto SpectralClassifier::fit(
+    HINALEA_IN SpectralMeasure        const newMeasure,
+    HINALEA_IN ::hinalea::f32 const * const newEndmembers,
+    HINALEA_IN ::hinalea::Int         const newObservations,
+    HINALEA_IN ::hinalea::Int         const newBands
+    ) -> void
+{
+    if ( ( newObservations < 1 ) or ( newObservations > ::maxObservations ) or ( newBands < 1 ) )
+    {
+        throw ::std::invalid_argument{ "Spectral classification requires 1 to 255 endmembers and at least 1 band." };
+    }
+
+    this->measure = newMeasure;
+    this->observations = newObservations;
+    this->bands = newBands;
+
+    ::visitSpectralMeasure(
+        newMeasure,
+        [ & ]( auto const tag )
+        {
+            ::fitEndmembers< decltype( tag )::value >( newEndmembers, newObservations, newBands, this->weights, this->endmembers );
+        }
+        );
+}
+
+auto SpectralClassifier::classify(
+    HINALEA_IN ::hinalea::f32 const * const cube,
+    HINALEA_IN ::hinalea::Int         const area,
+    HINALEA_IN double                 const threshold
+    ) -> void
+{
+    if ( this->observations == 0 )
+    {
+        throw ::std::logic_error{ "Spectral classifier was not fit." };
+    }
+
+    this->labels.resize( static_cast< ::std::size_t >( area ) );
+
+    auto const range = this->thresholdRange( this->measure );
+    auto const limit = static_cast< ::hinalea::f32 >( ::std::clamp( threshold, range.lower, range.upper ) );
+
+    ::visitSpectralMeasure(
+        this->measure,
+        [ & ]( auto const tag )
+        {
+            ::dispatchBands< decltype( tag )::value >(
+                ::CommonBandCounts{ },
+                this->bands,
+                cube,
+                area,
+                this->bands,
+                this->weights.data( ),
+                this->endmembers.data( ),
+                this->observations,
+                limit,
+                this->labels.data( )
+                );
+        }
+        );
+}
+
+auto SpectralClassifier::classes(
+    ) const noexcept -> ::std::vector< ::std::uint8_t > const &
+{
+    return this->labels;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "SpectralMeasure.hxx"
+
+#include <Hinalea.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+/* Endmember classifier for BSQ float cubes.
+ *
+ * Each pixel gets the label of the closest endmember, ie. `1 + index` into the endmembers, or 0 if even the closest
+ * one is farther than the threshold. Labels use the same layout as `SpectralMetric::classes`.
+ *
+ * Every measure is expressed through per-pixel sums and one or two dot products between per-sample transforms of the
+ * pixel and of the endmembers (eg. square roots for Jeffries-Matusita, logarithms for SID). The cube is processed in
+ * spatial tiles small enough that those sums stay in L1 while every band plane streams through once. The dot
+ * products are accumulated with AVX2 FMAs (scalar fallback), and tiles are spread across `ThreadPool::global( )`.
+ * Kernels are instantiated per measure and for common band counts, so the band loop has a compile time trip count.
+ * Candidates are compared by a monotonic score, and only the winner is converted to a distance.
+ */
+class SpectralClassifier
+{
+public:
+    /* Pixels per tile, a multiple of the SIMD width. */
+    static auto constexpr tileSize = ::hinalea::Int{ 256 };
+
+    using ThresholdRange = SpectralThresholdRange;
+
+    /* `spectralThresholdRanges` until changed by `setThresholdLimits`. */
+    [[ nodiscard ]]
+    auto thresholdRange(
+        HINALEA_IN SpectralMeasure measure
+        ) const noexcept -> ThresholdRange;
+
+    /* Thresholds passed to `classify` are clamped into these limits. Not thread safe, set them up front. */
+    auto setThresholdLimits(
+        HINALEA_IN SpectralMeasure measure,
+        HINALEA_IN double          lower,
+        HINALEA_IN double          upper
+        ) -> void;
+
+    /* `endmembers` is `observations x bands`, row major. */
+    auto fit(
+        HINALEA_IN SpectralMeasure        measure,
+        HINALEA_IN ::hinalea::f32 const * endmembers,
+        HINALEA_IN ::hinalea::Int         observations,
+        HINALEA_IN ::hinalea::Int         bands
+        ) -> void;
+
+    /* `cube` is BSQ with the bands given to `fit`, ie. `bands` planes of `area` pixels. */
+    auto classify(
+        HINALEA_IN ::hinalea::f32 const * cube,
+        HINALEA_IN ::hinalea::Int         area,
+        HINALEA_IN double                 threshold
+        ) -> void;
+
+    [[ nodiscard ]]
+    auto classes(
+        ) const noexcept -> ::std::vector< ::std::uint8_t > const &;
+
+private:
+    SpectralMeasure measure{ SpectralMeasure::SpectralAngle };
+    ::hinalea::Int observations{ 0 };
+    ::hinalea::Int bands{ 0 };
+
+    /* Transformed endmembers, `terms x bands x observations`, so a band's weights are contiguous. */
+    ::std::vector< ::hinalea::f32 > weights{ };
+    ::std::vector< SpectralEndmember > endmembers{ };
+
+    ::std::array< ThresholdRange, spectralMeasureCount > ranges{ spectralThresholdRanges };
+
+    ::std::vector< ::std::uint8_t > labels{ };
+};
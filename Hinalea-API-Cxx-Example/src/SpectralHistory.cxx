@@ -0,0 +1,445 @@
+#include "SpectralHistory.hxx"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+/* Rows copied per lock while exporting. */
+auto constexpr exportChunk = ::std::uint64_t{ 256 };
+
+[[ nodiscard ]]
+auto rowBytes(
+    HINALEA_IN ::hinalea::Int const bands
+    ) noexcept -> ::std::size_t
+{
+    return sizeof( ::std::int64_t ) + static_cast< ::std::size_t >( bands ) * sizeof( ::hinalea::f32 );
+}
+
+/* `std::to_chars` ignores the C locale, which Qt sets from the environment. */
+template <
+    typename T
+    >
+auto appendNumber(
+    HINALEA_INOUT ::std::string & line,
+    HINALEA_IN    T const         value
+    ) -> void
+{
+    char buffer[ 32 ];
+    auto const [ end, error ] = ::std::to_chars( buffer, buffer + sizeof( buffer ), value );
+    HINALEA_ASSERT( error == ::std::errc{ } );
+    line.append( buffer, end );
+}
+
+template <
+    typename T
+    >
+auto writeRaw(
+    HINALEA_INOUT ::std::ofstream & file,
+    HINALEA_IN    T const *         data,
+    HINALEA_IN    ::std::size_t     count
+    ) -> void
+{
+    file.write( reinterpret_cast< char const * >( data ), static_cast< ::std::streamsize >( count * sizeof( T ) ) );
+}
+
+} /* namespace anonymous */
+
+auto SpectralHistory::Ring::row(
+    HINALEA_IN ::std::uint64_t const sequence
+    ) const noexcept -> ::std::byte const *
+{
+    return this->storage.data( ) + static_cast< ::std::size_t >( sequence % static_cast< ::std::uint64_t >( this->capacity ) ) * ::rowBytes( this->bands );
+}
+
+auto SpectralHistory::Ring::row(
+    HINALEA_IN ::std::uint64_t const sequence
+    ) noexcept -> ::std::byte *
+{
+    return this->storage.data( ) + static_cast< ::std::size_t >( sequence % static_cast< ::std::uint64_t >( this->capacity ) ) * ::rowBytes( this->bands );
+}
+
+auto SpectralHistory::setByteBudget(
+    HINALEA_IN ::std::size_t const bytes
+    ) -> void
+{
+    auto storages = ::std::vector< ::std::vector< ::std::byte > >{ };
+
+    {
+        auto const lock = ::std::scoped_lock{ this->mutex };
+
+        if ( bytes == this->byteBudget )
+        {
+            return;
+        }
+
+        this->byteBudget = bytes;
+        storages.resize( this->rings.size( ) );
+    }
+
+    /* NOTE: Allocated without the lock, cubes keep going into the old rings meanwhile. Only this thread changes the
+     * probe count, so it is the same once the lock is taken again.
+     */
+    for ( auto & storage : storages )
+    {
+        storage.resize( bytes );
+    }
+
+    auto const lock = ::std::scoped_lock{ this->mutex };
+
+    for ( auto i = ::std::size_t{ 0 }; i < this->rings.size( ); ++i )
+    {
+        this->rings[ i ].storage.swap( storages[ i ] );
+        this->reset( this->rings[ i ], this->rings[ i ].bands );
+    }
+}
+
+auto SpectralHistory::setProbes(
+    HINALEA_IN ::hinalea::Int const probes
+    ) -> void
+{
+    auto const count = static_cast< ::std::size_t >( ::std::max( probes, ::hinalea::Int{ 0 } ) );
+    auto changed = ::std::vector< Ring >{ };
+    auto bytes = ::std::size_t{ };
+
+    {
+        auto const lock = ::std::scoped_lock{ this->mutex };
+
+        if ( count <= this->rings.size( ) )
+        {
+            /* NOTE: The dropped rings are freed without the lock. */
+            changed.assign(
+                ::std::make_move_iterator( this->rings.begin( ) + static_cast< ::std::ptrdiff_t >( count ) ),
+                ::std::make_move_iterator( this->rings.end( ) )
+                );
+            this->rings.resize( count );
+            this->epoch = ++this->epochs;
+            return;
+        }
+
+        changed.resize( count - this->rings.size( ) );
+        bytes = this->byteBudget;
+    }
+
+    for ( auto & ring : changed )
+    {
+        ring.storage.resize( bytes );
+    }
+
+    auto const lock = ::std::scoped_lock{ this->mutex };
+    auto const bands = this->rings.empty( ) ? ::hinalea::Int{ 0 } : this->rings.front( ).bands;
+
+    for ( auto & ring : changed )
+    {
+        this->reset( ring, bands );
+        this->rings.push_back( ::std::move( ring ) );
+    }
+}
+
+auto SpectralHistory::clear(
+    ) -> void
+{
+    auto const lock = ::std::scoped_lock{ this->mutex };
+
+    for ( auto & ring : this->rings )
+    {
+        this->reset( ring, ring.bands );
+    }
+}
+
+auto SpectralHistory::push(
+    HINALEA_IN ::std::int64_t         const timestamp,
+    HINALEA_IN ::hinalea::f32 const * const spectra,
+    HINALEA_IN ::hinalea::Int         const probes,
+    HINALEA_IN ::hinalea::Int         const bands
+    ) -> void
+{
+    auto const lock = ::std::scoped_lock{ this->mutex };
+
+    if ( static_cast< ::std::size_t >( probes ) != this->rings.size( ) )
+    {
+        return;
+    }
+
+    auto const bytes = static_cast< ::std::size_t >( bands ) * sizeof( ::hinalea::f32 );
+
+    for ( auto p = ::std::size_t{ 0 }; p < this->rings.size( ); ++p )
+    {
+        auto & ring = this->rings[ p ];
+
+        if ( ring.bands != bands )
+        {
+            /* NOTE: Only happens when the bands change, not per cube, and does not touch the memory. */
+            this->reset( ring, bands );
+        }
+
+        if ( ring.capacity > 0 )
+        {
+            auto * const row = ring.row( this->end );
+            ::std::memcpy( row, &timestamp, sizeof( timestamp ) );
+            ::std::memcpy( row + sizeof( timestamp ), spectra + p * static_cast< ::std::size_t >( bands ), bytes );
+        }
+    }
+
+    ++this->end;
+
+    for ( auto & ring : this->rings )
+    {
+        ring.begin = ::std::max( ring.begin, this->end - ::std::min( this->end, static_cast< ::std::uint64_t >( ring.capacity ) ) );
+    }
+}
+
+auto SpectralHistory::shape(
+    HINALEA_IN ::hinalea::Int const probe
+    ) const -> Shape
+{
+    auto const lock = ::std::scoped_lock{ this->mutex };
+    return this->held( probe );
+}
+
+auto SpectralHistory::read(
+    HINALEA_IN  ::std::uint64_t                   const epoch,
+    HINALEA_IN  ::std::uint64_t                   const first,
+    HINALEA_IN  ::std::uint64_t                   const last,
+    HINALEA_IN  ::hinalea::Int                    const probe,
+    HINALEA_OUT ::std::vector< ::std::int64_t > &       rowTimestamps,
+    HINALEA_OUT ::std::vector< ::hinalea::f32 > &       rowValues
+    ) const -> ::std::uint64_t
+{
+    auto const lock = ::std::scoped_lock{ this->mutex };
+    auto const current = this->held( probe );
+
+    if ( ( epoch != current.epoch ) or ( probe >= current.probes ) or ( current.capacity == 0 ) )
+    {
+        rowTimestamps.clear( );
+        rowValues.clear( );
+        return last;
+    }
+
+    auto const begin = ::std::clamp( first, current.begin, ::std::max( current.begin, last ) );
+    auto const end = ::std::min( last, current.end );
+    auto const rows = static_cast< ::std::size_t >( ( end > begin ) ? end - begin : 0 );
+    auto const bands = static_cast< ::std::size_t >( current.bands );
+    auto const firstProbe = static_cast< ::std::size_t >( ::std::max( probe, ::hinalea::Int{ 0 } ) );
+    auto const lastProbe = ( probe < 0 ) ? this->rings.size( ) : firstProbe + 1;
+    auto const copied = ( lastProbe - firstProbe ) * bands;
+
+    rowTimestamps.resize( rows );
+    rowValues.resize( rows * copied );
+
+    for ( auto i = ::std::size_t{ 0 }; i < rows; ++i )
+    {
+        auto * value = rowValues.data( ) + i * copied;
+        ::std::memcpy( &rowTimestamps[ i ], this->rings[ firstProbe ].row( begin + i ), sizeof( ::std::int64_t ) );
+
+        for ( auto p = firstProbe; p < lastProbe; ++p, value += bands )
+        {
+            ::std::memcpy( value, this->rings[ p ].row( begin + i ) + sizeof( ::std::int64_t ), bands * sizeof( ::hinalea::f32 ) );
+        }
+    }
+
+    return begin;
+}
+
+template <
+    typename Visit
+    >
+auto SpectralHistory::visitRows(
+    HINALEA_IN Shape const & snapshot,
+    HINALEA_IN Visit &&      visit
+    ) const -> void
+{
+    auto rowTimestamps = ::std::vector< ::std::int64_t >{ };
+    auto rowValues = ::std::vector< ::hinalea::f32 >{ };
+
+    for ( auto first = snapshot.begin; first < snapshot.end; )
+    {
+        auto const last = ::std::min( first + exportChunk, snapshot.end );
+
+        if ( this->read( snapshot.epoch, first, last, -1, rowTimestamps, rowValues ) == last )
+        {
+            if ( this->shape( ).epoch != snapshot.epoch )
+            {
+                throw ::std::runtime_error{ "Spectral history was cleared while exporting." };
+            }
+        }
+
+        /* NOTE: Rows the acquisition overwrote before this chunk was read are skipped. */
+        visit( rowTimestamps, rowValues, rowTimestamps.size( ) );
+        first = last;
+    }
+}
+
+auto SpectralHistory::exportCsv(
+    HINALEA_IN ::hinalea::fs::path const &     path,
+    HINALEA_IN ::std::vector< double > const & bandPositions
+    ) const -> void
+{
+    auto const snapshot = this->shape( );
+    auto file = ::std::ofstream{ path, ::std::ios::binary };
+
+    if ( not file )
+    {
+        throw ::std::runtime_error{ "Failed to open spectral history export: " + path.string( ) };
+    }
+
+    auto const bands = static_cast< ::std::size_t >( snapshot.bands );
+    auto line = ::std::string{ "timestamp_ns,probe" };
+
+    for ( auto b = ::std::size_t{ 0 }; b < bands; ++b )
+    {
+        line += ',';
+
+        if ( bandPositions.size( ) == bands )
+        {
+            ::appendNumber( line, bandPositions[ b ] );
+        }
+        else
+        {
+            ::appendNumber( line, b );
+        }
+    }
+
+    file << line << '\n';
+
+    this->visitRows(
+        snapshot,
+        [ & ]( auto const & rowTimestamps, auto const & rowValues, ::std::size_t const rows )
+        {
+            auto const * value = rowValues.data( );
+
+            for ( auto i = ::std::size_t{ 0 }; i < rows; ++i )
+            {
+                for ( auto p = ::hinalea::Int{ 0 }; p < snapshot.probes; ++p )
+                {
+                    line.clear( );
+                    ::appendNumber( line, rowTimestamps[ i ] );
+                    line += ',';
+                    ::appendNumber( line, p + 1 );
+
+                    for ( auto b = ::std::size_t{ 0 }; b < bands; ++b )
+                    {
+                        line += ',';
+                        ::appendNumber( line, *value++ );
+                    }
+
+                    file << line << '\n';
+                }
+            }
+        }
+        );
+
+    if ( not file.flush( ) )
+    {
+        throw ::std::runtime_error{ "Failed to write spectral history export: " + path.string( ) };
+    }
+}
+
+auto SpectralHistory::exportBinary(
+    HINALEA_IN ::hinalea::fs::path const & path
+    ) const -> void
+{
+    auto const snapshot = this->shape( );
+    auto file = ::std::ofstream{ path, ::std::ios::binary };
+
+    if ( not file )
+    {
+        throw ::std::runtime_error{ "Failed to open spectral history export: " + path.string( ) };
+    }
+
+    auto const probes = static_cast< ::std::uint32_t >( snapshot.probes );
+    auto const bands = static_cast< ::std::uint32_t >( snapshot.bands );
+    auto rows = ::std::uint64_t{ 0 };
+
+    file.write( "HNLHIST1", 8 );
+    ::writeRaw( file, &probes, 1 );
+    ::writeRaw( file, &bands, 1 );
+    auto const rowsOffset = file.tellp( );
+    ::writeRaw( file, &rows, 1 );
+
+    this->visitRows(
+        snapshot,
+        [ & ]( auto const & rowTimestamps, auto const & rowValues, ::std::size_t const count )
+        {
+            auto const rowSize = static_cast< ::std::size_t >( probes ) * bands;
+
+            for ( auto i = ::std::size_t{ 0 }; i < count; ++i )
+            {
+                ::writeRaw( file, &rowTimestamps[ i ], 1 );
+                ::writeRaw( file, rowValues.data( ) + i * rowSize, rowSize );
+            }
+
+            rows += count;
+        }
+        );
+
+    /* NOTE: Rows overwritten during the export are skipped, so the count is only known at the end. */
+    file.seekp( rowsOffset );
+    ::writeRaw( file, &rows, 1 );
+
+    if ( not file.flush( ) )
+    {
+        throw ::std::runtime_error{ "Failed to write spectral history export: " + path.string( ) };
+    }
+}
+
+auto SpectralHistory::held(
+    HINALEA_IN ::hinalea::Int const probe
+    ) const -> Shape
+{
+    auto current = Shape{ };
+    current.probes = static_cast< ::hinalea::Int >( this->rings.size( ) );
+    current.end = this->end;
+
+    if ( probe >= current.probes )
+    {
+        return current;
+    }
+
+    if ( probe >= 0 )
+    {
+        auto const & ring = this->rings[ static_cast< ::std::size_t >( probe ) ];
+        current.bands = ring.bands;
+        current.capacity = ring.capacity;
+        current.epoch = ring.epoch;
+        current.begin = ring.begin;
+        return current;
+    }
+
+    /* NOTE: Every push lays all rings out for the same bands, they only differ until the first cube after a change. */
+    current.epoch = this->epoch;
+    current.begin = this->end;
+
+    if ( not this->rings.empty( ) and
+         ::std::all_of( this->rings.begin( ), this->rings.end( ), [ & ]( Ring const & ring ){ return ring.bands == this->rings.front( ).bands; } ) )
+    {
+        current.bands = this->rings.front( ).bands;
+        current.capacity = this->rings.front( ).capacity;
+        current.begin = 0;
+
+        for ( auto const & ring : this->rings )
+        {
+            current.capacity = ::std::min( current.capacity, ring.capacity );
+            current.begin = ::std::max( current.begin, ring.begin );
+        }
+    }
+
+    return current;
+}
+
+auto SpectralHistory::reset(
+    HINALEA_INOUT Ring &               ring,
+    HINALEA_IN    ::hinalea::Int const bands
+    ) -> void
+{
+    ring.bands = bands;
+    ring.capacity = ( bands > 0 ) ? static_cast< ::hinalea::Int >( ring.storage.size( ) / ::rowBytes( bands ) ) : 0;
+    ring.begin = this->end;
+    ring.epoch = ++this->epochs;
+    this->epoch = ++this->epochs;
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <Hinalea.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/* Fixed memory history of the probe spectra, one row per cube.
+ *
+ * Each probe has its own ring of `bands` spectra with a timestamp, whose capacity follows from a byte budget per probe,
+ * so a long running monitor never grows. Rows are numbered by a sequence shared by every probe that only grows; readers
+ * ask for a sequence range and get whatever part of it was not overwritten yet. Every lock is held for one row or one
+ * chunk only, so readers such as the exports never stall the thread pushing the cubes.
+ *
+ * Rings are only allocated by `setProbes` and `setByteBudget`, on the GUI thread. Adding or removing probes keeps the
+ * history of the others. `push` never allocates: it only copies the row, and when the band count changed it empties
+ * the rings and lays them out again in the memory they have. A ring's `epoch` changes whenever it is emptied.
+ */
+class SpectralHistory
+{
+public:
+    static auto constexpr defaultByteBudget = ::std::size_t{ 64 } << 20;
+
+    /* Of one probe's ring, or of the rows every probe holds. */
+    struct Shape
+    {
+        ::hinalea::Int probes{ 0 };
+        ::hinalea::Int bands{ 0 };
+        ::hinalea::Int capacity{ 0 };
+        ::std::uint64_t epoch{ 0 };
+        ::std::uint64_t begin{ 0 }; /* Oldest sequence still held. */
+        ::std::uint64_t end{ 0 };   /* One past the newest sequence. */
+    };
+
+    /* Reallocates every ring to `bytes`, emptying them. */
+    auto setByteBudget(
+        HINALEA_IN ::std::size_t bytes
+        ) -> void;
+
+    /* Keeps the rings of the first `probes`, drops the rest and allocates empty rings for new probes. */
+    auto setProbes(
+        HINALEA_IN ::hinalea::Int probes
+        ) -> void;
+
+    /* Drops every row of every probe. */
+    auto clear(
+        ) -> void;
+
+    /* `spectra` is `probes x bands`, row major. `timestamp` is in nanoseconds since the Unix epoch.
+     *
+     * The row is dropped if `probes` is not the count of `setProbes`, ie. the cube was reduced with the previous probes.
+     */
+    auto push(
+        HINALEA_IN ::std::int64_t         timestamp,
+        HINALEA_IN ::hinalea::f32 const * spectra,
+        HINALEA_IN ::hinalea::Int         probes,
+        HINALEA_IN ::hinalea::Int         bands
+        ) -> void;
+
+    /* Of the ring of `probe`, or of the rows held by every probe when it is negative. */
+    [[ nodiscard ]]
+    auto shape(
+        HINALEA_IN ::hinalea::Int probe = -1
+        ) const -> Shape;
+
+    /* Copies the rows `[ first, last )` of `epoch` that are still held, of one `probe` or of every probe when it is
+     * negative. Returns the first sequence copied, ie. rows before it were overwritten, or `last` if the rings were
+     * emptied or changed since `epoch`.
+     */
+    auto read(
+        HINALEA_IN  ::std::uint64_t                   epoch,
+        HINALEA_IN  ::std::uint64_t                   first,
+        HINALEA_IN  ::std::uint64_t                   last,
+        HINALEA_IN  ::hinalea::Int                    probe,
+        HINALEA_OUT ::std::vector< ::std::int64_t > & timestamps,
+        HINALEA_OUT ::std::vector< ::hinalea::f32 > & values
+        ) const -> ::std::uint64_t;
+
+    /* One line per row and probe: `timestamp_ns,probe,value...`, with `bandPositions` as the header of the values. */
+    auto exportCsv(
+        HINALEA_IN ::hinalea::fs::path const &     path,
+        HINALEA_IN ::std::vector< double > const & bandPositions
+        ) const -> void;
+
+    /* Little endian, 8 byte magic "HNLHIST1", u32 probes, u32 bands, u64 rows, then per row an i64 timestamp in
+     * nanoseconds followed by `probes x bands` f32 values.
+     */
+    auto exportBinary(
+        HINALEA_IN ::hinalea::fs::path const & path
+        ) const -> void;
+
+private:
+    /* Visits the held rows in chunks, `visit( timestamps, values, rows )` runs without the lock. */
+    template <
+        typename Visit
+        >
+    auto visitRows(
+        HINALEA_IN Shape const & snapshot,
+        HINALEA_IN Visit &&      visit
+        ) const -> void;
+
+    /* Rows of `sizeof( std::int64_t ) + bands * sizeof( f32 )` bytes: the timestamp, then the spectrum. */
+    struct Ring
+    {
+        ::std::vector< ::std::byte > storage{ };
+        ::hinalea::Int bands{ 0 };
+        ::hinalea::Int capacity{ 0 };
+        ::std::uint64_t epoch{ 0 };
+        ::std::uint64_t begin{ 0 };
+
+        [[ nodiscard ]]
+        auto row(
+            HINALEA_IN ::std::uint64_t sequence
+            ) const noexcept -> ::std::byte const *;
+
+        [[ nodiscard ]]
+        auto row(
+            HINALEA_IN ::std::uint64_t sequence
+            ) noexcept -> ::std::byte *;
+    };
+
+    /* Body of `shape`, with the lock held. */
+    [[ nodiscard ]]
+    auto held(
+        HINALEA_IN ::hinalea::Int probe
+        ) const -> Shape;
+
+    /* Lays `ring` out for `bands` and empties it. */
+    auto reset(
+        HINALEA_INOUT Ring &         ring,
+        HINALEA_IN    ::hinalea::Int bands
+        ) -> void;
+
+    mutable ::std::mutex mutex{ };
+    ::std::size_t byteBudget{ defaultByteBudget };
+    ::std::vector< Ring > rings{ };
+    ::std::uint64_t epoch{ 0 }; /* Of the rows held by every probe, ie. changes with any ring or the probe count. */
+    ::std::uint64_t epochs{ 0 }; /* Last epoch handed out, so no two rings ever share one. */
+    ::std::uint64_t end{ 0 };
+};
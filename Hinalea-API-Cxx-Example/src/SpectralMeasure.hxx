@@ -0,0 +1,439 @@
+#pragma once
+
+#include <Hinalea.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+
+/* Similarity measures supported by `SpectralClassifier` and `LibraryClassifier`. Every one is reported as a distance, smaller is closer. */
+enum class SpectralMeasure
+{
+    SpectralAngle,                 /* Angle between the spectra, radians. */
+    SpectralInformationDivergence, /* Symmetric relative entropy of the spectra normalized to distributions. */
+    Euclidean,                     /* Straight line distance, in cube units. */
+    NormalizedCorrelation,         /* 1 - Pearson correlation, 0 to 2. */
+    JeffriesMatusita,              /* Hellinger form of the Jeffries-Matusita distance, 0 to sqrt( 2 ). */
+};
+
+inline auto constexpr spectralMeasureCount = ::std::size_t{ 5 };
+
+/* Thresholds a classifier accepts for a measure, and the initial value and step of the threshold spin box. */
+struct SpectralThresholdRange
+{
+    double lower{ };
+    double upper{ };
+    double initial{ };
+    double step{ };
+};
+
+/* Defaults per measure, in `SpectralMeasure` order. They suit reflectance cubes; the spectral angle limits should come
+ * from `SpectralMetric::threshold_limits`.
+ */
+inline auto constexpr spectralThresholdRanges = ::std::array< SpectralThresholdRange, spectralMeasureCount >{ {
+    { 0.0, 3.14159265358979323846, 0.2 , 0.01 },
+    { 0.0, 10.0                  , 0.05, 0.01 },
+    { 0.0, 1.0e9                 , 1.0 , 0.1  },
+    { 0.0, 2.0                   , 0.1 , 0.01 },
+    { 0.0, 1.41421356237309504880, 0.2 , 0.01 },
+    } };
+
+/* Keeps logarithms of dark samples finite. */
+inline auto constexpr spectralMinSample = ::hinalea::f32{ 1.0e-12f };
+
+/* Per endmember constants. */
+struct SpectralEndmember
+{
+    ::hinalea::f32 sum{ };
+    ::hinalea::f32 mean{ };
+    ::hinalea::f32 squares{ };
+    ::hinalea::f32 scale{ };
+    ::hinalea::f32 entropy{ };
+};
+
+/* Per pixel sums, accumulated over the bands of a tile. */
+struct SpectralPixel
+{
+    ::hinalea::f32 sum{ };
+    ::hinalea::f32 squares{ };
+    ::hinalea::f32 entropy{ };
+    ::hinalea::f32 mean{ };
+    ::hinalea::f32 scale{ };
+};
+
+/* NOTE:
+ * Every measure provides:
+ * - `terms`: number of dot products between `pixelTerm( k, x )` and `weightTerm( k, y )` over the bands.
+ * - `accumulate`: per pixel sums, `prepare` turns them into the constants used by `score` once all bands are in.
+ * - `endmember`: the same constants for an endmember.
+ * - `score`: larger is closer, compared across endmembers. `distance` converts the winning score for the threshold.
+ */
+template <
+    SpectralMeasure Measure
+    >
+struct SpectralTraits;
+
+template < >
+struct SpectralTraits< SpectralMeasure::SpectralAngle >
+{
+    static auto constexpr terms = ::std::size_t{ 1 };
+    static auto constexpr identityTerms = true;
+
+    static auto pixelTerm( ::std::size_t, ::hinalea::f32 const x ) noexcept -> ::hinalea::f32 { return x; }
+    static auto weightTerm( ::std::size_t, ::hinalea::f32 const y ) noexcept -> ::hinalea::f32 { return y; }
+
+    static auto accumulate(
+        HINALEA_INOUT SpectralPixel &      pixel,
+        HINALEA_IN    ::hinalea::f32 const x
+        ) noexcept -> void
+    {
+        pixel.squares += x * x;
+    }
+
+    static auto prepare(
+        HINALEA_INOUT SpectralPixel &      pixel,
+        HINALEA_IN    ::hinalea::Int const
+        ) noexcept -> bool
+    {
+        pixel.scale = ( pixel.squares > 0 ) ? 1 / ::std::sqrt( pixel.squares ) : 0;
+        return pixel.squares > 0;
+    }
+
+    static auto endmember(
+        HINALEA_IN ::hinalea::f32 const * const y,
+        HINALEA_IN ::hinalea::Int         const bands
+        ) noexcept -> SpectralEndmember
+    {
+        auto em = SpectralEndmember{ };
+
+        for ( auto b = ::hinalea::Int{ 0 }; b < bands; ++b )
+        {
+            em.squares += y[ b ] * y[ b ];
+        }
+
+        em.scale = ( em.squares > 0 ) ? 1 / ::std::sqrt( em.squares ) : 0;
+        return em;
+    }
+
+    static auto score(
+        HINALEA_IN SpectralPixel const &        pixel,
+        HINALEA_IN SpectralEndmember const &    em,
+        HINALEA_IN ::hinalea::f32 const * const dots
+        ) noexcept -> ::hinalea::f32
+    {
+        return dots[ 0 ] * pixel.scale * em.scale;
+    }
+
+    static auto distance(
+        HINALEA_IN ::hinalea::f32 const score
+        ) noexcept -> ::hinalea::f32
+    {
+        return ::std::acos( ::std::clamp( score, -1.0f, 1.0f ) );
+    }
+};
+
+template < >
+struct SpectralTraits< SpectralMeasure::SpectralInformationDivergence >
+{
+    /* With p = x / Sx and q = y / Sy, SID = sum( ( p - q ) * ( log p - log q ) )
+     *   = ( sum( x log x ) - sum( x log y ) ) / Sx + ( sum( y log y ) - sum( y log x ) ) / Sy,
+     * the normalization logarithms cancel out.
+     */
+    static auto constexpr terms = ::std::size_t{ 2 };
+    static auto constexpr identityTerms = false;
+
+    static auto sample(
+        HINALEA_IN ::hinalea::f32 const x
+        ) noexcept -> ::hinalea::f32
+    {
+        return ::std::max( x, spectralMinSample );
+    }
+
+    static auto pixelTerm( ::std::size_t const k, ::hinalea::f32 const x ) noexcept -> ::hinalea::f32
+    {
+        return ( k == 0 ) ? sample( x ) : ::std::log( sample( x ) );
+    }
+
+    static auto weightTerm( ::std::size_t const k, ::hinalea::f32 const y ) noexcept -> ::hinalea::f32
+    {
+        return ( k == 0 ) ? ::std::log( sample( y ) ) : sample( y );
+    }
+
+    static auto accumulate(
+        HINALEA_INOUT SpectralPixel &      pixel,
+        HINALEA_IN    ::hinalea::f32 const x
+        ) noexcept -> void
+    {
+        auto const s = sample( x );
+        pixel.sum += s;
+        pixel.entropy += s * ::std::log( s );
+    }
+
+    static auto prepare(
+        HINALEA_INOUT SpectralPixel &      pixel,
+        HINALEA_IN    ::hinalea::Int const
+        ) noexcept -> bool
+    {
+        pixel.scale = 1 / pixel.sum;
+        return true;
+    }
+
+    static auto endmember(
+        HINALEA_IN ::hinalea::f32 const * const y,
+        HINALEA_IN ::hinalea::Int         const bands
+        ) noexcept -> SpectralEndmember
+    {
+        auto em = SpectralEndmember{ };
+
+        for ( auto b = ::hinalea::Int{ 0 }; b < bands; ++b )
+        {
+            auto const s = sample( y[ b ] );
+            em.sum += s;
+            em.entropy += s * ::std::log( s );
+        }
+
+        em.scale = 1 / em.sum;
+        return em;
+    }
+
+    static auto score(
+        HINALEA_IN SpectralPixel const &        pixel,
+        HINALEA_IN SpectralEndmember const &    em,
+        HINALEA_IN ::hinalea::f32 const * const dots
+        ) noexcept -> ::hinalea::f32
+    {
+        return -( ( pixel.entropy - dots[ 0 ] ) * pixel.scale + ( em.entropy - dots[ 1 ] ) * em.scale );
+    }
+
+    static auto distance(
+        HINALEA_IN ::hinalea::f32 const score
+        ) noexcept -> ::hinalea::f32
+    {
+        return ::std::max( -score, 0.0f );
+    }
+};
+
+template < >
+struct SpectralTraits< SpectralMeasure::Euclidean >
+{
+    static auto constexpr terms = ::std::size_t{ 1 };
+    static auto constexpr identityTerms = true;
+
+    static auto pixelTerm( ::std::size_t, ::hinalea::f32 const x ) noexcept -> ::hinalea::f32 { return x; }
+    static auto weightTerm( ::std::size_t, ::hinalea::f32 const y ) noexcept -> ::hinalea::f32 { return y; }
+
+    static auto accumulate(
+        HINALEA_INOUT SpectralPixel &      pixel,
+        HINALEA_IN    ::hinalea::f32 const x
+        ) noexcept -> void
+    {
+        pixel.squares += x * x;
+    }
+
+    static auto prepare(
+        HINALEA_INOUT SpectralPixel &      pixel,
+        HINALEA_IN    ::hinalea::Int const
+        ) noexcept -> bool
+    {
+        HINALEA_UNUSED( pixel );
+        return true;
+    }
+
+    static auto endmember(
+        HINALEA_IN ::hinalea::f32 const * const y,
+        HINALEA_IN ::hinalea::Int         const bands
+        ) noexcept -> SpectralEndmember
+    {
+        auto em = SpectralEndmember{ };
+
+        for ( auto b = ::hinalea::Int{ 0 }; b < bands; ++b )
+        {
+            em.squares += y[ b ] * y[ b ];
+        }
+
+        return em;
+    }
+
+    /* Negated squared distance, |x - y|^2 = |x|^2 + |y|^2 - 2 x.y */
+    static auto score(
+        HINALEA_IN SpectralPixel const &        pixel,
+        HINALEA_IN SpectralEndmember const &    em,
+        HINALEA_IN ::hinalea::f32 const * const dots
+        ) noexcept -> ::hinalea::f32
+    {
+        return 2 * dots[ 0 ] - pixel.squares - em.squares;
+    }
+
+    static auto distance(
+        HINALEA_IN ::hinalea::f32 const score
+        ) noexcept -> ::hinalea::f32
+    {
+        return ::std::sqrt( ::std::max( -score, 0.0f ) );
+    }
+};
+
+template < >
+struct SpectralTraits< SpectralMeasure::NormalizedCorrelation >
+{
+    static auto constexpr terms = ::std::size_t{ 1 };
+    static auto constexpr identityTerms = true;
+
+    static auto pixelTerm( ::std::size_t, ::hinalea::f32 const x ) noexcept -> ::hinalea::f32 { return x; }
+    static auto weightTerm( ::std::size_t, ::hinalea::f32 const y ) noexcept -> ::hinalea::f32 { return y; }
+
+    static auto accumulate(
+        HINALEA_INOUT SpectralPixel &      pixel,
+        HINALEA_IN    ::hinalea::f32 const x
+        ) noexcept -> void
+    {
+        pixel.sum += x;
+        pixel.squares += x * x;
+    }
+
+    static auto prepare(
+        HINALEA_INOUT SpectralPixel &      pixel,
+        HINALEA_IN    ::hinalea::Int const bands
+        ) noexcept -> bool
+    {
+        auto const n = static_cast< ::hinalea::f32 >( bands );
+        auto const variance = pixel.squares - pixel.sum * pixel.sum / n;
+        pixel.mean = pixel.sum / n;
+        pixel.scale = ( variance > 0 ) ? 1 / ::std::sqrt( variance ) : 0;
+        return variance > 0;
+    }
+
+    static auto endmember(
+        HINALEA_IN ::hinalea::f32 const * const y,
+        HINALEA_IN ::hinalea::Int         const bands
+        ) noexcept -> SpectralEndmember
+    {
+        auto em = SpectralEndmember{ };
+        auto sum = 0.0f;
+
+        for ( auto b = ::hinalea::Int{ 0 }; b < bands; ++b )
+        {
+            sum += y[ b ];
+            em.squares += y[ b ] * y[ b ];
+        }
+
+        auto const n = static_cast< ::hinalea::f32 >( bands );
+        auto const variance = em.squares - sum * sum / n;
+        em.mean = sum / n;
+        em.scale = ( variance > 0 ) ? 1 / ::std::sqrt( variance ) : 0;
+        return em;
+    }
+
+    /* Pearson correlation; the band count is folded into the means, sum( x y ) - n mx my is n times the covariance. */
+    static auto score(
+        HINALEA_IN SpectralPixel const &        pixel,
+        HINALEA_IN SpectralEndmember const &    em,
+        HINALEA_IN ::hinalea::f32 const * const dots
+        ) noexcept -> ::hinalea::f32
+    {
+        return ( dots[ 0 ] - pixel.sum * em.mean ) * pixel.scale * em.scale;
+    }
+
+    static auto distance(
+        HINALEA_IN ::hinalea::f32 const score
+        ) noexcept -> ::hinalea::f32
+    {
+        return 1 - ::std::clamp( score, -1.0f, 1.0f );
+    }
+};
+
+template < >
+struct SpectralTraits< SpectralMeasure::JeffriesMatusita >
+{
+    /* Bhattacharyya coefficient of the normalized spectra, sum( sqrt( x y ) ) / sqrt( Sx Sy ). */
+    static auto constexpr terms = ::std::size_t{ 1 };
+    static auto constexpr identityTerms = false;
+
+    static auto pixelTerm( ::std::size_t, ::hinalea::f32 const x ) noexcept -> ::hinalea::f32 { return ::std::sqrt( ::std::max( x, 0.0f ) ); }
+    static auto weightTerm( ::std::size_t, ::hinalea::f32 const y ) noexcept -> ::hinalea::f32 { return ::std::sqrt( ::std::max( y, 0.0f ) ); }
+
+    static auto accumulate(
+        HINALEA_INOUT SpectralPixel &      pixel,
+        HINALEA_IN    ::hinalea::f32 const x
+        ) noexcept -> void
+    {
+        pixel.sum += ::std::max( x, 0.0f );
+    }
+
+    static auto prepare(
+        HINALEA_INOUT SpectralPixel &      pixel,
+        HINALEA_IN    ::hinalea::Int const
+        ) noexcept -> bool
+    {
+        pixel.scale = ( pixel.sum > 0 ) ? 1 / ::std::sqrt( pixel.sum ) : 0;
+        return pixel.sum > 0;
+    }
+
+    static auto endmember(
+        HINALEA_IN ::hinalea::f32 const * const y,
+        HINALEA_IN ::hinalea::Int         const bands
+        ) noexcept -> SpectralEndmember
+    {
+        auto em = SpectralEndmember{ };
+
+        for ( auto b = ::hinalea::Int{ 0 }; b < bands; ++b )
+        {
+            em.sum += ::std::max( y[ b ], 0.0f );
+        }
+
+        em.scale = ( em.sum > 0 ) ? 1 / ::std::sqrt( em.sum ) : 0;
+        return em;
+    }
+
+    static auto score(
+        HINALEA_IN SpectralPixel const &        pixel,
+        HINALEA_IN SpectralEndmember const &    em,
+        HINALEA_IN ::hinalea::f32 const * const dots
+        ) noexcept -> ::hinalea::f32
+    {
+        return dots[ 0 ] * pixel.scale * em.scale;
+    }
+
+    static auto distance(
+        HINALEA_IN ::hinalea::f32 const score
+        ) noexcept -> ::hinalea::f32
+    {
+        return ::std::sqrt( ::std::max( 2 - 2 * score, 0.0f ) );
+    }
+};
+
+/* Calls `visit( std::integral_constant< SpectralMeasure, measure >{ } )`, to reach the kernel instantiated for it. */
+template <
+    typename Visitor
+    >
+auto visitSpectralMeasure(
+    HINALEA_IN SpectralMeasure const measure,
+    HINALEA_IN Visitor &&            visit
+    ) -> decltype( auto )
+{
+    switch ( measure )
+    {
+        case SpectralMeasure::SpectralInformationDivergence:
+        {
+            return visit( ::std::integral_constant< SpectralMeasure, SpectralMeasure::SpectralInformationDivergence >{ } );
+        }
+        case SpectralMeasure::Euclidean:
+        {
+            return visit( ::std::integral_constant< SpectralMeasure, SpectralMeasure::Euclidean >{ } );
+        }
+        case SpectralMeasure::NormalizedCorrelation:
+        {
+            return visit( ::std::integral_constant< SpectralMeasure, SpectralMeasure::NormalizedCorrelation >{ } );
+        }
+        case SpectralMeasure::JeffriesMatusita:
+        {
+            return visit( ::std::integral_constant< SpectralMeasure, SpectralMeasure::JeffriesMatusita >{ } );
+        }
+        case SpectralMeasure::SpectralAngle:
+        default:
+        {
+            return visit( ::std::integral_constant< SpectralMeasure, SpectralMeasure::SpectralAngle >{ } );
+        }
+    }
+}
@@ -0,0 +1,152 @@
+#include "StreamCapture.hxx"
+#include "ThreadPool.hxx"
+
+#include <QImage>
+#include <QString>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+[[ nodiscard ]]
+auto qtPath(
+    HINALEA_IN ::hinalea::fs::path const & path
+    ) -> QString
+{
+    return QString::fromStdU16String( path.generic_u16string( ) );
+}
+
+/* `frames.csv` of a capture, one line per frame. */
+auto writeFrameTable(
+    HINALEA_IN ::hinalea::fs::path const & path,
+    HINALEA_IN RawRecording const &        recording
+    ) -> void
+{
+    auto file = ::std::ofstream{ path, ::std::ios::binary };
+    auto const & settings = recording.settings( );
+
+    /* NOTE: `std::ofstream` uses the classic locale, Qt only sets the C one. */
+    file << "file,gap_index,timestamp_ns,bit_depth";
+
+    if ( settings )
+    {
+        file << ",exposure_us,gain,gain_mode,binning";
+    }
+
+    file << '\n';
+
+    for ( auto i = ::hinalea::Int{ 0 }; i < recording.frames( ); ++i )
+    {
+        file << i << ".png," << recording.gapIndex( i ) << ',' << recording.timestamp( i ) << ',' << recording.format( ).bitDepth;
+
+        if ( settings )
+        {
+            file << ',' << settings->exposure << ',' << settings->gain << ',' << settings->gainMode << ',' << settings->binning;
+        }
+
+        file << '\n';
+    }
+
+    if ( not file.flush( ) )
+    {
+        throw ::std::runtime_error{ "Failed to write capture frame table: " + path.string( ) };
+    }
+}
+
+} /* namespace anonymous */
+
+auto StreamCapture::find(
+    HINALEA_IN ::hinalea::fs::path const & dir
+    ) -> ::std::optional< ::hinalea::fs::path >
+{
+    auto base = dir / dir.filename( );
+    auto index = base;
+    index += ".idx";
+
+    if ( not ::hinalea::fs::is_regular_file( index ) )
+    {
+        return ::std::nullopt;
+    }
+
+    return base;
+}
+
+auto StreamCapture::convert(
+    HINALEA_IN ::hinalea::fs::path const & base,
+    HINALEA_IN Progress const &            progress
+    ) -> ::hinalea::fs::path
+{
+    auto const dir = base.parent_path( );
+    auto const capture = dir / "capture";
+
+    if ( ::hinalea::fs::is_directory( capture ) )
+    {
+        return capture;
+    }
+
+    auto recording = RawRecording::open( base );
+    auto const format = recording.format( );
+    auto const frames = recording.frames( );
+    auto const bytesPerPixel = RawRecorder::bytesPerPixel( format.bitDepth );
+    auto const imageFormat = ( bytesPerPixel == 2 ) ? QImage::Format_Grayscale16 : QImage::Format_Grayscale8;
+
+    auto const partial = dir / "capture.partial";
+    ::hinalea::fs::remove_all( partial );
+    ::hinalea::fs::create_directories( partial );
+    ::writeFrameTable( partial / "frames.csv", recording );
+
+    /* NOTE: Frames are read one after another, PNG encoding is what takes the time and runs on the pool. */
+    auto const rowBytes = static_cast< ::std::size_t >( format.width * bytesPerPixel );
+    auto const frameBytes = rowBytes * static_cast< ::std::size_t >( format.height );
+    auto const block = static_cast< ::hinalea::Int >( ThreadPool::global( ).concurrency( ) );
+    auto buffers = ::std::vector< ::std::vector< ::std::byte > >( static_cast< ::std::size_t >( block ) );
+
+    for ( auto first = ::hinalea::Int{ 0 }; first < frames; first += block )
+    {
+        auto const count = ::std::min( block, frames - first );
+
+        for ( auto i = ::hinalea::Int{ 0 }; i < count; ++i )
+        {
+            auto & buffer = buffers[ static_cast< ::std::size_t >( i ) ];
+            buffer.resize( frameBytes );
+            recording.read( first + i, buffer.data( ) );
+        }
+
+        ThreadPool::global( ).parallelFor(
+            static_cast< ::std::size_t >( count ),
+            1,
+            [ & ]( ::std::size_t const begin, ::std::size_t const end )
+            {
+                for ( auto i = begin; i < end; ++i )
+                {
+                    auto image = QImage{ static_cast< int >( format.width ), static_cast< int >( format.height ), imageFormat };
+
+                    for ( auto y = 0; y < image.height( ); ++y )
+                    {
+                        ::std::memcpy( image.scanLine( y ), buffers[ i ].data( ) + static_cast< ::std::size_t >( y ) * rowBytes, rowBytes );
+                    }
+
+                    auto const path = partial / ( ::std::to_string( first + static_cast< ::hinalea::Int >( i ) ) + ".png" );
+
+                    if ( not image.save( ::qtPath( path ), "PNG" ) )
+                    {
+                        throw ::std::runtime_error{ "Failed to write capture frame: " + path.string( ) };
+                    }
+                }
+            }
+            );
+
+        if ( progress )
+        {
+            progress( static_cast< int >( ( first + count ) * 100 / frames ) );
+        }
+    }
+
+    ::hinalea::fs::rename( partial, capture );
+    return capture;
+}
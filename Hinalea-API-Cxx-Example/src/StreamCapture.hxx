@@ -0,0 +1,41 @@
+#pragma once
+
+#include "RawRecorder.hxx"
+
+#include <Hinalea.h>
+
+#include <functional>
+#include <optional>
+
+/* Turns a raw stream of `RawRecorder` into a capture directory of one PNG per frame, which is what
+ * `Processor::process` reads.
+ *
+ * Frame `i` of the stream, in sweep order, is written as a grayscale PNG of the stream's bit depth named "<i>.png", with
+ * its samples as recorded. `frames.csv` next to the frames describes every frame from the stream's own header and
+ * index: its file, gap index, capture timestamp in nanoseconds since the Unix epoch, bit depth and the camera settings
+ * of the header. Compressed streams are decoded by `RawRecording`.
+ *
+ * The capture is written to `capture.partial` next to the stream and renamed to `capture` once complete, so an
+ * interrupted conversion is redone and a complete one is reused.
+ */
+class StreamCapture
+{
+public:
+    using Progress = ::std::function< void ( int percent ) >;
+
+    /* Base of the raw stream in `dir`, `<dir>/<name of dir>`, if `dir` holds one. */
+    [[ nodiscard ]]
+    static
+    auto find(
+        HINALEA_IN ::hinalea::fs::path const & dir
+        ) -> ::std::optional< ::hinalea::fs::path >;
+
+    /* Converts the stream `base` unless its capture is complete, and returns the capture directory. Throws
+     * `std::runtime_error` on I/O errors.
+     */
+    static
+    auto convert(
+        HINALEA_IN ::hinalea::fs::path const & base,
+        HINALEA_IN Progress const &            progress = { }
+        ) -> ::hinalea::fs::path;
+};
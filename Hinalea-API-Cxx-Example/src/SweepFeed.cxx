@@ -0,0 +1,116 @@
+#include "SweepFeed.hxx"
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+auto SweepFeed::start(
+    HINALEA_IN ::std::shared_ptr< RawRecorder > newRecorder
+    ) -> void
+{
+    auto const lock = ::std::scoped_lock{ this->mutex };
+    this->recorder = ::std::move( newRecorder );
+    this->wanted = false;
+    this->stopped = false;
+    this->active.store( true, ::std::memory_order_release );
+}
+
+auto SweepFeed::stop(
+    ) -> void
+{
+    {
+        auto const lock = ::std::scoped_lock{ this->mutex };
+        this->active.store( false, ::std::memory_order_release );
+        this->recorder.reset( );
+        this->wanted = false;
+        this->stopped = true;
+    }
+
+    this->delivered.notify_all( );
+}
+
+auto SweepFeed::isActive(
+    ) const noexcept -> bool
+{
+    return this->active.load( ::std::memory_order_acquire );
+}
+
+auto SweepFeed::take(
+    HINALEA_IN Clock::time_point const newNotBefore,
+    HINALEA_IN Clock::time_point const deadline,
+    HINALEA_IN ::hinalea::Int    const newGapIndex,
+    HINALEA_IN ::std::uint64_t   const newSequence
+    ) -> bool
+{
+    auto lock = ::std::unique_lock{ this->mutex };
+
+    if ( this->stopped )
+    {
+        return false;
+    }
+
+    this->notBefore = newNotBefore;
+    this->gapIndex = newGapIndex;
+    this->sequence = newSequence;
+    this->wanted = true;
+    this->pushed = false;
+    this->error = nullptr;
+
+    if ( not this->delivered.wait_until( lock, deadline, [ this ]{ return this->pushed or this->stopped; } ) )
+    {
+        this->wanted = false;
+        throw ::std::runtime_error{ "No camera frame arrived for gap index " + ::std::to_string( newGapIndex ) + "." };
+    }
+
+    if ( this->error )
+    {
+        ::std::rethrow_exception( ::std::exchange( this->error, nullptr ) );
+    }
+
+    return this->pushed;
+}
+
+auto SweepFeed::offer(
+    HINALEA_IN FrameView const &       frame,
+    HINALEA_IN Clock::time_point const fetched,
+    HINALEA_IN ::std::int64_t    const timestamp
+    ) -> void
+{
+    auto target = ::std::shared_ptr< RawRecorder >{ };
+    auto frameGapIndex = ::hinalea::Int{ };
+    auto frameSequence = ::std::uint64_t{ };
+
+    {
+        auto const lock = ::std::scoped_lock{ this->mutex };
+
+        if ( ( not this->wanted ) or ( fetched < this->notBefore ) )
+        {
+            return;
+        }
+
+        this->wanted = false;
+        target = this->recorder;
+        frameGapIndex = this->gapIndex;
+        frameSequence = this->sequence;
+    }
+
+    /* NOTE: Pushed without the lock, `push` blocks while every slot of the recorder waits for the disk. */
+    auto pushError = ::std::exception_ptr{ };
+
+    try
+    {
+        target->push( frame, frameGapIndex, timestamp, frameSequence );
+    }
+    catch ( ... )
+    {
+        pushError = ::std::current_exception( );
+    }
+
+    {
+        auto const lock = ::std::scoped_lock{ this->mutex };
+        this->error = pushError;
+        this->pushed = true;
+    }
+
+    this->delivered.notify_all( );
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "FrameStatistics.hxx"
+#include "RawRecorder.hxx"
+
+#include <Hinalea.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+
+/* Hands the frames of a raw sweep from the thread fetching live frames to a `RawRecorder`.
+ *
+ * After moving the FPI, the recording thread `take`s one frame for the gap index: it blocks until the fetching thread
+ * `offer`s a frame fetched at or after a given time, which `offer` pushes into the recorder before waking it. Frames
+ * offered while none is wanted, or too early, are left to the preview. So the sweep follows the camera's own frame
+ * delivery instead of polling for frames, and the preview keeps running during it.
+ */
+class SweepFeed
+{
+public:
+    using Clock = ::std::chrono::steady_clock;
+
+    /* Recording side, starts handing frames to `recorder`. */
+    auto start(
+        HINALEA_IN ::std::shared_ptr< RawRecorder > recorder
+        ) -> void;
+
+    /* Ends the sweep and wakes a waiting `take`, from any thread. */
+    auto stop(
+        ) -> void;
+
+    /* Fetching side, whether frames should be offered. */
+    [[ nodiscard ]]
+    auto isActive(
+        ) const noexcept -> bool;
+
+    /* Recording side, waits for the first frame fetched at or after `notBefore` and pushed with `gapIndex` and
+     * `sequence`. Returns false once stopped. Throws `std::runtime_error` if no frame came by `deadline`, and rethrows
+     * a failed push.
+     */
+    [[ nodiscard ]]
+    auto take(
+        HINALEA_IN Clock::time_point notBefore,
+        HINALEA_IN Clock::time_point deadline,
+        HINALEA_IN ::hinalea::Int    gapIndex,
+        HINALEA_IN ::std::uint64_t   sequence
+        ) -> bool;
+
+    /* Fetching side, called with every fetched frame while active. `timestamp` is in nanoseconds since the Unix epoch. */
+    auto offer(
+        HINALEA_IN FrameView const & frame,
+        HINALEA_IN Clock::time_point fetched,
+        HINALEA_IN ::std::int64_t    timestamp
+        ) -> void;
+
+private:
+    ::std::atomic< bool > active{ false };
+
+    mutable ::std::mutex mutex{ };
+    ::std::condition_variable delivered{ };
+    ::std::shared_ptr< RawRecorder > recorder{ };
+    Clock::time_point notBefore{ };
+    ::hinalea::Int gapIndex{ };
+    ::std::uint64_t sequence{ };
+    bool wanted{ false };
+    bool pushed{ false };
+    bool stopped{ true };
+    ::std::exception_ptr error{ };
+};
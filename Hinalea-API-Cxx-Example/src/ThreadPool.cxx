@@ -0,0 +1,174 @@
+#include "ThreadPool.hxx"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(
+    HINALEA_IN ::std::size_t const threads
+    )
+{
+    /* The caller always takes part in the work, so spawn one worker less. */
+    auto const count = ::std::max< ::std::size_t >( threads, 1 ) - 1;
+    this->workers.reserve( count );
+
+    for ( auto i = ::std::size_t{ 0 }; i < count; ++i )
+    {
+        this->workers.emplace_back( &ThreadPool::run, this );
+    }
+}
+
+ThreadPool::~ThreadPool(
+    )
+{
+    {
+        auto const lock = ::std::scoped_lock{ this->mutex };
+        this->stopping = true;
+    }
+
+    this->wake.notify_all( );
+
+    for ( auto & worker : this->workers )
+    {
+        worker.join( );
+    }
+}
+
+auto ThreadPool::global(
+    ) -> ThreadPool &
+{
+    static auto pool = ThreadPool{ };
+    return pool;
+}
+
+auto ThreadPool::concurrency(
+    ) const noexcept -> ::std::size_t
+{
+    return this->workers.size( ) + 1;
+}
+
+auto ThreadPool::parallelFor(
+    HINALEA_IN ::std::size_t const   count,
+    HINALEA_IN ::std::size_t const   grain,
+    HINALEA_IN Body          const & body
+    ) -> void
+{
+    if ( count == 0 )
+    {
+        return;
+    }
+
+    auto const chunk = ::std::max< ::std::size_t >( grain, 1 );
+
+    if ( ( count <= chunk ) or this->workers.empty( ) )
+    {
+        body( 0, count );
+        return;
+    }
+
+    auto current = Job{ };
+    current.body  = &body;
+    current.count = count;
+    current.grain = chunk;
+    current.pending.store( ( count + chunk - 1 ) / chunk, ::std::memory_order_relaxed );
+
+    {
+        auto const lock = ::std::scoped_lock{ this->mutex };
+        this->jobs.push_back( &current );
+    }
+
+    this->wake.notify_all( );
+    ThreadPool::work( current );
+
+    {
+        auto lock = ::std::unique_lock{ this->mutex };
+        /* Wait for every worker to let go of the job too, since it lives on this stack frame. */
+        this->done.wait(
+            lock,
+            [ & ]{ return ( current.pending.load( ::std::memory_order_acquire ) == 0 ) and ( current.helpers == 0 ); }
+            );
+        this->jobs.erase( ::std::find( this->jobs.begin( ), this->jobs.end( ), &current ) );
+    }
+
+    if ( current.error )
+    {
+        ::std::rethrow_exception( current.error );
+    }
+}
+
+auto ThreadPool::run(
+    ) -> void
+{
+    while ( true )
+    {
+        Job * current = nullptr;
+
+        {
+            auto lock = ::std::unique_lock{ this->mutex };
+            this->wake.wait( lock, [ & ]{ return this->stopping or ( ( current = this->claimable( ) ) != nullptr ); } );
+
+            if ( this->stopping )
+            {
+                return;
+            }
+
+            ++current->helpers;
+        }
+
+        ThreadPool::work( *current );
+
+        {
+            auto const lock = ::std::scoped_lock{ this->mutex };
+            --current->helpers;
+        }
+
+        this->done.notify_all( );
+    }
+}
+
+auto ThreadPool::claimable(
+    ) const -> Job *
+{
+    Job * best = nullptr;
+
+    for ( auto * const job : this->jobs )
+    {
+        if ( ( job->next.load( ::std::memory_order_relaxed ) < job->count ) and ( ( best == nullptr ) or ( job->helpers < best->helpers ) ) )
+        {
+            best = job;
+        }
+    }
+
+    return best;
+}
+
+auto ThreadPool::work(
+    HINALEA_INOUT Job & job
+    ) -> void
+{
+    while ( true )
+    {
+        auto const begin = job.next.fetch_add( job.grain, ::std::memory_order_relaxed );
+
+        if ( begin >= job.count )
+        {
+            return;
+        }
+
+        auto const end = ::std::min( begin + job.grain, job.count );
+
+        try
+        {
+            ( *job.body )( begin, end );
+        }
+        catch ( ... )
+        {
+            auto const lock = ::std::scoped_lock{ job.errorMutex };
+
+            if ( not job.error )
+            {
+                job.error = ::std::current_exception( );
+            }
+        }
+
+        job.pending.fetch_sub( 1, ::std::memory_order_acq_rel );
+    }
+}
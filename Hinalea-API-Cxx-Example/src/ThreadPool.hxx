@@ -0,0 +1,93 @@
+#pragma once
+
+#include <Hinalea.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* Fixed size pool of worker threads for data parallel loops over frames and cubes.
+ *
+ * `parallelFor` splits `count` items into chunks that are claimed dynamically by the workers and the calling thread,
+ * and returns only once every chunk has been processed. Exceptions thrown by the body are rethrown on the caller.
+ *
+ * Loops of several threads run at the same time: each is posted to a list of open jobs, and an idle worker claims from
+ * the job with the fewest helpers. A caller works through its own loop too, so it never waits for another caller's
+ * loop, only for the chunks of its own that workers are still processing.
+ */
+class ThreadPool
+{
+public:
+    using Body = ::std::function< void ( ::std::size_t begin, ::std::size_t end ) >;
+
+    explicit
+    ThreadPool(
+        HINALEA_IN ::std::size_t threads = ::std::thread::hardware_concurrency( )
+        );
+
+    ~ThreadPool(
+        );
+
+    ThreadPool(
+        ThreadPool const &
+        ) = delete;
+
+    auto operator=(
+        ThreadPool const &
+        ) -> ThreadPool & = delete;
+
+    /* Shared pool used by the display, classify and recording stages. */
+    [[ nodiscard ]]
+    static
+    auto global(
+        ) -> ThreadPool &;
+
+    /* Number of threads taking part in `parallelFor`, including the caller. */
+    [[ nodiscard ]]
+    auto concurrency(
+        ) const noexcept -> ::std::size_t;
+
+    auto parallelFor(
+        HINALEA_IN ::std::size_t count,
+        HINALEA_IN ::std::size_t grain,
+        HINALEA_IN Body const &  body
+        ) -> void;
+
+private:
+    struct Job
+    {
+        Body const *                  body{ nullptr };
+        ::std::size_t                 count{ };
+        ::std::size_t                 grain{ };
+        ::std::atomic< ::std::size_t > next{ 0 };
+        ::std::atomic< ::std::size_t > pending{ 0 };
+        ::std::size_t                 helpers{ 0 }; /* Workers holding the job, guarded by the pool mutex. */
+        ::std::exception_ptr          error{ };
+        ::std::mutex                  errorMutex{ };
+    };
+
+    ::std::vector< ::std::thread > workers{ };
+    ::std::mutex mutex{ };
+    ::std::condition_variable wake{ };
+    ::std::condition_variable done{ };
+    ::std::vector< Job * > jobs{ }; /* Open loops, each on the stack of its caller until it returns. */
+    bool stopping{ false };
+
+    auto run(
+        ) -> void;
+
+    /* Job with chunks left to claim and the fewest helpers, null if there is none. Called with `mutex` held. */
+    [[ nodiscard ]]
+    auto claimable(
+        ) const -> Job *;
+
+    static
+    auto work(
+        HINALEA_INOUT Job & job
+        ) -> void;
+};
@@ -0,0 +1,209 @@
+#include "ToneMap.hxx"
+
+#include "Simd.hxx"
+#include "ThreadPool.hxx"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+auto constexpr gatherPadding = ::std::size_t{ 4 };
+
+auto mapRowScalar(
+    HINALEA_IN  ::std::uint16_t const * const row,
+    HINALEA_IN  ::hinalea::Int          const begin,
+    HINALEA_IN  ::hinalea::Int          const width,
+    HINALEA_IN  ::std::uint8_t  const * const lut,
+    HINALEA_IN  ::std::uint16_t         const lastIndex,
+    HINALEA_OUT ::std::uint8_t *        const destination
+    ) -> void
+{
+    for ( auto x = begin; x < width; ++x )
+    {
+        destination[ x ] = lut[ ::std::min( row[ x ], lastIndex ) ];
+    }
+}
+
+SIMD_TARGET_AVX2
+auto mapRowAvx2(
+    HINALEA_IN  ::std::uint16_t const * const row,
+    HINALEA_IN  ::hinalea::Int          const width,
+    HINALEA_IN  ::std::uint8_t  const * const lut,
+    HINALEA_IN  ::std::uint16_t         const lastIndex,
+    HINALEA_OUT ::std::uint8_t *        const destination
+    ) -> void
+{
+    auto constexpr lanes = ::hinalea::Int{ 16 };
+    auto const clamp = _mm256_set1_epi16( static_cast< short >( lastIndex ) );
+    auto const byteMask = _mm256_set1_epi32( 0xFF );
+    auto const table = reinterpret_cast< int const * >( lut );
+    auto x = ::hinalea::Int{ 0 };
+
+    for ( ; x + lanes <= width; x += lanes )
+    {
+        auto const values = _mm256_min_epu16( _mm256_loadu_si256( reinterpret_cast< __m256i const * >( row + x ) ), clamp );
+        auto const lo = _mm256_cvtepu16_epi32( _mm256_castsi256_si128( values ) );
+        auto const hi = _mm256_cvtepu16_epi32( _mm256_extracti128_si256( values, 1 ) );
+
+        /* Gather 4 bytes at each index and keep the first one. */
+        auto const mappedLo = _mm256_and_si256( _mm256_i32gather_epi32( table, lo, 1 ), byteMask );
+        auto const mappedHi = _mm256_and_si256( _mm256_i32gather_epi32( table, hi, 1 ), byteMask );
+
+        /* Pack 2x8 32-bit to 16x 8-bit, fixing up the per lane ordering of the pack instructions. */
+        auto const words = _mm256_permute4x64_epi64( _mm256_packus_epi32( mappedLo, mappedHi ), 0b11'01'10'00 );
+        auto const bytes = _mm256_permute4x64_epi64( _mm256_packus_epi16( words, words ), 0b11'01'10'00 );
+        _mm_storeu_si128( reinterpret_cast< __m128i * >( destination + x ), _mm256_castsi256_si128( bytes ) );
+    }
+
+    ::mapRowScalar( row, x, width, lut, lastIndex, destination );
+}
+
+} /* namespace anonymous */
+
+auto ToneMapper::setWindow(
+    HINALEA_IN ::hinalea::Int const newLower,
+    HINALEA_IN ::hinalea::Int const newUpper,
+    HINALEA_IN ::hinalea::Int const newBitDepth
+    ) -> bool
+{
+    if ( ( newBitDepth < 1 ) or ( newBitDepth > 16 ) )
+    {
+        throw ::std::invalid_argument{ "Tone mapping only supports 1 to 16 bit frames." };
+    }
+
+    auto const maxValue = ( ::hinalea::Int{ 1 } << newBitDepth ) - 1;
+    auto const lo = ::std::clamp< ::hinalea::Int >( newLower, 0, maxValue - 1 );
+    auto const hi = ::std::clamp< ::hinalea::Int >( newUpper, lo + 1, maxValue );
+
+    if ( ( lo == this->lower ) and ( hi == this->upper ) and ( newBitDepth == this->bitDepth ) )
+    {
+        return false;
+    }
+
+    this->lower = lo;
+    this->upper = hi;
+    this->bitDepth = newBitDepth;
+
+    auto const entries = static_cast< ::std::size_t >( maxValue + 1 );
+    this->lut.resize( entries + ::gatherPadding );
+
+    auto const scale = 255.0 / static_cast< double >( hi - lo );
+
+    for ( auto value = ::std::size_t{ 0 }; value < entries; ++value )
+    {
+        auto const v = static_cast< ::hinalea::Int >( value );
+        auto const mapped = ( v <= lo ) ? 0.0
+            : ( v >= hi ) ? 255.0
+            : static_cast< double >( v - lo ) * scale;
+        this->lut[ value ] = static_cast< ::std::uint8_t >( ::std::lround( mapped ) );
+    }
+
+    return true;
+}
+
+auto ToneMapper::setPercentiles(
+    HINALEA_IN FrameStatistics const & statistics,
+    HINALEA_IN double          const   lowerPercentile,
+    HINALEA_IN double          const   upperPercentile
+    ) -> bool
+{
+    auto const & histogram = statistics.histogram;
+    auto total = ::std::uint64_t{ 0 };
+
+    for ( auto const count : histogram )
+    {
+        total += count;
+    }
+
+    if ( total == 0 )
+    {
+        return this->setWindow( statistics.min, statistics.max, statistics.bitDepth );
+    }
+
+    auto const lowerCount = static_cast< ::std::uint64_t >( lowerPercentile * static_cast< double >( total ) );
+    auto const upperCount = static_cast< ::std::uint64_t >( upperPercentile * static_cast< double >( total ) );
+    auto lo = ::hinalea::Int{ -1 };
+    auto hi = ::hinalea::Int{ -1 };
+    auto cumulative = ::std::uint64_t{ 0 };
+
+    for ( auto bin = ::std::size_t{ 0 }; bin < histogram.size( ); ++bin )
+    {
+        cumulative += histogram[ bin ];
+
+        if ( ( lo < 0 ) and ( cumulative > lowerCount ) )
+        {
+            lo = static_cast< ::hinalea::Int >( bin );
+        }
+
+        if ( cumulative >= upperCount )
+        {
+            hi = static_cast< ::hinalea::Int >( bin );
+            break;
+        }
+    }
+
+    return this->setWindow( ::std::max< ::hinalea::Int >( lo, 0 ), hi, statistics.bitDepth );
+}
+
+auto ToneMapper::table(
+    ) const noexcept -> ::std::uint8_t const *
+{
+    return this->lut.data( );
+}
+
+auto ToneMapper::apply(
+    HINALEA_IN  FrameView      const & source,
+    HINALEA_OUT ::std::uint8_t * const destination,
+    HINALEA_IN  ::hinalea::Int const   destinationLinePitch
+    ) const -> void
+{
+    if ( this->lut.empty( ) or ( source.bitDepth != this->bitDepth ) )
+    {
+        throw ::std::logic_error{ "Tone mapping window was not set up for this bit depth." };
+    }
+
+    auto const level = simd::level( );
+    auto const lastIndex = static_cast< ::std::uint16_t >( ( 1 << this->bitDepth ) - 1 );
+    auto const height = static_cast< ::std::size_t >( source.height );
+    auto const bands = ThreadPool::global( ).concurrency( ) * 2;
+    auto const * const bytes = static_cast< ::std::byte const * >( source.data );
+    auto const * const lookup = this->lut.data( );
+
+    ThreadPool::global( ).parallelFor(
+        height,
+        ::std::max< ::std::size_t >( ( height + bands - 1 ) / bands, 8 ),
+        [ & ]( ::std::size_t const begin, ::std::size_t const end )
+        {
+            for ( auto y = begin; y < end; ++y )
+            {
+                auto * const output = destination + y * destinationLinePitch;
+
+                if ( source.bitDepth <= 8 )
+                {
+                    /* A 256 entry table lives in L1, a plain lookup is as fast as a gather here. */
+                    auto const * const row = reinterpret_cast< ::std::uint8_t const * >( bytes + y * source.linePitch );
+
+                    for ( auto x = ::hinalea::Int{ 0 }; x < source.width; ++x )
+                    {
+                        output[ x ] = lookup[ row[ x ] ];
+                    }
+                }
+                else
+                {
+                    auto const * const row = reinterpret_cast< ::std::uint16_t const * >( bytes + y * source.linePitch );
+
+                    if ( level == simd::Level::Avx2 )
+                    {
+                        ::mapRowAvx2( row, source.width, lookup, lastIndex, output );
+                    }
+                    else
+                    {
+                        ::mapRowScalar( row, 0, source.width, lookup, lastIndex, output );
+                    }
+                }
+            }
+        }
+        );
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "FrameStatistics.hxx"
+
+#include <Hinalea.h>
+
+#include <cstdint>
+#include <vector>
+
+enum class ToneMapMode
+{
+    WindowLevel,    /* Linear stretch between an explicit lower and upper intensity. */
+    AutoPercentile, /* Linear stretch between two percentiles of the frame histogram. */
+};
+
+/* Maps high bit depth intensities to 8 bits through a lookup table.
+ *
+ * The table is only rebuilt when the window actually changes, so steady state frames only pay for the lookup pass.
+ * 16-bit frames are mapped with AVX2 gathers (scalar fallback) in row bands on `ThreadPool::global( )`.
+ */
+class ToneMapper
+{
+public:
+    /* Returns true if the lookup table had to be rebuilt. */
+    auto setWindow(
+        HINALEA_IN ::hinalea::Int lower,
+        HINALEA_IN ::hinalea::Int upper,
+        HINALEA_IN ::hinalea::Int bitDepth
+        ) -> bool;
+
+    /* Picks the window from the histogram percentiles, eg. 0.005 and 0.995. */
+    auto setPercentiles(
+        HINALEA_IN FrameStatistics const & statistics,
+        HINALEA_IN double                  lower,
+        HINALEA_IN double                  upper
+        ) -> bool;
+
+    /* Table indexed by raw intensity. Valid after the first call to `setWindow` or `setPercentiles`. */
+    [[ nodiscard ]]
+    auto table(
+        ) const noexcept -> ::std::uint8_t const *;
+
+    auto apply(
+        HINALEA_IN  FrameView const & source,
+        HINALEA_OUT ::std::uint8_t *  destination,
+        HINALEA_IN  ::hinalea::Int    destinationLinePitch
+        ) const -> void;
+
+private:
+    ::hinalea::Int lower{ -1 };
+    ::hinalea::Int upper{ -1 };
+    ::hinalea::Int bitDepth{ -1 };
+
+    /* Padded so 32-bit gathers at the last index stay in bounds. */
+    ::std::vector< ::std::uint8_t > lut{ };
+};
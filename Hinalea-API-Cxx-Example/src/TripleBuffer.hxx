@@ -0,0 +1,135 @@
+#pragma once
+
+#include <Hinalea.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <utility>
+
+/* Lock-free single producer / single consumer triple buffer.
+ *
+ * The producer always owns the back slot and the consumer always owns the front slot. The middle slot is swapped
+ * atomically between them, so neither side ever waits on the other. If the producer publishes twice before the
+ * consumer reads, the older frame is silently replaced (counted as overwritten) and the consumer gets the newest one.
+ */
+template <
+    typename T
+    >
+class TripleBuffer
+{
+public:
+    struct Counters
+    {
+        ::std::uint64_t produced{ };
+        ::std::uint64_t consumed{ };
+        ::std::uint64_t overwritten{ };
+    };
+
+    TripleBuffer(
+        ) = default;
+
+    TripleBuffer(
+        TripleBuffer const &
+        ) = delete;
+
+    auto operator=(
+        TripleBuffer const &
+        ) -> TripleBuffer & = delete;
+
+    /* Only call while neither the producer nor the consumer are running. */
+    template <
+        typename Factory
+        >
+    auto reset(
+        HINALEA_IN Factory && factory
+        ) -> void
+    {
+        for ( auto & slot : this->slots )
+        {
+            slot = factory( );
+        }
+
+        this->back  = 0;
+        this->front = 1;
+        this->middle.store( 2, ::std::memory_order_relaxed );
+        this->producedCount   .store( 0, ::std::memory_order_relaxed );
+        this->consumedCount   .store( 0, ::std::memory_order_relaxed );
+        this->overwrittenCount.store( 0, ::std::memory_order_relaxed );
+    }
+
+    /* Producer side: slot to be filled before calling `publish`. */
+    [[ nodiscard ]]
+    auto backBuffer(
+        ) noexcept -> T &
+    {
+        return this->slots[ this->back ];
+    }
+
+    /* Producer side: hand the back slot over to the consumer. */
+    auto publish(
+        ) noexcept -> void
+    {
+        auto const previous = this->middle.exchange(
+            static_cast< ::std::uint8_t >( this->back | dirtyBit ),
+            ::std::memory_order_acq_rel
+            );
+        this->back = previous & indexMask;
+        this->producedCount.fetch_add( 1, ::std::memory_order_relaxed );
+
+        if ( previous & dirtyBit )
+        {
+            this->overwrittenCount.fetch_add( 1, ::std::memory_order_relaxed );
+        }
+    }
+
+    /* Consumer side: newest published slot, or nullptr if nothing new was published since the last call. */
+    [[ nodiscard ]]
+    auto consume(
+        ) noexcept -> T *
+    {
+        if ( not ( this->middle.load( ::std::memory_order_relaxed ) & dirtyBit ) )
+        {
+            return nullptr;
+        }
+
+        auto const previous = this->middle.exchange( this->front, ::std::memory_order_acq_rel );
+        this->front = previous & indexMask;
+        this->consumedCount.fetch_add( 1, ::std::memory_order_relaxed );
+        return &this->slots[ this->front ];
+    }
+
+    /* Consumer side: last consumed slot, valid until the next call to `consume`. */
+    [[ nodiscard ]]
+    auto frontBuffer(
+        ) noexcept -> T &
+    {
+        return this->slots[ this->front ];
+    }
+
+    [[ nodiscard ]]
+    auto counters(
+        ) const noexcept -> Counters
+    {
+        return {
+            this->producedCount   .load( ::std::memory_order_relaxed ),
+            this->consumedCount   .load( ::std::memory_order_relaxed ),
+            this->overwrittenCount.load( ::std::memory_order_relaxed ),
+            };
+    }
+
+private:
+    static auto constexpr dirtyBit  = ::std::uint8_t{ 0b100 };
+    static auto constexpr indexMask = ::std::uint8_t{ 0b011 };
+
+    ::std::array< T, 3 > slots{ };
+
+    /* Cache line separation keeps the producer and consumer indexes from false sharing. */
+    alignas( 64 ) ::std::uint8_t back{ 0 };
+    alignas( 64 ) ::std::uint8_t front{ 1 };
+    alignas( 64 ) ::std::atomic< ::std::uint8_t > middle{ 2 };
+
+    alignas( 64 ) ::std::atomic< ::std::uint64_t > producedCount{ 0 };
+    ::std::atomic< ::std::uint64_t > consumedCount{ 0 };
+    ::std::atomic< ::std::uint64_t > overwrittenCount{ 0 };
+};
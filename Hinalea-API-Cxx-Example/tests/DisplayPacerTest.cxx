@@ -0,0 +1,208 @@
+#include "DisplayPacer.hxx"
+#include "TripleBuffer.hxx"
+
+#include <QTest>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = DisplayPacer::Clock;
+using Microseconds = ::std::chrono::microseconds;
+
+struct SyntheticFrame
+{
+    ::std::vector< ::std::uint16_t > pixels{ };
+    ::std::uint64_t sequence{ };
+    Clock::time_point published{ };
+};
+
+} /* namespace anonymous */
+
+/* Checks the display path of `MainWindow` without camera or GUI: the periods it derives from the exposure and the
+ * refresh target, the pacing of its loops, and a synthetic 1 kHz camera going through its triple buffers.
+ */
+class DisplayPacerTest
+    : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    auto periods(
+        ) -> void
+    {
+        struct Case
+        {
+            ::hinalea::MicrosecondsI exposure;
+            int refreshRate;
+            ::std::chrono::milliseconds timerInterval;
+            ::hinalea::MicrosecondsI displayPeriod;
+            ::hinalea::MicrosecondsI fetchPeriod;
+        };
+
+        /* Short exposures are shown at the refresh target, long ones at the camera rate. Every frame is fetched. */
+        Case const cases[ ] = {
+            Case{ ::hinalea::MicrosecondsI{ 1'000 }  , 30 , ::std::chrono::milliseconds{ 34 }   , ::hinalea::MicrosecondsI{ 33'333 }   , ::hinalea::MicrosecondsI{ 500 }     },
+            Case{ ::hinalea::MicrosecondsI{ 1'000 }  , 240, ::std::chrono::milliseconds{ 5 }    , ::hinalea::MicrosecondsI{ 4'166 }    , ::hinalea::MicrosecondsI{ 500 }     },
+            Case{ ::hinalea::MicrosecondsI{ 20'000 } , 60 , ::std::chrono::milliseconds{ 17 }   , ::hinalea::MicrosecondsI{ 20'000 }   , ::hinalea::MicrosecondsI{ 10'000 }  },
+            Case{ ::hinalea::MicrosecondsI{ 500'000 }, 30 , ::std::chrono::milliseconds{ 34 }   , ::hinalea::MicrosecondsI{ 500'000 }  , ::hinalea::MicrosecondsI{ 250'000 } },
+            Case{ ::hinalea::MicrosecondsI{ 0 }      , 1  , ::std::chrono::milliseconds{ 1'000 }, ::hinalea::MicrosecondsI{ 1'000'000 }, ::hinalea::MicrosecondsI{ 100 }     },
+            };
+
+        for ( auto const & test : cases )
+        {
+            auto const periods = DisplayPacer::periods( test.exposure, test.refreshRate );
+            QCOMPARE( periods.timerInterval.count( ), test.timerInterval.count( ) );
+            QCOMPARE( periods.displayPeriod.count( ), test.displayPeriod.count( ) );
+            QCOMPARE( periods.fetchPeriod.count( ), test.fetchPeriod.count( ) );
+        }
+    }
+
+    auto waitKeepsRate(
+        ) -> void
+    {
+        auto constexpr period = ::std::chrono::milliseconds{ 2 };
+        auto constexpr passes = 50;
+
+        auto pacer = DisplayPacer{ };
+        auto const start = Clock::now( );
+
+        for ( auto i = 0; i < passes; ++i )
+        {
+            pacer.wait( period );
+        }
+
+        auto const elapsed = Clock::now( ) - start;
+        QVERIFY( elapsed >= passes * period );
+        QVERIFY( elapsed < passes * period * 3 / 2 );
+    }
+
+    auto waitDoesNotBurstAfterStall(
+        ) -> void
+    {
+        auto constexpr period = ::std::chrono::milliseconds{ 2 };
+        auto constexpr passes = 10;
+
+        auto pacer = DisplayPacer{ };
+        ::std::this_thread::sleep_for( period * passes * 2 );
+
+        /* The overrun pass returns at once, the ones after it are paced from there. */
+        pacer.wait( period );
+        auto const start = Clock::now( );
+
+        for ( auto i = 0; i < passes; ++i )
+        {
+            pacer.wait( period );
+        }
+
+        QVERIFY( Clock::now( ) - start >= passes * period );
+    }
+
+    auto syntheticSource(
+        ) -> void
+    {
+        auto constexpr sourceRate = 1'000.0;
+        auto constexpr exposure = ::hinalea::MicrosecondsI{ 1'000 };
+        auto constexpr refreshRate = 30;
+        auto constexpr duration = ::std::chrono::milliseconds{ 2'000 };
+        auto constexpr pixels = ::std::size_t{ 640 * 480 };
+
+        auto const periods = DisplayPacer::periods( exposure, refreshRate );
+        auto const sourcePeriod = ::std::chrono::duration_cast< Clock::duration >( ::std::chrono::duration< double >{ 1.0 / sourceRate } );
+
+        auto source = TripleBuffer< SyntheticFrame >{ };
+        auto display = TripleBuffer< SyntheticFrame >{ };
+        source.reset( [ & ]{ return SyntheticFrame{ ::std::vector< ::std::uint16_t >( pixels ) }; } );
+        display.reset( [ & ]{ return SyntheticFrame{ ::std::vector< ::std::uint16_t >( pixels ) }; } );
+
+        auto running = ::std::atomic< bool >{ true };
+        auto displayPasses = ::std::uint64_t{ 0 };
+
+        /* Stands in for the camera, the newest frame being what `Acquisition::image` returns. */
+        auto sourceThread = ::std::jthread{
+            [ & ]
+            {
+                auto pacer = DisplayPacer{ };
+
+                for ( auto sequence = ::std::uint64_t{ 0 }; running.load( ::std::memory_order_acquire ); ++sequence )
+                {
+                    auto & frame = source.backBuffer( );
+                    ::std::fill( frame.pixels.begin( ), frame.pixels.end( ), static_cast< ::std::uint16_t >( sequence ) );
+                    frame.sequence = sequence;
+                    frame.published = Clock::now( );
+                    source.publish( );
+                    pacer.wait( sourcePeriod );
+                }
+            }
+            };
+
+        /* Paced like `MainWindow::runDisplayThread`. */
+        auto displayThread = ::std::jthread{
+            [ & ]
+            {
+                auto pacer = DisplayPacer{ };
+
+                while ( running.load( ::std::memory_order_acquire ) )
+                {
+                    if ( auto const * const newest = source.consume( );
+                         newest != nullptr )
+                    {
+                        auto & frame = display.backBuffer( );
+                        ::std::copy( newest->pixels.begin( ), newest->pixels.end( ), frame.pixels.begin( ) );
+                        frame.sequence = newest->sequence;
+                        frame.published = newest->published;
+                        display.publish( );
+                        ++displayPasses;
+                    }
+
+                    pacer.wait( periods.displayPeriod );
+                }
+            }
+            };
+
+        /* Stands in for the GUI display timer, every frame it consumes is one repaint. */
+        auto repaints = ::std::uint64_t{ 0 };
+        auto maxAge = Microseconds{ 0 };
+        auto pacer = DisplayPacer{ };
+
+        for ( auto const end = Clock::now( ) + duration; Clock::now( ) < end; pacer.wait( periods.timerInterval ) )
+        {
+            if ( auto const * const frame = display.consume( );
+                 frame != nullptr )
+            {
+                ++repaints;
+                maxAge = ::std::max( maxAge, ::std::chrono::duration_cast< Microseconds >( Clock::now( ) - frame->published ) );
+            }
+        }
+
+        running.store( false, ::std::memory_order_release );
+        sourceThread.join( );
+        displayThread.join( );
+
+        auto const produced = source.counters( ).produced;
+        auto const maxDisplayPasses = static_cast< ::std::uint64_t >( duration / periods.displayPeriod ) + 2;
+        auto const maxRepaints = static_cast< ::std::uint64_t >( duration / periods.timerInterval ) + 2;
+        auto const ageLimit = ::std::chrono::duration_cast< Microseconds >( 2 * periods.displayPeriod + sourcePeriod );
+
+        auto const numbers = "source frames: " + ::std::to_string( produced ) + ", display passes: " + ::std::to_string( displayPasses ) +
+                             " of at most " + ::std::to_string( maxDisplayPasses ) + ", repaints: " + ::std::to_string( repaints ) +
+                             " of at most " + ::std::to_string( maxRepaints ) + ", oldest frame: " + ::std::to_string( maxAge.count( ) ) +
+                             " us of at most " + ::std::to_string( ageLimit.count( ) ) + " us";
+        qInfo( "%s", numbers.c_str( ) );
+
+        /* NOTE: A source that fell far behind would make the other bounds pass without exercising them. */
+        QVERIFY2( produced >= static_cast< ::std::uint64_t >( ::std::chrono::duration< double >{ duration }.count( ) * sourceRate / 2.0 ), numbers.c_str( ) );
+        QVERIFY2( displayPasses <= maxDisplayPasses, numbers.c_str( ) );
+        QVERIFY2( repaints <= maxRepaints, numbers.c_str( ) );
+        QVERIFY2( maxAge <= ageLimit, numbers.c_str( ) );
+    }
+};
+
+QTEST_APPLESS_MAIN( DisplayPacerTest )
+
+#include "DisplayPacerTest.moc"
@@ -0,0 +1,24 @@
+########################################################################################################################
+# Qt Options
+############
+
+QT += core testlib
+
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+include( ../common.pri )
+
+########################################################################################################################
+# Source Files
+##############
+
+SOURCES += \
+    DisplayPacerTest.cxx
+
+########################################################################################################################
+# Deployment
+############
+
+TARGET = Hinalea-API-Cxx-Tests
+DESTDIR = $$PWD/../bin